@@ -9,8 +9,20 @@ QT       += core
 QT       += positioning
 QT       += sensors
 QT       += gui
+QT       += concurrent
+QT       += network
 
-CONFIG   += debug
+# The build is for debugging, unless "qmake CONFIG+=optimize", which
+# is what tracker-bench should be measured with.
+optimize {
+    CONFIG -= debug
+    CONFIG += release
+} else {
+    CONFIG += debug
+}
+
+# Per stage latency tracing (see LatencyTrace.hpp) is compiled in
+# with "qmake DEFINES+=LATENCY_TRACE".
 
 # Add additional compiler checks
 contains(DEFINES, DEVELOPER_MODE) {
@@ -0,0 +1,373 @@
+#include <QDebug>
+#include <QFile>
+#include <QDataStream>
+#include <QtConcurrent>
+#include <QtMath>
+#include "CoverageRaster.hpp"
+#include "GeoObserver.hpp"
+#include "LookAngle.hpp"
+#include "FastMath.hpp"
+
+// The sites of which a SiteMask is exact in a float, the others being
+// left out of it
+static const int MaskSiteCount = 24;
+
+// The value of a cell seen by no site, in MaximumElevation
+static const float NotSeen = -90.0f;
+
+CoverageRaster::CoverageRaster() :
+  m_south(0.0),
+  m_west(0.0),
+  m_north(0.0),
+  m_east(0.0),
+  m_columns(0),
+  m_rows(0),
+  m_altitude(0.0),
+  m_value(SiteCount),
+  m_tileSize(256)
+{
+}
+
+void CoverageRaster::setGrid(double south, double west, double north, double east, int columns, int rows)
+{
+  m_south = south;
+  m_west = west;
+  m_north = north;
+  m_east = east;
+  m_columns = qMax(0, columns);
+  m_rows = qMax(0, rows);
+  m_values.clear();
+}
+
+double CoverageRaster::south() const
+{
+  return m_south;
+}
+
+double CoverageRaster::west() const
+{
+  return m_west;
+}
+
+double CoverageRaster::north() const
+{
+  return m_north;
+}
+
+double CoverageRaster::east() const
+{
+  return m_east;
+}
+
+int CoverageRaster::columns() const
+{
+  return m_columns;
+}
+
+int CoverageRaster::rows() const
+{
+  return m_rows;
+}
+
+double CoverageRaster::altitude() const
+{
+  return m_altitude;
+}
+
+void CoverageRaster::setAltitude(double altitude)
+{
+  m_altitude = altitude;
+}
+
+CoverageRaster::Value CoverageRaster::value() const
+{
+  return m_value;
+}
+
+void CoverageRaster::setValue(Value value)
+{
+  m_value = value;
+}
+
+int CoverageRaster::tileSize() const
+{
+  return m_tileSize;
+}
+
+void CoverageRaster::setTileSize(int tileSize)
+{
+  m_tileSize = qMax(1, tileSize);
+}
+
+int CoverageRaster::addSite(QGeoCoordinate const &position, double elevationMask, Refraction const &refraction)
+{
+  const LookAngleFrame frame = LookAngleFrame::at(position);
+  Site site;
+  site.point = frame.point;
+  site.normal = frame.normal;
+  site.elevationMask = elevationMask;
+  site.sinMask = qSin(qDegreesToRadians(elevationMask));
+  // The largest correction is that of the lowest elevation
+  const double lowest = elevationMask - refraction.correction(-90.0f);
+  site.sinLowest = qSin(qDegreesToRadians(qMax(-90.0, lowest)));
+  site.refraction = refraction;
+  m_sites.append(site);
+  return m_sites.size() - 1;
+}
+
+int CoverageRaster::addSite(GeoObserver const &observer)
+{
+  return addSite(observer.position().coordinate(), observer.elevationMask(), observer.refraction());
+}
+
+int CoverageRaster::siteCount() const
+{
+  return m_sites.size();
+}
+
+void CoverageRaster::clearSites()
+{
+  m_sites.clear();
+}
+
+void CoverageRaster::compute()
+{
+  m_values.fill(m_value == MaximumElevation ? NotSeen : 0.0f, m_columns * m_rows);
+  if (m_values.isEmpty())
+    return;
+  if (m_value == SiteMask && m_sites.size() > MaskSiteCount)
+    qWarning() << "Warning: the site mask leaves out" << m_sites.size() - MaskSiteCount << "sites beyond the first" << MaskSiteCount;
+
+  // The tiles write to cells of their own, through a pointer taken
+  // once, not detaching the values from the threads
+  float *values = m_values.data();
+  const int tileColumns = (m_columns + m_tileSize - 1) / m_tileSize;
+  const int tileRows = (m_rows + m_tileSize - 1) / m_tileSize;
+  QVector<int> tiles(tileColumns * tileRows);
+  for (int i = 0; i < tiles.size(); ++i)
+    tiles[i] = i;
+  QtConcurrent::blockingMap(tiles, [this, values](int tile) { computeTile(tile, values); });
+}
+
+void CoverageRaster::computeTile(int tile, float *raster) const
+{
+  const int tileColumns = (m_columns + m_tileSize - 1) / m_tileSize;
+  const int beginColumn = (tile % tileColumns) * m_tileSize;
+  const int endColumn = qMin(beginColumn + m_tileSize, m_columns);
+  const int beginRow = (tile / tileColumns) * m_tileSize;
+  const int endRow = qMin(beginRow + m_tileSize, m_rows);
+  const int width = endColumn - beginColumn;
+
+  const double cellLatitude = (m_north - m_south) / m_rows;
+  const double cellLongitude = (m_east - m_west) / m_columns;
+  const double step = qDegreesToRadians(cellLongitude);
+  const double cosStep = qCos(step);
+  const double sinStep = qSin(step);
+  const double degrees = 180.0 / M_PI;
+
+  QVector<double> x(width), y(width);
+  QVector<quint32> mask(width);
+  for (int row = beginRow; row < endRow; ++row) {
+    // The cells of the row are on a circle about the z axis: at
+    // longitude 0, the point of the conversion is (A, 0, Z).
+    const double latitude = m_north - (row + 0.5) * cellLatitude;
+    const GeoPoint meridian = LookAngle::point(QGeoCoordinate(latitude, 0.0, m_altitude));
+    const double a = meridian.x();
+    const double z = meridian.z();
+
+    // Stepped by rotation from the first cell of the tile row
+    const double longitude = qDegreesToRadians(m_west + (beginColumn + 0.5) * cellLongitude);
+    double c = qCos(longitude);
+    double s = qSin(longitude);
+    for (int i = 0; i < width; ++i) {
+      x[i] = a * c;
+      y[i] = a * s;
+      const double next = c * cosStep - s * sinStep;
+      s = s * cosStep + c * sinStep;
+      c = next;
+    }
+
+    float *values = raster + row * m_columns + beginColumn;
+    for (int site = 0; site < m_sites.size(); ++site) {
+      Site const &o = m_sites.at(site);
+      const double dz = z - o.point.z();
+      const double upZ = dz * o.normal.z();
+      const bool refracts = o.sinLowest < o.sinMask;
+      const float bit = site < MaskSiteCount ? float(1u << site) : 0.0f;
+
+      for (int i = 0; i < width; ++i) {
+        const double dx = x[i] - o.point.x();
+        const double dy = y[i] - o.point.y();
+        const double up = dx*o.normal.x() + dy*o.normal.y() + upZ;
+        const double range = qSqrt(dx*dx + dy*dy + dz*dz);
+        mask[i] = up >= o.sinMask * range ? 1u : (refracts && up >= o.sinLowest * range ? 2u : 0u);
+      }
+
+      for (int i = 0; i < width; ++i) {
+        if (mask[i] == 0u)
+          continue;
+        if (mask[i] == 2u || m_value == MaximumElevation) {
+          // The apparent elevation of the cell
+          const double dx = x[i] - o.point.x();
+          const double dy = y[i] - o.point.y();
+          const double up = dx*o.normal.x() + dy*o.normal.y() + upZ;
+          const double range = qSqrt(dx*dx + dy*dy + dz*dz);
+          const double horizontal = qSqrt(qMax(0.0, range*range - up*up));
+          const float geometric = range > 0.0 ? float(FastMath::atan2(up, horizontal) * degrees) : 90.0f;
+          const float elevation = o.refraction.apparentElevation(geometric, range);
+          if (elevation < o.elevationMask)
+            continue;
+          if (m_value == MaximumElevation) {
+            values[i] = qMax(values[i], elevation);
+            continue;
+          }
+        }
+        if (m_value == SiteCount)
+          values[i] += 1.0f;
+        else
+          values[i] += bit;
+      }
+    }
+  }
+}
+
+QVector<float> const &CoverageRaster::values() const
+{
+  return m_values;
+}
+
+float CoverageRaster::value(int column, int row) const
+{
+  return m_values.at(row * m_columns + column);
+}
+
+QGeoCoordinate CoverageRaster::cellCenter(int column, int row) const
+{
+  double longitude = m_west + (column + 0.5) * (m_east - m_west) / m_columns;
+  if (longitude > 180.0)
+    longitude -= 360.0;
+  return QGeoCoordinate(m_north - (row + 0.5) * (m_north - m_south) / m_rows, longitude, m_altitude);
+}
+
+bool CoverageRaster::write(QString const &fileName, Format format)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    m_errorString = file.errorString();
+    return false;
+  }
+  const bool isWritten = format == GeoTiffFormat ? writeGeoTiff(&file) : writeRaw(&file);
+  if (!isWritten) {
+    m_errorString = file.errorString();
+    if (m_errorString.isEmpty())
+      m_errorString = "The raster is too large for the format";
+    return false;
+  }
+  file.close();
+  return true;
+}
+
+QString CoverageRaster::errorString() const
+{
+  return m_errorString;
+}
+
+bool CoverageRaster::writeRaw(QIODevice *device) const
+{
+  QDataStream stream(device);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  for (float value : m_values)
+    stream << value;
+  return stream.status() == QDataStream::Ok;
+}
+
+// The tags of the GeoTIFF, in their order
+enum TiffTag {
+  ImageWidth = 256,
+  ImageLength = 257,
+  BitsPerSample = 258,
+  Compression = 259,
+  PhotometricInterpretation = 262,
+  StripOffsets = 273,
+  SamplesPerPixel = 277,
+  RowsPerStrip = 278,
+  StripByteCounts = 279,
+  PlanarConfiguration = 284,
+  SampleFormat = 339,
+  ModelPixelScale = 33550,
+  ModelTiepoint = 33922,
+  GeoKeyDirectory = 34735
+};
+
+enum TiffType {
+  TiffShort = 3,
+  TiffLong = 4,
+  TiffDouble = 12
+};
+
+static
+void WriteTiffEntry(QDataStream &stream, TiffTag tag, TiffType type, quint32 count, quint32 value)
+{
+  stream << quint16(tag) << quint16(type) << count;
+  if (type == TiffShort && count == 1)
+    stream << quint16(value) << quint16(0);
+  else
+    stream << value;
+}
+
+bool CoverageRaster::writeGeoTiff(QIODevice *device) const
+{
+  // The header, one directory of 14 entries, its values too large
+  // for an entry, and the image as a single strip
+  const quint32 entryCount = 14;
+  const quint32 directory = 8;
+  const quint32 pixelScale = directory + 2 + entryCount * 12 + 4;
+  const quint32 tiepoint = pixelScale + 3 * 8;
+  const quint32 geoKeys = tiepoint + 6 * 8;
+  const quint32 image = geoKeys + 16 * 2;
+  const quint64 imageSize = quint64(m_values.size()) * 4;
+  if (image + imageSize > Q_UINT64_C(0xffffffff))
+    return false;
+
+  QDataStream stream(device);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+  stream << quint8('I') << quint8('I') << quint16(42) << directory;
+
+  stream << quint16(entryCount);
+  WriteTiffEntry(stream, ImageWidth, TiffLong, 1, quint32(m_columns));
+  WriteTiffEntry(stream, ImageLength, TiffLong, 1, quint32(m_rows));
+  WriteTiffEntry(stream, BitsPerSample, TiffShort, 1, 32);
+  WriteTiffEntry(stream, Compression, TiffShort, 1, 1);               // none
+  WriteTiffEntry(stream, PhotometricInterpretation, TiffShort, 1, 1); // black is zero
+  WriteTiffEntry(stream, StripOffsets, TiffLong, 1, image);
+  WriteTiffEntry(stream, SamplesPerPixel, TiffShort, 1, 1);
+  WriteTiffEntry(stream, RowsPerStrip, TiffLong, 1, quint32(m_rows));
+  WriteTiffEntry(stream, StripByteCounts, TiffLong, 1, quint32(imageSize));
+  WriteTiffEntry(stream, PlanarConfiguration, TiffShort, 1, 1);       // chunky
+  WriteTiffEntry(stream, SampleFormat, TiffShort, 1, 3);              // IEEE float
+  WriteTiffEntry(stream, ModelPixelScale, TiffDouble, 3, pixelScale);
+  WriteTiffEntry(stream, ModelTiepoint, TiffDouble, 6, tiepoint);
+  WriteTiffEntry(stream, GeoKeyDirectory, TiffShort, 16, geoKeys);
+  stream << quint32(0);                                               // the last directory
+
+  // The size of a cell, and the north west corner of the first
+  stream << (m_east - m_west) / m_columns << (m_north - m_south) / m_rows << 0.0;
+  stream << 0.0 << 0.0 << 0.0 << m_west << m_north << 0.0;
+
+  // Geographic, pixel is area, WGS 84
+  const quint16 keys[16] = {
+    1, 1, 0, 3,
+    1024, 0, 1, 2,        // GTModelTypeGeoKey: ModelTypeGeographic
+    1025, 0, 1, 1,        // GTRasterTypeGeoKey: RasterPixelIsArea
+    2048, 0, 1, 4326      // GeographicTypeGeoKey: GCS_WGS_84
+  };
+  for (quint16 key : keys)
+    stream << key;
+
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  for (float value : m_values)
+    stream << value;
+  return stream.status() == QDataStream::Ok;
+}
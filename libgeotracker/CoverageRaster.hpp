@@ -0,0 +1,124 @@
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QGeoCoordinate>
+#include "GeoPoint.hpp"
+#include "Refraction.hpp"
+
+class QIODevice;
+class GeoObserver;
+
+// A CoverageRaster computes which sites (GeoObservers) can see a point
+// at a given altitude above their elevation masks, for every cell of
+// a latitude and longitude grid, as a siting study would.
+//
+// The grid covers [south, north] x [west, east] in cells of equal
+// angular size, the value of a cell being that of its center.  Row 0
+// is the northernmost, as in an image.  The east edge may exceed 180
+// degrees for a grid across the antimeridian.
+//
+// The value of a cell is one of:
+//
+// - SiteCount: the number of sites that see it.
+// - SiteMask: the sites that see it, site i as bit i.  Only the first
+//   24 sites are exact in a float: the sites from 24 on are left out
+//   of the mask, with a warning from compute().
+// - MaximumElevation: the highest apparent elevation at which a site
+//   sees it, or -90 if none does.
+//
+// Rather than a LookAngle per site and cell, a row of cells is at a
+// single latitude, so its cells are the points (A cos(lon), A sin(lon),
+// Z) of a circle around the axis of the Earth, A and Z being those
+// of the conversion of LookAngle.  The cosines and sines of the
+// longitudes are stepped along the row by the rotation of one cell,
+// from a value computed exactly at the start of each tile row, and
+// each site is then tested against the whole row at once: up = normal
+// . (cell - site) against range sin(mask).  Only the cells within the
+// largest refraction of the mask take the arc tangent and the
+// refraction model.
+//
+// The tiles of the grid are computed in parallel on the global
+// thread pool.  The raster may be written as a GeoTIFF (32 bit float,
+// WGS 84 geographic, pixel is area) or as raw 32 bit little endian
+// floats, row by row from the north.
+
+class CoverageRaster
+{
+public:
+  enum Value {
+    SiteCount,
+    SiteMask,
+    MaximumElevation
+  };
+
+  enum Format {
+    RawFormat,
+    GeoTiffFormat
+  };
+
+  CoverageRaster();
+
+  // The grid, in degrees
+  void setGrid(double south, double west, double north, double east, int columns, int rows);
+  double south() const;
+  double west() const;
+  double north() const;
+  double east() const;
+  int columns() const;
+  int rows() const;
+
+  // The altitude of the cells in meters
+  double altitude() const;
+  void setAltitude(double altitude);
+
+  Value value() const;
+  void setValue(Value value);
+
+  // The cells of a side of a tile
+  int tileSize() const;
+  void setTileSize(int tileSize);
+
+  // Add a site, returning its index
+  int addSite(QGeoCoordinate const &position, double elevationMask = 0.0,
+              Refraction const &refraction = Refraction());
+  int addSite(GeoObserver const &observer);
+  int siteCount() const;
+  void clearSites();
+
+  // Compute the values of the cells
+  void compute();
+
+  // The values, row by row from the north
+  QVector<float> const &values() const;
+  float value(int column, int row) const;
+  QGeoCoordinate cellCenter(int column, int row) const;
+
+  bool write(QString const &fileName, Format format);
+  QString errorString() const;
+
+private:
+  struct Site
+  {
+    GeoPoint point;
+    GeoPoint normal;
+    double elevationMask;
+    double sinMask;       // the sine of the mask
+    double sinLowest;     // of the lowest geometric elevation that may
+                          // be refracted above the mask
+    Refraction refraction;
+  };
+
+  void computeTile(int tile, float *raster) const;
+  bool writeRaw(QIODevice *device) const;
+  bool writeGeoTiff(QIODevice *device) const;
+
+  double m_south, m_west, m_north, m_east;
+  int m_columns, m_rows;
+  double m_altitude;
+  Value m_value;
+  int m_tileSize;
+  QVector<Site> m_sites;
+  QVector<float> m_values;
+  QString m_errorString;
+};
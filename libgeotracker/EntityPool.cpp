@@ -0,0 +1,112 @@
+#include "EntityPool.hpp"
+
+EntityPool::EntityPool(int slabSize) :
+  m_slabSize(qMax(1, slabSize))
+{
+}
+
+EntityPool::~EntityPool()
+{
+  for (EntityRecord *slab : m_slabs)
+    delete [] slab;
+}
+
+EntityRecord *EntityPool::slot(quint32 index) const
+{
+  return m_slabs.at(int(index) / m_slabSize) + int(index) % m_slabSize;
+}
+
+EntityHandle EntityPool::acquire(quint64 id)
+{
+  EntityHandle handle = find(id);
+  if (!handle.isNull())
+    return handle;
+
+  if (m_free.isEmpty()) {
+    // A new slab, its slots taken lowest first
+    const int first = m_generations.size();
+    m_slabs.append(new EntityRecord[m_slabSize]);
+    m_generations.resize(first + m_slabSize);
+    for (int index = first + m_slabSize - 1; index >= first; --index)
+      m_free.append(quint32(index));
+  }
+  const quint32 index = m_free.takeLast();
+  const quint32 generation = ++m_generations[int(index)];
+
+  EntityRecord *record = slot(index);
+  record->id = id;
+  record->position = PositionSample::invalid(id);
+  record->rotationTimestamp = 0;
+  record->pitch = 0.0;
+  record->roll = 0.0;
+  record->yaw = 0.0;
+  m_indexes.insert(id, index);
+  return EntityHandle(index, generation);
+}
+
+EntityHandle EntityPool::find(quint64 id) const
+{
+  const int index = int(m_indexes.value(id, quint32(m_generations.size())));
+  if (index >= m_generations.size())
+    return EntityHandle();
+  return EntityHandle(quint32(index), m_generations.at(index));
+}
+
+void EntityPool::release(EntityHandle handle)
+{
+  if (!contains(handle))
+    return;
+  ++m_generations[int(handle.index)];
+  m_indexes.remove(slot(handle.index)->id);
+  m_free.append(handle.index);
+}
+
+bool EntityPool::contains(EntityHandle handle) const
+{
+  return !handle.isNull()
+    && int(handle.index) < m_generations.size()
+    && m_generations.at(int(handle.index)) == handle.generation;
+}
+
+EntityRecord *EntityPool::record(EntityHandle handle)
+{
+  return contains(handle) ? slot(handle.index) : nullptr;
+}
+
+EntityRecord const *EntityPool::record(EntityHandle handle) const
+{
+  return contains(handle) ? slot(handle.index) : nullptr;
+}
+
+EntityHandle EntityPool::update(PositionSample const &sample)
+{
+  EntityHandle handle = acquire(sample.id);
+  slot(handle.index)->position = sample;
+  return handle;
+}
+
+int EntityPool::expire(qint64 olderThan)
+{
+  int released = 0;
+  for (int index = 0; index < m_generations.size(); ++index) {
+    const quint32 generation = m_generations.at(index);
+    if (!(generation & 1))
+      continue;
+    PositionSample const &position = slot(quint32(index))->position;
+    if (!position.isValid() || position.timestamp < olderThan) {
+      release(EntityHandle(quint32(index), generation));
+      ++released;
+    }
+  }
+  return released;
+}
+
+int EntityPool::count() const
+{
+  return m_indexes.size();
+}
+
+int EntityPool::capacity() const
+{
+  return m_generations.size();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QHash>
+#include <QVector>
+#include "PositionSample.hpp"
+
+// The state of an entity in an EntityPool: what a GeoEntity holds,
+// without the QObject.
+struct EntityRecord
+{
+  quint64        id;
+  PositionSample position;            // invalid until the first sample
+  qint64         rotationTimestamp;   // microseconds, as QSensorReading
+  double         pitch;               // degrees, as the x, y and z of a QRotationReading
+  double         roll;
+  double         yaw;
+};
+
+// A handle on a record of an EntityPool.  A handle outlives its
+// record safely: once the record is released, the pool no longer
+// resolves the handle, even if the slot is reused.
+struct EntityHandle
+{
+  quint32 index;
+  quint32 generation;
+
+  EntityHandle() : index(0), generation(0) {}
+  EntityHandle(quint32 index, quint32 generation) : index(index), generation(generation) {}
+  bool isNull() const { return generation == 0; }
+  bool operator==(EntityHandle const &other) const { return index == other.index && generation == other.generation; }
+  bool operator!=(EntityHandle const &other) const { return !(*this == other); }
+};
+
+// An EntityPool holds the state of many entities without a QObject
+// (and its private data, and a QRotationReading) for each, for the
+// feeds in which entities come and go by the thousand.
+//
+// The records are allocated in slabs of a fixed number of records,
+// which are never moved or freed until the pool is destroyed, so a
+// record stays at the same address for as long as it is in use.
+// Released records are reused, newest first, and a generation count
+// tells the handles of the previous user of a slot from those of the
+// current one.
+//
+// The records are also found by the id of their samples.  A
+// GeoEntity is an optional wrapper for the entities that need
+// signals (see GeoEntityDispatcher::setPool).
+//
+// An EntityPool is not thread safe.
+
+class EntityPool
+{
+public:
+  EntityPool(int slabSize = 1024);
+  ~EntityPool();
+
+  // The record of an id, created if there is none yet
+  EntityHandle acquire(quint64 id);
+  // The record of an id, or a null handle
+  EntityHandle find(quint64 id) const;
+  void release(EntityHandle handle);
+
+  // The record of a handle, or null if it was released
+  bool contains(EntityHandle handle) const;
+  EntityRecord *record(EntityHandle handle);
+  EntityRecord const *record(EntityHandle handle) const;
+
+  // Update the position of the record of the sample's id, creating
+  // it if needed.
+  EntityHandle update(PositionSample const &sample);
+
+  // Release the records whose latest position is older than a time
+  // (milliseconds since 1970, UTC), or that have none.  Returns the
+  // number of records released.
+  int expire(qint64 olderThan);
+
+  // The records in use, and the records allocated
+  int count() const;
+  int capacity() const;
+
+  // Call a function with each record in use, in slot order.
+  template <typename Function>
+  void forEach(Function function) const
+  {
+    for (int index = 0; index < m_generations.size(); ++index) {
+      if (m_generations.at(index) & 1)
+        function(EntityHandle(quint32(index), m_generations.at(index)), *slot(quint32(index)));
+    }
+  }
+
+private:
+  Q_DISABLE_COPY(EntityPool)
+
+  EntityRecord *slot(quint32 index) const;
+
+  int m_slabSize;
+  QVector<EntityRecord *> m_slabs;
+  QVector<quint32> m_generations;   // odd while in use
+  QVector<quint32> m_free;
+  QHash<quint64, quint32> m_indexes; // id to slot
+};
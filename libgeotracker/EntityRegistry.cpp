@@ -0,0 +1,342 @@
+#include <QThread>
+#include <cstring>
+#include <algorithm>
+#include "EntityRegistry.hpp"
+
+// The number of buckets of the timing wheel, a power of two, and the
+// number of ticks in a timeout, less than half of it so that an
+// entity is always scheduled less than a turn of the wheel ahead.
+static const int WheelSize = 256;
+static const int TicksPerTimeout = 128;
+
+static
+quint64 Hash(QUuid const &uuid)
+{
+  // The bits of a QUuid made from a sample id are all in its first
+  // half, and those of a random one all over, so the halves are
+  // mixed.  qHash(QUuid) xors them together without mixing, which
+  // leaves the low bits of consecutive ids the same.
+  quint64 a = (quint64(uuid.data1) << 32) | (quint64(uuid.data2) << 16) | uuid.data3;
+  quint64 b;
+  std::memcpy(&b, uuid.data4, sizeof(b));
+  quint64 h = (a ^ (b * Q_UINT64_C(0x9e3779b97f4a7c15))) * Q_UINT64_C(0xff51afd7ed558ccd);
+  return h ^ (h >> 33);
+}
+
+EntityRegistry::EntityRegistry(int timeout, QObject *parent) :
+  QObject(parent),
+  m_timeout(qMax(1, timeout)),
+  m_resolution(qMax(1, (m_timeout + TicksPerTimeout - 1) / TicksPerTimeout)),
+  m_sink(nullptr),
+  m_pool(nullptr),
+  m_free(-1),
+  m_count(0),
+  m_table(16, -1),
+  m_wheel(WheelSize, -1),
+  m_time(0),
+  timer(new QTimer(this))
+{
+  m_clock.start();
+  timer->setInterval(m_resolution);
+  connect(timer, SIGNAL(timeout()), this, SLOT(expire()));
+}
+
+int EntityRegistry::timeout() const
+{
+  return m_timeout;
+}
+
+void EntityRegistry::setTimeout(int msecs)
+{
+  m_timeout = qMax(1, msecs);
+  m_resolution = qMax(1, (m_timeout + TicksPerTimeout - 1) / TicksPerTimeout);
+  timer->setInterval(m_resolution);
+
+  // The ticks have changed: schedule every entity again.
+  m_wheel.fill(-1);
+  for (int entry : m_table) {
+    if (entry >= 0) {
+      m_entries[entry].bucket = -1;
+      schedule(entry, (m_entries.at(entry).lastSeen + m_timeout) / m_resolution + 1);
+    }
+  }
+}
+
+int EntityRegistry::resolution() const
+{
+  return m_resolution;
+}
+
+PositionSampleSink *EntityRegistry::sampleSink() const
+{
+  return m_sink;
+}
+
+void EntityRegistry::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+EntityPool *EntityRegistry::pool() const
+{
+  return m_pool;
+}
+
+void EntityRegistry::setPool(EntityPool *pool)
+{
+  m_pool = pool;
+}
+
+int EntityRegistry::count() const
+{
+  return m_count;
+}
+
+int EntityRegistry::capacity() const
+{
+  return m_entries.size();
+}
+
+bool EntityRegistry::contains(QUuid const &uuid) const
+{
+  return find(uuid) >= 0;
+}
+
+qint64 EntityRegistry::lastSeen(QUuid const &uuid) const
+{
+  const int entry = find(uuid);
+  return entry < 0 ? -1 : m_entries.at(entry).lastSeen;
+}
+
+qint64 EntityRegistry::elapsed() const
+{
+  return m_clock.elapsed();
+}
+
+QUuid EntityRegistry::uuidOf(quint64 id)
+{
+  // The id in the first half, and a constant in the second
+  return QUuid(uint(id >> 32), ushort(id >> 16), ushort(id),
+               'g', 'e', 'o', 't', 'r', 'a', 'c', 'k');
+}
+
+int EntityRegistry::home(QUuid const &uuid) const
+{
+  return int(Hash(uuid) & quint64(m_table.size() - 1));
+}
+
+int EntityRegistry::find(QUuid const &uuid) const
+{
+  const int mask = m_table.size() - 1;
+  for (int i = home(uuid); m_table.at(i) >= 0; i = (i + 1) & mask) {
+    if (m_entries.at(m_table.at(i)).uuid == uuid)
+      return m_table.at(i);
+  }
+  return -1;
+}
+
+void EntityRegistry::rehash(int size)
+{
+  QVector<int> table(size, -1);
+  table.swap(m_table);
+  const int mask = size - 1;
+  for (int entry : table) {
+    if (entry < 0)
+      continue;
+    int i = home(m_entries.at(entry).uuid);
+    while (m_table.at(i) >= 0)
+      i = (i + 1) & mask;
+    m_table[i] = entry;
+  }
+}
+
+int EntityRegistry::insert(QUuid const &uuid)
+{
+  // At most half full
+  if (2 * (m_count + 1) > m_table.size())
+    rehash(2 * m_table.size());
+
+  int entry = m_free;
+  if (entry >= 0) {
+    m_free = m_entries.at(entry).next;
+  } else {
+    entry = m_entries.size();
+    m_entries.resize(entry + 1);
+  }
+  Entry &e = m_entries[entry];
+  e.uuid = uuid;
+  e.id = 0;
+  e.hasId = false;
+  e.lastSeen = 0;
+  e.bucket = -1;
+
+  const int mask = m_table.size() - 1;
+  int i = home(uuid);
+  while (m_table.at(i) >= 0)
+    i = (i + 1) & mask;
+  m_table[i] = entry;
+  ++m_count;
+  return entry;
+}
+
+void EntityRegistry::erase(int entry)
+{
+  unlink(entry);
+
+  const int mask = m_table.size() - 1;
+  int i = home(m_entries.at(entry).uuid);
+  while (m_table.at(i) != entry)
+    i = (i + 1) & mask;
+
+  // Shift back the entries after it that may not be found otherwise,
+  // rather than leave a tombstone.
+  for (int j = (i + 1) & mask; m_table.at(j) >= 0; j = (j + 1) & mask) {
+    const int k = home(m_entries.at(m_table.at(j)).uuid);
+    if (j > i ? (k <= i || k > j) : (k <= i && k > j)) {
+      m_table[i] = m_table.at(j);
+      i = j;
+    }
+  }
+  m_table[i] = -1;
+
+  m_entries[entry].next = m_free;
+  m_free = entry;
+  --m_count;
+}
+
+void EntityRegistry::schedule(int entry, qint64 tick)
+{
+  tick = qMax(tick, m_time / m_resolution + 1);
+  Entry &e = m_entries[entry];
+  e.bucket = int(tick & (WheelSize - 1));
+  e.previous = -1;
+  e.next = m_wheel.at(e.bucket);
+  if (e.next >= 0)
+    m_entries[e.next].previous = entry;
+  m_wheel[e.bucket] = entry;
+}
+
+void EntityRegistry::unlink(int entry)
+{
+  Entry &e = m_entries[entry];
+  if (e.bucket < 0)
+    return;
+  if (e.previous >= 0)
+    m_entries[e.previous].next = e.next;
+  else
+    m_wheel[e.bucket] = e.next;
+  if (e.next >= 0)
+    m_entries[e.next].previous = e.previous;
+  e.bucket = -1;
+}
+
+int EntityRegistry::update(QUuid const &uuid, qint64 time)
+{
+  int entry = find(uuid);
+  if (entry >= 0) {
+    // Moved to its new bucket when its current one comes up
+    Entry &e = m_entries[entry];
+    e.lastSeen = qMax(e.lastSeen, time);
+    return entry;
+  }
+  entry = insert(uuid);
+  m_entries[entry].lastSeen = time;
+  schedule(entry, (time + m_timeout) / m_resolution + 1);
+  m_appeared.append(uuid);
+  if (!timer->isActive())
+    timer->start();
+  return entry;
+}
+
+void EntityRegistry::touch(QUuid const &uuid, qint64 time)
+{
+  update(uuid, time);
+}
+
+void EntityRegistry::touch(quint64 id, qint64 time)
+{
+  Entry &e = m_entries[update(uuidOf(id), time)];
+  e.id = id;
+  e.hasId = true;
+}
+
+bool EntityRegistry::remove(QUuid const &uuid)
+{
+  const int entry = find(uuid);
+  if (entry < 0)
+    return false;
+  erase(entry);
+  return true;
+}
+
+void EntityRegistry::expire(qint64 time)
+{
+  const qint64 last = m_time / m_resolution;
+  const qint64 now = time / m_resolution;
+  m_time = qMax(m_time, time);
+
+  // One turn of the wheel at most visits every bucket.
+  for (qint64 tick = qMax(last + 1, now - WheelSize + 1); tick <= now; ++tick) {
+    const int bucket = int(tick & (WheelSize - 1));
+    int entry = m_wheel.at(bucket);
+    m_wheel[bucket] = -1;
+    while (entry >= 0) {
+      Entry &e = m_entries[entry];
+      const int next = e.next;
+      e.bucket = -1;
+      if (e.lastSeen + m_timeout <= m_time) {
+        m_lost.append(e.uuid);
+        if (m_pool && e.hasId)
+          m_pool->release(m_pool->find(e.id));
+        erase(entry);
+      } else {
+        schedule(entry, (e.lastSeen + m_timeout) / m_resolution + 1);
+      }
+      entry = next;
+    }
+  }
+
+  // Handed over before emitting, in case a receiver touches or
+  // expires in turn.
+  if (!m_appeared.isEmpty()) {
+    QVector<QUuid> uuids;
+    uuids.swap(m_appeared);
+    emit appeared(uuids);
+  }
+  if (!m_lost.isEmpty()) {
+    QVector<QUuid> uuids;
+    uuids.swap(m_lost);
+    emit lost(uuids);
+  }
+  if (m_count == 0 && m_appeared.isEmpty())
+    timer->stop();
+}
+
+void EntityRegistry::expire()
+{
+  expire(elapsed());
+}
+
+void EntityRegistry::consume(PositionSample const *samples, int count)
+{
+  if (count <= 0)
+    return;
+  if (QThread::currentThread() == thread()) {
+    receive(samples, count);
+    return;
+  }
+  QVector<PositionSample> copy(count);
+  std::copy(samples, samples + count, copy.begin());
+  QMetaObject::invokeMethod(this, [this, copy]() {
+      receive(copy.constData(), copy.size());
+    }, Qt::QueuedConnection);
+}
+
+void EntityRegistry::receive(PositionSample const *samples, int count)
+{
+  const qint64 time = elapsed();
+  for (int i = 0; i < count; ++i)
+    touch(samples[i].id, time);
+  if (m_sink)
+    m_sink->consume(samples, count);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <QObject>
+#include <QUuid>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "PositionSample.hpp"
+#include "EntityPool.hpp"
+
+// An EntityRegistry keeps track of which entities are alive, so that
+// the ones that stop reporting are forgotten rather than kept, and
+// worked on, forever.
+//
+// Entities are known by their QUuid (see GeoEntity::uuid), or by the
+// id of their samples when the registry is a sample sink, from which
+// a name based QUuid is made (see uuidOf).  Each report touches the
+// entity; an entity that is not touched for the timeout is lost.
+// Lost entities are also released from the pool, if there is one.
+//
+// The appearances and losses are announced in batches: appeared() and
+// lost() are emitted at most once per tick of the expiry, with all
+// the entities concerned since the last tick.
+//
+// The entities are held in a flat table, found through an open
+// addressing hash table with linear probing; the slots of the lost
+// entities are reused.  Expiry is by a timing wheel: each entity is
+// in the bucket of the tick at which it would expire.  A touch only
+// records the time, and an entity whose bucket comes up that was
+// touched since is moved to its new bucket then, so the cost of a
+// tick is the number of entities in its bucket, not the number of
+// entities.  The wheel has 256 buckets; the tick is a 128th of the
+// timeout, which is therefore the precision of the expiry.
+//
+// Times are in milliseconds of the clock of the registry (see
+// elapsed), which starts with the registry.  Samples consumed from
+// another thread are copied and queued to the thread of the
+// registry.  The samples are passed on to the sample sink, if any.
+
+class EntityRegistry : public QObject, public PositionSampleSink
+{
+  Q_OBJECT
+public:
+  EntityRegistry(int timeout = 10000, QObject *parent = nullptr);
+
+  // The time, in milliseconds, after which an entity is lost
+  int timeout() const;
+  void setTimeout(int msecs);
+  // The tick of the expiry, in milliseconds
+  int resolution() const;
+
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+  // The pool of records to release the lost entities from, which is
+  // not owned, or null
+  EntityPool *pool() const;
+  void setPool(EntityPool *pool);
+
+  // The entities alive, and the slots allocated for them
+  int count() const;
+  int capacity() const;
+
+  bool contains(QUuid const &uuid) const;
+  // The time the entity was last touched, or -1 if it is not known
+  qint64 lastSeen(QUuid const &uuid) const;
+
+  // Record a report of an entity at a time of the clock, adding the
+  // entity if it is new.  A report of a sample id also tells which
+  // pool record to release when the entity is lost.
+  void touch(QUuid const &uuid, qint64 time);
+  void touch(quint64 id, qint64 time);
+
+  // Forget an entity without announcing its loss
+  bool remove(QUuid const &uuid);
+
+  // The clock of the registry
+  qint64 elapsed() const;
+
+  // The QUuid of the entity of a sample id
+  static QUuid uuidOf(quint64 id);
+
+  virtual void consume(PositionSample const *samples, int count);
+
+signals:
+  void appeared(QVector<QUuid> const &uuids);
+  void lost(QVector<QUuid> const &uuids);
+
+public slots:
+  // Expire the entities not touched for the timeout at a time of the
+  // clock, or now, and announce the changes since the last time.
+  void expire(qint64 time);
+  void expire();
+
+private:
+  struct Entry
+  {
+    QUuid   uuid;
+    quint64 id;                 // of the samples, or 0
+    bool    hasId;
+    qint64  lastSeen;
+    int     bucket;             // -1 while free
+    int     next;               // in the bucket, or in the free list
+    int     previous;
+  };
+
+  int find(QUuid const &uuid) const;
+  int home(QUuid const &uuid) const;
+  int insert(QUuid const &uuid);
+  int update(QUuid const &uuid, qint64 time);
+  void erase(int entry);
+  void rehash(int size);
+  void schedule(int entry, qint64 tick);
+  void unlink(int entry);
+  void receive(PositionSample const *samples, int count);
+
+  int m_timeout;
+  int m_resolution;
+  PositionSampleSink *m_sink;
+  EntityPool *m_pool;
+  QVector<Entry> m_entries;
+  int m_free;                   // the first free entry
+  int m_count;
+  QVector<int> m_table;         // entry indexes, -1 for empty
+  QVector<int> m_wheel;         // the first entry of each bucket
+  qint64 m_time;                // of the last expiry
+  QVector<QUuid> m_appeared;
+  QVector<QUuid> m_lost;
+  QElapsedTimer m_clock;
+  QTimer *timer;
+};
@@ -0,0 +1,412 @@
+#include <cmath>
+#include <QtGlobal>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "FastMath.hpp"
+
+static const double Pi = 3.14159265358979323846;
+static const double PiOver2 = 1.57079632679489661923;
+static const double PiOver4 = 0.78539816339744830962;
+static const double TwoOverPi = 0.63661977236758134308;
+static const double TanPiOver8 = 0.41421356237309504880;
+
+// pi/2 in three parts, the first two of 33 bits, so that k times
+// either is exact for |k| < 2^20 (fdlibm)
+static const double PiOver2Part1 = 1.57079632673412561417e+00;
+static const double PiOver2Part2 = 6.07710050630396597660e-11;
+static const double PiOver2Part3 = 2.02226624871116645580e-21;
+
+// The largest argument reduced by sinCos()
+static const double SinCosLimit = 1.0e6;
+
+// Adding then subtracting 1.5 * 2^52 rounds a double of magnitude
+// below 2^51 to the nearest integer, without a call.
+static const double RoundingShift = 6755399441055744.0;
+
+// The arithmetic of the kernels, on a double or on a register of
+// them, so that each kernel is written once.  A mask is a bool or a
+// register of all-ones or all-zeros lanes.
+
+static inline double Constant(double c, double) { return c; }
+static inline double Add(double a, double b) { return a + b; }
+static inline double Sub(double a, double b) { return a - b; }
+static inline double Mul(double a, double b) { return a * b; }
+static inline double Div(double a, double b) { return a / b; }
+static inline double Sqrt(double a) { return std::sqrt(a); }
+static inline double Abs(double a) { return std::fabs(a); }
+static inline bool Greater(double a, double b) { return a > b; }
+static inline bool IsNegative(double a) { return std::signbit(a); }
+static inline double Select(bool mask, double a, double b) { return mask ? a : b; }
+static inline double CopySign(double magnitude, double sign) { return std::copysign(magnitude, sign); }
+
+#ifdef __SSE2__
+static inline __m128d Constant(double c, __m128d) { return _mm_set1_pd(c); }
+static inline __m128d Add(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+static inline __m128d Sub(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+static inline __m128d Mul(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+static inline __m128d Div(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+static inline __m128d Sqrt(__m128d a) { return _mm_sqrt_pd(a); }
+static inline __m128d SignBits() { return _mm_set1_pd(-0.0); }
+static inline __m128d Abs(__m128d a) { return _mm_andnot_pd(SignBits(), a); }
+static inline __m128d Greater(__m128d a, __m128d b) { return _mm_cmpgt_pd(a, b); }
+static inline __m128d Select(__m128d mask, __m128d a, __m128d b)
+{
+  return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+static inline __m128d IsNegative(__m128d a)
+{
+  // The sign bit spread over the lane
+  return _mm_castsi128_pd(_mm_shuffle_epi32(_mm_srai_epi32(_mm_castpd_si128(a), 31), _MM_SHUFFLE(3, 3, 1, 1)));
+}
+static inline __m128d CopySign(__m128d magnitude, __m128d sign)
+{
+  return _mm_or_pd(Abs(magnitude), _mm_and_pd(SignBits(), sign));
+}
+#endif
+
+// The minimax polynomials, in u = x^2, of
+//
+//   sin(x) = x + x^3 sine(u)                   |x| <= pi/4
+//   cos(x) = 1 - u/2 + u^2 cosine(u)           |x| <= pi/4
+//   atan(x) = x + x^3 arcTangent(u)            |x| <= tan(pi/8)
+//
+// fitted for the least maximum error by Lawson's iteration.
+
+template <FastMath::Accuracy> struct Polynomials;
+
+template <>
+struct Polynomials<FastMath::Precise>
+{
+  template <class V>
+  static V sine(V u)
+  {
+    V p = Constant(-2.4745485630516536e-08, u);
+    p = Add(Mul(p, u), Constant(2.7555099294557042e-06, u));
+    p = Add(Mul(p, u), Constant(-0.00019841262368013154, u));
+    p = Add(Mul(p, u), Constant(0.0083333333219282948, u));
+    return Add(Mul(p, u), Constant(-0.16666666666606084, u));
+  }
+
+  template <class V>
+  static V cosine(V u)
+  {
+    V p = Constant(-2.7210236729012818e-07, u);
+    p = Add(Mul(p, u), Constant(2.4799519993086405e-05, u));
+    p = Add(Mul(p, u), Constant(-0.0013888883753334564, u));
+    return Add(Mul(p, u), Constant(0.041666666622826906, u));
+  }
+
+  template <class V>
+  static V arcTangent(V u)
+  {
+    V p = Constant(-0.03697811905191295, u);
+    p = Add(Mul(p, u), Constant(0.069322478503179116, u));
+    p = Add(Mul(p, u), Constant(-0.089822998644261742, u));
+    p = Add(Mul(p, u), Constant(0.11102210499133669, u));
+    p = Add(Mul(p, u), Constant(-0.14285308957333109, u));
+    p = Add(Mul(p, u), Constant(0.1999999081655543, u));
+    return Add(Mul(p, u), Constant(-0.33333333257229092, u));
+  }
+};
+
+template <>
+struct Polynomials<FastMath::Approximate>
+{
+  template <class V>
+  static V sine(V u)
+  {
+    V p = Constant(-0.00019495634615240341, u);
+    p = Add(Mul(p, u), Constant(0.0083319786475574854, u));
+    return Add(Mul(p, u), Constant(-0.16666650668937555, u));
+  }
+
+  template <class V>
+  static V cosine(V u)
+  {
+    V p = Constant(2.4438449681674234e-05, u);
+    p = Add(Mul(p, u), Constant(-0.0013887367496707157, u));
+    return Add(Mul(p, u), Constant(0.041666646865985847, u));
+  }
+
+  template <class V>
+  static V arcTangent(V u)
+  {
+    V p = Constant(0.079025844227181369, u);
+    p = Add(Mul(p, u), Constant(-0.13824448771159459, u));
+    p = Add(Mul(p, u), Constant(0.19971878737409565, u));
+    return Add(Mul(p, u), Constant(-0.33332756649166212, u));
+  }
+};
+
+// The sine and cosine of the reduced argument r, |r| <= pi/4
+template <FastMath::Accuracy A, class V>
+static inline void SinCosReduced(V r, V *sine, V *cosine)
+{
+  const V u = Mul(r, r);
+  *sine = Add(r, Mul(Mul(r, u), Polynomials<A>::sine(u)));
+  *cosine = Add(Sub(Constant(1.0, u), Mul(Constant(0.5, u), u)), Mul(Mul(u, u), Polynomials<A>::cosine(u)));
+}
+
+template <FastMath::Accuracy A>
+static inline void SinCos(double x, double *sine, double *cosine)
+{
+  const double k = (x * TwoOverPi + RoundingShift) - RoundingShift;
+  const double r = ((x - k * PiOver2Part1) - k * PiOver2Part2) - k * PiOver2Part3;
+  double s, c;
+  SinCosReduced<A>(r, &s, &c);
+  // By quadrant
+  const int q = int(k) & 3;
+  const double ss = (q & 1) ? c : s;
+  const double cc = (q & 1) ? s : c;
+  *sine = (q & 2) ? -ss : ss;
+  *cosine = ((q + 1) & 2) ? -cc : cc;
+}
+
+// The arc tangent of a in [0, 1]
+template <FastMath::Accuracy A, class V>
+static inline V ArcTangent(V a)
+{
+  const auto isReduced = Greater(a, Constant(TanPiOver8, a));
+  const V t = Select(isReduced, Div(Sub(a, Constant(1.0, a)), Add(a, Constant(1.0, a))), a);
+  const V u = Mul(t, t);
+  const V base = Select(isReduced, Constant(PiOver4, a), Constant(0.0, a));
+  return Add(base, Add(t, Mul(Mul(t, u), Polynomials<A>::arcTangent(u))));
+}
+
+template <FastMath::Accuracy A, class V>
+static inline V ArcTangent2(V y, V x)
+{
+  const V ax = Abs(x);
+  const V ay = Abs(y);
+  const auto isSteep = Greater(ay, ax);
+  const V larger = Select(isSteep, ay, ax);
+  const V smaller = Select(isSteep, ax, ay);
+  // 0/0 at the origin, made 0
+  const auto isNonZero = Greater(larger, Constant(0.0, x));
+  const V a = Select(isNonZero, Div(smaller, Select(isNonZero, larger, Constant(1.0, x))), Constant(0.0, x));
+  V t = ArcTangent<A>(a);
+  t = Select(isSteep, Sub(Constant(PiOver2, x), t), t);
+  t = Select(IsNegative(x), Sub(Constant(Pi, x), t), t);
+  return CopySign(t, y);
+}
+
+template <FastMath::Accuracy A, class V>
+static inline V ArcCosine(V x)
+{
+  const V one = Constant(1.0, x);
+  return ArcTangent2<A>(Sqrt(Mul(Sub(one, x), Add(one, x))), x);
+}
+
+#ifdef __SSE2__
+template <FastMath::Accuracy A>
+static inline void SinCos(__m128d x, __m128d *sine, __m128d *cosine)
+{
+  const __m128d shift = _mm_set1_pd(RoundingShift);
+  const __m128d k = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(x, _mm_set1_pd(TwoOverPi)), shift), shift);
+  const __m128d r = _mm_sub_pd(_mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, _mm_set1_pd(PiOver2Part1))),
+                                          _mm_mul_pd(k, _mm_set1_pd(PiOver2Part2))),
+                               _mm_mul_pd(k, _mm_set1_pd(PiOver2Part3)));
+  __m128d s, c;
+  SinCosReduced<A>(r, &s, &c);
+
+  // By quadrant: the masks of q & 1, q & 2 and (q + 1) & 2, made
+  // 64 bits wide
+  const __m128i q = _mm_cvtpd_epi32(k);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128i swap = _mm_cmpeq_epi32(_mm_and_si128(q, one), one);
+  const __m128i negateSine = _mm_cmpeq_epi32(_mm_and_si128(q, two), two);
+  const __m128i negateCosine = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), two);
+  const __m128d isSwapped = _mm_castsi128_pd(_mm_shuffle_epi32(swap, _MM_SHUFFLE(1, 1, 0, 0)));
+  const __m128d sineSign = _mm_and_pd(_mm_castsi128_pd(_mm_shuffle_epi32(negateSine, _MM_SHUFFLE(1, 1, 0, 0))), SignBits());
+  const __m128d cosineSign = _mm_and_pd(_mm_castsi128_pd(_mm_shuffle_epi32(negateCosine, _MM_SHUFFLE(1, 1, 0, 0))), SignBits());
+  *sine = _mm_xor_pd(Select(isSwapped, c, s), sineSign);
+  *cosine = _mm_xor_pd(Select(isSwapped, s, c), cosineSign);
+}
+#endif
+
+template <FastMath::Accuracy A>
+static void SinCosBatch(int count, double const *x, double *sine, double *cosine)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= count; i += 2) {
+    __m128d s, c;
+    SinCos<A>(_mm_loadu_pd(x + i), &s, &c);
+    _mm_storeu_pd(sine + i, s);
+    _mm_storeu_pd(cosine + i, c);
+  }
+#endif
+  for (; i < count; ++i)
+    SinCos<A>(x[i], sine + i, cosine + i);
+}
+
+template <FastMath::Accuracy A>
+static void ArcTangent2Batch(int count, double const *y, double const *x, double *angle)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= count; i += 2)
+    _mm_storeu_pd(angle + i, ArcTangent2<A>(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+#endif
+  for (; i < count; ++i)
+    angle[i] = ArcTangent2<A>(y[i], x[i]);
+}
+
+template <FastMath::Accuracy A>
+static void ArcTangent2Batch(int count, float const *y, float const *x, float *angle)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= count; i += 2) {
+    const __m128d yy = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const *>(y + i))));
+    const __m128d xx = _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<double const *>(x + i))));
+    _mm_store_sd(reinterpret_cast<double *>(angle + i), _mm_castps_pd(_mm_cvtpd_ps(ArcTangent2<A>(yy, xx))));
+  }
+#endif
+  for (; i < count; ++i)
+    angle[i] = float(ArcTangent2<A>(double(y[i]), double(x[i])));
+}
+
+template <FastMath::Accuracy A>
+static void ArcCosineBatch(int count, double const *x, double *angle)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= count; i += 2)
+    _mm_storeu_pd(angle + i, ArcCosine<A>(_mm_loadu_pd(x + i)));
+#endif
+  for (; i < count; ++i)
+    angle[i] = ArcCosine<A>(x[i]);
+}
+
+double FastMath::maximumError(Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    return 1e-12;
+  case Approximate:
+    return 1e-7;
+  default:
+    return 0.0;
+  }
+}
+
+void FastMath::sinCos(double x, double *sine, double *cosine, Accuracy accuracy)
+{
+  if (accuracy == Exact || !(qAbs(x) <= SinCosLimit)) {
+    *sine = std::sin(x);
+    *cosine = std::cos(x);
+  } else if (accuracy == Precise) {
+    SinCos<Precise>(x, sine, cosine);
+  } else {
+    SinCos<Approximate>(x, sine, cosine);
+  }
+}
+
+double FastMath::atan2(double y, double x, Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    return ArcTangent2<Precise>(y, x);
+  case Approximate:
+    return ArcTangent2<Approximate>(y, x);
+  default:
+    return std::atan2(y, x);
+  }
+}
+
+double FastMath::acos(double x, Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    return ArcCosine<Precise>(x);
+  case Approximate:
+    return ArcCosine<Approximate>(x);
+  default:
+    return std::acos(x);
+  }
+}
+
+void FastMath::sinCos(int count, double const *x, double *sine, double *cosine, Accuracy accuracy)
+{
+  // Arguments too large to reduce, seldom if ever, are left to the C
+  // library, one at a time.
+  bool isReducible = true;
+  for (int i = 0; i < count; ++i)
+    isReducible &= qAbs(x[i]) <= SinCosLimit;
+  if (Q_UNLIKELY(!isReducible)) {
+    for (int i = 0; i < count; ++i) {
+      double s, c;
+      sinCos(x[i], &s, &c, accuracy);
+      sine[i] = s;
+      cosine[i] = c;
+    }
+    return;
+  }
+
+  switch (accuracy) {
+  case Precise:
+    SinCosBatch<Precise>(count, x, sine, cosine);
+    break;
+  case Approximate:
+    SinCosBatch<Approximate>(count, x, sine, cosine);
+    break;
+  default:
+    for (int i = 0; i < count; ++i) {
+      const double angle = x[i];
+      sine[i] = std::sin(angle);
+      cosine[i] = std::cos(angle);
+    }
+    break;
+  }
+}
+
+void FastMath::atan2(int count, double const *y, double const *x, double *angle, Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    ArcTangent2Batch<Precise>(count, y, x, angle);
+    break;
+  case Approximate:
+    ArcTangent2Batch<Approximate>(count, y, x, angle);
+    break;
+  default:
+    for (int i = 0; i < count; ++i)
+      angle[i] = std::atan2(y[i], x[i]);
+    break;
+  }
+}
+
+void FastMath::atan2(int count, float const *y, float const *x, float *angle, Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    ArcTangent2Batch<Precise>(count, y, x, angle);
+    break;
+  case Approximate:
+    ArcTangent2Batch<Approximate>(count, y, x, angle);
+    break;
+  default:
+    for (int i = 0; i < count; ++i)
+      angle[i] = float(std::atan2(double(y[i]), double(x[i])));
+    break;
+  }
+}
+
+void FastMath::acos(int count, double const *x, double *angle, Accuracy accuracy)
+{
+  switch (accuracy) {
+  case Precise:
+    ArcCosineBatch<Precise>(count, x, angle);
+    break;
+  case Approximate:
+    ArcCosineBatch<Approximate>(count, x, angle);
+    break;
+  default:
+    for (int i = 0; i < count; ++i)
+      angle[i] = std::acos(x[i]);
+    break;
+  }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// FastMath approximates the trigonometric functions the look angle
+// and geodesy kernels spend most of their time in: sine and cosine,
+// the arc tangent of two arguments and the arc cosine.  Each
+// function is a minimax polynomial after a range reduction, with no
+// table, no branch and no call, so that a batch runs a SIMD register
+// at a time (two doubles with SSE2) and the compiler may unroll and
+// vectorize the rest.
+//
+// The accuracy is chosen per call:
+//
+// - Exact: the C library, to within an ulp or so.
+//
+// - Precise: within 1e-12 of the exact value (in radians for the
+//   inverse functions).  The polynomials are of degree 11 (sine), 10
+//   (cosine) and 15 (arc tangent), and are good to about 2e-13.
+//
+// - Approximate: within 1e-7, with polynomials of degree 7, 8 and 9,
+//   good to about 5e-9.  Enough for angles handed out as float.
+//
+// sinCos() reduces its argument by pi/2 in three parts (Cody and
+// Waite), which keeps the error bounds for |x| up to 1e6 radians;
+// larger arguments are handed to the C library.  atan2() takes the
+// ratio of the smaller to the larger argument, reduced to
+// [0, tan(pi/8)] by atan(t) = pi/4 + atan((t - 1)/(t + 1)), and
+// acos(x) is atan2(sqrt((1 - x)(1 + x)), x).  The arguments must be
+// finite: NaN and infinities are not handled.
+//
+// The errors and the speedups over the C library are checked by
+// test_FastMath, and reported by tracker-bench.
+
+class FastMath
+{
+public:
+  enum Accuracy {
+    Exact,            // the C library
+    Precise,          // within 1e-12
+    Approximate       // within 1e-7
+  };
+
+  // The bound of the error of an accuracy
+  static double maximumError(Accuracy accuracy);
+
+  static void sinCos(double x, double *sine, double *cosine, Accuracy accuracy = Precise);
+  static double atan2(double y, double x, Accuracy accuracy = Precise);
+  static double acos(double x, Accuracy accuracy = Precise);
+
+  // The same over arrays, in place or not.  The float version of
+  // atan2() computes in double.
+  static void sinCos(int count, double const *x, double *sine, double *cosine, Accuracy accuracy = Precise);
+  static void atan2(int count, double const *y, double const *x, double *angle, Accuracy accuracy = Precise);
+  static void atan2(int count, float const *y, float const *x, float *angle, Accuracy accuracy = Approximate);
+  static void acos(int count, double const *x, double *angle, Accuracy accuracy = Precise);
+};
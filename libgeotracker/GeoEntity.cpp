@@ -1,10 +1,12 @@
+#include <QMetaMethod>
 #include "GeoEntity.hpp"
+#include "LatencyTrace.hpp"
 
 GeoEntity::GeoEntity(QObject * parent) :
   QObject(parent),
   m_uuid(QUuid::createUuid()),
   m_position(),
-  m_rotation(new QRotationReading(this))
+  m_rotation(this)
 {
 }
 
@@ -12,14 +14,12 @@ GeoEntity::GeoEntity(QUuid const &uuid) :
   QObject(),
   m_uuid(uuid),
   m_position(),
-  m_rotation(new QRotationReading(this))
-
+  m_rotation(this)
 {
 }
 
 GeoEntity::~GeoEntity()
 {
-  delete m_rotation;
 }
 
 QUuid const GeoEntity::uuid() const
@@ -30,7 +30,22 @@ QUuid const GeoEntity::uuid() const
 void GeoEntity::setPosition(QGeoPositionInfo const &position)
 {
   m_position = position;
-  emit positionChanged(m_position);
+  LATENCY_TRACE_MARK(EntityUpdate);
+  m_positionListeners.notify(m_position);
+
+  static const QMetaMethod positionChangedSignal = QMetaMethod::fromSignal(&GeoEntity::positionChanged);
+  if (isSignalConnected(positionChangedSignal))
+    emit positionChanged(m_position);
+}
+
+void GeoEntity::addPositionListener(PositionListener *listener)
+{
+  m_positionListeners.add(listener);
+}
+
+void GeoEntity::removePositionListener(PositionListener *listener)
+{
+  m_positionListeners.remove(listener);
 }
 
 QGeoPositionInfo const GeoEntity::position() const
@@ -40,12 +55,12 @@ QGeoPositionInfo const GeoEntity::position() const
 
 QRotationReading *GeoEntity::rotation() const
 {
-  return m_rotation;
+  return &m_rotation;
 }
 
 void GeoEntity::setRotation(QRotationReading const *reading)
 {
-  m_rotation->setTimestamp(reading->timestamp());
-  m_rotation->setFromEuler(reading->x(), reading->y(), reading->z());
-  emit rotationChanged(m_rotation);
+  m_rotation.setTimestamp(reading->timestamp());
+  m_rotation.setFromEuler(reading->x(), reading->y(), reading->z());
+  emit rotationChanged(&m_rotation);
 }
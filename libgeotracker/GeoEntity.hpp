@@ -7,6 +7,9 @@
 #include <QRotationSensor>
 #include "RotationReadingSource.hpp"
 #include <QRotationReading>
+#include "Listener.hpp"
+
+typedef Listener<QGeoPositionInfo> PositionListener;
 
 // A GeoEntity is an object in the physical world, moving or not.
 // Each GeoEntity has an unique identifier, a geographic position and
@@ -16,6 +19,15 @@
 // serial port, a gpsd UDP message, a GeoClue2 DBUS message, a physics
 // engine, or even a text file.  If the rotational source is not
 // provided, then the GeoEntity assumes a (0,0,0) rotation.
+//
+// For feeds of many short lived entities, an EntityPool holds the
+// same state without a QObject per entity; GeoEntity objects are then
+// only made for the entities that need signals.
+//
+// The position is given first to the position listeners, which are
+// called directly (see Listener), then to the receivers of
+// positionChanged(), if there are any.  The observers of an entity
+// listen; the signal is for the receivers in other threads and QML.
 
 class GeoEntity : public QObject
 {
@@ -32,6 +44,12 @@ public:
   QGeoPositionInfo const position() const;
   QRotationReading *rotation() const;
 
+  // Call a listener when the position changes, in the thread of the
+  // entity.  The listener leaves any list it was in.  It is removed
+  // by Listener::unlisten(), or when either is destroyed.
+  void addPositionListener(PositionListener *listener);
+  void removePositionListener(PositionListener *listener);
+
 signals:
   void positionChanged(QGeoPositionInfo const &position);
   void rotationChanged(QRotationReading *rotation);
@@ -48,5 +66,8 @@ public slots:
 private:
   QUuid                   m_uuid;
   QGeoPositionInfo        m_position;
-  QRotationReading       *m_rotation;
+  ListenerList<QGeoPositionInfo> m_positionListeners;
+  // A member rather than a child allocated on its own; rotation()
+  // hands it out from a const function.
+  mutable QRotationReading m_rotation;
 };
@@ -0,0 +1,143 @@
+#include <QThread>
+#include <algorithm>
+#include "GeoEntityDispatcher.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the dispatchers
+static
+MetricCounter &SampleCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_samples_total",
+                                                            "Position samples dispatched to entities.");
+  return *counter;
+}
+
+static
+MetricCounter &UpdateCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_entity_updates_total",
+                                                            "Entity updates made from position samples.");
+  return *counter;
+}
+
+GeoEntityDispatcher::GeoEntityDispatcher(QObject *parent) :
+  QObject(parent),
+  m_pool(nullptr),
+  m_createsEntities(false),
+  m_samples(0),
+  m_updates(0)
+{
+}
+
+void GeoEntityDispatcher::setEntity(quint64 id, GeoEntity *entity)
+{
+  GeoEntity *previous = m_entities.value(id);
+  if (previous == entity)
+    return;
+  if (previous)
+    disconnect(previous, &QObject::destroyed, this, nullptr);
+  if (!entity) {
+    m_entities.remove(id);
+    return;
+  }
+  m_entities.insert(id, entity);
+  connect(entity, &QObject::destroyed, this, [this, id]() {
+      m_entities.remove(id);
+    });
+}
+
+GeoEntity *GeoEntityDispatcher::entity(quint64 id) const
+{
+  return m_entities.value(id);
+}
+
+int GeoEntityDispatcher::count() const
+{
+  return m_entities.size();
+}
+
+EntityPool *GeoEntityDispatcher::pool() const
+{
+  return m_pool;
+}
+
+void GeoEntityDispatcher::setPool(EntityPool *pool)
+{
+  m_pool = pool;
+}
+
+bool GeoEntityDispatcher::createsEntities() const
+{
+  return m_createsEntities;
+}
+
+void GeoEntityDispatcher::setCreatesEntities(bool createsEntities)
+{
+  m_createsEntities = createsEntities;
+}
+
+quint64 GeoEntityDispatcher::samples() const
+{
+  return m_samples;
+}
+
+quint64 GeoEntityDispatcher::updates() const
+{
+  return m_updates;
+}
+
+void GeoEntityDispatcher::consume(PositionSample const *samples, int count)
+{
+  if (count <= 0)
+    return;
+  if (QThread::currentThread() == thread()) {
+    dispatch(samples, count);
+    return;
+  }
+  QVector<PositionSample> copy(count);
+  std::copy(samples, samples + count, copy.begin());
+  QMetaObject::invokeMethod(this, [this, copy]() {
+      dispatch(copy.constData(), copy.size());
+    }, Qt::QueuedConnection);
+}
+
+void GeoEntityDispatcher::dispatch(PositionSample const *samples, int count)
+{
+  m_samples += quint64(count);
+  SampleCount().add(quint64(count));
+  const quint64 updates = m_updates;
+
+  // Order the samples by id and time (and arrival, among samples of
+  // the same time), so that the last of each run of an id is its
+  // latest.  The order is kept between batches to save the
+  // allocation.
+  m_order.resize(count);
+  for (int i = 0; i < count; ++i)
+    m_order[i] = i;
+  std::sort(m_order.begin(), m_order.end(), [samples](int a, int b) {
+      if (samples[a].id != samples[b].id)
+        return samples[a].id < samples[b].id;
+      if (samples[a].timestamp != samples[b].timestamp)
+        return samples[a].timestamp < samples[b].timestamp;
+      return a < b;
+    });
+
+  for (int i = 0; i < count; ++i) {
+    PositionSample const &sample = samples[m_order.at(i)];
+    if (i + 1 < count && samples[m_order.at(i + 1)].id == sample.id)
+      continue;
+    if (m_pool)
+      m_pool->update(sample);
+    GeoEntity *entity = m_entities.value(sample.id);
+    if (!entity && m_createsEntities) {
+      entity = new GeoEntity(this);
+      setEntity(sample.id, entity);
+      emit entityCreated(sample.id, entity);
+    }
+    if (entity)
+      entity->setPosition(sample.toPositionInfo());
+    if (entity || m_pool)
+      ++m_updates;
+  }
+  UpdateCount().add(m_updates - updates);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include "GeoEntity.hpp"
+#include "PositionSample.hpp"
+#include "EntityPool.hpp"
+
+// A GeoEntityDispatcher distributes batches of position samples from
+// a feed of many entities (see StreamPositionSource::setSampleSink)
+// to the GeoEntity objects they describe, by the id of the samples.
+//
+// Each entity is updated at most once per batch, with its latest
+// sample, which spares the consumers of positionChanged() the
+// positions that are already out of date when the batch is
+// delivered.  Samples of unknown ids are dropped, unless the
+// dispatcher is allowed to create the entities, in which case it
+// owns them and announces them with entityCreated().
+//
+// With a pool (see EntityPool), the latest sample of every id goes to
+// the record of that id in the pool, created if needed.  The
+// GeoEntity objects are then optional: only the ids that need
+// signals are given one, and the dispatcher should not also be
+// allowed to create entities.
+//
+// The entities are updated in the thread of the dispatcher.  Batches
+// consumed from another thread, such as the I/O thread of a
+// ThreadedPositionSource, are copied and queued.
+
+class GeoEntityDispatcher : public QObject, public PositionSampleSink
+{
+  Q_OBJECT
+public:
+  GeoEntityDispatcher(QObject *parent = nullptr);
+
+  // Route the samples of an id to an entity, or to no entity if it is
+  // null.  The entity is forgotten when it is destroyed.
+  void setEntity(quint64 id, GeoEntity *entity);
+  GeoEntity *entity(quint64 id) const;
+  int count() const;
+
+  // The pool of records updated, which is not owned, or null
+  EntityPool *pool() const;
+  void setPool(EntityPool *pool);
+
+  bool createsEntities() const;
+  void setCreatesEntities(bool createsEntities);
+
+  // The number of samples received, and of entity updates made
+  quint64 samples() const;
+  quint64 updates() const;
+
+  virtual void consume(PositionSample const *samples, int count);
+
+signals:
+  void entityCreated(quint64 id, GeoEntity *entity);
+
+private:
+  void dispatch(PositionSample const *samples, int count);
+
+  QHash<quint64, GeoEntity *> m_entities;
+  EntityPool *m_pool;
+  QVector<int> m_order;
+  bool m_createsEntities;
+  quint64 m_samples;
+  quint64 m_updates;
+};
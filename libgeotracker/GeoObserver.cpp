@@ -1,23 +1,77 @@
+#include <QMetaMethod>
 #include "GeoEntity.hpp"
 #include "GeoObserver.hpp"
 #include "LookAngle.hpp"
+#include "LatencyTrace.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the observers
+static
+MetricCounter &LookAngleCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_look_angles_total",
+                                                            "Look angles computed.");
+  return *counter;
+}
+
+static
+MetricHistogram &LookAngleTime()
+{
+  static MetricHistogram *histogram = Metrics::global().histogram("geotracker_look_angle_compute_seconds",
+                                                                  "Time to compute a look angle.");
+  return *histogram;
+}
+
+static
+MetricCounter &RebaseCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_local_tangent_plane_rebases_total",
+                                                            "Rebases of the local tangent planes of the observers.");
+  return *counter;
+}
+
+static
+MetricCounter &CacheHitCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_look_angle_cache_hits_total",
+                                                            "Look angles found in the caches of the observers.");
+  return *counter;
+}
+
+static
+MetricCounter &CacheMissCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_look_angle_cache_misses_total",
+                                                            "Look angles computed into the caches of the observers.");
+  return *counter;
+}
 
 GeoObserver::GeoObserver(QObject *parent) :
   GeoEntity(parent),
   m_targetType(TARGET_NONE),
-  m_entity(nullptr)
+  m_entity(nullptr),
+  m_elevationMask(0.0),
+  m_isLocalTangentPlane(false),
+  m_isLookAngleCached(false)
 {
   // track the observer's movements
-  connect (this, &GeoEntity::positionChanged, this, &GeoObserver::onObserverPositionChanged);
+  m_observerListener.bind<GeoObserver, &GeoObserver::onObserverPositionChanged>(this);
+  m_targetListener.bind<GeoObserver, &GeoObserver::onTargetPositionChanged>(this);
+  addPositionListener(&m_observerListener);
 }
 
 GeoObserver::GeoObserver(QUuid const &uuid) :
   GeoEntity(uuid),
   m_targetType(TARGET_NONE),
-  m_entity(nullptr)
+  m_entity(nullptr),
+  m_elevationMask(0.0),
+  m_isLocalTangentPlane(false),
+  m_isLookAngleCached(false)
 {
   // track the observer's movements
-  connect (this, &GeoEntity::positionChanged, this, &GeoObserver::onObserverPositionChanged);
+  m_observerListener.bind<GeoObserver, &GeoObserver::onObserverPositionChanged>(this);
+  m_targetListener.bind<GeoObserver, &GeoObserver::onTargetPositionChanged>(this);
+  addPositionListener(&m_observerListener);
 }
 
 GeoObserver::~GeoObserver()
@@ -26,8 +80,7 @@ GeoObserver::~GeoObserver()
 
 void GeoObserver::setTarget()
 {
-  if (m_targetType == TARGET_ENTITY && m_entity)
-    disconnect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+  unfollowTarget();
   m_entity = nullptr;
   m_targetType = TARGET_NONE;
   emit targetChanged(m_targetType);
@@ -35,8 +88,7 @@ void GeoObserver::setTarget()
 
 void GeoObserver::setTarget(QGeoCoordinate const coordinate)
 {
-  if (m_targetType == TARGET_ENTITY && m_entity)
-    disconnect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+  unfollowTarget();
   m_coordinate = coordinate;
   m_targetType = TARGET_COORDINATE;
   calculateLookAngle();
@@ -45,8 +97,7 @@ void GeoObserver::setTarget(QGeoCoordinate const coordinate)
 
 void GeoObserver::setTarget(LookAngle const commanded_lookAngle)
 {
-  if (m_targetType == TARGET_ENTITY && m_entity)
-    disconnect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+  unfollowTarget();
   m_commanded_lookAngle = commanded_lookAngle;
   m_targetType = TARGET_LOOK_ANGLE;
   calculateLookAngle();
@@ -56,43 +107,189 @@ void GeoObserver::setTarget(LookAngle const commanded_lookAngle)
 void GeoObserver::setTarget(GeoEntity *entity)
 {
   if (m_entity != entity) {
-    if (m_targetType == TARGET_ENTITY && m_entity)
-      disconnect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+    unfollowTarget();
     if (entity == nullptr) {
       m_entity = nullptr;
       m_targetType = TARGET_NONE;
     } else {
       m_entity = entity;
       m_targetType = TARGET_ENTITY;
-      
-      // connect signals emitted from target
-      connect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+      m_targetPosition = entity->position().coordinate();
+
+      // follow the target's movements: directly in this thread, or by
+      // a queued signal from the thread of the entity
+      if (entity->thread() == thread())
+        m_entity->addPositionListener(&m_targetListener);
+      else
+        connect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
       calculateLookAngle();
       emit targetChanged(m_targetType);
     }
   }
 }
 
+void GeoObserver::unfollowTarget()
+{
+  m_targetListener.unlisten();
+  if (m_targetType == TARGET_ENTITY && m_entity)
+    disconnect (m_entity, &GeoEntity::positionChanged, this, &GeoObserver::onTargetPositionChanged);
+}
+
+void GeoObserver::addLookAngleListener(LookAngleListener *listener)
+{
+  m_lookAngleListeners.add(listener);
+}
+
+void GeoObserver::removeLookAngleListener(LookAngleListener *listener)
+{
+  m_lookAngleListeners.remove(listener);
+}
+
 LookAngle GeoObserver::lookAngle() const
 {
   return m_lookAngle;
 }
 
+Refraction GeoObserver::refraction() const
+{
+  return m_refraction;
+}
+
+void GeoObserver::setRefraction(Refraction const &refraction)
+{
+  m_refraction = refraction;
+  if (m_targetType != TARGET_NONE)
+    calculateLookAngle();
+}
+
+double GeoObserver::elevationMask() const
+{
+  return m_elevationMask;
+}
+
+void GeoObserver::setElevationMask(double elevationMask)
+{
+  m_elevationMask = elevationMask;
+}
+
+bool GeoObserver::isLocalTangentPlane() const
+{
+  return m_isLocalTangentPlane;
+}
+
+void GeoObserver::setLocalTangentPlane(bool isLocalTangentPlane)
+{
+  m_isLocalTangentPlane = isLocalTangentPlane;
+}
+
+double GeoObserver::localTangentPlaneTolerance() const
+{
+  return m_localTangentPlane.tolerance();
+}
+
+void GeoObserver::setLocalTangentPlaneTolerance(double tolerance)
+{
+  m_localTangentPlane.setTolerance(tolerance);
+}
+
+double GeoObserver::localTangentPlaneError() const
+{
+  // A coordinate target goes through the cache first
+  if (m_isLookAngleCached && m_targetType == TARGET_COORDINATE)
+    return 0.0;
+  return m_isLocalTangentPlane ? m_localTangentPlane.error() : 0.0;
+}
+
+bool GeoObserver::isLookAngleCached() const
+{
+  return m_isLookAngleCached;
+}
+
+void GeoObserver::setLookAngleCached(bool isLookAngleCached)
+{
+  m_isLookAngleCached = isLookAngleCached;
+  if (!m_isLookAngleCached)
+    m_lookAngleCache.clear();
+}
+
+double GeoObserver::lookAngleCacheTolerance() const
+{
+  return m_lookAngleCache.tolerance();
+}
+
+void GeoObserver::setLookAngleCacheTolerance(double tolerance)
+{
+  m_lookAngleCache.setTolerance(tolerance);
+}
+
+void GeoObserver::cacheLookAngles(QVector<QGeoCoordinate> const &targets)
+{
+  m_lookAngleCache.setObserver(position().coordinate());
+  float azimuth, elevation;
+  double range;
+  for (QGeoCoordinate const &target : targets)
+    m_lookAngleCache.lookAngle(target, &azimuth, &elevation, &range);
+}
+
+void GeoObserver::setCachedLookAngle(QGeoCoordinate const &target, LookAngle *lookAngle)
+{
+  m_lookAngleCache.setObserver(position().coordinate());
+  const quint64 misses = m_lookAngleCache.misses();
+  float azimuth, elevation;
+  double range;
+  m_lookAngleCache.lookAngle(target, &azimuth, &elevation, &range);
+  if (m_lookAngleCache.misses() != misses)
+    CacheMissCount().increment();
+  else
+    CacheHitCount().increment();
+  lookAngle->setAzimuth(azimuth);
+  if (range > 0.0)
+    lookAngle->setElevation(m_refraction.apparentElevation(elevation, range));
+}
+
+void GeoObserver::setLocalLookAngle(QGeoCoordinate const &target, LookAngle *lookAngle)
+{
+  // Moving the observer rebases the plane
+  m_localTangentPlane.setObserver(position().coordinate());
+  const quint64 rebases = m_localTangentPlane.rebases();
+  float azimuth = lookAngle->azimuth();
+  float elevation = lookAngle->elevation();
+  double range = 0.0;
+  m_localTangentPlane.lookAngle(target, &azimuth, &elevation, &range);
+  if (m_localTangentPlane.rebases() != rebases)
+    RebaseCount().increment();
+  lookAngle->setAzimuth(azimuth);
+  if (range > 0.0)
+    lookAngle->setElevation(m_refraction.apparentElevation(elevation, range));
+}
+
 void GeoObserver::calculateLookAngle()
 {
   // For readability, create the observer (which is this object instance):
   GeoEntity *observer = this;
   LookAngle next;
+  const qint64 start = LatencyTrace::now();
   
   switch (m_targetType)
     {
     case TARGET_ENTITY:
-      next.setLookAngle(observer->position().coordinate(),
-                        m_entity->position().coordinate());
+      if (m_isLocalTangentPlane)
+        setLocalLookAngle(m_targetPosition, &next);
+      else
+        next.setLookAngle(observer->position().coordinate(),
+                          m_targetPosition,
+                          m_refraction);
       break;
     case TARGET_COORDINATE:
-      next.setLookAngle(observer->position().coordinate(),
-                        m_coordinate);
+      // The cache takes precedence over the local tangent plane
+      if (m_isLookAngleCached)
+        setCachedLookAngle(m_coordinate, &next);
+      else if (m_isLocalTangentPlane)
+        setLocalLookAngle(m_coordinate, &next);
+      else
+        next.setLookAngle(observer->position().coordinate(),
+                          m_coordinate,
+                          m_refraction);
       break;
     case TARGET_LOOK_ANGLE:
       next = m_commanded_lookAngle;
@@ -102,7 +299,14 @@ void GeoObserver::calculateLookAngle()
     }
   // TODO: only set if the look angle has changed:
   m_lookAngle = next;
-  emit lookAngleChanged(m_lookAngle);
+  LookAngleTime().record(LatencyTrace::now() - start);
+  LookAngleCount().increment();
+  LATENCY_TRACE_MARK(LookAngleComputed);
+  m_lookAngleListeners.notify(m_lookAngle);
+
+  static const QMetaMethod lookAngleChangedSignal = QMetaMethod::fromSignal(&GeoObserver::lookAngleChanged);
+  if (isSignalConnected(lookAngleChangedSignal))
+    emit lookAngleChanged(m_lookAngle);
 }
 
 void GeoObserver::onObserverPositionChanged(QGeoPositionInfo const &)
@@ -110,7 +314,15 @@ void GeoObserver::onObserverPositionChanged(QGeoPositionInfo const &)
   calculateLookAngle();
 }
 
-void GeoObserver::onTargetPositionChanged(QGeoPositionInfo const &)
+void GeoObserver::onTargetPositionChanged(QGeoPositionInfo const &position)
 {
+  // A position of a former target may still be queued
+  QObject *entity = sender();
+  if (entity && (m_targetType != TARGET_ENTITY || entity != m_entity))
+    return;
+
+  // The position given rather than that of the entity, which may be
+  // changing in another thread
+  m_targetPosition = position.coordinate();
   calculateLookAngle();
 }
@@ -4,6 +4,12 @@
 #include <QGeoCoordinate>
 #include "GeoEntity.hpp"
 #include "LookAngle.hpp"
+#include "Refraction.hpp"
+#include "LocalTangentPlane.hpp"
+#include "LookAngleCache.hpp"
+#include "Listener.hpp"
+
+typedef Listener<LookAngle> LookAngleListener;
 
 // A GeoObserver is a type of GeoEntity that can point at another
 // object in space.  A gimballed camera or a radio telescope are
@@ -15,11 +21,45 @@
 // reference frame. In other words, the azimuth is measured from true
 // North and the elevation is from the horizon, regardless of the
 // observer's position and orientation.
+//
+// The observer follows its own position and that of the target
+// entity as a position listener, without signals, and gives the look
+// angle to its look angle listeners before it emits
+// lookAngleChanged() (see Listener).  A target entity in another
+// thread than the observer, such as one fed by a source thread or
+// held by a ShardedTracker shard, is followed by a queued
+// positionChanged() instead, so that the look angle is always
+// computed in the thread of the observer.  The thread is that of the
+// entity when it is set as the target.
+//
+// In local tangent plane mode, meant for targets that move a little
+// at a time (a drone a few kilometers away, say), the look angles are
+// computed from a linearization of the target's conversion to
+// Earth-centered coordinates, rebased when its error bound exceeds a
+// tolerance (see LocalTangentPlane).  The bound of the last look
+// angle is reported as localTangentPlaneError().
+//
+// With the look angle cache, the look angles to the coordinates the
+// observer is pointed at are kept until the observer moves further
+// than a tolerance (see LookAngleCache), so that a fixed installation
+// going back to a known point, or getting a new fix of its own
+// position, looks the look angle up.  The known points may be given
+// beforehand with cacheLookAngles().  The cache takes precedence over
+// the local tangent plane mode: with both on, a coordinate target is
+// looked up in the cache, and only an entity target goes through the
+// plane.
 
 class GeoObserver : public GeoEntity
 {
   Q_OBJECT
   Q_PROPERTY(LookAngle  lookAngle READ lookAngle                 NOTIFY lookAngleChanged)
+  Q_PROPERTY(Refraction refraction READ refraction WRITE setRefraction)
+  Q_PROPERTY(double     elevationMask READ elevationMask WRITE setElevationMask)
+  Q_PROPERTY(bool       localTangentPlane READ isLocalTangentPlane WRITE setLocalTangentPlane)
+  Q_PROPERTY(double     localTangentPlaneTolerance READ localTangentPlaneTolerance WRITE setLocalTangentPlaneTolerance)
+  Q_PROPERTY(double     localTangentPlaneError READ localTangentPlaneError)
+  Q_PROPERTY(bool       lookAngleCache READ isLookAngleCached WRITE setLookAngleCached)
+  Q_PROPERTY(double     lookAngleCacheTolerance READ lookAngleCacheTolerance WRITE setLookAngleCacheTolerance)
 public:
   // The discriminant: what we're looking at.  sometimes called the
   // pointing mode.
@@ -37,12 +77,50 @@ public:
 
   LookAngle lookAngle() const;
 
+  // The atmospheric refraction model applied to the calculated
+  // elevation.  By default, the elevation is geometric.
+  Refraction refraction() const;
+  void setRefraction(Refraction const &refraction);
+
+  // The elevation in degrees below which a target is obstructed
+  // (by terrain, buildings or the mechanical limits of the mount)
+  // and cannot be seen.  The default is the horizon.
+  double elevationMask() const;
+  void setElevationMask(double elevationMask);
+
+  // The local tangent plane mode, off by default, the tolerance of
+  // its error in meters of target position (1 cm by default), and
+  // the bound of the error of the last look angle, which is zero when
+  // the target was converted in full or looked up in the look angle
+  // cache.
+  bool isLocalTangentPlane() const;
+  void setLocalTangentPlane(bool isLocalTangentPlane);
+  double localTangentPlaneTolerance() const;
+  void setLocalTangentPlaneTolerance(double tolerance);
+  double localTangentPlaneError() const;
+
+  // The look angle cache of the coordinate targets, off by default,
+  // and the distance in meters the observer may move by and keep the
+  // look angles (1 cm by default).  It takes precedence over the local
+  // tangent plane mode for the coordinate targets.
+  bool isLookAngleCached() const;
+  void setLookAngleCached(bool isLookAngleCached);
+  double lookAngleCacheTolerance() const;
+  void setLookAngleCacheTolerance(double tolerance);
+  // Compute the look angles to known points into the cache
+  void cacheLookAngles(QVector<QGeoCoordinate> const &targets);
+
   // Setting the pointing mode:
   void setTarget();                                      // look at nothing
   void setTarget(QGeoCoordinate const position);         // look at a fixed position
   void setTarget(LookAngle const commanded_lookAngle);   // look in a fixed direction
   void setTarget(GeoEntity *entity);                     // look at a an entity (that might be moving)
 
+  // Call a listener when the look angle changes, in the thread of the
+  // observer.  The listener leaves any list it was in.
+  void addLookAngleListener(LookAngleListener *listener);
+  void removeLookAngleListener(LookAngleListener *listener);
+
 signals:
   void targetChanged(TargetType &targetType);
   void lookAngleChanged(LookAngle const &lookAngle);
@@ -54,6 +132,11 @@ public slots:
 protected:
   void calculateLookAngle();
 
+private:
+  void setLocalLookAngle(QGeoCoordinate const &target, LookAngle *lookAngle);
+  void setCachedLookAngle(QGeoCoordinate const &target, LookAngle *lookAngle);
+  void unfollowTarget();
+
 private:
   // The discriminant of the anonymous union
   TargetType        m_targetType; // What are we looking at?
@@ -72,4 +155,27 @@ private:
   // hardware pointing device.  Remember that this is in the world
   // reference frame.
   LookAngle  m_lookAngle;
+
+  // The last position of the target entity, as it was notified
+  QGeoCoordinate m_targetPosition;
+
+  // The model used to correct the calculated elevation for the
+  // bending of the line of sight by the atmosphere.
+  Refraction m_refraction;
+
+  // The lowest elevation at which the observer can see a target.
+  double     m_elevationMask;
+
+  // The linearization of the local tangent plane mode
+  bool              m_isLocalTangentPlane;
+  LocalTangentPlane m_localTangentPlane;
+
+  // The look angles to the coordinates
+  bool              m_isLookAngleCached;
+  LookAngleCache    m_lookAngleCache;
+
+  // The observer listens to itself and to the target entity.
+  PositionListener m_observerListener;
+  PositionListener m_targetListener;
+  ListenerList<LookAngle> m_lookAngleListeners;
 };
@@ -452,7 +452,7 @@ GeoPoint::GeoPoint(double const _x, double const _y, double const _z) :
 GeoPoint::GeoPoint(QGeoCoordinate const c) {
   // construct a geocetric point (x,y,z) from a Geodetic Coordinate
   // (latitude, longitude, altitude).
-  pj_Convert_Geodetic_To_Geocentric(&pj_wgs84, c.latitude(), c.longitude(), c.altitude(), &m_x, &m_y, &m_z);
+  set(c);
 }
 
 double GeoPoint::x() const {
@@ -484,7 +484,10 @@ void GeoPoint::set(double const _x, double const _y, double const _z) {
 }
 
 void GeoPoint::set(QGeoCoordinate const c) {
-  pj_Convert_Geodetic_To_Geocentric(&pj_wgs84, c.latitude(), c.longitude(), c.altitude(), &m_x, &m_y, &m_z);
+  // The proj functions work in radians while QGeoCoordinate is in
+  // degrees.  A coordinate without an altitude is on the ellipsoid.
+  const double altitude = qIsNaN(c.altitude()) ? 0.0 : c.altitude();
+  pj_Convert_Geodetic_To_Geocentric(&pj_wgs84, qDegreesToRadians(c.latitude()), qDegreesToRadians(c.longitude()), altitude, &m_x, &m_y, &m_z);
 }
 
 double GeoPoint::distanceTo (GeoPoint const &to) const {
@@ -497,5 +500,5 @@ double GeoPoint::distanceTo (GeoPoint const &to) const {
 QGeoCoordinate GeoPoint::coordinate() const {
   double latitude, longitude, altitude;
   pj_Convert_Geocentric_To_Geodetic(&pj_wgs84, m_x, m_y, m_z, &latitude, &longitude, &altitude);
-  return QGeoCoordinate(latitude, longitude, altitude);
+  return QGeoCoordinate(qRadiansToDegrees(latitude), qRadiansToDegrees(longitude), altitude);
 }
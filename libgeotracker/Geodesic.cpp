@@ -0,0 +1,900 @@
+// The geodesic solution is a transcription of the inverse problem of
+// Karney's GeographicLib (Geodesic.cpp, MIT/X11 license), with the
+// series truncated at the sixth order as in the original.  The
+// variable names follow that code to make it easy to compare against.
+// The reduced length, the geodesic scales and the area are not
+// computed.
+
+#include <cfloat>
+#include <cmath>
+#include <QtMath>
+#include <QVector>
+#include <QtConcurrent>
+#include "Geodesic.hpp"
+
+// WGS84
+static const double Wgs84EquatorialRadius = 6378137.0;
+static const double Wgs84Flattening = 1.0 / 298.257223563;
+
+// Order of the series expansions
+static const int nA1 = 6;
+static const int nC1 = 6;
+static const int nA2 = 6;
+static const int nC2 = 6;
+static const int nA3 = 6;
+static const int nC3 = 6;
+
+static const int maxit1 = 20;
+static const int maxit2 = maxit1 + DBL_MANT_DIG + 10;
+
+static const double tiny = std::sqrt(DBL_MIN);
+static const double tol0 = DBL_EPSILON;
+static const double tol1 = 200.0 * tol0;
+static const double tol2 = std::sqrt(tol0);
+static const double tolb = tol0;
+static const double xthresh = 1000.0 * tol2;
+
+// Pairs are processed in blocks of this many per thread pool task.
+static const int GeodesicBlockSize = 1024;
+
+static inline
+double Sq(double x)
+{
+  return x * x;
+}
+
+static inline
+void Norm(double &x, double &y)
+{
+  const double r = std::hypot(x, y);
+  x /= r;
+  y /= r;
+}
+
+static inline
+double ErrorFreeSum(double u, double v, double &t)
+{
+  // u + v = s + t exactly
+  volatile double s = u + v;
+  volatile double up = s - v;
+  volatile double vpp = s - up;
+  up -= u;
+  vpp -= v;
+  t = s != 0.0 ? 0.0 - (up + vpp) : s;
+  return s;
+}
+
+static inline
+double PolyVal(int N, double const *p, double x)
+{
+  double y = N < 0 ? 0.0 : *p++;
+  while (--N >= 0)
+    y = y * x + *p++;
+  return y;
+}
+
+static inline
+double AngRound(double x)
+{
+  // Round an angle so that small values underflow to zero, which
+  // avoids near singular cases.
+  static const double z = 1.0 / 16.0;
+  volatile double y = std::fabs(x);
+  volatile double w = z - y;
+  y = w > 0 ? z - w : y;
+  return std::copysign(y, x);
+}
+
+static inline
+double LatFix(double x)
+{
+  return std::fabs(x) > 90.0 ? qQNaN() : x;
+}
+
+static inline
+double AngDiff(double x, double y, double &e)
+{
+  // y - x reduced to [-180, 180] accurately, with the rounding error
+  // in e.
+  double t;
+  double d = ErrorFreeSum(std::remainder(-x, 360.0), std::remainder(y, 360.0), t);
+  d = ErrorFreeSum(std::remainder(d, 360.0), t, e);
+  if (d == 0.0 || std::fabs(d) == 180.0)
+    d = std::copysign(d, e == 0.0 ? y - x : -e);
+  return d;
+}
+
+static inline
+void SinCosQuadrant(double r, int q, double &sinx, double &cosx)
+{
+  const double s = std::sin(r);
+  const double c = std::cos(r);
+  switch (unsigned(q) & 3U) {
+  case 0U:  sinx =  s; cosx =  c; break;
+  case 1U:  sinx =  c; cosx = -s; break;
+  case 2U:  sinx = -s; cosx = -c; break;
+  default:  sinx = -c; cosx =  s; break;
+  }
+  cosx += 0.0;
+}
+
+static inline
+void SinCosDegrees(double x, double &sinx, double &cosx)
+{
+  // Exact results for multiples of 90 degrees
+  int q = 0;
+  double r = std::remquo(x, 90.0, &q);
+  SinCosQuadrant(qDegreesToRadians(r), q, sinx, cosx);
+  if (sinx == 0.0)
+    sinx = std::copysign(sinx, x);
+}
+
+static inline
+void SinCosDegrees(double x, double t, double &sinx, double &cosx)
+{
+  // sin and cos of x + t, for x in [-180, 180] and a small t
+  const int q = int(std::round(x / 90.0));
+  const double r = x - 90.0 * q;
+  SinCosQuadrant(qDegreesToRadians(AngRound(r + t)), q, sinx, cosx);
+  if (sinx == 0.0)
+    sinx = std::copysign(sinx, x);
+}
+
+static inline
+double Atan2Degrees(double y, double x)
+{
+  int q = 0;
+  if (std::fabs(y) > std::fabs(x)) {
+    std::swap(x, y);
+    q = 2;
+  }
+  if (std::signbit(x)) {
+    x = -x;
+    ++q;
+  }
+  double ang = qRadiansToDegrees(std::atan2(y, x));
+  switch (q) {
+  case 1: ang = std::copysign(180.0, y) - ang; break;
+  case 2: ang = 90.0 - ang; break;
+  case 3: ang = -90.0 + ang; break;
+  default: break;
+  }
+  return ang;
+}
+
+static
+double SinCosSeries(bool sinp, double sinx, double cosx, double const c[], int n)
+{
+  // Evaluate
+  // y = sinp ? sum(c[i] * sin( 2*i    * x), i, 1, n) :
+  //            sum(c[i] * cos((2*i+1) * x), i, 0, n-1)
+  // by Clenshaw summation.  c[0] is unused for the sine series.
+  c += n + sinp;
+  const double ar = 2.0 * (cosx - sinx) * (cosx + sinx);
+  double y0 = (n & 1) ? *--c : 0.0;
+  double y1 = 0.0;
+  n /= 2;
+  while (n--) {
+    y1 = ar * y0 - y1 + *--c;
+    y0 = ar * y1 - y0 + *--c;
+  }
+  return sinp ? 2.0 * sinx * cosx * y0 : cosx * (y0 - y1);
+}
+
+static
+double Astroid(double x, double y)
+{
+  // The positive root k of k^4+2*k^3-(x^2+y^2-1)*k^2-2*y^2*k-y^2 = 0
+  double k;
+  const double p = Sq(x);
+  const double q = Sq(y);
+  const double r = (p + q - 1.0) / 6.0;
+  if (!(q == 0.0 && r <= 0.0)) {
+    const double S = p * q / 4.0;
+    const double r2 = Sq(r);
+    const double r3 = r * r2;
+    const double disc = S * (S + 2.0 * r3);
+    double u = r;
+    if (disc >= 0.0) {
+      double T3 = S + r3;
+      T3 += T3 < 0.0 ? -std::sqrt(disc) : std::sqrt(disc);
+      const double T = std::cbrt(T3);
+      u += T + (T != 0.0 ? r2 / T : 0.0);
+    } else {
+      const double ang = std::atan2(std::sqrt(-disc), -(S + r3));
+      u += 2.0 * r * std::cos(ang / 3.0);
+    }
+    const double v = std::sqrt(Sq(u) + q);
+    const double uv = u < 0.0 ? q / (v - u) : u + v;
+    const double w = (uv - q) / (2.0 * v);
+    k = uv / (std::sqrt(uv + Sq(w)) + w);
+  } else {
+    k = 0.0;
+  }
+  return k;
+}
+
+static
+double A1m1f(double eps)
+{
+  static const double coeff[] = {
+    1, 4, 64, 0, 256,
+  };
+  const int m = nA1 / 2;
+  const double t = PolyVal(m, coeff, Sq(eps)) / coeff[m + 1];
+  return (t + eps) / (1.0 - eps);
+}
+
+static
+void C1f(double eps, double c[])
+{
+  static const double coeff[] = {
+    -1, 6, -16, 32,
+    -9, 64, -128, 2048,
+    9, -16, 768,
+    3, -5, 512,
+    -7, 1280,
+    -7, 2048,
+  };
+  const double eps2 = Sq(eps);
+  double d = eps;
+  int o = 0;
+  for (int l = 1; l <= nC1; ++l) {
+    const int m = (nC1 - l) / 2;
+    c[l] = d * PolyVal(m, coeff + o, eps2) / coeff[o + m + 1];
+    o += m + 2;
+    d *= eps;
+  }
+}
+
+static
+double A2m1f(double eps)
+{
+  static const double coeff[] = {
+    -11, -28, -192, 0, 256,
+  };
+  const int m = nA2 / 2;
+  const double t = PolyVal(m, coeff, Sq(eps)) / coeff[m + 1];
+  return (t - eps) / (1.0 + eps);
+}
+
+static
+void C2f(double eps, double c[])
+{
+  static const double coeff[] = {
+    1, 2, 16, 32,
+    35, 64, 384, 2048,
+    15, 80, 768,
+    7, 35, 512,
+    63, 1280,
+    77, 2048,
+  };
+  const double eps2 = Sq(eps);
+  double d = eps;
+  int o = 0;
+  for (int l = 1; l <= nC2; ++l) {
+    const int m = (nC2 - l) / 2;
+    c[l] = d * PolyVal(m, coeff + o, eps2) / coeff[o + m + 1];
+    o += m + 2;
+    d *= eps;
+  }
+}
+
+// Run func(begin, end) over [0, count) in blocks on the global
+// thread pool.  Each block writes a disjoint range of the outputs.
+template <typename Function>
+static
+void ForEachBlock(int count, Function func)
+{
+  if (count <= GeodesicBlockSize) {
+    func(0, count);
+    return;
+  }
+  QVector<int> blocks;
+  for (int begin = 0; begin < count; begin += GeodesicBlockSize)
+    blocks.append(begin);
+  QtConcurrent::blockingMap(blocks, [&func, count](int begin) {
+      func(begin, qMin(begin + GeodesicBlockSize, count));
+    });
+}
+
+Geodesic::Geodesic() :
+  Geodesic(Wgs84EquatorialRadius, Wgs84Flattening)
+{
+}
+
+Geodesic::Geodesic(double equatorialRadius, double flattening) :
+  m_a(equatorialRadius),
+  m_f(flattening),
+  m_f1(1.0 - flattening),
+  m_e2(flattening * (2.0 - flattening)),
+  m_ep2(m_e2 / Sq(m_f1)),
+  m_n(flattening / (2.0 - flattening)),
+  m_b(equatorialRadius * m_f1)
+{
+  // The threshold of sig12 below which a line is "really short"; see
+  // GeographicLib.
+  m_etol2 = 0.1 * tol2 / std::sqrt(qMax(0.001, std::fabs(m_f)) * qMin(1.0, 1.0 - m_f / 2.0) / 2.0);
+
+  static const double A3coeff[] = {
+    -3, 128,
+    -2, -3, 64,
+    -1, -3, -1, 16,
+    3, -1, -2, 8,
+    1, -1, 2,
+    1, 1,
+  };
+  int o = 0, k = 0;
+  for (int j = nA3 - 1; j >= 0; --j) {
+    const int m = qMin(nA3 - j - 1, j);
+    m_A3x[k++] = PolyVal(m, A3coeff + o, m_n) / A3coeff[o + m + 1];
+    o += m + 2;
+  }
+
+  static const double C3coeff[] = {
+    3, 128,
+    2, 5, 128,
+    -1, 3, 3, 64,
+    -1, 0, 1, 8,
+    -1, 1, 4,
+    5, 256,
+    1, 3, 128,
+    -3, -2, 3, 64,
+    1, -3, 2, 32,
+    7, 512,
+    -10, 9, 384,
+    5, -9, 5, 192,
+    7, 512,
+    -14, 7, 512,
+    21, 2560,
+  };
+  o = 0;
+  k = 0;
+  for (int l = 1; l < nC3; ++l) {
+    for (int j = nC3 - 1; j >= l; --j) {
+      const int m = qMin(nC3 - j - 1, j);
+      m_C3x[k++] = PolyVal(m, C3coeff + o, m_n) / C3coeff[o + m + 1];
+      o += m + 2;
+    }
+  }
+}
+
+double Geodesic::equatorialRadius() const
+{
+  return m_a;
+}
+
+double Geodesic::flattening() const
+{
+  return m_f;
+}
+
+Geodesic const &Geodesic::wgs84()
+{
+  static const Geodesic wgs84;
+  return wgs84;
+}
+
+double Geodesic::a3f(double eps) const
+{
+  return PolyVal(nA3 - 1, m_A3x, eps);
+}
+
+void Geodesic::c3f(double eps, double c[]) const
+{
+  // Elements c[1] through c[nC3 - 1] are set
+  double mult = 1.0;
+  int o = 0;
+  for (int l = 1; l < nC3; ++l) {
+    const int m = nC3 - l - 1;
+    mult *= eps;
+    c[l] = mult * PolyVal(m, m_C3x + o, eps);
+    o += m + 1;
+  }
+}
+
+void Geodesic::lengths(double eps, double sig12,
+                       double ssig1, double csig1, double dn1,
+                       double ssig2, double csig2, double dn2,
+                       bool wantDistance, double *s12b, double *m12b, double *m0) const
+{
+  // The distance s12b and reduced length m12b, both divided by b,
+  // and the coefficient m0 of the secular term of the reduced
+  // length.  The reduced length is only needed to steer the Newton
+  // iteration.
+  double C1a[nC1 + 1], C2a[nC2 + 1];
+  double A1 = A1m1f(eps);
+  C1f(eps, C1a);
+  double A2 = A2m1f(eps);
+  C2f(eps, C2a);
+  const double m0x = A1 - A2;
+  A1 += 1.0;
+  A2 += 1.0;
+
+  double J12;
+  if (wantDistance) {
+    const double B1 = SinCosSeries(true, ssig2, csig2, C1a, nC1) - SinCosSeries(true, ssig1, csig1, C1a, nC1);
+    *s12b = A1 * (sig12 + B1);
+    const double B2 = SinCosSeries(true, ssig2, csig2, C2a, nC2) - SinCosSeries(true, ssig1, csig1, C2a, nC2);
+    J12 = m0x * sig12 + (A1 * B1 - A2 * B2);
+  } else {
+    for (int l = 1; l <= nC2; ++l)
+      C2a[l] = A1 * C1a[l] - A2 * C2a[l];
+    J12 = m0x * sig12 + (SinCosSeries(true, ssig2, csig2, C2a, nC2) - SinCosSeries(true, ssig1, csig1, C2a, nC2));
+  }
+  *m0 = m0x;
+  *m12b = dn2 * (csig1 * ssig2) - dn1 * (ssig1 * csig2) - csig1 * csig2 * J12;
+}
+
+double Geodesic::inverseStart(double sbet1, double cbet1, double sbet2, double cbet2,
+                              double lam12, double slam12, double clam12,
+                              double *salp1, double *calp1, double *salp2, double *calp2,
+                              double *dnm) const
+{
+  // A starting point for Newton's method in salp1 and calp1, and the
+  // function value -1.  If Newton's method is not needed, salp2,
+  // calp2 and dnm are also set and the function value is sig12.
+  double sig12 = -1.0;
+  const double sbet12 = sbet2 * cbet1 - cbet2 * sbet1;
+  const double cbet12 = cbet2 * cbet1 + sbet2 * sbet1;
+  volatile double sbet12a = sbet2 * cbet1;
+  sbet12a += cbet2 * sbet1;
+
+  const bool shortline = cbet12 >= 0.0 && sbet12 < 0.5 && cbet2 * lam12 < 0.5;
+  double somg12, comg12;
+  if (shortline) {
+    double sbetm2 = Sq(sbet1 + sbet2);
+    sbetm2 /= sbetm2 + Sq(cbet1 + cbet2);
+    *dnm = std::sqrt(1.0 + m_ep2 * sbetm2);
+    const double omg12 = lam12 / (m_f1 * *dnm);
+    somg12 = std::sin(omg12);
+    comg12 = std::cos(omg12);
+  } else {
+    somg12 = slam12;
+    comg12 = clam12;
+  }
+
+  *salp1 = cbet2 * somg12;
+  *calp1 = comg12 >= 0.0
+    ? sbet12 + cbet2 * sbet1 * Sq(somg12) / (1.0 + comg12)
+    : sbet12a - cbet2 * sbet1 * Sq(somg12) / (1.0 - comg12);
+
+  const double ssig12 = std::hypot(*salp1, *calp1);
+  const double csig12 = sbet1 * sbet2 + cbet1 * cbet2 * comg12;
+
+  if (shortline && ssig12 < m_etol2) {
+    // Really short lines
+    *salp2 = cbet1 * somg12;
+    *calp2 = sbet12 - cbet1 * sbet2 * (comg12 >= 0.0 ? Sq(somg12) / (1.0 + comg12) : 1.0 - comg12);
+    Norm(*salp2, *calp2);
+    sig12 = std::atan2(ssig12, csig12);
+  } else if (std::fabs(m_n) > 0.1 || csig12 >= 0.0 || ssig12 >= 6.0 * std::fabs(m_n) * M_PI * Sq(cbet1)) {
+    // The zeroth order spherical approximation is good enough
+  } else {
+    // Nearly antipodal.  Scale lam12 and bet2 to an x, y coordinate
+    // system where the antipodal point is at the origin and the
+    // singular point is at y = 0, x = -1.
+    const double lam12x = std::atan2(-slam12, -clam12);
+    const double k2 = Sq(sbet1) * m_ep2;
+    const double eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+    const double lamscale = m_f * cbet1 * a3f(eps) * M_PI;
+    const double betscale = lamscale * cbet1;
+    const double x = lam12x / lamscale;
+    const double y = sbet12a / betscale;
+
+    if (y > -tol1 && x > -1.0 - xthresh) {
+      // Strip near the cut
+      *salp1 = qMin(1.0, -x);
+      *calp1 = -std::sqrt(1.0 - Sq(*salp1));
+    } else {
+      // Estimate omg12 by solving the astroid problem, and use the
+      // spherical formula to compute alp1.
+      const double k = Astroid(x, y);
+      const double omg12a = lamscale * (-x * k / (1.0 + k));
+      somg12 = std::sin(omg12a);
+      comg12 = -std::cos(omg12a);
+      *salp1 = cbet2 * somg12;
+      *calp1 = sbet12a - cbet2 * sbet1 * Sq(somg12) / (1.0 - comg12);
+    }
+  }
+  // Sanity check on the starting guess.  The backwards test lets NaN
+  // through.
+  if (!(*salp1 <= 0.0)) {
+    Norm(*salp1, *calp1);
+  } else {
+    *salp1 = 1.0;
+    *calp1 = 0.0;
+  }
+  return sig12;
+}
+
+double Geodesic::lambda12(double sbet1, double cbet1, double dn1,
+                          double sbet2, double cbet2, double dn2,
+                          double salp1, double calp1, double slam120, double clam120,
+                          bool diffp,
+                          double *salp2, double *calp2, double *sig12,
+                          double *ssig1, double *csig1, double *ssig2, double *csig2,
+                          double *eps, double *dlam12) const
+{
+  // The longitude difference reached by the geodesic leaving point 1
+  // with azimuth alp1, less the target difference lam120, and its
+  // derivative with respect to alp1.
+  if (sbet1 == 0.0 && calp1 == 0.0)
+    // Break the degeneracy of an equatorial line
+    calp1 = -tiny;
+
+  const double salp0 = salp1 * cbet1;
+  const double calp0 = std::hypot(calp1, salp1 * sbet1);
+
+  *ssig1 = sbet1;
+  const double somg1 = salp0 * sbet1;
+  *csig1 = calp1 * cbet1;
+  const double comg1 = *csig1;
+  Norm(*ssig1, *csig1);
+
+  // Enforce the symmetries in the case abs(bet2) = -bet1.
+  *salp2 = cbet2 != cbet1 ? salp0 / cbet2 : salp1;
+  *calp2 = cbet2 != cbet1 || std::fabs(sbet2) != -sbet1
+    ? std::sqrt(Sq(calp1 * cbet1) + (cbet1 < -sbet1 ? (cbet2 - cbet1) * (cbet1 + cbet2)
+                                                    : (sbet1 - sbet2) * (sbet1 + sbet2))) / cbet2
+    : std::fabs(calp1);
+
+  *ssig2 = sbet2;
+  const double somg2 = salp0 * sbet2;
+  *csig2 = *calp2 * cbet2;
+  const double comg2 = *csig2;
+  Norm(*ssig2, *csig2);
+
+  // sig12 = sig2 - sig1, limited to [0, pi]
+  *sig12 = std::atan2(qMax(0.0, *csig1 * *ssig2 - *ssig1 * *csig2) + 0.0,
+                      *csig1 * *csig2 + *ssig1 * *ssig2);
+
+  // omg12 = omg2 - omg1, limited to [0, pi]
+  const double somg12 = qMax(0.0, comg1 * somg2 - somg1 * comg2) + 0.0;
+  const double comg12 = comg1 * comg2 + somg1 * somg2;
+  // eta = omg12 - lam120
+  const double eta = std::atan2(somg12 * clam120 - comg12 * slam120,
+                                comg12 * clam120 + somg12 * slam120);
+
+  double C3a[nC3];
+  const double k2 = Sq(calp0) * m_ep2;
+  *eps = k2 / (2.0 * (1.0 + std::sqrt(1.0 + k2)) + k2);
+  c3f(*eps, C3a);
+  const double B312 = SinCosSeries(true, *ssig2, *csig2, C3a, nC3 - 1) - SinCosSeries(true, *ssig1, *csig1, C3a, nC3 - 1);
+  const double domg12 = -m_f * a3f(*eps) * salp0 * (*sig12 + B312);
+  const double lam12 = eta + domg12;
+
+  if (diffp) {
+    if (*calp2 == 0.0) {
+      *dlam12 = -2.0 * m_f1 * dn1 / sbet1;
+    } else {
+      double s12b, m0;
+      lengths(*eps, *sig12, *ssig1, *csig1, dn1, *ssig2, *csig2, dn2, false, &s12b, dlam12, &m0);
+      *dlam12 *= m_f1 / (*calp2 * cbet2);
+    }
+  }
+  return lam12;
+}
+
+double Geodesic::inverse(double lat1, double lon1, double lat2, double lon2,
+                         double *azimuth1, double *azimuth2) const
+{
+  // Compute the longitude difference carefully.  The result is in
+  // [-180, 180], with -180 only for west going geodesics.
+  double lon12s;
+  double lon12 = AngDiff(lon1, lon2, lon12s);
+  // Make the longitude difference positive.
+  double lonsign = std::signbit(lon12) ? -1.0 : 1.0;
+  lon12 *= lonsign;
+  lon12s *= lonsign;
+  const double lam12 = qDegreesToRadians(lon12);
+  double slam12, clam12;
+  SinCosDegrees(lon12, lon12s, slam12, clam12);
+  // The supplementary longitude difference
+  lon12s = (180.0 - lon12) - lon12s;
+
+  // If really close to the equator, treat as on the equator.
+  lat1 = AngRound(LatFix(lat1));
+  lat2 = AngRound(LatFix(lat2));
+  // Swap the points so that the point with the higher (absolute)
+  // latitude is point 1.  If one latitude is a NaN, it becomes lat1.
+  const double swapp = std::fabs(lat1) < std::fabs(lat2) || std::isnan(lat2) ? -1.0 : 1.0;
+  if (swapp < 0.0) {
+    lonsign *= -1.0;
+    std::swap(lat1, lat2);
+  }
+  // Make lat1 <= 0
+  const double latsign = std::signbit(lat1) ? 1.0 : -1.0;
+  lat1 *= latsign;
+  lat2 *= latsign;
+  // Now 0 <= lon12 <= 180, -90 <= lat1 <= 0 and lat1 <= lat2 <= -lat1.
+  // lonsign, swapp and latsign register the transformation to this
+  // canonical form.
+
+  double sbet1, cbet1, sbet2, cbet2;
+  SinCosDegrees(lat1, sbet1, cbet1);
+  sbet1 *= m_f1;
+  // Ensure cbet1 = +epsilon at the poles
+  Norm(sbet1, cbet1);
+  cbet1 = qMax(tiny, cbet1);
+
+  SinCosDegrees(lat2, sbet2, cbet2);
+  sbet2 *= m_f1;
+  Norm(sbet2, cbet2);
+  cbet2 = qMax(tiny, cbet2);
+
+  // Force bet2 = +/- bet1 exactly when the measures of their
+  // difference vanish (see lambda12).
+  if (cbet1 < -sbet1) {
+    if (cbet2 == cbet1)
+      sbet2 = std::copysign(sbet1, sbet2);
+  } else {
+    if (std::fabs(sbet2) == -sbet1)
+      cbet2 = cbet1;
+  }
+
+  const double dn1 = std::sqrt(1.0 + m_ep2 * Sq(sbet1));
+  const double dn2 = std::sqrt(1.0 + m_ep2 * Sq(sbet2));
+
+  double s12x = 0.0;
+  double sig12, salp1, calp1, salp2, calp2;
+
+  bool meridian = lat1 == -90.0 || slam12 == 0.0;
+  if (meridian) {
+    // The end points are on a single full meridian, so the geodesic
+    // might lie on the meridian.
+    calp1 = clam12;
+    salp1 = slam12;
+    calp2 = 1.0;
+    salp2 = 0.0;
+
+    const double ssig1 = sbet1, csig1 = calp1 * cbet1;
+    const double ssig2 = sbet2, csig2 = calp2 * cbet2;
+
+    sig12 = std::atan2(qMax(0.0, csig1 * ssig2 - ssig1 * csig2) + 0.0,
+                       csig1 * csig2 + ssig1 * ssig2);
+    double m12x, m0;
+    lengths(m_n, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, true, &s12x, &m12x, &m0);
+
+    // A meridian is not the shortest path if sig12 > pi/2 and the
+    // reduced length is negative.
+    if (sig12 < tol2 || m12x >= 0.0) {
+      // Prevent a negative s12 for short lines
+      if (sig12 < 3.0 * tiny || (sig12 < tol0 && s12x < 0.0))
+        s12x = 0.0;
+      s12x *= m_b;
+    } else {
+      meridian = false;
+    }
+  }
+
+  if (!meridian && sbet1 == 0.0 && (m_f <= 0.0 || lon12s >= m_f * 180.0)) {
+    // The geodesic runs along the equator
+    calp1 = calp2 = 0.0;
+    salp1 = salp2 = 1.0;
+    s12x = m_a * lam12;
+  } else if (!meridian) {
+    // Both points are within a hemisphere bounded by a meridian and
+    // the geodesic is neither meridional nor equatorial.
+    double dnm = 1.0;
+    sig12 = inverseStart(sbet1, cbet1, sbet2, cbet2, lam12, slam12, clam12,
+                         &salp1, &calp1, &salp2, &calp2, &dnm);
+
+    if (sig12 >= 0.0) {
+      // Short lines
+      s12x = sig12 * m_b * dnm;
+    } else {
+      // Newton's method on f(alp1) = lambda12(alp1) - lam12 = 0,
+      // maintaining a bracket (alp1a, alp1b) of the root and falling
+      // back to bisection when a Newton step leaves it.
+      double ssig1 = 0.0, csig1 = 0.0, ssig2 = 0.0, csig2 = 0.0, eps = 0.0;
+      int numit = 0;
+      bool tripn = false, tripb = false;
+      double salp1a = tiny, calp1a = 1.0, salp1b = tiny, calp1b = -1.0;
+      for (;; ++numit) {
+        double dv = 0.0;
+        const double v = lambda12(sbet1, cbet1, dn1, sbet2, cbet2, dn2,
+                                  salp1, calp1, slam12, clam12,
+                                  numit < maxit1,
+                                  &salp2, &calp2, &sig12,
+                                  &ssig1, &csig1, &ssig2, &csig2,
+                                  &eps, &dv);
+        // The reversed test lets NaNs escape
+        if (tripb || !(std::fabs(v) >= (tripn ? 8.0 : 1.0) * tol0) || numit == maxit2)
+          break;
+        // Update the bracket
+        if (v > 0.0 && (numit > maxit1 || calp1 / salp1 > calp1b / salp1b)) {
+          salp1b = salp1;
+          calp1b = calp1;
+        } else if (v < 0.0 && (numit > maxit1 || calp1 / salp1 < calp1a / salp1a)) {
+          salp1a = salp1;
+          calp1a = calp1;
+        }
+        if (numit < maxit1 && dv > 0.0) {
+          const double dalp1 = -v / dv;
+          if (std::fabs(dalp1) < M_PI) {
+            const double sdalp1 = std::sin(dalp1), cdalp1 = std::cos(dalp1);
+            const double nsalp1 = salp1 * cdalp1 + calp1 * sdalp1;
+            if (nsalp1 > 0.0) {
+              calp1 = calp1 * cdalp1 - salp1 * sdalp1;
+              salp1 = nsalp1;
+              Norm(salp1, calp1);
+              // Convergence may be less than quadratic where the
+              // slope vanishes, so test against epsilon rather than
+              // its square root.
+              tripn = std::fabs(v) <= 16.0 * tol0;
+              continue;
+            }
+          }
+        }
+        // Bisect the bracket
+        salp1 = (salp1a + salp1b) / 2.0;
+        calp1 = (calp1a + calp1b) / 2.0;
+        Norm(salp1, calp1);
+        tripn = false;
+        tripb = (std::fabs(salp1a - salp1) + (calp1a - calp1) < tolb ||
+                 std::fabs(salp1 - salp1b) + (calp1 - calp1b) < tolb);
+      }
+      double m12x, m0;
+      lengths(eps, sig12, ssig1, csig1, dn1, ssig2, csig2, dn2, true, &s12x, &m12x, &m0);
+      s12x *= m_b;
+    }
+  }
+
+  // Undo the transformation to the canonical form.
+  if (swapp < 0.0) {
+    std::swap(salp1, salp2);
+    std::swap(calp1, calp2);
+  }
+  salp1 *= swapp * lonsign;
+  calp1 *= swapp * latsign;
+  salp2 *= swapp * lonsign;
+  calp2 *= swapp * latsign;
+
+  if (azimuth1)
+    *azimuth1 = Atan2Degrees(salp1, calp1);
+  if (azimuth2)
+    *azimuth2 = Atan2Degrees(salp2, calp2);
+  return 0.0 + s12x;
+}
+
+double Geodesic::inverse(QGeoCoordinate const &from, QGeoCoordinate const &to,
+                         double *azimuth1, double *azimuth2) const
+{
+  return inverse(from.latitude(), from.longitude(), to.latitude(), to.longitude(), azimuth1, azimuth2);
+}
+
+void Geodesic::inverse(int count,
+                       double const *lat1, double const *lon1,
+                       double const *lat2, double const *lon2,
+                       double *distance, double *azimuth1, double *azimuth2) const
+{
+  ForEachBlock(count, [=](int begin, int end) {
+      double s12, azi1, azi2;
+      for (int i = begin; i < end; ++i) {
+        s12 = inverse(lat1[i], lon1[i], lat2[i], lon2[i], &azi1, &azi2);
+        if (distance)
+          distance[i] = s12;
+        if (azimuth1)
+          azimuth1[i] = azi1;
+        if (azimuth2)
+          azimuth2[i] = azi2;
+      }
+    });
+}
+
+double Geodesic::greatEllipse(double lat1, double lon1, double lat2, double lon2,
+                              double *azimuth1, double *azimuth2) const
+{
+  // Work in Earth centered, Earth fixed coordinates scaled by the
+  // equatorial radius.
+  double sphi1, cphi1, slam1, clam1, sphi2, cphi2, slam2, clam2;
+  SinCosDegrees(LatFix(lat1), sphi1, cphi1);
+  SinCosDegrees(lon1, slam1, clam1);
+  SinCosDegrees(LatFix(lat2), sphi2, cphi2);
+  SinCosDegrees(lon2, slam2, clam2);
+  const double nu1 = 1.0 / std::sqrt(1.0 - m_e2 * Sq(sphi1));
+  const double nu2 = 1.0 / std::sqrt(1.0 - m_e2 * Sq(sphi2));
+  const double p1[3] = { nu1 * cphi1 * clam1, nu1 * cphi1 * slam1, nu1 * (1.0 - m_e2) * sphi1 };
+  const double p2[3] = { nu2 * cphi2 * clam2, nu2 * cphi2 * slam2, nu2 * (1.0 - m_e2) * sphi2 };
+
+  // The normal to the plane of the great ellipse.  For coincident
+  // or antipodal points the plane is not defined by the points, and
+  // the meridian of the first point is used.
+  double n[3] = { p1[1] * p2[2] - p1[2] * p2[1],
+                  p1[2] * p2[0] - p1[0] * p2[2],
+                  p1[0] * p2[1] - p1[1] * p2[0] };
+  double nn = std::sqrt(Sq(n[0]) + Sq(n[1]) + Sq(n[2]));
+  if (nn < tol1) {
+    n[0] = -slam1;
+    n[1] = clam1;
+    n[2] = 0.0;
+    nn = 1.0;
+  }
+  n[0] /= nn;
+  n[1] /= nn;
+  n[2] /= nn;
+
+  // u is along the line of nodes, where the plane cuts the equator,
+  // and v completes a right handed basis (u, v, n) of the plane, so
+  // the path from point 1 to point 2 turns positively about n.
+  double u[3] = { -n[1], n[0], 0.0 };
+  double un = std::hypot(u[0], u[1]);
+  if (un < tol1) {
+    // The equator itself: any direction in the plane will do.
+    u[0] = clam1;
+    u[1] = slam1;
+    un = 1.0;
+  }
+  u[0] /= un;
+  u[1] /= un;
+  const double v[3] = { n[1] * u[2] - n[2] * u[1],
+                        n[2] * u[0] - n[0] * u[2],
+                        n[0] * u[1] - n[1] * u[0] };
+
+  // The great ellipse has the equatorial radius as its semi-major
+  // axis along u.  Its semi-minor axis, along v, is (relative to the
+  // equatorial radius) gamma.
+  const double gamma = 1.0 / std::sqrt(Sq(v[0]) + Sq(v[1]) + Sq(v[2]) / Sq(m_f1));
+
+  // The parametric angles of the points on the ellipse
+  const double x1 = p1[0] * u[0] + p1[1] * u[1];
+  const double y1 = (p1[0] * v[0] + p1[1] * v[1] + p1[2] * v[2]) / gamma;
+  const double x2 = p2[0] * u[0] + p2[1] * u[1];
+  const double y2 = (p2[0] * v[0] + p2[1] * v[1] + p2[2] * v[2]) / gamma;
+  const double r1 = std::hypot(x1, y1), r2 = std::hypot(x2, y2);
+  const double ssig1 = y1 / r1, csig1 = x1 / r1;
+  const double ssig2 = y2 / r2, csig2 = x2 / r2;
+  const double sig12 = std::atan2(qMax(0.0, csig1 * ssig2 - ssig1 * csig2) + 0.0,
+                                 csig1 * csig2 + ssig1 * ssig2);
+
+  // The arc of an ellipse is that of a meridian of an ellipsoid with
+  // the same axes, so use the same series as for the geodesic, in the
+  // third flattening of the great ellipse.
+  double C1a[nC1 + 1];
+  const double eps = (1.0 - gamma) / (1.0 + gamma);
+  C1f(eps, C1a);
+  const double B1 = SinCosSeries(true, ssig2, csig2, C1a, nC1) - SinCosSeries(true, ssig1, csig1, C1a, nC1);
+  const double distance = m_a * gamma * (1.0 + A1m1f(eps)) * (sig12 + B1);
+
+  // The bearings are those of the tangents to the ellipse in the
+  // local north and east directions.
+  auto bearing = [&](double ssig, double csig, double sphi, double cphi, double slam, double clam) {
+    const double t[3] = { -ssig * u[0] + gamma * csig * v[0],
+                          -ssig * u[1] + gamma * csig * v[1],
+                          gamma * csig * v[2] };
+    const double east = -slam * t[0] + clam * t[1];
+    const double north = -sphi * (clam * t[0] + slam * t[1]) + cphi * t[2];
+    return Atan2Degrees(east, north);
+  };
+  if (azimuth1)
+    *azimuth1 = bearing(ssig1, csig1, sphi1, cphi1, slam1, clam1);
+  if (azimuth2)
+    *azimuth2 = bearing(ssig2, csig2, sphi2, cphi2, slam2, clam2);
+  return distance;
+}
+
+double Geodesic::greatEllipse(QGeoCoordinate const &from, QGeoCoordinate const &to,
+                              double *azimuth1, double *azimuth2) const
+{
+  return greatEllipse(from.latitude(), from.longitude(), to.latitude(), to.longitude(), azimuth1, azimuth2);
+}
+
+void Geodesic::greatEllipse(int count,
+                            double const *lat1, double const *lon1,
+                            double const *lat2, double const *lon2,
+                            double *distance, double *azimuth1, double *azimuth2) const
+{
+  ForEachBlock(count, [=](int begin, int end) {
+      double s12, azi1, azi2;
+      for (int i = begin; i < end; ++i) {
+        s12 = greatEllipse(lat1[i], lon1[i], lat2[i], lon2[i], &azi1, &azi2);
+        if (distance)
+          distance[i] = s12;
+        if (azimuth1)
+          azimuth1[i] = azi1;
+        if (azimuth2)
+          azimuth2[i] = azi2;
+      }
+    });
+}
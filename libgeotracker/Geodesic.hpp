@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QGeoCoordinate>
+
+// The Geodesic class solves the inverse geodetic problem on the
+// ellipsoid: given two points on the surface, find the length of the
+// shortest path between them and the bearings (azimuths, in degrees
+// clockwise from true north) of that path at either end.  This is
+// the ground track distance, as opposed to the line of sight range
+// of GeoPoint::distanceTo() and LookAngle.
+//
+// Two paths are offered:
+//
+// - The geodesic, which is the true shortest path, computed with
+//   Karney's algorithm ("Algorithms for geodesics", J. Geodesy 87,
+//   43-55, 2013).  The result is accurate to about 15 nanometers for
+//   any pair of points, including nearly antipodal ones.  This is a
+//   transcription of the inverse solution of GeographicLib (MIT/X11
+//   license), reduced to the distance and the azimuths.
+//
+// - The great ellipse, which is the intersection of the ellipsoid
+//   with the plane through the two points and the center of the
+//   earth.  It is cheaper (no iteration) and, for points less than
+//   10000 km apart, no more than about 15 meters longer than the
+//   geodesic; it departs further from the geodesic as the points
+//   approach the antipodes.  It is the ellipsoidal counterpart of
+//   the great circle used by QGeoCoordinate::distanceTo() and
+//   azimuthTo().
+//
+// The final bearing is the forward azimuth at the second point, i.e.
+// the direction of travel on arrival, not the bearing back to the
+// first point.
+//
+// The batch versions take structure of arrays inputs and outputs so
+// that large sets of pairs can be processed without building
+// QGeoCoordinate objects.  Any of the outputs may be null if it is
+// not needed.  Batches are split across the global thread pool.
+//
+// Coordinates are in degrees, distances in meters.  The altitudes of
+// QGeoCoordinate arguments are ignored: the paths are on the surface
+// of the ellipsoid.
+
+class Geodesic
+{
+public:
+  // The WGS84 ellipsoid
+  Geodesic();
+  // An ellipsoid given its equatorial radius and flattening.  Only
+  // oblate ellipsoids (0 <= flattening < 1) are supported.
+  Geodesic(double equatorialRadius, double flattening);
+
+  double equatorialRadius() const;
+  double flattening() const;
+
+  // The length in meters of the geodesic between two points, and
+  // optionally its initial and final azimuths.
+  double inverse(double lat1, double lon1, double lat2, double lon2,
+                 double *azimuth1 = nullptr, double *azimuth2 = nullptr) const;
+  double inverse(QGeoCoordinate const &from, QGeoCoordinate const &to,
+                 double *azimuth1 = nullptr, double *azimuth2 = nullptr) const;
+  void inverse(int count,
+               double const *lat1, double const *lon1,
+               double const *lat2, double const *lon2,
+               double *distance, double *azimuth1, double *azimuth2) const;
+
+  // The same for the great ellipse.
+  double greatEllipse(double lat1, double lon1, double lat2, double lon2,
+                      double *azimuth1 = nullptr, double *azimuth2 = nullptr) const;
+  double greatEllipse(QGeoCoordinate const &from, QGeoCoordinate const &to,
+                      double *azimuth1 = nullptr, double *azimuth2 = nullptr) const;
+  void greatEllipse(int count,
+                    double const *lat1, double const *lon1,
+                    double const *lat2, double const *lon2,
+                    double *distance, double *azimuth1, double *azimuth2) const;
+
+  // The WGS84 ellipsoid, shared
+  static Geodesic const &wgs84();
+
+private:
+  void lengths(double eps, double sig12,
+               double ssig1, double csig1, double dn1,
+               double ssig2, double csig2, double dn2,
+               bool wantDistance, double *s12b, double *m12b, double *m0) const;
+  double inverseStart(double sbet1, double cbet1, double sbet2, double cbet2,
+                      double lam12, double slam12, double clam12,
+                      double *salp1, double *calp1, double *salp2, double *calp2,
+                      double *dnm) const;
+  double lambda12(double sbet1, double cbet1, double dn1,
+                  double sbet2, double cbet2, double dn2,
+                  double salp1, double calp1, double slam120, double clam120,
+                  bool diffp,
+                  double *salp2, double *calp2, double *sig12,
+                  double *ssig1, double *csig1, double *ssig2, double *csig2,
+                  double *eps, double *dlam12) const;
+  double a3f(double eps) const;
+  void c3f(double eps, double c[]) const;
+
+  double m_a;         // equatorial radius
+  double m_f;         // flattening
+  double m_f1;        // 1 - f
+  double m_e2;        // eccentricity squared
+  double m_ep2;       // second eccentricity squared
+  double m_n;         // third flattening
+  double m_b;         // polar radius
+  double m_etol2;
+  double m_A3x[6];
+  double m_C3x[15];
+};
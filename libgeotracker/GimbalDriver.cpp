@@ -0,0 +1,398 @@
+#include <QtCore>
+#include <QtMath>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <errno.h>
+#include <string.h>
+#include "GimbalDriver.hpp"
+#include "Metrics.hpp"
+
+// The target is extrapolated for no longer than this after its last
+// look angle, and look angles further apart than this give it no rate.
+static const double ExtrapolationLimit = 1.0;   // seconds
+
+// The metrics of the gimbal
+static
+MetricGauge &TrackingError()
+{
+  static MetricGauge *gauge = Metrics::global().gauge("geotracker_gimbal_tracking_error_degrees",
+                                                      "Angle between the commanded direction of the gimbal and the target.");
+  return *gauge;
+}
+
+static
+MetricCounter &OverrunCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_gimbal_overruns_total",
+                                                            "Gimbal commands replaced before they were written, the device being behind.");
+  return *counter;
+}
+
+static
+speed_t BaudRate(int baudRate)
+{
+  switch (baudRate) {
+  case 9600:    return B9600;
+  case 19200:   return B19200;
+  case 38400:   return B38400;
+  case 57600:   return B57600;
+  case 115200:  return B115200;
+  case 230400:  return B230400;
+#ifdef B460800
+  case 460800:  return B460800;
+#endif
+#ifdef B921600
+  case 921600:  return B921600;
+#endif
+  default:      return B0;
+  }
+}
+
+// An angle difference the short way around, in (-180, 180]
+static
+double Wrap180(double degrees)
+{
+  degrees = std::fmod(degrees, 360.0);
+  if (degrees > 180.0)
+    degrees -= 360.0;
+  else if (degrees <= -180.0)
+    degrees += 360.0;
+  return degrees;
+}
+
+// An azimuth in [0, 360)
+static
+double Wrap360(double degrees)
+{
+  degrees = std::fmod(degrees, 360.0);
+  if (degrees < 0.0)
+    degrees += 360.0;
+  return degrees >= 360.0 ? 0.0 : degrees;
+}
+
+// Drive one axis towards a target moving at a rate, by an interval.
+// The axis brakes at its acceleration to arrive with the rate of the
+// target.  The closing speed is the highest from which the steps of
+// the interval can brake, losing the acceleration times the interval
+// at each, within the error: k steps cover k(k + 1)/2 times the
+// acceleration times the interval squared.
+static
+void Drive(double error, double targetRate, double maxRate, double maxAcceleration,
+           double interval, double *position, double *rate)
+{
+  double closing;
+  if (interval > 0.0) {
+    const double unit = maxAcceleration * interval * interval;
+    const double steps = 0.5 * (qSqrt(1.0 + 8.0 * qAbs(error) / unit) - 1.0);
+    closing = steps * maxAcceleration * interval;
+  } else {
+    closing = qSqrt(2.0 * maxAcceleration * qAbs(error));
+  }
+  const double wanted = qBound(-maxRate, targetRate + (error < 0.0 ? -closing : closing), maxRate);
+  const double change = maxAcceleration * interval;
+  *rate += qBound(-change, wanted - *rate, change);
+  *position += *rate * interval;
+}
+
+GimbalLimits GimbalLimits::defaults()
+{
+  GimbalLimits limits;
+  limits.azimuthRate = 60.0;
+  limits.azimuthAcceleration = 120.0;
+  limits.elevationRate = 60.0;
+  limits.elevationAcceleration = 120.0;
+  limits.minimumElevation = -10.0;
+  limits.maximumElevation = 90.0;
+  return limits;
+}
+
+GimbalDriver::GimbalDriver(QObject *parent) :
+  QObject(parent),
+  m_limits(GimbalLimits::defaults()),
+  m_commandRate(50),
+  m_hasTarget(false),
+  m_targetTime(0.0),
+  m_targetAzimuth(0.0),
+  m_targetElevation(0.0),
+  m_targetAzimuthRate(0.0),
+  m_targetElevationRate(0.0),
+  m_time(0.0),
+  m_lastTick(0),
+  timer(new QTimer(this)),
+  m_fd(-1),
+  notifier(nullptr)
+{
+  qRegisterMetaType<GimbalCommand>();
+  m_position.azimuth = 0.0;
+  m_position.elevation = 0.0;
+  m_position.azimuthRate = 0.0;
+  m_position.elevationRate = 0.0;
+  m_statistics.commands = 0;
+  m_statistics.overruns = 0;
+  m_statistics.trackingError = 0.0;
+  m_statistics.maxTrackingError = 0.0;
+  m_clock.start();
+  timer->setTimerType(Qt::PreciseTimer);
+  timer->setInterval(1000 / m_commandRate);
+  connect(timer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+GimbalDriver::~GimbalDriver()
+{
+  close();
+}
+
+GimbalLimits GimbalDriver::limits() const
+{
+  return m_limits;
+}
+
+void GimbalDriver::setLimits(GimbalLimits const &limits)
+{
+  m_limits = limits;
+}
+
+int GimbalDriver::commandRate() const
+{
+  return m_commandRate;
+}
+
+void GimbalDriver::setCommandRate(int rate)
+{
+  m_commandRate = qBound(1, rate, 1000);
+  timer->setInterval(1000 / m_commandRate);
+}
+
+bool GimbalDriver::open(QString const &device, int baudRate)
+{
+  close();
+  m_fd = ::open(QFile::encodeName(device).constData(), O_WRONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+  if (m_fd < 0) {
+    m_errorString = QString::fromLocal8Bit(strerror(errno));
+    return false;
+  }
+  if (::isatty(m_fd)) {
+    // Raw bytes, at the baud rate of the link
+    struct termios options;
+    if (::tcgetattr(m_fd, &options) == 0) {
+      ::cfmakeraw(&options);
+      options.c_cflag |= CLOCAL;
+      const speed_t speed = BaudRate(baudRate);
+      if (speed != B0) {
+        ::cfsetispeed(&options, speed);
+        ::cfsetospeed(&options, speed);
+      } else {
+        qWarning() << "Warning: unsupported baud rate" << baudRate;
+      }
+      ::tcsetattr(m_fd, TCSANOW, &options);
+    }
+  }
+
+  // Only watched while a command waits for the device
+  notifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+  notifier->setEnabled(false);
+  connect(notifier, SIGNAL(activated(int)), this, SLOT(writeOut()));
+  return true;
+}
+
+void GimbalDriver::close()
+{
+  delete notifier;
+  notifier = nullptr;
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+  m_partial.clear();
+  m_next.clear();
+}
+
+bool GimbalDriver::isOpen() const
+{
+  return m_fd >= 0;
+}
+
+QString GimbalDriver::errorString() const
+{
+  return m_errorString;
+}
+
+GimbalCommand GimbalDriver::position() const
+{
+  return m_position;
+}
+
+void GimbalDriver::setPosition(double azimuth, double elevation)
+{
+  m_position.azimuth = Wrap360(azimuth);
+  m_position.elevation = qBound(m_limits.minimumElevation, elevation, m_limits.maximumElevation);
+  m_position.azimuthRate = 0.0;
+  m_position.elevationRate = 0.0;
+}
+
+LookAngle GimbalDriver::target() const
+{
+  double azimuth, elevation;
+  targetAt(m_time, &azimuth, &elevation);
+  return LookAngle(float(azimuth), float(elevation));
+}
+
+bool GimbalDriver::hasTarget() const
+{
+  return m_hasTarget;
+}
+
+GimbalStatistics GimbalDriver::statistics() const
+{
+  return m_statistics;
+}
+
+void GimbalDriver::setTarget(LookAngle const &lookAngle)
+{
+  // The look angle is taken to be of the time of the last step, which
+  // is at most one command interval off.
+  const double azimuth = lookAngle.azimuth();
+  const double elevation = lookAngle.elevation();
+  const double elapsed = m_time - m_targetTime;
+  if (m_hasTarget && elapsed > 0.0 && elapsed <= ExtrapolationLimit) {
+    m_targetAzimuthRate = qBound(-m_limits.azimuthRate,
+                                 Wrap180(azimuth - m_targetAzimuth) / elapsed,
+                                 m_limits.azimuthRate);
+    m_targetElevationRate = qBound(-m_limits.elevationRate,
+                                   (elevation - m_targetElevation) / elapsed,
+                                   m_limits.elevationRate);
+  } else if (!m_hasTarget || elapsed > 0.0) {
+    m_targetAzimuthRate = 0.0;
+    m_targetElevationRate = 0.0;
+  }
+  m_hasTarget = true;
+  m_targetTime = m_time;
+  m_targetAzimuth = azimuth;
+  m_targetElevation = elevation;
+}
+
+void GimbalDriver::targetAt(double time, double *azimuth, double *elevation) const
+{
+  const double ahead = qBound(0.0, time - m_targetTime, ExtrapolationLimit);
+  *azimuth = Wrap360(m_targetAzimuth + m_targetAzimuthRate * ahead);
+  *elevation = qBound(m_limits.minimumElevation,
+                      m_targetElevation + m_targetElevationRate * ahead,
+                      m_limits.maximumElevation);
+}
+
+GimbalCommand GimbalDriver::step(double interval)
+{
+  interval = qMax(0.0, interval);
+  m_time += interval;
+  if (!m_hasTarget)
+    return m_position;
+
+  double azimuth, elevation;
+  targetAt(m_time, &azimuth, &elevation);
+  const bool isExtrapolating = m_time - m_targetTime < ExtrapolationLimit;
+  const double azimuthRate = isExtrapolating ? m_targetAzimuthRate : 0.0;
+  const double elevationRate = isExtrapolating ? m_targetElevationRate : 0.0;
+
+  Drive(Wrap180(azimuth - m_position.azimuth), azimuthRate,
+        m_limits.azimuthRate, m_limits.azimuthAcceleration, interval,
+        &m_position.azimuth, &m_position.azimuthRate);
+  m_position.azimuth = Wrap360(m_position.azimuth);
+  Drive(elevation - m_position.elevation, elevationRate,
+        m_limits.elevationRate, m_limits.elevationAcceleration, interval,
+        &m_position.elevation, &m_position.elevationRate);
+  if (m_position.elevation <= m_limits.minimumElevation || m_position.elevation >= m_limits.maximumElevation) {
+    m_position.elevation = qBound(m_limits.minimumElevation, m_position.elevation, m_limits.maximumElevation);
+    m_position.elevationRate = 0.0;
+  }
+
+  // The angle between the two directions, by the haversine formula,
+  // which holds up for small angles
+  const double e1 = qDegreesToRadians(m_position.elevation);
+  const double e2 = qDegreesToRadians(elevation);
+  const double da = qDegreesToRadians(azimuth - m_position.azimuth);
+  const double h = qPow(qSin(0.5 * (e2 - e1)), 2) + qCos(e1) * qCos(e2) * qPow(qSin(0.5 * da), 2);
+  const double error = qRadiansToDegrees(2.0 * qAsin(qMin(1.0, qSqrt(h))));
+
+  ++m_statistics.commands;
+  m_statistics.trackingError = error;
+  m_statistics.maxTrackingError = qMax(m_statistics.maxTrackingError, error);
+  TrackingError().set(error);
+  emit commanded(m_position);
+  emit trackingErrorChanged(error);
+  return m_position;
+}
+
+QByteArray GimbalDriver::format(GimbalCommand const &command)
+{
+  QByteArray sentence = "GMBL,";
+  sentence += QByteArray::number(command.azimuth, 'f', 3) + ',';
+  sentence += QByteArray::number(command.elevation, 'f', 3) + ',';
+  sentence += QByteArray::number(command.azimuthRate, 'f', 3) + ',';
+  sentence += QByteArray::number(command.elevationRate, 'f', 3);
+  quint8 checksum = 0;
+  for (char c : sentence)
+    checksum ^= quint8(c);
+  return '$' + sentence + '*' + QByteArray::number(checksum, 16).toUpper().rightJustified(2, '0') + "\r\n";
+}
+
+void GimbalDriver::start()
+{
+  m_lastTick = m_clock.nsecsElapsed();
+  timer->start();
+}
+
+void GimbalDriver::stop()
+{
+  timer->stop();
+  m_position.azimuthRate = 0.0;
+  m_position.elevationRate = 0.0;
+}
+
+void GimbalDriver::tick()
+{
+  // Step by the time actually elapsed, as the timer may be late.
+  const qint64 now = m_clock.nsecsElapsed();
+  const double interval = (now - m_lastTick) * 1e-9;
+  m_lastTick = now;
+  if (!m_hasTarget)
+    return;
+  const GimbalCommand command = step(interval);
+  if (m_fd >= 0)
+    send(format(command));
+}
+
+void GimbalDriver::send(QByteArray const &line)
+{
+  if (!m_next.isEmpty()) {
+    ++m_statistics.overruns;
+    OverrunCount().increment();
+  }
+  m_next = line;
+  writeOut();
+}
+
+void GimbalDriver::writeOut()
+{
+  // The rest of a command partly written goes first, so that the
+  // device never sees half a line.
+  while (m_fd >= 0 && (!m_partial.isEmpty() || !m_next.isEmpty())) {
+    if (m_partial.isEmpty())
+      m_partial.swap(m_next);
+    const ssize_t size = ::write(m_fd, m_partial.constData(), size_t(m_partial.size()));
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      notifier->setEnabled(true);
+      return;
+    }
+    if (size < 0) {
+      m_errorString = QString::fromLocal8Bit(strerror(errno));
+      qWarning() << "Error: cannot write to the gimbal:" << m_errorString;
+      close();
+      return;
+    }
+    m_partial.remove(0, int(size));
+  }
+  if (notifier)
+    notifier->setEnabled(false);
+}
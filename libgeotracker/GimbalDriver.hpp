@@ -0,0 +1,163 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include "LookAngle.hpp"
+
+class QTimer;
+class QSocketNotifier;
+
+// The limits of the motion of a gimbal: the top speed and the
+// acceleration of each axis, and the travel of the elevation axis.
+// The azimuth axis turns without end.
+
+struct GimbalLimits
+{
+  double azimuthRate;             // degrees per second
+  double azimuthAcceleration;     // degrees per second squared
+  double elevationRate;           // degrees per second
+  double elevationAcceleration;   // degrees per second squared
+  double minimumElevation;        // degrees
+  double maximumElevation;        // degrees
+
+  // A small pan and tilt head
+  static GimbalLimits defaults();
+};
+
+// A command to the gimbal: where to point, and how fast each axis is
+// moving there.
+
+struct GimbalCommand
+{
+  double azimuth;         // degrees from true north, 0 to 360
+  double elevation;       // degrees above the horizon
+  double azimuthRate;     // degrees per second, clockwise
+  double elevationRate;   // degrees per second, up
+};
+
+Q_DECLARE_METATYPE(GimbalCommand)
+
+struct GimbalStatistics
+{
+  quint64 commands;           // commands made
+  quint64 overruns;           // commands dropped, the device being behind
+  double  trackingError;      // degrees, of the last command
+  double  maxTrackingError;   // degrees, since the start
+};
+
+// The GimbalDriver points a gimbal at the target: it turns the look
+// angles of the target, which arrive at the rate of the position
+// source, into a trajectory that the gimbal can follow, sampled at
+// the rate of its controller.
+//
+// Between look angles the target is extrapolated at the rate of the
+// last two (for up to a second), and each axis is driven towards it
+// at no more than its top speed and acceleration, braking in time to
+// stop on it rather than overshoot.  The azimuth is driven the short
+// way around, so the gimbal goes from 359 to 1 degrees through north.
+// The elevation is kept within the travel of the axis.
+//
+// Every command is sent to the device, if one is open, as a line of
+// ASCII, in the manner of NMEA 0183:
+//
+//   $GMBL,<azimuth>,<elevation>,<azimuth rate>,<elevation rate>*<checksum>\r\n
+//
+// with the angles in degrees to a thousandth and the rates in degrees
+// per second, and the checksum the exclusive or of the bytes between
+// the $ and the *, in hexadecimal.  The device (a serial device or
+// pseudo terminal, put in raw mode at the baud rate) is written
+// without blocking.  When it cannot keep up, the command waiting to
+// be written is replaced by the newer one, which is counted as an
+// overrun: a stale position is no use to the gimbal.
+//
+// The tracking error is the angle between the commanded direction and
+// the target.  POSIX only.
+
+class GimbalDriver : public QObject
+{
+  Q_OBJECT
+public:
+  GimbalDriver(QObject *parent = nullptr);
+  ~GimbalDriver();
+
+  GimbalLimits limits() const;
+  void setLimits(GimbalLimits const &limits);
+
+  // Commands per second
+  int commandRate() const;
+  void setCommandRate(int rate);
+
+  // Write the commands to a device.  Returns false, with the reason
+  // in errorString(), if it cannot be opened.
+  bool open(QString const &device, int baudRate = 115200);
+  void close();
+  bool isOpen() const;
+  QString errorString() const;
+
+  // Where the gimbal points, as last commanded.  Set it to where the
+  // gimbal is before the start.
+  GimbalCommand position() const;
+  void setPosition(double azimuth, double elevation);
+
+  // The direction of the target, extrapolated to now
+  LookAngle target() const;
+  bool hasTarget() const;
+
+  GimbalStatistics statistics() const;
+
+  // Advance the trajectory by an interval in seconds, and return the
+  // command for the end of it.  The timer does this at the command
+  // rate; it is public so that the trajectory may be computed
+  // off line.
+  GimbalCommand step(double interval);
+
+  // The line sent to the device for a command
+  static QByteArray format(GimbalCommand const &command);
+
+public slots:
+  // A new look angle of the target
+  void setTarget(LookAngle const &lookAngle);
+
+  void start();
+  void stop();
+
+signals:
+  void commanded(GimbalCommand const &command);
+  void trackingErrorChanged(double degrees);
+
+private slots:
+  void tick();
+  void writeOut();
+
+private:
+  // The target extrapolated to a time of the trajectory
+  void targetAt(double time, double *azimuth, double *elevation) const;
+  void send(QByteArray const &line);
+
+  GimbalLimits m_limits;
+  int m_commandRate;
+  GimbalCommand m_position;
+  GimbalStatistics m_statistics;
+
+  // The target, and its rates from the look angle before
+  bool m_hasTarget;
+  double m_targetTime;            // seconds of the trajectory
+  double m_targetAzimuth;
+  double m_targetElevation;
+  double m_targetAzimuthRate;
+  double m_targetElevationRate;
+
+  double m_time;                  // seconds of the trajectory, stepped
+  QElapsedTimer m_clock;
+  qint64 m_lastTick;              // nanoseconds of m_clock
+  QTimer *timer;
+
+  int m_fd;
+  QString m_errorString;
+  QSocketNotifier *notifier;
+  QByteArray m_partial;           // the rest of a command partly written
+  QByteArray m_next;              // the command waiting to be written
+};
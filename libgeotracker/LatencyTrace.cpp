@@ -0,0 +1,302 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+#include <QtAlgorithms>
+#include <QTimer>
+#include <cstdio>
+#include <cmath>
+#include <limits>
+#include "LatencyTrace.hpp"
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <string.h>
+#endif
+
+// The longest latency counted, about 18 minutes
+static const qint64 LongestLatency = (Q_INT64_C(1) << 40) - 1;
+
+LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+LatencyHistogram::LatencyHistogram(LatencyHistogram const &other)
+{
+  *this = other;
+}
+
+LatencyHistogram &LatencyHistogram::operator=(LatencyHistogram const &other)
+{
+  for (int i = 0; i < CounterCount; ++i)
+    m_counts[i].storeRelaxed(other.m_counts[i].loadRelaxed());
+  m_count.storeRelaxed(other.m_count.loadRelaxed());
+  m_sum.storeRelaxed(other.m_sum.loadRelaxed());
+  m_minimum.storeRelaxed(other.m_minimum.loadRelaxed());
+  m_maximum.storeRelaxed(other.m_maximum.loadRelaxed());
+  return *this;
+}
+
+int LatencyHistogram::indexOf(qint64 nsecs)
+{
+  const quint64 value = quint64(qBound(Q_INT64_C(0), nsecs, LongestLatency));
+  // The power of two above the first 256 values, which are counted
+  // one by one, and the position within it
+  const int bucket = 63 - int(qCountLeadingZeroBits(value | 255)) - SubBucketMagnitude;
+  return (bucket << SubBucketMagnitude) + int(value >> bucket);
+}
+
+qint64 LatencyHistogram::lowestAt(int index)
+{
+  int bucket = (index >> SubBucketMagnitude) - 1;
+  int subBucket = (index & ((1 << SubBucketMagnitude) - 1)) + (1 << SubBucketMagnitude);
+  if (bucket < 0) {
+    subBucket -= 1 << SubBucketMagnitude;
+    bucket = 0;
+  }
+  return qint64(subBucket) << bucket;
+}
+
+qint64 LatencyHistogram::highestAt(int index)
+{
+  const int bucket = qMax(0, (index >> SubBucketMagnitude) - 1);
+  return lowestAt(index) + (Q_INT64_C(1) << bucket) - 1;
+}
+
+void LatencyHistogram::record(qint64 nsecs)
+{
+  // A single writer: no atomic read-modify-write is needed.
+  QAtomicInteger<quint64> &counter = m_counts[indexOf(nsecs)];
+  counter.storeRelaxed(counter.loadRelaxed() + 1);
+  m_count.storeRelaxed(m_count.loadRelaxed() + 1);
+  m_sum.storeRelaxed(m_sum.loadRelaxed() + nsecs);
+  if (nsecs < m_minimum.loadRelaxed())
+    m_minimum.storeRelaxed(nsecs);
+  if (nsecs > m_maximum.loadRelaxed())
+    m_maximum.storeRelaxed(nsecs);
+}
+
+void LatencyHistogram::add(LatencyHistogram const &other)
+{
+  for (int i = 0; i < CounterCount; ++i)
+    m_counts[i].fetchAndAddRelaxed(other.m_counts[i].loadRelaxed());
+  m_count.fetchAndAddRelaxed(other.m_count.loadRelaxed());
+  m_sum.fetchAndAddRelaxed(other.m_sum.loadRelaxed());
+  m_minimum.storeRelaxed(qMin(m_minimum.loadRelaxed(), other.m_minimum.loadRelaxed()));
+  m_maximum.storeRelaxed(qMax(m_maximum.loadRelaxed(), other.m_maximum.loadRelaxed()));
+}
+
+void LatencyHistogram::reset()
+{
+  for (int i = 0; i < CounterCount; ++i)
+    m_counts[i].storeRelaxed(0);
+  m_count.storeRelaxed(0);
+  m_sum.storeRelaxed(0);
+  m_minimum.storeRelaxed(std::numeric_limits<qint64>::max());
+  m_maximum.storeRelaxed(0);
+}
+
+quint64 LatencyHistogram::count() const
+{
+  return m_count.loadRelaxed();
+}
+
+qint64 LatencyHistogram::sum() const
+{
+  return m_sum.loadRelaxed();
+}
+
+qint64 LatencyHistogram::minimum() const
+{
+  return count() ? m_minimum.loadRelaxed() : 0;
+}
+
+qint64 LatencyHistogram::maximum() const
+{
+  return m_maximum.loadRelaxed();
+}
+
+qint64 LatencyHistogram::percentile(double fraction) const
+{
+  const quint64 total = count();
+  if (total == 0)
+    return 0;
+  const quint64 rank = qMax(Q_UINT64_C(1), quint64(std::ceil(qBound(0.0, fraction, 1.0) * double(total))));
+  quint64 cumulative = 0;
+  for (int i = 0; i < CounterCount; ++i) {
+    cumulative += m_counts[i].loadRelaxed();
+    if (cumulative >= rank)
+      return qMin(highestAt(i), maximum());
+  }
+  return maximum();
+}
+
+// The histograms of a thread
+struct LatencyRecorder
+{
+  LatencyHistogram stages[LatencyTrace::StageCount];
+};
+
+static QMutex recordersMutex;
+static QVector<LatencyRecorder *> recorders;
+static thread_local LatencyRecorder *threadRecorder = nullptr;
+static thread_local qint64 threadOrigin = 0;
+
+static
+LatencyRecorder *ThreadRecorder()
+{
+  // Made on the first mark of a thread; the lock is taken only then.
+  if (!threadRecorder) {
+    threadRecorder = new LatencyRecorder;
+    QMutexLocker locker(&recordersMutex);
+    recorders.append(threadRecorder);
+  }
+  return threadRecorder;
+}
+
+LatencyTrace::Scope::Scope() :
+  m_previous(threadOrigin)
+{
+  threadOrigin = now();
+}
+
+LatencyTrace::Scope::Scope(qint64 origin) :
+  m_previous(threadOrigin)
+{
+  threadOrigin = origin;
+}
+
+LatencyTrace::Scope::~Scope()
+{
+  threadOrigin = m_previous;
+}
+
+qint64 LatencyTrace::now()
+{
+  static const QElapsedTimer clock = []() {
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+  }();
+  return clock.nsecsElapsed() + 1;
+}
+
+qint64 LatencyTrace::origin()
+{
+  return threadOrigin;
+}
+
+void LatencyTrace::mark(Stage stage)
+{
+  const qint64 origin = threadOrigin;
+  if (origin == 0)
+    return;
+  ThreadRecorder()->stages[stage].record(now() - origin);
+}
+
+char const *LatencyTrace::stageName(Stage stage)
+{
+  switch (stage) {
+  case Handover:           return "handover";
+  case EntityUpdate:       return "entity update";
+  case LookAngleComputed:  return "look angle computed";
+  case LookAngleDelivered: return "look angle delivered";
+  default:                 return "?";
+  }
+}
+
+LatencyHistogram LatencyTrace::histogram(Stage stage)
+{
+  LatencyHistogram sum;
+  QMutexLocker locker(&recordersMutex);
+  for (LatencyRecorder const *recorder : recorders)
+    sum.add(recorder->stages[stage]);
+  return sum;
+}
+
+void LatencyTrace::reset()
+{
+  // Racing with the recording threads, a few counts may survive.
+  QMutexLocker locker(&recordersMutex);
+  for (LatencyRecorder *recorder : recorders) {
+    for (LatencyHistogram &histogram : recorder->stages)
+      histogram.reset();
+  }
+}
+
+QString LatencyTrace::report()
+{
+  QString result = QString::asprintf("%-22s %10s %10s %10s %10s %10s (us from ingest)\n",
+                                     "stage", "count", "p50", "p99", "p999", "max");
+  for (int stage = 0; stage < StageCount; ++stage) {
+    LatencyHistogram h = histogram(Stage(stage));
+    result += QString::asprintf("%-22s %10llu %10.1f %10.1f %10.1f %10.1f\n",
+                                stageName(Stage(stage)),
+                                static_cast<unsigned long long>(h.count()),
+                                h.percentile(0.5) / 1000.0,
+                                h.percentile(0.99) / 1000.0,
+                                h.percentile(0.999) / 1000.0,
+                                h.maximum() / 1000.0);
+  }
+  return result;
+}
+
+static
+void DumpReport()
+{
+  fputs(LatencyTrace::report().toLocal8Bit().constData(), stderr);
+  fflush(stderr);
+}
+
+#ifdef Q_OS_UNIX
+// The signal handler only raises a flag, which a timer of the event
+// loop looks at, since writing the report is not async signal safe.
+static volatile sig_atomic_t isReportRequested = 0;
+
+static
+void OnSignal(int)
+{
+  isReportRequested = 1;
+}
+#endif
+
+void LatencyTrace::dumpOnSignal(int signalNumber)
+{
+#ifdef Q_OS_UNIX
+  QCoreApplication *application = QCoreApplication::instance();
+  if (!application)
+    return;
+  static QTimer *timer = nullptr;
+  if (!timer) {
+    timer = new QTimer(application);
+    timer->setInterval(200);
+    QObject::connect(timer, &QTimer::timeout, []() {
+        if (isReportRequested) {
+          isReportRequested = 0;
+          DumpReport();
+        }
+      });
+    timer->start();
+  }
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = OnSignal;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  ::sigaction(signalNumber, &action, nullptr);
+#else
+  Q_UNUSED(signalNumber);
+#endif
+}
+
+void LatencyTrace::dumpOnSignal()
+{
+#ifdef Q_OS_UNIX
+  dumpOnSignal(SIGUSR1);
+#endif
+}
+
+void LatencyTrace::dumpAtExit()
+{
+  qAddPostRoutine(DumpReport);
+}
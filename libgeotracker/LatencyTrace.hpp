@@ -0,0 +1,136 @@
+#pragma once
+
+#include <QString>
+#include <QAtomicInteger>
+
+// A LatencyHistogram counts latencies in nanoseconds, from one
+// nanosecond to about 18 minutes, in the manner of an HDR histogram:
+// each power of two is divided into 128 buckets, so that any value is
+// counted with a relative error under 1%, whatever its magnitude,
+// with a fixed 35 kB of counters.  Longer latencies are counted as the
+// longest.
+//
+// It may be recorded into by one thread while it is read by others:
+// the counters are atomic, and only the recording thread writes
+// them.
+
+class LatencyHistogram
+{
+public:
+  LatencyHistogram();
+  LatencyHistogram(LatencyHistogram const &other);
+  LatencyHistogram &operator=(LatencyHistogram const &other);
+
+  // Count a latency.  Only one thread may record into a histogram.
+  void record(qint64 nsecs);
+  // Add the counts of another histogram
+  void add(LatencyHistogram const &other);
+  void reset();
+
+  quint64 count() const;
+  qint64 sum() const;
+  qint64 minimum() const;
+  qint64 maximum() const;
+  // The latency under which a fraction (0 to 1) of the latencies are,
+  // to within the precision of the histogram, or 0 if it is empty
+  qint64 percentile(double fraction) const;
+
+  // The number of counters, and the latencies they stand for
+  static int indexOf(qint64 nsecs);
+  static qint64 lowestAt(int index);
+  static qint64 highestAt(int index);
+
+  enum {
+    SubBucketMagnitude = 7,             // 128 buckets per power of two
+    BucketCount = 34,                   // up to 2^40 nanoseconds
+    CounterCount = (BucketCount + 1) << SubBucketMagnitude
+  };
+
+private:
+  QAtomicInteger<quint64> m_counts[CounterCount];
+  QAtomicInteger<quint64> m_count;
+  QAtomicInteger<qint64> m_sum;
+  QAtomicInteger<qint64> m_minimum;
+  QAtomicInteger<qint64> m_maximum;
+};
+
+// The LatencyTrace times the way of a position from the moment it is
+// read (by a position source: the ingest) to the moment the look
+// angle it leads to reaches its consumer.
+//
+// A trace starts with a Scope at the ingest, which takes the time of
+// a monotonic clock as the origin of the trace on this thread.  Each
+// stage that the position then goes through, within the scope, marks
+// itself: the time since the origin is counted in the histogram of
+// that stage.  Signals delivered by direct connections are within the
+// scope; where a queued connection hands a position over to another
+// thread (ThreadedPositionSource), the origin is carried along and
+// the trace resumes there.  Marks outside any trace are ignored.
+//
+// Each thread records into histograms of its own, found through a
+// thread local pointer, so recording takes no lock and shares no
+// cache line.  The histograms of the threads are added up when they
+// are read, and are kept until the process exits.
+//
+// The tracing is compiled in with "qmake DEFINES+=LATENCY_TRACE".
+// Without it, the LATENCY_TRACE_ macros placed along the way compile
+// to nothing; the classes stay available.
+
+class LatencyTrace
+{
+public:
+  // The stages, in order
+  enum Stage {
+    Handover,               // to the consumer's thread, if threaded
+    EntityUpdate,           // GeoEntity::setPosition
+    LookAngleComputed,      // GeoObserver::calculateLookAngle
+    LookAngleDelivered,     // the receiver of lookAngleChanged
+    StageCount
+  };
+
+  // A trace in progress on this thread, from now or from an origin
+  // carried over from another thread.  Scopes may be nested; the
+  // innermost one is in effect.
+  class Scope
+  {
+  public:
+    Scope();
+    explicit Scope(qint64 origin);
+    ~Scope();
+
+  private:
+    Q_DISABLE_COPY(Scope)
+    qint64 m_previous;
+  };
+
+  // The monotonic clock, in nanoseconds, never 0
+  static qint64 now();
+  // The origin of the trace in progress on this thread, or 0
+  static qint64 origin();
+  // Count the time since the origin for a stage
+  static void mark(Stage stage);
+
+  static char const *stageName(Stage stage);
+  // The histogram of a stage, all threads added up
+  static LatencyHistogram histogram(Stage stage);
+  static void reset();
+
+  // A table of the count, p50, p99, p999 and maximum of each stage,
+  // in microseconds
+  static QString report();
+
+  // Write the report to the standard error when the process receives
+  // a signal (on Unix), or when the application exits.  Both need a
+  // QCoreApplication.
+  static void dumpOnSignal(int signalNumber);
+  static void dumpOnSignal();
+  static void dumpAtExit();
+};
+
+#ifdef LATENCY_TRACE
+#define LATENCY_TRACE_SCOPE() LatencyTrace::Scope latencyTraceScope
+#define LATENCY_TRACE_MARK(stage) LatencyTrace::mark(LatencyTrace::stage)
+#else
+#define LATENCY_TRACE_SCOPE() do {} while (false)
+#define LATENCY_TRACE_MARK(stage) do {} while (false)
+#endif
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <QtGlobal>
+
+template <class Value> class ListenerList;
+
+// A Listener is called directly, without a signal, when a value it
+// listens to changes: the position of a GeoEntity (see
+// GeoEntity::addPositionListener) or the look angle of a GeoObserver
+// (see GeoObserver::addLookAngleListener).  It is the fast path from
+// an entity to its many observers, where a signal would cost a look
+// up of the connections, and a copy of the value per queued receiver.
+//
+// A Listener is bound to a member function of an object, which is
+// called through a plain function pointer made by the template:
+//
+//   listener.bind<GeoObserver, &GeoObserver::onTargetPositionChanged>(this);
+//   entity->addPositionListener(&listener);
+//
+// The lists are intrusive: the listener is the node of the list, so
+// adding and removing one allocates nothing and takes constant time.
+// A listener is in one list at most; it leaves the list when it is
+// removed, added to another or destroyed, and the list lets go of its
+// listeners when it is destroyed.  A listener may remove itself, or
+// any other, while it is called.
+//
+// The lists are not thread safe: a listener is called in the thread
+// that changes the value, and must be added and removed in that
+// thread.  Signals remain for the receivers in other threads, and for
+// QML.
+
+template <class Value>
+class Listener
+{
+public:
+  typedef void (*Callback)(void *object, Value const &value);
+
+  Listener() :
+    m_callback(nullptr),
+    m_object(nullptr),
+    m_list(nullptr),
+    m_previous(nullptr),
+    m_next(nullptr)
+  {
+  }
+
+  ~Listener()
+  {
+    unlisten();
+  }
+
+  // Call a member function of an object
+  template <class T, void (T::*Method)(Value const &)>
+  void bind(T *object)
+  {
+    m_callback = &invoke<T, Method>;
+    m_object = object;
+  }
+
+  bool isListening() const
+  {
+    return m_list != nullptr;
+  }
+
+  // Leave the list, if any
+  void unlisten()
+  {
+    if (m_list)
+      m_list->remove(this);
+  }
+
+private:
+  Q_DISABLE_COPY(Listener)
+  friend class ListenerList<Value>;
+
+  template <class T, void (T::*Method)(Value const &)>
+  static void invoke(void *object, Value const &value)
+  {
+    (static_cast<T *>(object)->*Method)(value);
+  }
+
+  Callback m_callback;
+  void *m_object;
+  ListenerList<Value> *m_list;
+  Listener *m_previous;
+  Listener *m_next;
+};
+
+// The listeners of a value, called in the order they were added
+
+template <class Value>
+class ListenerList
+{
+public:
+  ListenerList() :
+    m_first(nullptr),
+    m_last(nullptr),
+    m_next(nullptr)
+  {
+  }
+
+  ~ListenerList()
+  {
+    clear();
+  }
+
+  bool isEmpty() const
+  {
+    return m_first == nullptr;
+  }
+
+  int count() const
+  {
+    int count = 0;
+    for (Listener<Value> const *listener = m_first; listener; listener = listener->m_next)
+      ++count;
+    return count;
+  }
+
+  void add(Listener<Value> *listener)
+  {
+    listener->unlisten();
+    listener->m_list = this;
+    listener->m_previous = m_last;
+    listener->m_next = nullptr;
+    if (m_last)
+      m_last->m_next = listener;
+    else
+      m_first = listener;
+    m_last = listener;
+  }
+
+  void remove(Listener<Value> *listener)
+  {
+    if (listener->m_list != this)
+      return;
+    // A listener removed while the list is being notified must not be
+    // the next one called.
+    if (m_next == listener)
+      m_next = listener->m_next;
+    if (listener->m_previous)
+      listener->m_previous->m_next = listener->m_next;
+    else
+      m_first = listener->m_next;
+    if (listener->m_next)
+      listener->m_next->m_previous = listener->m_previous;
+    else
+      m_last = listener->m_previous;
+    listener->m_list = nullptr;
+    listener->m_previous = nullptr;
+    listener->m_next = nullptr;
+  }
+
+  void clear()
+  {
+    while (m_first)
+      remove(m_first);
+  }
+
+  // Call every listener with the value.  Not reentrant: a listener
+  // must not change the value again while it is called.
+  void notify(Value const &value)
+  {
+    for (Listener<Value> *listener = m_first; listener; listener = m_next) {
+      m_next = listener->m_next;
+      if (listener->m_callback)
+        listener->m_callback(listener->m_object, value);
+    }
+    m_next = nullptr;
+  }
+
+private:
+  Q_DISABLE_COPY(ListenerList)
+
+  Listener<Value> *m_first;
+  Listener<Value> *m_last;
+  Listener<Value> *m_next;    // of the notification in progress
+};
@@ -0,0 +1,153 @@
+#include <QtMath>
+#include "LocalTangentPlane.hpp"
+#include "FastMath.hpp"
+
+// The steps of the central differences of the Jacobian, in degrees
+// and meters.  The conversion is linear in the altitude.
+static const double AngleStep = 1.0e-4;
+static const double AltitudeStep = 1.0;
+
+// The equatorial radius, as in EarthRadiusInMeters(), and the share
+// of it added to the bound for the flattening and the terms of third
+// order
+static const double EquatorialRadius = 6378137.0;
+static const double BoundMargin = 1.01;
+
+LocalTangentPlane::LocalTangentPlane() :
+  m_tolerance(0.01),
+  m_hasReference(false),
+  m_latitude(0.0),
+  m_longitude(0.0),
+  m_altitude(0.0),
+  m_radius(0.0),
+  m_error(0.0),
+  m_rebases(0)
+{
+}
+
+double LocalTangentPlane::tolerance() const
+{
+  return m_tolerance;
+}
+
+void LocalTangentPlane::setTolerance(double tolerance)
+{
+  m_tolerance = tolerance;
+}
+
+QGeoCoordinate LocalTangentPlane::observer() const
+{
+  return m_observer;
+}
+
+void LocalTangentPlane::setObserver(QGeoCoordinate const &observer)
+{
+  if (observer == m_observer)
+    return;
+  m_observer = observer;
+  m_frame = LookAngleFrame::at(observer);
+  m_hasReference = false;
+}
+
+void LocalTangentPlane::lookAngle(QGeoCoordinate const &target, float *azimuth, float *elevation, double *range)
+{
+  const double dLatitude = target.latitude() - m_latitude;
+  double dLongitude = target.longitude() - m_longitude;
+  if (dLongitude > 180.0)
+    dLongitude -= 360.0;
+  else if (dLongitude < -180.0)
+    dLongitude += 360.0;
+  const double dAltitude = target.altitude() - m_altitude;
+
+  // The bound of the second order terms
+  const double s = (qAbs(dLatitude) + qAbs(dLongitude)) * (M_PI / 180.0);
+  const double error = s * (0.5 * m_radius * s + qAbs(dAltitude));
+
+  double d[3];
+  if (!m_hasReference || !(error <= m_tolerance)) {
+    rebase(target);
+    m_error = 0.0;
+    for (int i = 0; i < 3; ++i)
+      d[i] = m_offset[i];
+  } else {
+    m_error = error;
+    for (int i = 0; i < 3; ++i)
+      d[i] = m_offset[i] + m_jacobian[i][0]*dLatitude + m_jacobian[i][1]*dLongitude + m_jacobian[i][2]*dAltitude;
+  }
+
+  // The projection on the frame, as in LookAngleKernel: the axes of
+  // the azimuth are those of the point of the target, the observer's
+  // point added back.
+  GeoPoint const &p = m_frame.point;
+  GeoPoint const &n = m_frame.normal;
+  const double east = (d[0] + p.x())*m_frame.east.x() + (d[1] + p.y())*m_frame.east.y();
+  const double north = (d[0] + p.x())*m_frame.north.x() + (d[1] + p.y())*m_frame.north.y()
+    + (d[2] + p.z())*m_frame.north.z();
+  const double up = d[0]*n.x() + d[1]*n.y() + d[2]*n.z();
+  const double _range = qSqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+  const double horizontal = qSqrt(qMax(0.0, _range*_range - up*up));
+
+  const double degrees = 180.0 / M_PI;
+  if ((north*north + east*east) > 1.0e-6) {
+    double _azimuth = 90.0 - FastMath::atan2(north, east) * degrees;
+    if (_azimuth < 0.0)
+      _azimuth += 360.0;
+    if (_azimuth > 360.0)
+      _azimuth -= 360.0;
+    *azimuth = float(_azimuth);
+  }
+  *elevation = _range > 0.0 ? float(FastMath::atan2(up, horizontal) * degrees) : 90.0f;
+  *range = _range;
+}
+
+double LocalTangentPlane::error() const
+{
+  return m_error;
+}
+
+quint64 LocalTangentPlane::rebases() const
+{
+  return m_rebases;
+}
+
+void LocalTangentPlane::rebase(QGeoCoordinate const &target)
+{
+  m_latitude = target.latitude();
+  m_longitude = target.longitude();
+  m_altitude = target.altitude();
+  m_radius = BoundMargin * (EquatorialRadius + qAbs(m_altitude));
+
+  const GeoPoint point = LookAngle::point(target);
+  m_offset[0] = point.x() - m_frame.point.x();
+  m_offset[1] = point.y() - m_frame.point.y();
+  m_offset[2] = point.z() - m_frame.point.z();
+
+  // The columns of the Jacobian, by central differences
+  const double steps[3] = { AngleStep, AngleStep, AltitudeStep };
+  for (int j = 0; j < 3; ++j) {
+    QGeoCoordinate before(m_latitude, m_longitude, m_altitude);
+    QGeoCoordinate after(m_latitude, m_longitude, m_altitude);
+    switch (j) {
+    case 0:
+      before.setLatitude(m_latitude - steps[j]);
+      after.setLatitude(m_latitude + steps[j]);
+      break;
+    case 1:
+      before.setLongitude(m_longitude - steps[j]);
+      after.setLongitude(m_longitude + steps[j]);
+      break;
+    default:
+      before.setAltitude(m_altitude - steps[j]);
+      after.setAltitude(m_altitude + steps[j]);
+      break;
+    }
+    const GeoPoint a = LookAngle::point(before);
+    const GeoPoint b = LookAngle::point(after);
+    m_jacobian[0][j] = (b.x() - a.x()) / (2.0 * steps[j]);
+    m_jacobian[1][j] = (b.y() - a.y()) / (2.0 * steps[j]);
+    m_jacobian[2][j] = (b.z() - a.z()) / (2.0 * steps[j]);
+  }
+
+  m_hasReference = true;
+  ++m_rebases;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QGeoCoordinate>
+#include "GeoPoint.hpp"
+#include "LookAngle.hpp"
+
+// A LocalTangentPlane computes the look angles from an observer to a
+// target that moves a little at a time, such as a drone a few
+// kilometers away, without converting every position of the target
+// to Earth-centered coordinates.
+//
+// The target is converted in full once, at a reference position.
+// With it, the Jacobian of the conversion there is taken, so that
+// the vector from the observer to the next positions is
+//
+//   d = d0 + J (latitude - latitude0, longitude - longitude0, altitude - altitude0)
+//
+// which is then projected on the frame of the observer (see
+// LookAngleFrame) for the east, north and up offsets.  An update
+// costs a few multiply-adds and the square roots and arc tangents of
+// the angles.
+//
+// The error of the linearization is bounded by the second order
+// terms of the conversion:
+//
+//   error <= s (1.01 (a + |altitude0|) s / 2 + |altitude - altitude0|)
+//
+// in meters, where s = |latitude - latitude0| + |longitude -
+// longitude0| in radians and a is the equatorial radius, with 1% to
+// spare for the flattening and the terms of third order.  When the
+// bound exceeds the tolerance (1 cm by default), the plane is rebased
+// at the target, which is converted in full again; the bound is kept
+// with each look angle.  Moving the observer rebases the plane as
+// well.  A tolerance of 1 cm moves the reference every 350 m or so of
+// the target's track.
+//
+// The look angles agree with those of LookAngle, geometric
+// elevation, within the bound over the range of the target.
+
+class LocalTangentPlane
+{
+public:
+  LocalTangentPlane();
+
+  // The bound of the error of a target position in meters
+  double tolerance() const;
+  void setTolerance(double tolerance);
+
+  QGeoCoordinate observer() const;
+  void setObserver(QGeoCoordinate const &observer);
+
+  // The look angle from the observer to a target, with the geometric
+  // elevation, and its range in meters.  The azimuth is only written
+  // when the target is off the vertical of the observer.
+  void lookAngle(QGeoCoordinate const &target, float *azimuth, float *elevation, double *range);
+
+  // The bound of the error of the last target position in meters
+  double error() const;
+
+  // The times the plane has been rebased
+  quint64 rebases() const;
+
+private:
+  void rebase(QGeoCoordinate const &target);
+
+  double m_tolerance;
+  QGeoCoordinate m_observer;
+  LookAngleFrame m_frame;
+
+  // The reference, in degrees and meters, and the vector to it from
+  // the observer
+  bool m_hasReference;
+  double m_latitude, m_longitude, m_altitude;
+  double m_offset[3];
+  // The partial derivatives of the vector, by degree and by meter,
+  // row by row
+  double m_jacobian[3][3];
+  // The radius of the bound at the reference
+  double m_radius;
+
+  double m_error;
+  quint64 m_rebases;
+};
@@ -107,9 +107,10 @@ GeoPoint RotateGlobe(QGeoCoordinate const &b, QGeoCoordinate const &a)
 }
 
 static
-GeoPoint *NormalizeVectorDiff(GeoPoint const &b, GeoPoint const &a, GeoPoint *rval)
+GeoPoint *NormalizeVectorDiff(GeoPoint const &b, GeoPoint const &a, GeoPoint *rval, double *length)
 {
   // Calculate norm(b-a), where norm divides a vector by its length to produce a unit vector.
+  // Also return the length of b-a.
   // returns NULL upon error.
   const double dx = b.x() - a.x();
   const double dy = b.y() - a.y();
@@ -122,10 +123,119 @@ GeoPoint *NormalizeVectorDiff(GeoPoint const &b, GeoPoint const &a, GeoPoint *rv
   dist = qSqrt(dist2);
   if (rval)
     rval->set(dx/dist, dy/dist, dz/dist);
+  if (length)
+    *length = dist;
   return rval;
 }
 
+GeoPoint LookAngle::point(QGeoCoordinate const &coordinate)
+{
+  GeoPoint point;
+  ConvertLocationToPoint(coordinate, &point, 0, 0);
+  return point;
+}
+
+LookAngleFrame LookAngleFrame::at(QGeoCoordinate const &observer)
+{
+  LookAngleFrame frame;
+  ConvertLocationToPoint(observer, &frame.point, &frame.normal, 0);
+
+  // The rotation of RotateGlobe(), by the longitude about the z axis
+  // then by the geocentric latitude about the y axis, as the axes
+  // onto which it projects the target.
+  const double lon = observer.longitude() * M_PI / 180.0;
+  const double clat = GeocentricLatitude(observer.latitude() * M_PI / 180.0);
+  const double cosLon = qCos(lon);
+  const double sinLon = qSin(lon);
+  frame.east.set(-sinLon, cosLon, 0.0);
+  frame.north.set(-qSin(clat) * cosLon, -qSin(clat) * sinLon, qCos(clat));
+  return frame;
+}
+
+// The targets converted at once by LookAngleFrame::lookAngles()
+static const int LookAngleBlockSize = 256;
+
+void LookAngleFrame::lookAngles(int count, double const *latitude, double const *longitude, double const *altitude,
+                                float *azimuth, float *elevation, double *range,
+                                FastMath::Accuracy accuracy) const
+{
+  // As in EarthRadiusInMeters() and GeocentricLatitude()
+  const double a = 6378137.0;
+  const double b = 6356752.314245;
+  const double e2 = 0.00669437999014;
+  const double degrees = 180.0 / M_PI;
+
+  double lat[LookAngleBlockSize], lon[LookAngleBlockSize];
+  double sinLat[LookAngleBlockSize], cosLat[LookAngleBlockSize];
+  double sinLon[LookAngleBlockSize], cosLon[LookAngleBlockSize];
+  double east[LookAngleBlockSize], north[LookAngleBlockSize];
+  double up[LookAngleBlockSize], horizontal[LookAngleBlockSize];
+  double bearing[LookAngleBlockSize], angle[LookAngleBlockSize];
+
+  for (int begin = 0; begin < count; begin += LookAngleBlockSize) {
+    const int n = qMin(LookAngleBlockSize, count - begin);
+    for (int i = 0; i < n; ++i) {
+      lat[i] = latitude[begin + i] * (M_PI / 180.0);
+      lon[i] = longitude[begin + i] * (M_PI / 180.0);
+    }
+    FastMath::sinCos(n, lat, sinLat, cosLat, accuracy);
+    FastMath::sinCos(n, lon, sinLon, cosLon, accuracy);
+
+    // ConvertLocationToPoint() without its own trigonometry: the
+    // geocentric latitude has tangent (1 - e2) tan(lat), so its sine
+    // and cosine follow from those of the latitude.  Then the
+    // projection on the frame.
+    for (int i = 0; i < n; ++i) {
+      const double t1 = a * a * cosLat[i];
+      const double t2 = b * b * sinLat[i];
+      const double t3 = a * cosLat[i];
+      const double t4 = b * sinLat[i];
+      const double radius = qSqrt((t1*t1 + t2*t2) / (t3*t3 + t4*t4));
+      const double sy = (1.0 - e2) * sinLat[i];
+      const double sx = cosLat[i];
+      const double h = qSqrt(sx*sx + sy*sy);
+      const double cosC = sx / h;
+      const double sinC = sy / h;
+      const double alt = altitude[begin + i];
+      const double x = radius * cosLon[i] * cosC + alt * cosLat[i] * cosLon[i];
+      const double y = radius * sinLon[i] * cosC + alt * cosLat[i] * sinLon[i];
+      const double z = radius * sinC + alt * sinLat[i];
+
+      const double dx = x - point.x();
+      const double dy = y - point.y();
+      const double dz = z - point.z();
+      const double cx = dy*normal.z() - dz*normal.y();
+      const double cy = dz*normal.x() - dx*normal.z();
+      const double cz = dx*normal.y() - dy*normal.x();
+      range[begin + i] = qSqrt(dx*dx + dy*dy + dz*dz);
+      up[i] = dx*normal.x() + dy*normal.y() + dz*normal.z();
+      horizontal[i] = qSqrt(cx*cx + cy*cy + cz*cz);
+      east[i] = x*this->east.x() + y*this->east.y();
+      north[i] = x*this->north.x() + y*this->north.y() + z*this->north.z();
+    }
+    FastMath::atan2(n, north, east, bearing, accuracy);
+    FastMath::atan2(n, up, horizontal, angle, accuracy);
+
+    for (int i = 0; i < n; ++i) {
+      if ((north[i]*north[i] + east[i]*east[i]) > 1.0e-6) {
+        double _azimuth = 90.0 - bearing[i] * degrees;
+        if (_azimuth < 0.0)
+          _azimuth += 360.0;
+        if (_azimuth > 360.0)
+          _azimuth -= 360.0;
+        azimuth[begin + i] = float(_azimuth);
+      }
+      elevation[begin + i] = range[begin + i] > 0.0 ? float(angle[i] * degrees) : 90.0f;
+    }
+  }
+}
+
 void LookAngle::setLookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target)
+{
+  setLookAngle(observer, target, Refraction());
+}
+
+void LookAngle::setLookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target, Refraction const &refraction)
 {
   GeoPoint ap, bp, br, bma;
   GeoPoint ap_normal;
@@ -151,13 +261,17 @@ void LookAngle::setLookAngle(QGeoCoordinate const &observer, QGeoCoordinate cons
     setAzimuth(_azimuth);
   }
                 
-  if (NormalizeVectorDiff(bp, ap, &bma)) {
+  double range;
+  if (NormalizeVectorDiff(bp, ap, &bma, &range)) {
     // Calculate elevation, which is the angle above the horizon of B as seen from A.
     // Almost always, B will actually be below the horizon, so the altitude will be negative.
     // The dot product of bma and norm = cos(zenith_angle), and zenith_angle = (90 deg) - altitude.
     // So altitude = 90 - acos(dotprod).
-    setElevation(90.0 - (180.0 / M_PI)*
-                 qAcos(bma.x()*ap_normal.x() + bma.y()*ap_normal.y() + bma.z()*ap_normal.z()));
+    const float elevation = 90.0 - (180.0 / M_PI)*
+      qAcos(bma.x()*ap_normal.x() + bma.y()*ap_normal.y() + bma.z()*ap_normal.z());
+
+    // The atmosphere bends the line of sight so that B appears higher than it is.
+    setElevation(refraction.apparentElevation(elevation, range));
   }
 }
 
@@ -178,6 +292,11 @@ LookAngle::LookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &targe
   setLookAngle(observer, target);
 }
 
+LookAngle::LookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target, Refraction const &refraction)
+{
+  setLookAngle(observer, target, refraction);
+}
+
 LookAngle::LookAngle(LookAngle const &other) :
   m_azimuth(other.m_azimuth),
   m_elevation(other.m_elevation)
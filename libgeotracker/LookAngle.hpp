@@ -2,6 +2,9 @@
 
 #include <QtCore/QMetaType>
 #include <QGeoCoordinate>
+#include "Refraction.hpp"
+#include "GeoPoint.hpp"
+#include "FastMath.hpp"
 
 // The Look angle is the direction in which the observer must gaze in
 // order to see the target. The look angle is represented in the
@@ -28,6 +31,7 @@ public:
   LookAngle();
   LookAngle(float azimuth, float elevation);
   LookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target);
+  LookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target, Refraction const &refraction);
   LookAngle(LookAngle const &other);
   ~LookAngle();
 
@@ -46,6 +50,16 @@ public:
   // calculate the look angle of the target from the observer's
   // reference.
   void setLookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target);
+
+  // calculate the look angle of the target from the observer's
+  // reference, with the elevation corrected for atmospheric
+  // refraction.
+  void setLookAngle(QGeoCoordinate const &observer, QGeoCoordinate const &target, Refraction const &refraction);
+
+  // The point of a coordinate in the Earth-centered, Earth-fixed
+  // coordinates of the look angle calculation (see LookAngleFrame),
+  // which are not those of GeoPoint::set().
+  static GeoPoint point(QGeoCoordinate const &coordinate);
   
 private:
   friend bool qFuzzyCompare(LookAngle const &p1, LookAngle const &p2);
@@ -59,3 +73,39 @@ private:
 Q_DECLARE_METATYPE(LookAngle)
 
 bool qFuzzyCompare(LookAngle const &p1, LookAngle const &p2);
+
+// A LookAngleFrame holds what a look angle needs of the observer, in
+// the Earth-centered, Earth-fixed coordinates used by LookAngle: its
+// point, the normal to the ellipsoid there, and the east and north
+// axes of the globe rotated so that the observer is at latitude 0,
+// longitude 0.  A frame and the point of a target (LookAngle::point)
+// give the look angle with a few products, so the frame of an
+// observer, or the point of a target, may be computed once and used
+// for many look angles (see ObserverNetwork).
+//
+//   azimuth   = atan2(east . target, north . target)
+//   elevation = 90 - acos(normal . (target - point) / |target - point|)
+//
+// lookAngles() is the other batch: from one observer to many targets,
+// such as the entities of a feed.  The targets are converted to
+// points a block at a time, with the trigonometry of FastMath, and
+// the elevation is taken as atan2(up, horizontal) (see
+// LookAngleKernel).
+
+struct LookAngleFrame
+{
+  GeoPoint point;
+  GeoPoint normal;
+  GeoPoint east;
+  GeoPoint north;
+
+  static LookAngleFrame at(QGeoCoordinate const &observer);
+
+  // The look angles to count targets, given by their latitudes and
+  // longitudes in degrees and altitudes in meters, with the
+  // geometric elevation and the range in meters.  An azimuth is only
+  // written when the target is off the vertical of the observer.
+  void lookAngles(int count, double const *latitude, double const *longitude, double const *altitude,
+                  float *azimuth, float *elevation, double *range,
+                  FastMath::Accuracy accuracy = FastMath::Precise) const;
+};
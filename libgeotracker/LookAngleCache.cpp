@@ -0,0 +1,156 @@
+#include <QHash>
+#include <QtMath>
+#include "LookAngleCache.hpp"
+#include "LookAngle.hpp"
+
+// The entries probed for a target from its own
+static const int ProbeCount = 4;
+
+// Whether two values of a key are the same, the missing altitudes of
+// two 2D coordinates included
+static
+bool SameValue(double a, double b)
+{
+  return a == b || (qIsNaN(a) && qIsNaN(b));
+}
+
+static
+uint Hash(QGeoCoordinate const &target)
+{
+  uint hash = qHash(target.latitude());
+  hash = hash * 31 + qHash(target.longitude());
+  hash = hash * 31 + qHash(qIsNaN(target.altitude()) ? 0.0 : target.altitude());
+  // Spread the bits over those of the index
+  return hash ^ (hash >> 16);
+}
+
+LookAngleCache::LookAngleCache(int capacity) :
+  m_tolerance(0.01),
+  m_point(0.0, 0.0, 0.0),
+  m_generation(1),
+  m_hits(0),
+  m_misses(0)
+{
+  // The capacity is a power of two, at least that of the probes
+  int size = ProbeCount;
+  while (size < capacity)
+    size *= 2;
+  m_entries.resize(size);
+  m_mask = size - 1;
+  clear();
+}
+
+int LookAngleCache::capacity() const
+{
+  return m_entries.size();
+}
+
+double LookAngleCache::tolerance() const
+{
+  return m_tolerance;
+}
+
+void LookAngleCache::setTolerance(double tolerance)
+{
+  m_tolerance = tolerance;
+}
+
+QGeoCoordinate LookAngleCache::observer() const
+{
+  return m_observer;
+}
+
+void LookAngleCache::setObserver(QGeoCoordinate const &observer)
+{
+  if (observer == m_observer)
+    return;
+  const GeoPoint point = LookAngle::point(observer);
+  if (m_observer.isValid() && point.distanceTo(m_point) <= m_tolerance)
+    return;
+
+  // All the entries are stale
+  m_observer = observer;
+  m_point = point;
+  if (++m_generation == 0) {
+    clear();
+    m_generation = 1;
+  }
+}
+
+void LookAngleCache::lookAngle(QGeoCoordinate const &target, float *azimuth, float *elevation, double *range)
+{
+  int index = find(target);
+  if (index >= 0 && m_entries.at(index).generation == m_generation) {
+    Entry const &entry = m_entries.at(index);
+    *azimuth = entry.azimuth;
+    *elevation = entry.elevation;
+    *range = entry.range;
+    ++m_hits;
+    return;
+  }
+  ++m_misses;
+
+  if (index < 0) {
+    // A free or stale entry among the probes, or else the first
+    const uint hash = Hash(target);
+    index = int(hash & uint(m_mask));
+    for (int i = 0; i < ProbeCount; ++i) {
+      const int probe = int((hash + uint(i)) & uint(m_mask));
+      if (m_entries.at(probe).generation != m_generation) {
+        index = probe;
+        break;
+      }
+    }
+  }
+
+  Entry &entry = m_entries[index];
+  LookAngle geometric;
+  geometric.setLookAngle(m_observer, target);
+  entry.latitude = target.latitude();
+  entry.longitude = target.longitude();
+  entry.altitude = target.altitude();
+  entry.azimuth = geometric.azimuth();
+  entry.elevation = geometric.elevation();
+  entry.range = m_point.distanceTo(LookAngle::point(target));
+  entry.generation = m_generation;
+  *azimuth = entry.azimuth;
+  *elevation = entry.elevation;
+  *range = entry.range;
+}
+
+bool LookAngleCache::contains(QGeoCoordinate const &target) const
+{
+  const int index = find(target);
+  return index >= 0 && m_entries.at(index).generation == m_generation;
+}
+
+void LookAngleCache::clear()
+{
+  for (Entry &entry : m_entries)
+    entry.generation = 0;
+}
+
+quint64 LookAngleCache::hits() const
+{
+  return m_hits;
+}
+
+quint64 LookAngleCache::misses() const
+{
+  return m_misses;
+}
+
+int LookAngleCache::find(QGeoCoordinate const &target) const
+{
+  const uint hash = Hash(target);
+  for (int i = 0; i < ProbeCount; ++i) {
+    const int probe = int((hash + uint(i)) & uint(m_mask));
+    Entry const &entry = m_entries.at(probe);
+    if (entry.generation != 0
+        && SameValue(entry.latitude, target.latitude())
+        && SameValue(entry.longitude, target.longitude())
+        && SameValue(entry.altitude, target.altitude()))
+      return probe;
+  }
+  return -1;
+}
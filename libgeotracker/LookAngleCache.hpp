@@ -0,0 +1,78 @@
+#pragma once
+
+#include <QVector>
+#include <QGeoCoordinate>
+#include "GeoPoint.hpp"
+
+// A LookAngleCache keeps the look angles from an observer to the
+// targets it has been pointed at, so that pointing again at a known
+// point, such as a surveyed target of a fixed installation, is a
+// lookup rather than a LookAngle.
+//
+// The cache is a small hash table of a fixed size (a power of two),
+// keyed by the target coordinate, with linear probing over a few
+// entries.  When the probes are all taken by other targets, a stale
+// entry, or else the first, is replaced.  The look angles are
+// geometric, with their range, so that any refraction may be applied
+// to them; they are those of LookAngle, bit for bit.
+//
+// The entries are computed for the observer position of the cache.
+// Moving the observer by less than the tolerance (1 cm by default)
+// keeps them; moving it further makes them all stale at once, and each
+// is computed again from the new position when it is next looked up.
+// The targets stay in the table.  The error of a kept look angle is
+// at most the tolerance over the range of the target, in radians.
+
+class LookAngleCache
+{
+public:
+  LookAngleCache(int capacity = 64);
+
+  int capacity() const;
+
+  // The distance in meters the observer may move by and keep the
+  // look angles
+  double tolerance() const;
+  void setTolerance(double tolerance);
+
+  // The observer position the look angles are computed for
+  QGeoCoordinate observer() const;
+  void setObserver(QGeoCoordinate const &observer);
+
+  // The look angle from the observer to a target, computed and kept
+  // on a miss.  The azimuth of a target on the vertical of the
+  // observer, and the elevation of one at the observer, are 0.
+  void lookAngle(QGeoCoordinate const &target, float *azimuth, float *elevation, double *range);
+
+  // Whether the look angle to a target is kept, and current
+  bool contains(QGeoCoordinate const &target) const;
+
+  // Drop the look angles
+  void clear();
+
+  quint64 hits() const;
+  quint64 misses() const;
+
+private:
+  struct Entry
+  {
+    double latitude;
+    double longitude;
+    double altitude;
+    float azimuth;
+    float elevation;
+    double range;
+    quint32 generation;     // of the observer position, 0 when free
+  };
+
+  int find(QGeoCoordinate const &target) const;
+
+  QVector<Entry> m_entries;
+  int m_mask;
+  double m_tolerance;
+  QGeoCoordinate m_observer;
+  GeoPoint m_point;           // of the observer
+  quint32 m_generation;
+  quint64 m_hits;
+  quint64 m_misses;
+};
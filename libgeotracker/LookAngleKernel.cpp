@@ -0,0 +1,245 @@
+#include <cmath>
+#include <QtMath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "LookAngleKernel.hpp"
+
+// The arrays of a kernel, for the projection
+template <class Real>
+struct KernelArrays
+{
+  Real const *pointX, *pointY, *pointZ;
+  Real const *normalX, *normalY, *normalZ;
+  Real const *eastX, *eastY;
+  Real const *northX, *northY, *northZ;
+  Real const *eastBias, *northBias;
+  Real *east, *north, *up, *horizontal, *range;
+};
+
+// Project the target (x, y, z), relative to the origin, on the frames
+// of observers [begin, end): along the east and north axes, along
+// the normal (up) and across it (horizontal), and its range.  No
+// branches, no calls.
+template <class Real>
+static
+void ProjectScalar(KernelArrays<Real> const &a, Real x, Real y, Real z, int begin, int end)
+{
+  for (int i = begin; i < end; ++i) {
+    const Real dx = x - a.pointX[i];
+    const Real dy = y - a.pointY[i];
+    const Real dz = z - a.pointZ[i];
+    const Real nx = a.normalX[i];
+    const Real ny = a.normalY[i];
+    const Real nz = a.normalZ[i];
+    const Real cx = dy*nz - dz*ny;
+    const Real cy = dz*nx - dx*nz;
+    const Real cz = dx*ny - dy*nx;
+    a.range[i] = std::sqrt(dx*dx + dy*dy + dz*dz);
+    a.up[i] = dx*nx + dy*ny + dz*nz;
+    a.horizontal[i] = std::sqrt(cx*cx + cy*cy + cz*cz);
+    a.east[i] = dx*a.eastX[i] + dy*a.eastY[i] + a.eastBias[i];
+    a.north[i] = dx*a.northX[i] + dy*a.northY[i] + dz*a.northZ[i] + a.northBias[i];
+  }
+}
+
+#ifdef __SSE2__
+// The SSE2 registers of a Real, and their operations
+template <class Real> struct Sse2;
+
+template <>
+struct Sse2<double>
+{
+  typedef __m128d Vector;
+  enum { Width = 2 };
+  static Vector set(double x) { return _mm_set1_pd(x); }
+  static Vector load(double const *p) { return _mm_loadu_pd(p); }
+  static void store(double *p, Vector v) { _mm_storeu_pd(p, v); }
+  static Vector add(Vector a, Vector b) { return _mm_add_pd(a, b); }
+  static Vector sub(Vector a, Vector b) { return _mm_sub_pd(a, b); }
+  static Vector mul(Vector a, Vector b) { return _mm_mul_pd(a, b); }
+  static Vector sqrt(Vector a) { return _mm_sqrt_pd(a); }
+};
+
+template <>
+struct Sse2<float>
+{
+  typedef __m128 Vector;
+  enum { Width = 4 };
+  static Vector set(float x) { return _mm_set1_ps(x); }
+  static Vector load(float const *p) { return _mm_loadu_ps(p); }
+  static void store(float *p, Vector v) { _mm_storeu_ps(p, v); }
+  static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+  static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+  static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+  static Vector sqrt(Vector a) { return _mm_sqrt_ps(a); }
+};
+
+// The same, a register of observers at a time.  Returns the number
+// of observers projected.
+template <class Real>
+static
+int ProjectSse2(KernelArrays<Real> const &a, Real x, Real y, Real z, int count)
+{
+  typedef Sse2<Real> S;
+  typedef typename S::Vector V;
+  const V tx = S::set(x);
+  const V ty = S::set(y);
+  const V tz = S::set(z);
+  int i = 0;
+  for (; i + S::Width <= count; i += S::Width) {
+    const V dx = S::sub(tx, S::load(a.pointX + i));
+    const V dy = S::sub(ty, S::load(a.pointY + i));
+    const V dz = S::sub(tz, S::load(a.pointZ + i));
+    const V nx = S::load(a.normalX + i);
+    const V ny = S::load(a.normalY + i);
+    const V nz = S::load(a.normalZ + i);
+    const V cx = S::sub(S::mul(dy, nz), S::mul(dz, ny));
+    const V cy = S::sub(S::mul(dz, nx), S::mul(dx, nz));
+    const V cz = S::sub(S::mul(dx, ny), S::mul(dy, nx));
+    S::store(a.range + i, S::sqrt(S::add(S::add(S::mul(dx, dx), S::mul(dy, dy)), S::mul(dz, dz))));
+    S::store(a.up + i, S::add(S::add(S::mul(dx, nx), S::mul(dy, ny)), S::mul(dz, nz)));
+    S::store(a.horizontal + i, S::sqrt(S::add(S::add(S::mul(cx, cx), S::mul(cy, cy)), S::mul(cz, cz))));
+    S::store(a.east + i, S::add(S::add(S::mul(dx, S::load(a.eastX + i)),
+                                       S::mul(dy, S::load(a.eastY + i))),
+                                S::load(a.eastBias + i)));
+    S::store(a.north + i, S::add(S::add(S::add(S::mul(dx, S::load(a.northX + i)),
+                                               S::mul(dy, S::load(a.northY + i))),
+                                        S::mul(dz, S::load(a.northZ + i))),
+                                 S::load(a.northBias + i)));
+  }
+  return i;
+}
+#endif
+
+template <class Real>
+LookAngleKernel<Real>::LookAngleKernel() :
+  m_origin(0.0, 0.0, 0.0),
+  m_accuracy(sizeof(Real) == sizeof(float) ? FastMath::Approximate : FastMath::Precise)
+{
+}
+
+template <class Real>
+int LookAngleKernel<Real>::count() const
+{
+  return m_pointX.size();
+}
+
+template <class Real>
+void LookAngleKernel<Real>::resize(int count)
+{
+  for (QVector<Real> *component : { &m_pointX, &m_pointY, &m_pointZ,
+                                    &m_normalX, &m_normalY, &m_normalZ,
+                                    &m_eastX, &m_eastY,
+                                    &m_northX, &m_northY, &m_northZ,
+                                    &m_eastBias, &m_northBias,
+                                    &m_east, &m_north, &m_up, &m_horizontal, &m_range, &m_bearing })
+    component->resize(count);
+}
+
+template <class Real>
+FastMath::Accuracy LookAngleKernel<Real>::accuracy() const
+{
+  return m_accuracy;
+}
+
+template <class Real>
+void LookAngleKernel<Real>::setAccuracy(FastMath::Accuracy accuracy)
+{
+  m_accuracy = accuracy;
+}
+
+template <class Real>
+GeoPoint LookAngleKernel<Real>::origin() const
+{
+  return m_origin;
+}
+
+template <class Real>
+void LookAngleKernel<Real>::setOrigin(GeoPoint const &origin)
+{
+  m_origin = origin;
+  resize(0);
+}
+
+template <class Real>
+void LookAngleKernel<Real>::setFrame(int observer, LookAngleFrame const &frame)
+{
+  GeoPoint const &p = frame.point;
+  m_pointX[observer] = Real(p.x() - m_origin.x());
+  m_pointY[observer] = Real(p.y() - m_origin.y());
+  m_pointZ[observer] = Real(p.z() - m_origin.z());
+  m_normalX[observer] = Real(frame.normal.x());
+  m_normalY[observer] = Real(frame.normal.y());
+  m_normalZ[observer] = Real(frame.normal.z());
+  m_eastX[observer] = Real(frame.east.x());
+  m_eastY[observer] = Real(frame.east.y());
+  m_northX[observer] = Real(frame.north.x());
+  m_northY[observer] = Real(frame.north.y());
+  m_northZ[observer] = Real(frame.north.z());
+  // The target is projected relative to the point, so the projection
+  // of the point itself (nearly zero) is added back.
+  m_eastBias[observer] = Real(p.x()*frame.east.x() + p.y()*frame.east.y());
+  m_northBias[observer] = Real(p.x()*frame.north.x() + p.y()*frame.north.y() + p.z()*frame.north.z());
+}
+
+template <class Real>
+void LookAngleKernel<Real>::copyFrame(int from, int to)
+{
+  for (QVector<Real> *component : { &m_pointX, &m_pointY, &m_pointZ,
+                                    &m_normalX, &m_normalY, &m_normalZ,
+                                    &m_eastX, &m_eastY,
+                                    &m_northX, &m_northY, &m_northZ,
+                                    &m_eastBias, &m_northBias })
+    (*component)[to] = component->at(from);
+}
+
+template <class Real>
+void LookAngleKernel<Real>::calculate(GeoPoint const &target, float *azimuth, float *elevation, double *range)
+{
+  const int count = m_pointX.size();
+  KernelArrays<Real> a = {
+    m_pointX.constData(), m_pointY.constData(), m_pointZ.constData(),
+    m_normalX.constData(), m_normalY.constData(), m_normalZ.constData(),
+    m_eastX.constData(), m_eastY.constData(),
+    m_northX.constData(), m_northY.constData(), m_northZ.constData(),
+    m_eastBias.constData(), m_northBias.constData(),
+    m_east.data(), m_north.data(), m_up.data(), m_horizontal.data(), m_range.data()
+  };
+
+  // The target, moved to the origin in double
+  const Real x = Real(target.x() - m_origin.x());
+  const Real y = Real(target.y() - m_origin.y());
+  const Real z = Real(target.z() - m_origin.z());
+  int projected = 0;
+#ifdef __SSE2__
+  projected = ProjectSse2(a, x, y, z, count);
+#endif
+  ProjectScalar(a, x, y, z, projected, count);
+
+  // The angles, the elevation in place of up
+  FastMath::atan2(count, a.north, a.east, m_bearing.data(), m_accuracy);
+  FastMath::atan2(count, a.up, a.horizontal, a.up, m_accuracy);
+
+  const Real degrees = Real(180.0 / M_PI);
+  for (int i = 0; i < count; ++i) {
+    const Real east = a.east[i];
+    const Real north = a.north[i];
+    if ((north*north + east*east) > Real(1.0e-6)) {
+      Real _azimuth = Real(90.0) - m_bearing[i] * degrees;
+      if (_azimuth < Real(0.0))
+        _azimuth += Real(360.0);
+      if (_azimuth > Real(360.0))
+        _azimuth -= Real(360.0);
+      azimuth[i] = float(_azimuth);
+    }
+    if (a.range[i] > Real(0.0))
+      elevation[i] = float(a.up[i] * degrees);
+    else
+      elevation[i] = 90.0f;
+    range[i] = double(a.range[i]);
+  }
+}
+
+template class LookAngleKernel<float>;
+template class LookAngleKernel<double>;
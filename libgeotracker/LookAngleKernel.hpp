@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QVector>
+#include "GeoPoint.hpp"
+#include "LookAngle.hpp"
+#include "FastMath.hpp"
+
+// A LookAngleKernel computes the look angles from many observers to
+// one target, with the arithmetic done in Real, which is float or
+// double.  It is the kernel of ObserverNetwork.
+//
+// The frames of the observers (see LookAngleFrame) are kept as a
+// structure of arrays, relative to an origin near the observers, so
+// that the coordinates are small enough for a float.  The target is
+// moved to the origin in double, and from there on the kernel works
+// in Real: the projection of the target on the frames is done a SIMD
+// register at a time (two doubles or four floats with SSE2), then
+// the angles are taken over the whole batch by FastMath, at the
+// accuracy of the kernel: Precise by default for double, Approximate
+// for float, whose own rounding is larger than either.
+//
+// The elevation is taken as atan2(up, horizontal) rather than as
+// LookAngle's 90 - acos(up / range), which loses half the digits of
+// Real near the zenith.  Against LookAngle, over a global grid of
+// observers and targets from 1 km to geostationary range (see
+// test_LookAngleKernel):
+//
+// - double: within 1e-5 degree in azimuth and elevation, which is the
+//   rounding of the float results.
+//
+// - float: within 1e-3 degree in azimuth and elevation for
+//   observers within 100 km of the origin and targets beyond 1 km,
+//   and within 1e-2 degree for observers within 1000 km.  The error
+//   grows with the distance of the observer from the origin over the
+//   range of the target.  A float is enough for a display, and takes
+//   half the memory and twice the observers per instruction.
+
+template <class Real>
+class LookAngleKernel
+{
+public:
+  LookAngleKernel();
+
+  int count() const;
+  void resize(int count);
+
+  // The point the frames are relative to.  Setting it drops the
+  // frames.
+  GeoPoint origin() const;
+  void setOrigin(GeoPoint const &origin);
+
+  // The accuracy of the trigonometry
+  FastMath::Accuracy accuracy() const;
+  void setAccuracy(FastMath::Accuracy accuracy);
+
+  void setFrame(int observer, LookAngleFrame const &frame);
+  void copyFrame(int from, int to);
+
+  // The look angles from every observer to the point of a target
+  // (see LookAngle::point), with the geometric elevation.  An azimuth
+  // is only written when the target is off the vertical of the
+  // observer, and the elevation of a target at the observer is 90.
+  void calculate(GeoPoint const &target, float *azimuth, float *elevation, double *range);
+
+private:
+  GeoPoint m_origin;
+  FastMath::Accuracy m_accuracy;
+
+  // The frames, by component
+  QVector<Real> m_pointX, m_pointY, m_pointZ;       // relative to the origin
+  QVector<Real> m_normalX, m_normalY, m_normalZ;
+  QVector<Real> m_eastX, m_eastY;                   // east has no z
+  QVector<Real> m_northX, m_northY, m_northZ;
+  QVector<Real> m_eastBias, m_northBias;            // of the point itself
+
+  // The projections of the target
+  QVector<Real> m_east, m_north, m_up, m_horizontal, m_range;
+  QVector<Real> m_bearing;                          // atan2(north, east)
+};
+
+extern template class LookAngleKernel<float>;
+extern template class LookAngleKernel<double>;
@@ -0,0 +1,233 @@
+#include <QHash>
+#include <QtAlgorithms>
+#include <cstring>
+#include <algorithm>
+#include "Metrics.hpp"
+
+// The shard of the thread, given round robin
+static QAtomicInteger<int> nextShard;
+static thread_local int threadShard = -1;
+
+// The histograms of the thread, by the id of their MetricHistogram
+static QAtomicInteger<int> nextHistogram;
+static thread_local QVector<LatencyHistogram *> threadHistograms;
+
+MetricCounter::MetricCounter()
+{
+  for (Shard &shard : m_shards)
+    shard.value.storeRelaxed(0);
+}
+
+void MetricCounter::add(quint64 n)
+{
+  if (threadShard < 0)
+    threadShard = nextShard.fetchAndAddRelaxed(1) % ShardCount;
+  m_shards[threadShard].value.fetchAndAddRelaxed(n);
+}
+
+quint64 MetricCounter::value() const
+{
+  quint64 sum = 0;
+  for (Shard const &shard : m_shards)
+    sum += shard.value.loadRelaxed();
+  return sum;
+}
+
+// The gauge keeps the bits of a double in an atomic integer.
+
+static
+quint64 BitsOf(double value)
+{
+  quint64 bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static
+double ValueOf(quint64 bits)
+{
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+MetricGauge::MetricGauge() :
+  m_bits(BitsOf(0.0))
+{
+}
+
+void MetricGauge::set(double value)
+{
+  m_bits.storeRelaxed(BitsOf(value));
+}
+
+void MetricGauge::add(double delta)
+{
+  quint64 bits = m_bits.loadRelaxed();
+  while (!m_bits.testAndSetRelaxed(bits, BitsOf(ValueOf(bits) + delta), bits))
+    ;
+}
+
+double MetricGauge::value() const
+{
+  return ValueOf(m_bits.loadRelaxed());
+}
+
+MetricHistogram::MetricHistogram() :
+  m_id(nextHistogram.fetchAndAddRelaxed(1))
+{
+}
+
+MetricHistogram::~MetricHistogram()
+{
+  qDeleteAll(m_threads);
+}
+
+void MetricHistogram::record(qint64 nsecs)
+{
+  if (threadHistograms.size() <= m_id)
+    threadHistograms.resize(m_id + 1);
+  LatencyHistogram *histogram = threadHistograms.at(m_id);
+  if (!histogram) {
+    // The first record of this thread
+    histogram = new LatencyHistogram;
+    threadHistograms[m_id] = histogram;
+    QMutexLocker locker(&m_mutex);
+    m_threads.append(histogram);
+  }
+  histogram->record(nsecs);
+}
+
+LatencyHistogram MetricHistogram::histogram() const
+{
+  LatencyHistogram sum;
+  QMutexLocker locker(&m_mutex);
+  for (LatencyHistogram const *histogram : m_threads)
+    sum.add(*histogram);
+  return sum;
+}
+
+Metrics::Metrics()
+{
+}
+
+Metrics::~Metrics()
+{
+  for (Metric const &metric : m_metrics) {
+    switch (metric.type) {
+    case Counter:   delete static_cast<MetricCounter *>(metric.metric); break;
+    case Gauge:     delete static_cast<MetricGauge *>(metric.metric); break;
+    case Histogram: delete static_cast<MetricHistogram *>(metric.metric); break;
+    }
+  }
+}
+
+Metrics &Metrics::global()
+{
+  static Metrics metrics;
+  return metrics;
+}
+
+void *Metrics::find(QString const &name, QString const &labels, Type type) const
+{
+  for (Metric const &metric : m_metrics) {
+    if (metric.name == name && metric.labels == labels)
+      return metric.type == type ? metric.metric : nullptr;
+  }
+  return nullptr;
+}
+
+MetricCounter *Metrics::counter(QString const &name, QString const &help, QString const &labels)
+{
+  QMutexLocker locker(&m_mutex);
+  if (void *existing = find(name, labels, Counter))
+    return static_cast<MetricCounter *>(existing);
+  MetricCounter *counter = new MetricCounter;
+  m_metrics.append(Metric { name, help, labels, Counter, counter });
+  return counter;
+}
+
+MetricGauge *Metrics::gauge(QString const &name, QString const &help, QString const &labels)
+{
+  QMutexLocker locker(&m_mutex);
+  if (void *existing = find(name, labels, Gauge))
+    return static_cast<MetricGauge *>(existing);
+  MetricGauge *gauge = new MetricGauge;
+  m_metrics.append(Metric { name, help, labels, Gauge, gauge });
+  return gauge;
+}
+
+MetricHistogram *Metrics::histogram(QString const &name, QString const &help, QString const &labels)
+{
+  QMutexLocker locker(&m_mutex);
+  if (void *existing = find(name, labels, Histogram))
+    return static_cast<MetricHistogram *>(existing);
+  MetricHistogram *histogram = new MetricHistogram;
+  m_metrics.append(Metric { name, help, labels, Histogram, histogram });
+  return histogram;
+}
+
+static
+QByteArray Labels(QString const &labels, char const *extra = nullptr)
+{
+  if (labels.isEmpty() && !extra)
+    return QByteArray();
+  QByteArray result = "{" + labels.toUtf8();
+  if (extra) {
+    if (!labels.isEmpty())
+      result += ',';
+    result += extra;
+  }
+  return result + "}";
+}
+
+QByteArray Metrics::exposition() const
+{
+  QMutexLocker locker(&m_mutex);
+
+  // The metrics of the same name together, in the order of their
+  // first appearance
+  QHash<QString, int> first;
+  for (int i = 0; i < m_metrics.size(); ++i) {
+    if (!first.contains(m_metrics.at(i).name))
+      first.insert(m_metrics.at(i).name, i);
+  }
+  QVector<Metric> metrics = m_metrics;
+  std::stable_sort(metrics.begin(), metrics.end(), [&first](Metric const &a, Metric const &b) {
+      return first.value(a.name) < first.value(b.name);
+    });
+
+  static char const *typeNames[] = { "counter", "gauge", "summary" };
+  QByteArray text;
+  for (int i = 0; i < metrics.size(); ++i) {
+    Metric const &metric = metrics.at(i);
+    const QByteArray name = metric.name.toUtf8();
+    if (i == 0 || metrics.at(i - 1).name != metric.name) {
+      text += "# HELP " + name + ' ' + metric.help.toUtf8() + '\n';
+      text += "# TYPE " + name + ' ' + typeNames[metric.type] + '\n';
+    }
+    switch (metric.type) {
+    case Counter:
+      text += name + Labels(metric.labels) + ' '
+        + QByteArray::number(static_cast<MetricCounter const *>(metric.metric)->value()) + '\n';
+      break;
+    case Gauge:
+      text += name + Labels(metric.labels) + ' '
+        + QByteArray::number(static_cast<MetricGauge const *>(metric.metric)->value(), 'g', 15) + '\n';
+      break;
+    case Histogram: {
+      const LatencyHistogram h = static_cast<MetricHistogram const *>(metric.metric)->histogram();
+      static char const *quantiles[] = { "quantile=\"0.5\"", "quantile=\"0.99\"", "quantile=\"0.999\"" };
+      static const double fractions[] = { 0.5, 0.99, 0.999 };
+      for (int q = 0; q < 3; ++q) {
+        text += name + Labels(metric.labels, quantiles[q]) + ' '
+          + QByteArray::number(h.percentile(fractions[q]) * 1e-9, 'g', 6) + '\n';
+      }
+      text += name + "_sum" + Labels(metric.labels) + ' ' + QByteArray::number(h.sum() * 1e-9, 'g', 15) + '\n';
+      text += name + "_count" + Labels(metric.labels) + ' ' + QByteArray::number(h.count()) + '\n';
+      break;
+    }
+    }
+  }
+  return text;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInteger>
+#include "LatencyTrace.hpp"
+
+// A MetricCounter counts events from any number of threads.  The
+// count is split in shards on cache lines of their own, and each
+// thread adds to the shard it was given on its first count, so that
+// threads counting at once do not contend for a cache line.  The
+// value is the sum of the shards.
+
+class MetricCounter
+{
+public:
+  MetricCounter();
+
+  void increment() { add(1); }
+  void add(quint64 n);
+  quint64 value() const;
+
+  enum { ShardCount = 16 };
+
+private:
+  Q_DISABLE_COPY(MetricCounter)
+
+  struct Shard
+  {
+    QAtomicInteger<quint64> value;
+    char padding[64 - sizeof(QAtomicInteger<quint64>)];
+  };
+  Shard m_shards[ShardCount];
+};
+
+// A MetricGauge is a value that goes up and down, such as the depth
+// of a queue.
+
+class MetricGauge
+{
+public:
+  MetricGauge();
+
+  void set(double value);
+  void add(double delta);
+  double value() const;
+
+private:
+  Q_DISABLE_COPY(MetricGauge)
+  QAtomicInteger<quint64> m_bits;
+};
+
+// A MetricHistogram counts durations, in nanoseconds, from any number
+// of threads: each thread records into a LatencyHistogram of its own,
+// made on its first record, and the histograms are added up when the
+// metric is read.
+
+class MetricHistogram
+{
+public:
+  MetricHistogram();
+  ~MetricHistogram();
+
+  void record(qint64 nsecs);
+  LatencyHistogram histogram() const;
+
+private:
+  Q_DISABLE_COPY(MetricHistogram)
+
+  int m_id;                               // unique, never reused
+  mutable QMutex m_mutex;
+  QVector<LatencyHistogram *> m_threads;
+};
+
+// Metrics is a set of named metrics, exported in the text exposition
+// format of Prometheus (version 0.0.4).  Histograms are exported as
+// summaries, in seconds, with the 0.5, 0.99 and 0.999 quantiles.
+//
+// A metric is known by its name and its labels, given as they are
+// written between the braces (source="target"); asking for it again
+// returns the same one.  The metrics are owned by the set and live as
+// long as it does, so the pointers to them may be kept: the usual way
+// is a function local static pointer to a metric of global().
+//
+// Updating a metric takes no lock.  Making one, and exporting, take
+// the lock of the set, but no lock that an update takes, so that
+// reading the metrics never holds up the threads that update them.
+
+class Metrics
+{
+public:
+  Metrics();
+  ~Metrics();
+
+  MetricCounter *counter(QString const &name, QString const &help, QString const &labels = QString());
+  MetricGauge *gauge(QString const &name, QString const &help, QString const &labels = QString());
+  MetricHistogram *histogram(QString const &name, QString const &help, QString const &labels = QString());
+
+  // The text exposition of every metric
+  QByteArray exposition() const;
+
+  // The metrics of the process
+  static Metrics &global();
+
+private:
+  Q_DISABLE_COPY(Metrics)
+
+  enum Type { Counter, Gauge, Histogram };
+
+  struct Metric
+  {
+    QString name;
+    QString help;
+    QString labels;
+    Type type;
+    void *metric;
+  };
+
+  void *find(QString const &name, QString const &labels, Type type) const;
+
+  mutable QMutex m_mutex;
+  QVector<Metric> m_metrics;
+};
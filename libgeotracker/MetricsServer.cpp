@@ -0,0 +1,146 @@
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "MetricsServer.hpp"
+
+// The longest request read, which is plenty for the headers sent by
+// a scraper
+static const int MaximumRequestSize = 8192;
+
+MetricsServer::MetricsServer(Metrics *metrics, QObject *parent) :
+  QObject(parent),
+  m_metrics(metrics),
+  thread(new QThread(this)),
+  m_tcpServer(nullptr),
+  m_localServer(nullptr),
+  m_requests(0)
+{
+  thread->setObjectName(QStringLiteral("Metrics"));
+  thread->start();
+}
+
+MetricsServer::~MetricsServer()
+{
+  close();
+  thread->quit();
+  thread->wait();
+}
+
+bool MetricsServer::listen(QString const &address)
+{
+  close();
+
+  // The servers are made, listen and are deleted in the thread, where
+  // their sockets live.
+  bool isListening = false;
+  if (address.startsWith("unix:")) {
+    const QString path = address.mid(5);
+    // The socket file of a previous run is in the way.
+    QLocalServer::removeServer(path);
+    m_localServer = new QLocalServer;
+    m_localServer->moveToThread(thread);
+    QMetaObject::invokeMethod(m_localServer, [&]() {
+        isListening = m_localServer->listen(path);
+        if (!isListening) {
+          m_errorString = m_localServer->errorString();
+          return;
+        }
+        QLocalServer *server = m_localServer;
+        connect(server, &QLocalServer::newConnection, server, [this, server]() {
+            while (QLocalSocket *socket = server->nextPendingConnection())
+              serve(socket);
+          });
+      }, Qt::BlockingQueuedConnection);
+    if (isListening)
+      m_address = "unix:" + path;
+  } else {
+    const QString port = address.startsWith("localhost:") ? address.mid(10) : address;
+    bool isNumber;
+    const quint16 number = port.toUShort(&isNumber);
+    if (!isNumber) {
+      m_errorString = "Not a port: " + port;
+      return false;
+    }
+    quint16 actualPort = 0;
+    m_tcpServer = new QTcpServer;
+    m_tcpServer->moveToThread(thread);
+    QMetaObject::invokeMethod(m_tcpServer, [&]() {
+        isListening = m_tcpServer->listen(QHostAddress::LocalHost, number);
+        actualPort = m_tcpServer->serverPort();
+        if (!isListening) {
+          m_errorString = m_tcpServer->errorString();
+          return;
+        }
+        QTcpServer *server = m_tcpServer;
+        connect(server, &QTcpServer::newConnection, server, [this, server]() {
+            while (QTcpSocket *socket = server->nextPendingConnection())
+              serve(socket);
+          });
+      }, Qt::BlockingQueuedConnection);
+    if (isListening)
+      m_address = "localhost:" + QString::number(actualPort);
+  }
+  if (!isListening)
+    close();
+  return isListening;
+}
+
+void MetricsServer::close()
+{
+  QObject *server = m_tcpServer ? static_cast<QObject *>(m_tcpServer) : m_localServer;
+  if (server)
+    QMetaObject::invokeMethod(server, [server]() { delete server; }, Qt::BlockingQueuedConnection);
+  m_tcpServer = nullptr;
+  m_localServer = nullptr;
+  m_address.clear();
+}
+
+QString MetricsServer::address() const
+{
+  return m_address;
+}
+
+QString MetricsServer::errorString() const
+{
+  return m_errorString;
+}
+
+quint64 MetricsServer::requests() const
+{
+  return m_requests.loadRelaxed();
+}
+
+void MetricsServer::serve(QIODevice *socket)
+{
+  // In the thread of the server.  The request is answered once its
+  // headers have arrived.
+  connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+  connect(socket, &QIODevice::readyRead, socket, [this, socket]() {
+      QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+      if (!request.contains("\r\n\r\n") && !request.contains("\n\n") && request.size() < MaximumRequestSize) {
+        socket->setProperty("request", request);
+        return;
+      }
+      disconnect(socket, &QIODevice::readyRead, socket, nullptr);
+
+      QByteArray response;
+      if (request.startsWith("GET ") || request.startsWith("HEAD ")) {
+        const QByteArray body = m_metrics->exposition();
+        response = "HTTP/1.0 200 OK\r\n"
+          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+          "Connection: close\r\n\r\n";
+        if (request.startsWith("GET "))
+          response += body;
+      } else {
+        response = "HTTP/1.0 405 Method Not Allowed\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+      }
+      m_requests.fetchAndAddRelaxed(1);
+      socket->write(response);
+      if (QTcpSocket *tcpSocket = qobject_cast<QTcpSocket *>(socket))
+        tcpSocket->disconnectFromHost();
+      else if (QLocalSocket *localSocket = qobject_cast<QLocalSocket *>(socket))
+        localSocket->disconnectFromServer();
+    });
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include "Metrics.hpp"
+
+class QTcpServer;
+class QLocalServer;
+class QIODevice;
+
+// A MetricsServer answers HTTP requests with the text exposition of
+// a set of Metrics, for Prometheus to scrape (or curl, with
+// --unix-socket).  It listens either on a TCP port of the loopback
+// interface only, or on a Unix domain socket.
+//
+// The server runs on a thread of its own, and the metrics are read
+// without taking the locks of the threads that update them, so a
+// scrape never holds up the tracking loop.  Every request gets the
+// metrics, whatever its path, and the connection is closed after the
+// response.
+
+class MetricsServer : public QObject
+{
+  Q_OBJECT
+public:
+  MetricsServer(Metrics *metrics = &Metrics::global(), QObject *parent = nullptr);
+  ~MetricsServer();
+
+  // Listen on "unix:<path>", "localhost:<port>" or "<port>".  Returns
+  // false, with the reason in errorString(), if it cannot.
+  bool listen(QString const &address);
+  void close();
+
+  // The address listened on, "unix:<path>" or "localhost:<port>" with
+  // the actual port, or an empty string.
+  QString address() const;
+  QString errorString() const;
+
+  // The number of requests answered
+  quint64 requests() const;
+
+private:
+  void serve(QIODevice *socket);
+
+  Metrics *m_metrics;
+  QThread *thread;
+  QTcpServer *m_tcpServer;
+  QLocalServer *m_localServer;
+  QString m_address;
+  QString m_errorString;
+  QAtomicInteger<quint64> m_requests;
+};
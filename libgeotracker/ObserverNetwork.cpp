@@ -0,0 +1,222 @@
+#include <QMetaMethod>
+#include "ObserverNetwork.hpp"
+#include "LatencyTrace.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the networks
+static
+MetricCounter &LookAngleCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_network_look_angles_total",
+                                                            "Look angles computed by the observer networks.");
+  return *counter;
+}
+
+ObserverNetwork::ObserverNetwork(QObject *parent) :
+  QObject(parent),
+  m_precision(DoublePrecision),
+  m_origin(0.0, 0.0, 0.0),
+  m_timestamp(0),
+  m_target(nullptr)
+{
+  m_targetListener.bind<ObserverNetwork, &ObserverNetwork::onTargetPositionChanged>(this);
+}
+
+ObserverNetwork::~ObserverNetwork()
+{
+}
+
+ObserverNetwork::Precision ObserverNetwork::precision() const
+{
+  return m_precision;
+}
+
+void ObserverNetwork::setPrecision(Precision precision)
+{
+  if (m_precision == precision)
+    return;
+  m_precision = precision;
+  rebuild();
+}
+
+FastMath::Accuracy ObserverNetwork::accuracy() const
+{
+  if (m_precision == SinglePrecision)
+    return m_singleKernel.accuracy();
+  return m_doubleKernel.accuracy();
+}
+
+void ObserverNetwork::setAccuracy(FastMath::Accuracy accuracy)
+{
+  m_singleKernel.setAccuracy(accuracy);
+  m_doubleKernel.setAccuracy(accuracy);
+}
+
+int ObserverNetwork::count() const
+{
+  return m_positions.size();
+}
+
+int ObserverNetwork::addObserver(QGeoCoordinate const &position)
+{
+  const int observer = m_positions.size();
+  if (observer == 0) {
+    // The frames are relative to the first observer
+    m_origin = LookAngleFrame::at(position).point;
+    rebuild();
+  }
+  resize(observer + 1);
+  m_azimuth[observer] = 0.0f;
+  m_elevation[observer] = 0.0f;
+  m_range[observer] = 0.0;
+  setFrame(observer, position);
+  return observer;
+}
+
+QGeoCoordinate ObserverNetwork::observerPosition(int observer) const
+{
+  return m_positions.at(observer);
+}
+
+void ObserverNetwork::setObserverPosition(int observer, QGeoCoordinate const &position)
+{
+  setFrame(observer, position);
+}
+
+void ObserverNetwork::removeObserver(int observer)
+{
+  const int last = m_positions.size() - 1;
+  if (observer != last) {
+    m_positions[observer] = m_positions.at(last);
+    if (m_precision == SinglePrecision)
+      m_singleKernel.copyFrame(last, observer);
+    else
+      m_doubleKernel.copyFrame(last, observer);
+    m_azimuth[observer] = m_azimuth.at(last);
+    m_elevation[observer] = m_elevation.at(last);
+    m_range[observer] = m_range.at(last);
+  }
+  resize(last);
+}
+
+void ObserverNetwork::clear()
+{
+  resize(0);
+}
+
+Refraction ObserverNetwork::refraction() const
+{
+  return m_refraction;
+}
+
+void ObserverNetwork::setRefraction(Refraction const &refraction)
+{
+  m_refraction = refraction;
+}
+
+GeoEntity *ObserverNetwork::target() const
+{
+  return m_target;
+}
+
+void ObserverNetwork::setTarget(GeoEntity *entity)
+{
+  if (m_target == entity)
+    return;
+  m_targetListener.unlisten();
+  m_target = entity;
+  if (m_target) {
+    // follow the target's movements
+    m_target->addPositionListener(&m_targetListener);
+    if (m_target->position().isValid())
+      onTargetPositionChanged(m_target->position());
+  }
+}
+
+void ObserverNetwork::calculate(QGeoCoordinate const &target, qint64 timestamp)
+{
+  const int count = m_positions.size();
+  m_timestamp = timestamp;
+
+  // The target, once for all the observers
+  const GeoPoint point = LookAngle::point(target);
+  if (m_precision == SinglePrecision)
+    m_singleKernel.calculate(point, m_azimuth.data(), m_elevation.data(), m_range.data());
+  else
+    m_doubleKernel.calculate(point, m_azimuth.data(), m_elevation.data(), m_range.data());
+  m_refraction.apply(m_elevation.data(), m_range.constData(), count);
+  LookAngleCount().add(quint64(count));
+  LATENCY_TRACE_MARK(LookAngleComputed);
+
+  m_lookAnglesListeners.notify(lookAngles());
+
+  static const QMetaMethod lookAnglesChangedSignal = QMetaMethod::fromSignal(&ObserverNetwork::lookAnglesChanged);
+  if (isSignalConnected(lookAnglesChangedSignal))
+    emit lookAnglesChanged();
+}
+
+NetworkLookAngles ObserverNetwork::lookAngles() const
+{
+  NetworkLookAngles lookAngles;
+  lookAngles.timestamp = m_timestamp;
+  lookAngles.count = m_positions.size();
+  lookAngles.azimuth = m_azimuth.constData();
+  lookAngles.elevation = m_elevation.constData();
+  lookAngles.range = m_range.constData();
+  return lookAngles;
+}
+
+LookAngle ObserverNetwork::lookAngle(int observer) const
+{
+  return LookAngle(m_azimuth.at(observer), m_elevation.at(observer));
+}
+
+void ObserverNetwork::addLookAnglesListener(NetworkLookAnglesListener *listener)
+{
+  m_lookAnglesListeners.add(listener);
+}
+
+void ObserverNetwork::removeLookAnglesListener(NetworkLookAnglesListener *listener)
+{
+  m_lookAnglesListeners.remove(listener);
+}
+
+void ObserverNetwork::onTargetPositionChanged(QGeoPositionInfo const &position)
+{
+  calculate(position.coordinate(), position.timestamp().toMSecsSinceEpoch());
+}
+
+void ObserverNetwork::setFrame(int observer, QGeoCoordinate const &position)
+{
+  m_positions[observer] = position;
+  if (m_precision == SinglePrecision)
+    m_singleKernel.setFrame(observer, LookAngleFrame::at(position));
+  else
+    m_doubleKernel.setFrame(observer, LookAngleFrame::at(position));
+}
+
+void ObserverNetwork::resize(int count)
+{
+  m_positions.resize(count);
+  if (m_precision == SinglePrecision)
+    m_singleKernel.resize(count);
+  else
+    m_doubleKernel.resize(count);
+  m_azimuth.resize(count);
+  m_elevation.resize(count);
+  m_range.resize(count);
+}
+
+void ObserverNetwork::rebuild()
+{
+  // Only the kernel of the precision has the frames
+  m_singleKernel.setOrigin(m_origin);
+  m_doubleKernel.setOrigin(m_origin);
+  const int count = m_positions.size();
+  if (m_precision == SinglePrecision)
+    m_singleKernel.resize(count);
+  else
+    m_doubleKernel.resize(count);
+  for (int i = 0; i < count; ++i)
+    setFrame(i, m_positions.at(i));
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include "GeoEntity.hpp"
+#include "LookAngle.hpp"
+#include "LookAngleKernel.hpp"
+#include "Refraction.hpp"
+#include "Listener.hpp"
+
+// The look angles from all the observers of a network to its target,
+// by observer index.  The arrays belong to the network and are valid
+// until it next calculates.
+struct NetworkLookAngles
+{
+  qint64 timestamp;           // of the target position, in milliseconds since 1970-01-01T00:00:00 UTC
+  int count;
+  float const *azimuth;       // degrees from true north
+  float const *elevation;     // degrees above the horizon, refracted
+  double const *range;        // meters
+};
+
+typedef Listener<NetworkLookAngles> NetworkLookAnglesListener;
+
+// An ObserverNetwork is a network of fixed observers (ground
+// stations, say) that all look at the same target.  It replaces N
+// GeoObservers following one entity, each of which converts the same
+// target position to Earth-centered coordinates again, by one
+// conversion of the target per update and a pass over the observers.
+//
+// The frame of each observer (see LookAngleFrame) is computed when
+// the observer is added or moved, and kept in a LookAngleKernel,
+// which projects the target on all the frames at once a SIMD
+// register at a time.  The frames are relative to the first observer
+// added.  The kernel works in double by default, in agreement with
+// LookAngle, or in float, with twice the observers per instruction,
+// at the accuracy of a display (see LookAngleKernel for the error
+// bounds of each), with the trigonometry of FastMath at the accuracy
+// of the network, or by default of the kernel.  The refraction is
+// applied to the whole batch.
+//
+// The network follows a target entity as a position listener, and
+// gives the look angles to its own listeners (see Listener) before
+// it emits lookAnglesChanged().
+
+class ObserverNetwork : public QObject
+{
+  Q_OBJECT
+  Q_PROPERTY(Precision precision READ precision WRITE setPrecision)
+public:
+  // The arithmetic of the look angles
+  enum Precision {
+    SinglePrecision,  // float
+    DoublePrecision   // double
+  };
+  Q_ENUM(Precision)
+
+  ObserverNetwork(QObject *parent = nullptr);
+  ~ObserverNetwork();
+
+  Precision precision() const;
+  void setPrecision(Precision precision);
+
+  // The accuracy of the trigonometry of the kernels
+  FastMath::Accuracy accuracy() const;
+  void setAccuracy(FastMath::Accuracy accuracy);
+
+  int count() const;
+
+  // Add an observer, returning its index
+  int addObserver(QGeoCoordinate const &position);
+  QGeoCoordinate observerPosition(int observer) const;
+  void setObserverPosition(int observer, QGeoCoordinate const &position);
+  // Remove an observer: the last observer takes its index.
+  void removeObserver(int observer);
+  void clear();
+
+  Refraction refraction() const;
+  void setRefraction(Refraction const &refraction);
+
+  // The entity the network follows, or null
+  GeoEntity *target() const;
+  void setTarget(GeoEntity *entity);
+
+  // Calculate the look angles from every observer to a position
+  void calculate(QGeoCoordinate const &target, qint64 timestamp = 0);
+
+  // The look angles of the last calculation
+  NetworkLookAngles lookAngles() const;
+  LookAngle lookAngle(int observer) const;
+
+  void addLookAnglesListener(NetworkLookAnglesListener *listener);
+  void removeLookAnglesListener(NetworkLookAnglesListener *listener);
+
+signals:
+  void lookAnglesChanged();
+
+private:
+  void onTargetPositionChanged(QGeoPositionInfo const &position);
+  void setFrame(int observer, QGeoCoordinate const &position);
+  void resize(int count);
+  void rebuild();
+
+  Precision m_precision;
+  QVector<QGeoCoordinate> m_positions;
+  GeoPoint m_origin;
+  LookAngleKernel<float> m_singleKernel;    // the one of the precision
+  LookAngleKernel<double> m_doubleKernel;   // has the frames
+
+  QVector<float> m_azimuth;
+  QVector<float> m_elevation;
+  QVector<double> m_range;
+  qint64 m_timestamp;
+
+  Refraction m_refraction;
+  GeoEntity *m_target;
+  PositionListener m_targetListener;
+  ListenerList<NetworkLookAngles> m_lookAnglesListeners;
+};
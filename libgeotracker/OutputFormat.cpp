@@ -0,0 +1,189 @@
+#include <QtEndian>
+#include <QGeoCoordinate>
+#include <cstring>
+#include <limits>
+#include "OutputFormat.hpp"
+
+static const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+OutputRecord OutputRecord::position(Kind kind, qint64 timestamp,
+                                    double latitude, double longitude, double altitude)
+{
+  OutputRecord record;
+  record.kind = kind;
+  record.timestamp = timestamp;
+  record.latitude = latitude;
+  record.longitude = longitude;
+  record.altitude = altitude;
+  record.azimuth = NaN;
+  record.elevation = NaN;
+  return record;
+}
+
+OutputRecord OutputRecord::lookAngle(qint64 timestamp, double azimuth, double elevation)
+{
+  OutputRecord record;
+  record.kind = LookAngle;
+  record.timestamp = timestamp;
+  record.latitude = NaN;
+  record.longitude = NaN;
+  record.altitude = NaN;
+  record.azimuth = azimuth;
+  record.elevation = elevation;
+  return record;
+}
+
+// The names of the kinds of record in the csv and ndjson formats
+static
+char const *KindName(OutputRecord::Kind kind)
+{
+  switch (kind) {
+  case OutputRecord::ObserverPosition: return "observer";
+  case OutputRecord::TargetPosition:   return "target";
+  case OutputRecord::LookAngle:        return "look_angle";
+  }
+  return "";
+}
+
+// A number with the given number of decimals, or the given
+// replacement if it is NaN
+static
+void AppendNumber(QByteArray *out, double value, int decimals, char const *nan)
+{
+  if (qIsNaN(value))
+    out->append(nan);
+  else
+    out->append(QByteArray::number(value, 'f', decimals));
+}
+
+OutputFormat::~OutputFormat()
+{
+}
+
+QByteArray OutputFormat::header() const
+{
+  return QByteArray();
+}
+
+OutputFormat *OutputFormat::create(QString const &name)
+{
+  if (name == "text")
+    return new TextOutputFormat;
+  if (name == "csv")
+    return new CsvOutputFormat;
+  if (name == "ndjson")
+    return new NdjsonOutputFormat;
+  if (name == "binary")
+    return new BinaryOutputFormat;
+  return nullptr;
+}
+
+QStringList OutputFormat::names()
+{
+  return QStringList() << "text" << "csv" << "ndjson" << "binary";
+}
+
+QString TextOutputFormat::name() const
+{
+  return "text";
+}
+
+void TextOutputFormat::format(OutputRecord const &record, QByteArray *out) const
+{
+  switch (record.kind) {
+  case OutputRecord::ObserverPosition:
+  case OutputRecord::TargetPosition:
+    out->append(record.kind == OutputRecord::ObserverPosition ? "   observer's location: " : "     target's location: ");
+    out->append(QGeoCoordinate(record.latitude, record.longitude, record.altitude).toString().toUtf8());
+    out->append('\n');
+    break;
+  case OutputRecord::LookAngle:
+    out->append("     azimuth to target: ");
+    out->append(QByteArray::number(record.azimuth, 'g', 6));
+    out->append("\n   elevation to target: ");
+    out->append(QByteArray::number(record.elevation, 'g', 6));
+    out->append('\n');
+    break;
+  }
+}
+
+QString CsvOutputFormat::name() const
+{
+  return "csv";
+}
+
+QByteArray CsvOutputFormat::header() const
+{
+  return "kind,timestamp,latitude,longitude,altitude,azimuth,elevation\n";
+}
+
+void CsvOutputFormat::format(OutputRecord const &record, QByteArray *out) const
+{
+  out->append(KindName(record.kind));
+  out->append(',');
+  out->append(QByteArray::number(record.timestamp));
+  out->append(',');
+  AppendNumber(out, record.latitude, 8, "");
+  out->append(',');
+  AppendNumber(out, record.longitude, 8, "");
+  out->append(',');
+  AppendNumber(out, record.altitude, 3, "");
+  out->append(',');
+  AppendNumber(out, record.azimuth, 6, "");
+  out->append(',');
+  AppendNumber(out, record.elevation, 6, "");
+  out->append('\n');
+}
+
+QString NdjsonOutputFormat::name() const
+{
+  return "ndjson";
+}
+
+void NdjsonOutputFormat::format(OutputRecord const &record, QByteArray *out) const
+{
+  out->append("{\"kind\":\"");
+  out->append(KindName(record.kind));
+  out->append("\",\"timestamp\":");
+  out->append(QByteArray::number(record.timestamp));
+  if (record.kind == OutputRecord::LookAngle) {
+    out->append(",\"azimuth\":");
+    AppendNumber(out, record.azimuth, 6, "null");
+    out->append(",\"elevation\":");
+    AppendNumber(out, record.elevation, 6, "null");
+  } else {
+    out->append(",\"latitude\":");
+    AppendNumber(out, record.latitude, 8, "null");
+    out->append(",\"longitude\":");
+    AppendNumber(out, record.longitude, 8, "null");
+    out->append(",\"altitude\":");
+    AppendNumber(out, record.altitude, 3, "null");
+  }
+  out->append("}\n");
+}
+
+QString BinaryOutputFormat::name() const
+{
+  return "binary";
+}
+
+QByteArray BinaryOutputFormat::header() const
+{
+  return QByteArray("GTRK\x01\0\0\0", HeaderSize);
+}
+
+void BinaryOutputFormat::format(OutputRecord const &record, QByteArray *out) const
+{
+  uchar data[RecordSize];
+  qToLittleEndian<qint64>(record.timestamp, data);
+  qToLittleEndian<quint32>(quint32(record.kind), data + 8);
+  qToLittleEndian<quint32>(0, data + 12);
+  double const values[] = { record.latitude, record.longitude, record.altitude,
+                            record.azimuth, record.elevation };
+  for (int i = 0; i < 5; ++i) {
+    quint64 bits;
+    memcpy(&bits, &values[i], sizeof(bits));
+    qToLittleEndian<quint64>(bits, data + 16 + 8 * i);
+  }
+  out->append(reinterpret_cast<char const *>(data), RecordSize);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+// An OutputRecord is one line of the tracker's output: a position of
+// the observer or of the target, or a look angle from the one to the
+// other.  It is a plain value so that the tracking thread can queue
+// it without formatting it (see OutputSink).  The fields that do not
+// apply to the kind of record are NaN.
+
+struct OutputRecord
+{
+  enum Kind { ObserverPosition, TargetPosition, LookAngle };
+
+  Kind    kind;
+  qint64  timestamp;    // milliseconds since 1970-01-01T00:00:00 UTC
+  double  latitude;     // degrees
+  double  longitude;    // degrees
+  double  altitude;     // meters above sea level
+  double  azimuth;      // degrees from true north
+  double  elevation;    // degrees above the horizon
+
+  static OutputRecord position(Kind kind, qint64 timestamp,
+                               double latitude, double longitude, double altitude);
+  static OutputRecord lookAngle(qint64 timestamp, double azimuth, double elevation);
+};
+
+// An OutputFormat turns records into bytes.  The formats are:
+//
+// - text: the lines for people to read that target-tracker has always
+//   printed, with the coordinates in degrees, minutes and seconds.
+//
+// - csv: one line per record, after a line of column names.
+//
+// - ndjson: one JSON object per line, with only the fields that apply
+//   to the kind of record.
+//
+// - binary: a header of 8 bytes, "GTRK", the version (1) and three
+//   zero bytes, then 56 bytes per record, little endian: the time
+//   stamp (int64), the kind (uint32), 4 reserved bytes, and the
+//   latitude, longitude, altitude, azimuth and elevation (float64).
+//
+// A format is only used by one thread at a time.
+
+class OutputFormat
+{
+public:
+  virtual ~OutputFormat();
+
+  virtual QString name() const = 0;
+
+  // The bytes written once before the first record
+  virtual QByteArray header() const;
+  // Append a record to the output
+  virtual void format(OutputRecord const &record, QByteArray *out) const = 0;
+
+  // A format by name, or null if there is none of the name.  The
+  // caller owns it.
+  static OutputFormat *create(QString const &name);
+  static QStringList names();
+};
+
+class TextOutputFormat : public OutputFormat
+{
+public:
+  virtual QString name() const;
+  virtual void format(OutputRecord const &record, QByteArray *out) const;
+};
+
+class CsvOutputFormat : public OutputFormat
+{
+public:
+  virtual QString name() const;
+  virtual QByteArray header() const;
+  virtual void format(OutputRecord const &record, QByteArray *out) const;
+};
+
+class NdjsonOutputFormat : public OutputFormat
+{
+public:
+  virtual QString name() const;
+  virtual void format(OutputRecord const &record, QByteArray *out) const;
+};
+
+class BinaryOutputFormat : public OutputFormat
+{
+public:
+  enum { HeaderSize = 8, RecordSize = 56 };
+
+  virtual QString name() const;
+  virtual QByteArray header() const;
+  virtual void format(OutputRecord const &record, QByteArray *out) const;
+};
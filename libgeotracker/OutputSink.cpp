@@ -0,0 +1,208 @@
+#include <QThread>
+#include <QMutexLocker>
+#include <cstdio>
+#include "OutputSink.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the sinks
+static
+MetricCounter &WrittenCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_output_records_total",
+                                                            "Records written by the output sinks.");
+  return *counter;
+}
+
+static
+MetricCounter &DroppedCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_output_dropped_records_total",
+                                                            "Records dropped by the output sinks, their queue being full or the output failing.");
+  return *counter;
+}
+
+OutputSink::OutputSink(OutputFormat *format, int capacity) :
+  m_format(format),
+  m_capacity(qMax(1, capacity)),
+  thread(nullptr),
+  m_queued(0),
+  m_done(0),
+  m_flushing(0),
+  m_flushInterval(50),
+  m_isOpen(false),
+  m_isStopping(false),
+  m_written(0),
+  m_dropped(0)
+{
+  m_queue.reserve(qMin(m_capacity, int(BatchSize)));
+}
+
+OutputSink::~OutputSink()
+{
+  close();
+  delete m_format;
+}
+
+bool OutputSink::open(QString const &fileName)
+{
+  close();
+  bool isOpen;
+  if (fileName == "-") {
+    // Written to with one call per batch, so no need for buffering
+    // on top.
+    isOpen = m_file.open(fileno(stdout), QIODevice::WriteOnly | QIODevice::Unbuffered);
+  } else {
+    m_file.setFileName(fileName);
+    isOpen = m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered);
+  }
+  if (!isOpen) {
+    m_errorString = m_file.errorString();
+    return false;
+  }
+
+  {
+    QMutexLocker locker(&m_mutex);
+    m_isOpen = true;
+    m_isStopping = false;
+  }
+  thread = QThread::create([this]() { run(); });
+  thread->setObjectName("OutputSink");
+  thread->start();
+  return true;
+}
+
+void OutputSink::close()
+{
+  if (!thread)
+    return;
+  {
+    QMutexLocker locker(&m_mutex);
+    m_isStopping = true;
+    m_wakeWriter.wakeOne();
+  }
+  thread->wait();
+  delete thread;
+  thread = nullptr;
+  m_file.close();
+
+  QMutexLocker locker(&m_mutex);
+  m_isOpen = false;
+  m_isStopping = false;
+}
+
+bool OutputSink::isOpen() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_isOpen;
+}
+
+QString OutputSink::errorString() const
+{
+  return m_errorString;
+}
+
+OutputFormat const *OutputSink::format() const
+{
+  return m_format;
+}
+
+int OutputSink::capacity() const
+{
+  return m_capacity;
+}
+
+int OutputSink::flushInterval() const
+{
+  QMutexLocker locker(&m_mutex);
+  return m_flushInterval;
+}
+
+void OutputSink::setFlushInterval(int msecs)
+{
+  QMutexLocker locker(&m_mutex);
+  m_flushInterval = qMax(0, msecs);
+}
+
+void OutputSink::write(OutputRecord const &record)
+{
+  QMutexLocker locker(&m_mutex);
+  if (!m_isOpen || m_isStopping || m_queue.size() >= m_capacity) {
+    locker.unlock();
+    m_dropped.fetchAndAddRelaxed(1);
+    DroppedCount().increment();
+    return;
+  }
+  m_queue.append(record);
+  ++m_queued;
+  // The writer sleeps until there is a record, then waits out the
+  // flush interval unless a batch fills first.
+  if (m_queue.size() == 1 || m_queue.size() == BatchSize)
+    m_wakeWriter.wakeOne();
+}
+
+void OutputSink::flush()
+{
+  QMutexLocker locker(&m_mutex);
+  if (!m_isOpen)
+    return;
+  const quint64 target = m_queued;
+  ++m_flushing;
+  m_wakeWriter.wakeOne();
+  while (m_done < target)
+    m_wakeFlush.wait(&m_mutex);
+  --m_flushing;
+}
+
+quint64 OutputSink::written() const
+{
+  return m_written.loadRelaxed();
+}
+
+quint64 OutputSink::dropped() const
+{
+  return m_dropped.loadRelaxed();
+}
+
+void OutputSink::run()
+{
+  // In the writer thread.  The queue is swapped with an empty one so
+  // that the tracking thread can go on queuing while the batch is
+  // written; both keep their capacity, so nothing is allocated once
+  // they have grown.
+  QVector<OutputRecord> batch;
+  batch.reserve(m_queue.capacity());
+  QByteArray buffer = m_format->header();
+
+  QMutexLocker locker(&m_mutex);
+  for (;;) {
+    while (m_queue.isEmpty() && !m_isStopping && buffer.isEmpty())
+      m_wakeWriter.wait(&m_mutex);
+    if (m_queue.size() < BatchSize && !m_isStopping && m_flushing == 0 && m_flushInterval > 0)
+      m_wakeWriter.wait(&m_mutex, m_flushInterval);
+
+    batch.swap(m_queue);
+    const quint64 taken = m_queued;
+    const bool isStopping = m_isStopping;
+    locker.unlock();
+
+    for (OutputRecord const &record : batch)
+      m_format->format(record, &buffer);
+    if (!buffer.isEmpty()) {
+      if (m_file.write(buffer) == buffer.size()) {
+        m_written.fetchAndAddRelaxed(batch.size());
+        WrittenCount().add(batch.size());
+      } else {
+        m_dropped.fetchAndAddRelaxed(batch.size());
+        DroppedCount().add(batch.size());
+      }
+    }
+    buffer.clear();
+    batch.clear();
+
+    locker.relock();
+    m_done = taken;
+    m_wakeFlush.wakeAll();
+    if (isStopping && m_queue.isEmpty())
+      break;
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include "OutputFormat.hpp"
+
+class QThread;
+
+// An OutputSink writes records in a format from a thread of its own,
+// so that the thread that tracks never waits for the output.
+//
+// write() only copies the record to a queue.  The writer thread takes
+// the whole queue at once, formats it into one buffer and writes the
+// buffer with one call: at most flushInterval() milliseconds after a
+// record is queued, or as soon as a batch of records is waiting.  If
+// the output falls so far behind that the queue is full, the records
+// are dropped, and counted, rather than held up.
+
+class OutputSink
+{
+public:
+  // The sink owns the format.
+  OutputSink(OutputFormat *format, int capacity = 65536);
+  ~OutputSink();
+
+  // Write to a file, or to the standard output for "-".  Returns
+  // false, with the reason in errorString(), if it cannot.
+  bool open(QString const &fileName);
+  // Write out the records queued and stop.
+  void close();
+  bool isOpen() const;
+  QString errorString() const;
+
+  OutputFormat const *format() const;
+  int capacity() const;
+
+  int flushInterval() const;
+  void setFlushInterval(int msecs);
+
+  // Queue a record.  Never waits for the output; may be called from
+  // any thread.
+  void write(OutputRecord const &record);
+
+  // Wait until the records queued so far are written.
+  void flush();
+
+  quint64 written() const;
+  quint64 dropped() const;
+
+  // The records queued at once that wake the writer before the flush
+  // interval is up
+  enum { BatchSize = 1024 };
+
+private:
+  Q_DISABLE_COPY(OutputSink)
+
+  void run();
+
+  OutputFormat *m_format;
+  int m_capacity;
+  QFile m_file;
+  QString m_errorString;
+  QThread *thread;
+
+  mutable QMutex m_mutex;
+  QWaitCondition m_wakeWriter;       // a batch to write, or stop
+  QWaitCondition m_wakeFlush;        // a batch written
+  QVector<OutputRecord> m_queue;
+  quint64 m_queued;                  // records queued since the start
+  quint64 m_done;                    // and handled by the writer
+  int m_flushing;                    // threads waiting in flush()
+  int m_flushInterval;
+  bool m_isOpen;
+  bool m_isStopping;
+
+  QAtomicInteger<quint64> m_written;
+  QAtomicInteger<quint64> m_dropped;
+};
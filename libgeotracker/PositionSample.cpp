@@ -0,0 +1,68 @@
+#include <QtMath>
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include "PositionSample.hpp"
+
+PositionSample PositionSample::invalid(quint64 id)
+{
+  PositionSample sample;
+  sample.id = id;
+  sample.timestamp = 0;
+  sample.latitude = qQNaN();
+  sample.longitude = qQNaN();
+  sample.altitude = qQNaN();
+  sample.groundSpeed = qQNaN();
+  sample.direction = qQNaN();
+  sample.verticalSpeed = qQNaN();
+  sample.horizontalAccuracy = qQNaN();
+  sample.verticalAccuracy = qQNaN();
+  return sample;
+}
+
+static
+double Attribute(QGeoPositionInfo const &info, QGeoPositionInfo::Attribute attribute)
+{
+  return info.hasAttribute(attribute) ? double(info.attribute(attribute)) : qQNaN();
+}
+
+PositionSample PositionSample::fromPositionInfo(QGeoPositionInfo const &info, quint64 id)
+{
+  PositionSample sample = invalid(id);
+  QGeoCoordinate coordinate = info.coordinate();
+  sample.timestamp = info.timestamp().toMSecsSinceEpoch();
+  sample.latitude = coordinate.latitude();
+  sample.longitude = coordinate.longitude();
+  sample.altitude = coordinate.altitude();
+  sample.groundSpeed = Attribute(info, QGeoPositionInfo::GroundSpeed);
+  sample.direction = Attribute(info, QGeoPositionInfo::Direction);
+  sample.verticalSpeed = Attribute(info, QGeoPositionInfo::VerticalSpeed);
+  sample.horizontalAccuracy = Attribute(info, QGeoPositionInfo::HorizontalAccuracy);
+  sample.verticalAccuracy = Attribute(info, QGeoPositionInfo::VerticalAccuracy);
+  return sample;
+}
+
+bool PositionSample::isValid() const
+{
+  return latitude >= -90.0 && latitude <= 90.0 && longitude >= -180.0 && longitude <= 180.0;
+}
+
+QGeoPositionInfo PositionSample::toPositionInfo() const
+{
+  QGeoPositionInfo info(QGeoCoordinate(latitude, longitude, altitude),
+                        QDateTime::fromMSecsSinceEpoch(timestamp, Qt::UTC));
+  if (!qIsNaN(groundSpeed))
+    info.setAttribute(QGeoPositionInfo::GroundSpeed, groundSpeed);
+  if (!qIsNaN(direction))
+    info.setAttribute(QGeoPositionInfo::Direction, direction);
+  if (!qIsNaN(verticalSpeed))
+    info.setAttribute(QGeoPositionInfo::VerticalSpeed, verticalSpeed);
+  if (!qIsNaN(horizontalAccuracy))
+    info.setAttribute(QGeoPositionInfo::HorizontalAccuracy, horizontalAccuracy);
+  if (!qIsNaN(verticalAccuracy))
+    info.setAttribute(QGeoPositionInfo::VerticalAccuracy, verticalAccuracy);
+  return info;
+}
+
+PositionSampleSink::~PositionSampleSink()
+{
+}
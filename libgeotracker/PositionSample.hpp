@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <QGeoPositionInfo>
+
+// A PositionSample is one position report of an entity, as received
+// from a feed.  It is a plain value with no heap allocation, so that
+// the high rate sources can parse into arrays of them and hand them
+// on in batches (see PositionSampleSink), converting to
+// QGeoPositionInfo only where needed.
+//
+// The id identifies the entity within its feed: an ICAO address, an
+// MMSI, a MAVLink system id, a hash of the gpsd device name or of
+// the sender's address.  Quantities that are not reported are NaN.
+
+struct PositionSample
+{
+  quint64 id;
+  qint64  timestamp;            // milliseconds since 1970-01-01T00:00:00 UTC
+  double  latitude;             // degrees
+  double  longitude;            // degrees
+  double  altitude;             // meters above sea level
+  double  groundSpeed;          // meters per second
+  double  direction;            // degrees from true north
+  double  verticalSpeed;        // meters per second, up
+  double  horizontalAccuracy;   // meters
+  double  verticalAccuracy;     // meters
+
+  // A sample with no position
+  static PositionSample invalid(quint64 id = 0);
+  static PositionSample fromPositionInfo(QGeoPositionInfo const &info, quint64 id = 0);
+
+  bool isValid() const;
+  QGeoPositionInfo toPositionInfo() const;
+};
+
+Q_DECLARE_METATYPE(PositionSample)
+
+// A PositionSampleSink consumes batches of samples.  The samples are
+// only valid for the duration of the call.
+
+class PositionSampleSink
+{
+public:
+  virtual ~PositionSampleSink();
+
+  virtual void consume(PositionSample const *samples, int count) = 0;
+};
@@ -0,0 +1,168 @@
+#include <QtMath>
+#include "Refraction.hpp"
+
+// The table covers geometric elevations from just below the horizon
+// to the zenith.  Below the first entry the refraction formulas are
+// no longer valid, so the correction is held at its horizon value.
+static const float  TableMinimumElevation = -1.0f;  // degrees
+static const float  TableMaximumElevation = 90.0f;  // degrees
+static const float  TableStep             = 0.05f;  // degrees
+static const int    TableSize             = 1821;   // (max - min) / step + 1
+
+// The mean radius of the earth and the effective earth radius factor
+// of the FourThirdsEarth model.
+static const double EarthRadiusInMeters   = 6371000.0;
+static const double EffectiveRadiusFactor = 4.0 / 3.0;
+
+static
+double Cotangent(const double degrees)
+{
+  return 1.0 / qTan(qDegreesToRadians(degrees));
+}
+
+static
+double SaemundssonRefraction(const double elevation)
+{
+  // Refraction in arc minutes of a target at the given geometric
+  // elevation in degrees, at 10 degrees Celsius and 1010 millibars.
+  return 1.02 * Cotangent(elevation + 10.3 / (elevation + 5.11));
+}
+
+static
+double BennettRefraction(const double elevation)
+{
+  // Refraction in arc minutes of a target at the given geometric
+  // elevation in degrees, at 10 degrees Celsius and 1010 millibars.
+  // Bennett's formula is in terms of the apparent elevation, so
+  // solve apparent = geometric + R(apparent) by fixed point
+  // iteration.  The refraction changes slowly with elevation, so
+  // this converges after a few steps.
+  double apparent = elevation;
+  for (int i = 0; i < 20; ++i)
+    apparent = elevation + Cotangent(apparent + 7.31 / (apparent + 4.4)) / 60.0;
+  return (apparent - elevation) * 60.0;
+}
+
+Refraction::Refraction() :
+  m_model(None),
+  m_temperature(10.0),
+  m_pressure(1010.0)
+{
+}
+
+Refraction::Refraction(Model model, double temperature, double pressure) :
+  m_model(model),
+  m_temperature(temperature),
+  m_pressure(pressure)
+{
+  buildTable();
+}
+
+Refraction::Model Refraction::model() const
+{
+  return m_model;
+}
+
+double Refraction::temperature() const
+{
+  return m_temperature;
+}
+
+double Refraction::pressure() const
+{
+  return m_pressure;
+}
+
+void Refraction::buildTable()
+{
+  m_table.clear();
+  if (m_model == None)
+    return;
+
+  // Both optical formulas are given for standard conditions.  Scale
+  // them by the density of the air at the observer.
+  const double scale = (m_pressure / 1010.0) * (283.0 / (273.0 + m_temperature));
+
+  m_table.resize(TableSize);
+  for (int i = 0; i < TableSize; ++i) {
+    const double elevation = TableMinimumElevation + i * TableStep;
+    double arcMinutes;
+    if (m_model == Bennett)
+      arcMinutes = BennettRefraction(elevation);
+    else
+      arcMinutes = SaemundssonRefraction(elevation);
+
+    // The formulas go slightly negative at the zenith where the
+    // refraction is zero.
+    m_table[i] = float(qMax(0.0, scale * arcMinutes / 60.0));
+  }
+  m_table[TableSize - 1] = 0.0f;
+}
+
+float Refraction::tableLookup(float elevation) const
+{
+  // Linearly interpolate between the two nearest table entries.
+  float x = (elevation - TableMinimumElevation) * (1.0f / TableStep);
+  if (x <= 0.0f)
+    return m_table.at(0);
+  if (x >= TableSize - 1)
+    return m_table.at(TableSize - 1);
+  const int i = int(x);
+  const float fraction = x - i;
+  const float *table = m_table.constData();
+  return table[i] + fraction * (table[i + 1] - table[i]);
+}
+
+float Refraction::correction(float elevation, double range) const
+{
+  switch (m_model)
+    {
+    case FourThirdsEarth:
+      {
+        // A ray over an earth of radius k*R curves toward the ground
+        // with curvature (1 - 1/k)/R, so the chord to a target at the
+        // given range is below the initial direction of the ray by
+        // half of the bending over that range.  That bending cannot
+        // exceed the refraction through the whole atmosphere.
+        const float limit = tableLookup(elevation);
+        if (range <= 0.0)
+          return limit;
+        const double bending = range * (1.0 - 1.0 / EffectiveRadiusFactor) / (2.0 * EarthRadiusInMeters);
+        return qMin(float(qRadiansToDegrees(bending)), limit);
+      }
+    case Bennett:
+    case Saemundsson:
+      return tableLookup(elevation);
+    case None:
+    default:
+      return 0.0f;
+    }
+}
+
+float Refraction::apparentElevation(float elevation, double range) const
+{
+  return elevation + correction(elevation, range);
+}
+
+void Refraction::apply(float *elevation, double const *range, int count) const
+{
+  if (m_model == None)
+    return;
+
+  if (m_model == FourThirdsEarth && range) {
+    for (int i = 0; i < count; ++i)
+      elevation[i] += correction(elevation[i], range[i]);
+    return;
+  }
+
+  // The remaining models depend on elevation alone, so the loop is
+  // just the table interpolation.
+  const float *table = m_table.constData();
+  for (int i = 0; i < count; ++i) {
+    float x = (elevation[i] - TableMinimumElevation) * (1.0f / TableStep);
+    x = qBound(0.0f, x, float(TableSize - 1) - 0.001f);
+    const int j = int(x);
+    const float fraction = x - j;
+    elevation[i] += table[j] + fraction * (table[j + 1] - table[j]);
+  }
+}
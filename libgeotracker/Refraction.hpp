@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QtCore/QMetaType>
+#include <QVector>
+
+// Refraction models the bending of a line of sight by the
+// atmosphere.  The elevation calculated by LookAngle is geometric: it
+// is the angle to the target as if there were no atmosphere.  The
+// atmosphere bends the ray toward the ground, so the target appears
+// (and must be pointed at) slightly higher than its geometric
+// elevation.  Near the horizon the difference is about half a degree.
+//
+// The following models are provided:
+//
+// - None: the geometric elevation is reported unmodified.
+//
+// - FourThirdsEarth: the standard radio propagation model, which
+//   replaces the curved ray by a straight one over an earth of 4/3
+//   its true radius.  The correction grows with the slant range to
+//   the target and is limited by the refraction through the whole
+//   atmosphere at that elevation.
+//
+// - Bennett: the optical refraction formula of G. G. Bennett (1982)
+//   for a target outside the atmosphere.  Bennett's formula is
+//   expressed in terms of apparent elevation, so it is inverted when
+//   the table is built.
+//
+// - Saemundsson: the optical refraction formula of Th. Saemundsson
+//   (1986) for a target outside the atmosphere, expressed in terms
+//   of geometric elevation.
+//
+// The optical models (and the limit of the radio model) are scaled
+// by the temperature and pressure at the observer.
+//
+// The corrections are not evaluated for every look angle.  Instead,
+// they are precomputed into a table indexed by geometric elevation
+// when the model is constructed, and linearly interpolated
+// afterward.  The table is implicitly shared, so copying a
+// Refraction is cheap.
+
+class Refraction
+{
+  Q_GADGET
+
+  Q_PROPERTY(Model model READ model)
+  Q_PROPERTY(double temperature READ temperature)
+  Q_PROPERTY(double pressure READ pressure)
+
+public:
+  enum Model {
+    None,             // Geometric elevation, no correction
+    FourThirdsEarth,  // Radio: effective earth radius model
+    Bennett,          // Optical: Bennett (1982)
+    Saemundsson       // Optical: Saemundsson (1986)
+  };
+  Q_ENUM(Model)
+
+  Refraction();
+  Refraction(Model model, double temperature = 10.0, double pressure = 1010.0);
+
+  Model model() const;
+  double temperature() const; // degrees Celsius at the observer
+  double pressure() const;    // millibars (hPa) at the observer
+
+  // The correction in degrees to be added to the geometric
+  // elevation (in degrees) of a target at the given slant range (in
+  // meters).  The range is used only by the FourThirdsEarth model; a
+  // range of zero means that the target is outside the atmosphere.
+  float correction(float elevation, double range = 0.0) const;
+
+  // The apparent elevation in degrees of a target at the given
+  // geometric elevation (in degrees) and slant range (in meters).
+  float apparentElevation(float elevation, double range = 0.0) const;
+
+  // Convert count geometric elevations (in degrees) to apparent
+  // elevations in place.  range may be null for targets outside the
+  // atmosphere.
+  void apply(float *elevation, double const *range, int count) const;
+
+private:
+  void buildTable();
+  float tableLookup(float elevation) const;
+
+  Model          m_model;
+  double         m_temperature;
+  double         m_pressure;
+  QVector<float> m_table; // degrees, indexed by geometric elevation
+};
+
+Q_DECLARE_METATYPE(Refraction)
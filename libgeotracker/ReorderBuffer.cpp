@@ -0,0 +1,270 @@
+#include <QThread>
+#include <limits>
+#include <algorithm>
+#include "ReorderBuffer.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the reorder buffers
+static
+MetricCounter &LateCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_reorder_dropped_samples_total",
+                                                            "Samples dropped by the reorder buffers for arriving too late.");
+  return *counter;
+}
+
+static
+MetricCounter &ForcedCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_reorder_forced_samples_total",
+                                                            "Samples released early by the reorder buffers, their ring being full.");
+  return *counter;
+}
+
+static
+MetricGauge &HeldCount()
+{
+  static MetricGauge *gauge = Metrics::global().gauge("geotracker_reorder_held_samples",
+                                                      "Samples held in the reorder buffers.");
+  return *gauge;
+}
+
+ReorderBuffer::ReorderBuffer(int delay, int capacity, QObject *parent) :
+  QObject(parent),
+  m_delay(qMax(0, delay)),
+  m_capacity(qMax(1, capacity)),
+  m_idleTimeout(60000),
+  m_sink(nullptr),
+  m_count(0),
+  m_nextExpiry(0),
+  timer(new QTimer(this))
+{
+  m_statistics.received = 0;
+  m_statistics.released = 0;
+  m_statistics.late = 0;
+  m_statistics.forced = 0;
+  m_statistics.expired = 0;
+  m_clock.start();
+  // The samples are released a quarter of the delay late at most.
+  timer->setInterval(qMax(1, m_delay / 4));
+  connect(timer, SIGNAL(timeout()), this, SLOT(expire()));
+}
+
+ReorderBuffer::~ReorderBuffer()
+{
+  // The samples still held are dropped
+  HeldCount().add(-m_count);
+}
+
+int ReorderBuffer::delay() const
+{
+  return m_delay;
+}
+
+void ReorderBuffer::setDelay(int msecs)
+{
+  m_delay = qMax(0, msecs);
+  timer->setInterval(qMax(1, m_delay / 4));
+}
+
+int ReorderBuffer::capacity() const
+{
+  return m_capacity;
+}
+
+int ReorderBuffer::idleTimeout() const
+{
+  return m_idleTimeout;
+}
+
+void ReorderBuffer::setIdleTimeout(int msecs)
+{
+  m_idleTimeout = qMax(0, msecs);
+}
+
+PositionSampleSink *ReorderBuffer::sampleSink() const
+{
+  return m_sink;
+}
+
+void ReorderBuffer::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+int ReorderBuffer::count() const
+{
+  return m_count;
+}
+
+int ReorderBuffer::entityCount() const
+{
+  return m_rings.size();
+}
+
+ReorderBufferStatistics ReorderBuffer::statistics() const
+{
+  return m_statistics;
+}
+
+void ReorderBuffer::consume(PositionSample const *samples, int count)
+{
+  if (count <= 0)
+    return;
+  if (QThread::currentThread() == thread()) {
+    receive(samples, count);
+    return;
+  }
+  QVector<PositionSample> copy(count);
+  std::copy(samples, samples + count, copy.begin());
+  QMetaObject::invokeMethod(this, [this, copy]() {
+      receive(copy.constData(), copy.size());
+    }, Qt::QueuedConnection);
+}
+
+PositionSample &ReorderBuffer::at(Ring const &ring, int index)
+{
+  return m_storage[ring.offset + (ring.head + index) % m_capacity];
+}
+
+void ReorderBuffer::receive(PositionSample const *samples, int count)
+{
+  const qint64 now = m_clock.elapsed();
+  const int held = m_count;
+  for (int i = 0; i < count; ++i) {
+    PositionSample const &sample = samples[i];
+    ++m_statistics.received;
+
+    int index = m_indexes.value(sample.id, -1);
+    if (index < 0) {
+      Ring ring;
+      ring.id = sample.id;
+      if (m_freeOffsets.isEmpty()) {
+        ring.offset = m_storage.size();
+        m_storage.resize(m_storage.size() + m_capacity);
+      } else {
+        ring.offset = m_freeOffsets.takeLast();
+      }
+      ring.head = 0;
+      ring.count = 0;
+      ring.newest = std::numeric_limits<qint64>::min();
+      ring.released = std::numeric_limits<qint64>::min();
+      index = m_rings.size();
+      m_rings.append(ring);
+      m_indexes.insert(sample.id, index);
+    }
+
+    Ring &ring = m_rings[index];
+    ring.arrival = now;
+    insert(ring, sample);
+    release(ring, ring.newest - m_delay);
+  }
+  deliver();
+  HeldCount().add(m_count - held);
+  expireRings(now);
+  if (m_count > 0 && !timer->isActive())
+    timer->start();
+}
+
+void ReorderBuffer::insert(Ring &ring, PositionSample const &sample)
+{
+  if (sample.timestamp < ring.released) {
+    ++m_statistics.late;
+    LateCount().increment();
+    return;
+  }
+  if (ring.count == m_capacity) {
+    ++m_statistics.forced;
+    ForcedCount().increment();
+    release(ring, at(ring, 0).timestamp);
+    if (sample.timestamp < ring.released) {
+      ++m_statistics.late;
+      LateCount().increment();
+      return;
+    }
+  }
+
+  // Insertion from the newest end, after the samples of the same time
+  int i = ring.count;
+  while (i > 0 && at(ring, i - 1).timestamp > sample.timestamp) {
+    at(ring, i) = at(ring, i - 1);
+    --i;
+  }
+  at(ring, i) = sample;
+  ++ring.count;
+  ++m_count;
+  ring.newest = qMax(ring.newest, sample.timestamp);
+}
+
+void ReorderBuffer::release(Ring &ring, qint64 watermark)
+{
+  while (ring.count > 0 && at(ring, 0).timestamp <= watermark) {
+    PositionSample const &sample = at(ring, 0);
+    ring.released = sample.timestamp;
+    m_released.append(sample);
+    ring.head = (ring.head + 1) % m_capacity;
+    --ring.count;
+    --m_count;
+  }
+}
+
+void ReorderBuffer::deliver()
+{
+  if (m_released.isEmpty())
+    return;
+  m_statistics.released += quint64(m_released.size());
+  if (m_sink)
+    m_sink->consume(m_released.constData(), m_released.size());
+  // Since Qt 5.7, clear() keeps the capacity.
+  m_released.clear();
+}
+
+void ReorderBuffer::expire()
+{
+  // Release the samples of the entities that went quiet
+  const qint64 now = m_clock.elapsed();
+  const int held = m_count;
+  for (Ring &ring : m_rings) {
+    if (ring.count > 0 && now - ring.arrival >= m_delay)
+      release(ring, std::numeric_limits<qint64>::max());
+  }
+  deliver();
+  HeldCount().add(m_count - held);
+  expireRings(now);
+  if (m_count == 0)
+    timer->stop();
+}
+
+void ReorderBuffer::expireRings(qint64 now)
+{
+  // A sweep every quarter of the timeout
+  const qint64 timeout = qMax(m_idleTimeout, m_delay);
+  if (now < m_nextExpiry)
+    return;
+  m_nextExpiry = now + qMax<qint64>(1, timeout / 4);
+
+  // From the end, so that the ring moved into the place of a dropped
+  // one has been looked at already
+  for (int i = m_rings.size() - 1; i >= 0; --i) {
+    Ring const &ring = m_rings.at(i);
+    if (ring.count > 0 || now - ring.arrival < timeout)
+      continue;
+    m_indexes.remove(ring.id);
+    m_freeOffsets.append(ring.offset);
+    if (i != m_rings.size() - 1) {
+      m_rings[i] = m_rings.last();
+      m_indexes.insert(m_rings.at(i).id, i);
+    }
+    m_rings.removeLast();
+    ++m_statistics.expired;
+  }
+}
+
+void ReorderBuffer::flush()
+{
+  HeldCount().add(-m_count);
+  for (Ring &ring : m_rings)
+    release(ring, std::numeric_limits<qint64>::max());
+  deliver();
+  timer->stop();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "PositionSample.hpp"
+
+// Counters of a ReorderBuffer
+struct ReorderBufferStatistics
+{
+  quint64 received;         // samples received
+  quint64 released;         // samples released, in order
+  quint64 late;             // dropped: older than a sample already released
+  quint64 forced;           // released before their delay, the ring being full
+  quint64 expired;          // rings dropped after the idle timeout
+};
+
+// A ReorderBuffer puts the samples of each entity back in time order
+// after a network has shuffled them, so that a late sample does not
+// overwrite a newer position (and jerk whatever is pointed at the
+// entity back).
+//
+// The samples of each entity (by id) are held for a delay, in
+// milliseconds of their time stamps: a sample is released once a
+// sample at least that much newer has arrived, or once no sample has
+// arrived for that long (by the clock), whichever comes first.  The
+// samples are released to the sample sink in time stamp order.  A
+// sample that arrives after a newer one was released is too late and
+// is dropped.  The delay is the trade between the latency added and
+// the lateness tolerated; zero releases every sample at once and only
+// drops the ones that are out of order.
+//
+// Each entity has a ring of a fixed capacity, allocated once when
+// its first sample arrives.  When the ring is full, its oldest
+// sample is released early.  Samples mostly arrive in order, so
+// keeping a ring sorted costs little.
+//
+// The ring of an entity that has had no sample for the idle timeout
+// (by the clock, and at least the delay) is dropped once it is empty,
+// and its storage is given to the next new entity, so that a feed
+// whose ids come and go does not grow the buffer without bound.  A
+// sample of a dropped entity starts a new ring, and so is never late.
+//
+// Samples consumed from another thread are copied and queued to the
+// thread of the buffer.
+
+class ReorderBuffer : public QObject, public PositionSampleSink
+{
+  Q_OBJECT
+public:
+  ReorderBuffer(int delay = 200, int capacity = 64, QObject *parent = nullptr);
+  ~ReorderBuffer();
+
+  // The delay in milliseconds
+  int delay() const;
+  void setDelay(int msecs);
+
+  // The capacity of the ring of each entity
+  int capacity() const;
+
+  // The idle time in milliseconds after which the ring of an entity
+  // is dropped (60000 by default)
+  int idleTimeout() const;
+  void setIdleTimeout(int msecs);
+
+  // The released samples go to the sink, which is not owned.
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+  // The number of samples held
+  int count() const;
+  // The number of entities with a ring
+  int entityCount() const;
+
+  ReorderBufferStatistics statistics() const;
+
+  virtual void consume(PositionSample const *samples, int count);
+
+public slots:
+  // Release every sample held
+  void flush();
+
+private slots:
+  void expire();
+
+private:
+  struct Ring
+  {
+    quint64 id;
+    int offset;               // of the ring in the storage
+    int head;
+    int count;
+    qint64 newest;            // the newest time stamp received
+    qint64 released;          // the time stamp of the last sample released
+    qint64 arrival;           // the time of arrival of the newest sample, by the clock
+  };
+
+  void receive(PositionSample const *samples, int count);
+  void insert(Ring &ring, PositionSample const &sample);
+  void release(Ring &ring, qint64 watermark);
+  PositionSample &at(Ring const &ring, int index);
+  void deliver();
+  void expireRings(qint64 now);
+
+  int m_delay;
+  int m_capacity;
+  int m_idleTimeout;
+  PositionSampleSink *m_sink;
+  QVector<Ring> m_rings;
+  QHash<quint64, int> m_indexes;        // id to ring
+  QVector<PositionSample> m_storage;    // the rings, one after the other
+  QVector<int> m_freeOffsets;           // of the rings dropped
+  QVector<PositionSample> m_released;
+  int m_count;
+  QElapsedTimer m_clock;
+  qint64 m_nextExpiry;                  // of the rings, by the clock
+  QTimer *timer;
+  ReorderBufferStatistics m_statistics;
+};
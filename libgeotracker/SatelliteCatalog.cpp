@@ -0,0 +1,175 @@
+#include <QFile>
+#include <QtConcurrent>
+#include "SatelliteCatalog.hpp"
+#include "Trajectory.hpp"
+#include "VisibilityPredictor.hpp"
+
+// Satellites are propagated in blocks of this many per thread pool
+// task, which amortizes the cost of the task over enough work.
+static const int PropagationBlockSize = 256;
+
+SatelliteCatalog::SatelliteCatalog() :
+  m_time(0.0)
+{
+}
+
+bool SatelliteCatalog::load(QString const &fileName)
+{
+  // Nothing is kept of the previous catalog, or of its propagation
+  m_satellites.clear();
+  m_byCatalogNumber.clear();
+  m_byName.clear();
+  m_time = 0.0;
+  m_x.clear();
+  m_y.clear();
+  m_z.clear();
+  m_errors.clear();
+
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return false;
+
+  QByteArray name;
+  QByteArray line1;
+  while (!file.atEnd()) {
+    QByteArray line = file.readLine().trimmed();
+    if (line.isEmpty())
+      continue;
+    if (line.startsWith("1 ")) {
+      line1 = line;
+    } else if (line.startsWith("2 ") && !line1.isEmpty()) {
+      TwoLineElements elements;
+      if (elements.parse(line1, line)) {
+        elements.name = QString::fromLatin1(name);
+        append(elements);
+      }
+      line1.clear();
+      name.clear();
+    } else {
+      // A name line.  In the three line format, it is prefixed with
+      // a zero.
+      name = line.startsWith("0 ") ? line.mid(2).trimmed() : line;
+      line1.clear();
+    }
+  }
+  return true;
+}
+
+void SatelliteCatalog::append(TwoLineElements const &elements)
+{
+  const int index = m_satellites.size();
+  m_satellites.append(Sgp4(elements));
+  m_byCatalogNumber.insert(elements.catalogNumber, index);
+  if (!elements.name.isEmpty())
+    m_byName.insert(elements.name, index);
+}
+
+int SatelliteCatalog::count() const
+{
+  return m_satellites.size();
+}
+
+int SatelliteCatalog::indexOf(int catalogNumber) const
+{
+  return m_byCatalogNumber.value(catalogNumber, -1);
+}
+
+int SatelliteCatalog::indexOf(QString const &name) const
+{
+  return m_byName.value(name, -1);
+}
+
+TwoLineElements const &SatelliteCatalog::elements(int index) const
+{
+  return m_satellites.at(index).elements();
+}
+
+Sgp4 const &SatelliteCatalog::propagator(int index) const
+{
+  return m_satellites.at(index);
+}
+
+void SatelliteCatalog::propagateRange(int begin, int end)
+{
+  GeoPoint position;
+  for (int i = begin; i < end; ++i) {
+    m_errors[i] = m_satellites.at(i).positionAt(m_time, &position);
+    m_x[i] = position.x();
+    m_y[i] = position.y();
+    m_z[i] = position.z();
+  }
+}
+
+void SatelliteCatalog::propagate(QDateTime const &time)
+{
+  const int n = count();
+  m_time = time.toMSecsSinceEpoch();
+  m_x.resize(n);
+  m_y.resize(n);
+  m_z.resize(n);
+  m_errors.resize(n);
+
+  // Each task writes a disjoint block of the result arrays, so no
+  // locking is needed.
+  QVector<int> blocks;
+  for (int begin = 0; begin < n; begin += PropagationBlockSize)
+    blocks.append(begin);
+  QtConcurrent::blockingMap(blocks, [this, n](int begin) {
+      propagateRange(begin, qMin(begin + PropagationBlockSize, n));
+    });
+}
+
+QDateTime SatelliteCatalog::time() const
+{
+  return QDateTime::fromMSecsSinceEpoch(qint64(m_time), Qt::UTC);
+}
+
+Sgp4::Error SatelliteCatalog::error(int index) const
+{
+  return m_errors.at(index);
+}
+
+GeoPoint SatelliteCatalog::position(int index) const
+{
+  return GeoPoint(m_x.at(index), m_y.at(index), m_z.at(index));
+}
+
+QVector<double> const &SatelliteCatalog::x() const
+{
+  return m_x;
+}
+
+QVector<double> const &SatelliteCatalog::y() const
+{
+  return m_y;
+}
+
+QVector<double> const &SatelliteCatalog::z() const
+{
+  return m_z;
+}
+
+QVector<SatellitePass> SatelliteCatalog::predictPasses(int index,
+                                                       QGeoCoordinate const &observer,
+                                                       QDateTime const &start,
+                                                       QDateTime const &end,
+                                                       double minimumElevation,
+                                                       int step) const
+{
+  QVector<SatellitePass> passes;
+  Sgp4 const &satellite = m_satellites.at(index);
+  if (satellite.error() != Sgp4::NoError)
+    return passes;
+
+  VisibilityPredictor predictor(observer, minimumElevation);
+  predictor.setStep(step);
+  for (VisibilityWindow const &window : predictor.windows(SatelliteTrajectory(satellite), start, end)) {
+    SatellitePass pass;
+    pass.aos = window.rise;
+    pass.los = window.set;
+    pass.culmination = window.culmination;
+    pass.maxElevation = window.maxElevation;
+    passes.append(pass);
+  }
+  return passes;
+}
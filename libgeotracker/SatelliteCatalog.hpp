@@ -0,0 +1,93 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include "GeoPoint.hpp"
+#include "Sgp4.hpp"
+
+// A SatellitePass is an interval of time during which a satellite is
+// above an observer's elevation mask: from the acquisition of signal
+// (AOS) to the loss of signal (LOS).
+
+struct SatellitePass
+{
+  QDateTime aos;              // rise above the elevation mask
+  QDateTime los;              // set below the elevation mask
+  QDateTime culmination;      // time of the maximum elevation
+  double    maxElevation;     // degrees
+};
+
+// A SatelliteCatalog holds the orbital elements of many satellites
+// read from a local file of two line elements, such as those
+// published by CelesTrak.  Each element set may be preceded by a
+// name line.
+//
+// The whole catalog may be propagated to a common time in one call.
+// The propagation is split across the global thread pool and the
+// resulting Earth centered, Earth fixed positions are stored in
+// contiguous arrays (one per coordinate) so that later stages can
+// process them in bulk.
+//
+// Element sets that cannot be propagated (for instance deep space
+// objects, see Sgp4) are kept in the catalog and reported through
+// error().
+
+class SatelliteCatalog
+{
+public:
+  SatelliteCatalog();
+
+  // Read the catalog from a file, replacing the current contents and
+  // the results of the last propagate() call.  Returns false, with
+  // an empty catalog, if the file cannot be read.  Malformed element
+  // sets, truncated lines included, are skipped.
+  bool load(QString const &fileName);
+
+  // Add one element set to the catalog
+  void append(TwoLineElements const &elements);
+
+  int count() const;
+  int indexOf(int catalogNumber) const;
+  int indexOf(QString const &name) const;
+  TwoLineElements const &elements(int index) const;
+  Sgp4 const &propagator(int index) const;
+
+  // Propagate every satellite in the catalog to the given time.
+  void propagate(QDateTime const &time);
+
+  // The results of the last propagate() call
+  QDateTime time() const;
+  Sgp4::Error error(int index) const;
+  GeoPoint position(int index) const;
+  QVector<double> const &x() const;   // meters, ECEF
+  QVector<double> const &y() const;
+  QVector<double> const &z() const;
+
+  // Predict the passes of a satellite over an observer between two
+  // times (see VisibilityPredictor).  The step is the interval in
+  // seconds between coarse samples of the elevation, which must be
+  // shorter than the time between the culmination of one pass and
+  // the next.
+  QVector<SatellitePass> predictPasses(int index,
+                                       QGeoCoordinate const &observer,
+                                       QDateTime const &start,
+                                       QDateTime const &end,
+                                       double minimumElevation = 0.0,
+                                       int step = 30) const;
+
+private:
+  void propagateRange(int begin, int end);
+
+  QVector<Sgp4>       m_satellites;
+  QHash<int, int>     m_byCatalogNumber;
+  QHash<QString, int> m_byName;
+
+  double              m_time;     // milliseconds since 1970
+  QVector<double>     m_x;
+  QVector<double>     m_y;
+  QVector<double>     m_z;
+  QVector<Sgp4::Error> m_errors;
+};
@@ -0,0 +1,434 @@
+// The propagator is a transcription of the near earth branch of
+// Vallado's public domain sgp4unit.cpp, which accompanies "Revisiting
+// Spacetrack Report #3" (AIAA 2006-6753).  The variable names follow
+// that code to make it easy to compare against.
+
+#include <QtMath>
+#include <QDate>
+#include "Sgp4.hpp"
+
+// WGS72 constants: the elements are fitted using these.
+static const double EarthRadiusKm  = 6378.135;
+static const double Mu             = 398600.8;  // km^3/s^2
+static const double J2             = 0.001082616;
+static const double J3             = -0.00000253881;
+static const double J4             = -0.00000165597;
+static const double J3oJ2          = J3 / J2;
+static const double TwoThirds      = 2.0 / 3.0;
+static const double TwoPi          = 2.0 * M_PI;
+static const double MsecsPerDay    = 86400000.0;
+static const double JulianDayOfUnixEpoch = 2440587.5;
+
+static
+double Xke()
+{
+  // sqrt(mu) in earth radii^1.5 per minute
+  return 60.0 / qSqrt(EarthRadiusKm * EarthRadiusKm * EarthRadiusKm / Mu);
+}
+
+static
+double TleDouble(QByteArray const &field, bool *ok)
+{
+  return field.trimmed().toDouble(ok);
+}
+
+static
+double TleExponential(QByteArray const &field, bool *ok)
+{
+  // An implied decimal point with a trailing exponent, e.g.
+  // " 28098-4" is 0.28098e-4 and "-11606-4" is -0.11606e-4.
+  QByteArray f = field.trimmed();
+  if (f.isEmpty()) {
+    *ok = true;
+    return 0.0;
+  }
+  double sign = 1.0;
+  if (f.startsWith('-') || f.startsWith('+')) {
+    if (f.startsWith('-'))
+      sign = -1.0;
+    f = f.mid(1);
+  }
+  int exponent = f.size();
+  while (exponent > 0 && f.at(exponent - 1) != '-' && f.at(exponent - 1) != '+')
+    --exponent;
+  if (exponent == 0)
+    return sign * ("0." + f).toDouble(ok);
+  QByteArray mantissa = "0." + f.left(exponent - 1) + "e" + f.mid(exponent - 1);
+  return sign * mantissa.toDouble(ok);
+}
+
+static
+bool TleChecksum(QByteArray const &line)
+{
+  // The last column is the sum of the digits in the line (minus signs
+  // count as one) modulo 10.  A truncated line has none.
+  if (line.size() < 69)
+    return false;
+  int sum = 0;
+  for (int i = 0; i < 68; ++i) {
+    const char c = line.at(i);
+    if (c >= '0' && c <= '9')
+      sum += c - '0';
+    else if (c == '-')
+      sum += 1;
+  }
+  return (sum % 10) == (line.at(68) - '0');
+}
+
+bool TwoLineElements::parse(QByteArray const &l1, QByteArray const &l2)
+{
+  QByteArray line1 = l1.trimmed();
+  QByteArray line2 = l2.trimmed();
+  if (line1.size() < 63 || line2.size() < 63)
+    return false;
+  if (!line1.startsWith("1 ") || !line2.startsWith("2 "))
+    return false;
+  if (!TleChecksum(line1) || !TleChecksum(line2))
+    return false;
+
+  bool ok[9];
+  catalogNumber = line1.mid(2, 5).trimmed().toInt(&ok[0]);
+  const int year = line1.mid(18, 2).toInt(&ok[1]);
+  const double day = TleDouble(line1.mid(20, 12), &ok[2]);
+  bstar = TleExponential(line1.mid(53, 8), &ok[3]);
+  inclination = qDegreesToRadians(TleDouble(line2.mid(8, 8), &ok[4]));
+  rightAscension = qDegreesToRadians(TleDouble(line2.mid(17, 8), &ok[5]));
+  eccentricity = ("0." + line2.mid(26, 7).trimmed()).toDouble(&ok[6]);
+  argumentOfPerigee = qDegreesToRadians(TleDouble(line2.mid(34, 8), &ok[7]));
+  meanAnomaly = qDegreesToRadians(TleDouble(line2.mid(43, 8), &ok[8]));
+  bool hasMeanMotion;
+  meanMotion = TleDouble(line2.mid(52, 11), &hasMeanMotion) * TwoPi / 1440.0;
+  for (int i = 0; i < 9; ++i)
+    if (!ok[i])
+      return false;
+  if (!hasMeanMotion)
+    return false;
+
+  // Two digit years from 57 onward are in the 1900s (Sputnik).
+  const int fullYear = year < 57 ? 2000 + year : 1900 + year;
+  const qint64 days = QDate(fullYear, 1, 1).toJulianDay() - QDate(1970, 1, 1).toJulianDay();
+  epoch = (days + day - 1.0) * MsecsPerDay;
+  return true;
+}
+
+Sgp4::Sgp4() :
+  m_error(ElementsError)
+{
+}
+
+Sgp4::Sgp4(TwoLineElements const &elements)
+{
+  setElements(elements);
+}
+
+TwoLineElements const &Sgp4::elements() const
+{
+  return m_elements;
+}
+
+Sgp4::Error Sgp4::error() const
+{
+  return m_error;
+}
+
+Sgp4::Error Sgp4::setElements(TwoLineElements const &elements)
+{
+  m_elements = elements;
+  m_error = NoError;
+
+  const double ecco   = elements.eccentricity;
+  const double inclo  = elements.inclination;
+  const double argpo  = elements.argumentOfPerigee;
+  const double mo     = elements.meanAnomaly;
+  const double bstar  = elements.bstar;
+  const double xke    = Xke();
+  const double ss     = 78.0 / EarthRadiusKm + 1.0;
+  const double qzms2t = qPow((120.0 - 78.0) / EarthRadiusKm, 4);
+
+  if (elements.meanMotion <= 0.0 || ecco < 0.0 || ecco >= 1.0) {
+    m_error = ElementsError;
+    return m_error;
+  }
+
+  // initl: recover the original mean motion (un-Kozai) and semi-major
+  // axis from the input elements.
+  const double eccsq  = ecco * ecco;
+  const double omeosq = 1.0 - eccsq;
+  const double rteosq = qSqrt(omeosq);
+  const double cosio  = qCos(inclo);
+  const double cosio2 = cosio * cosio;
+  const double ak     = qPow(xke / elements.meanMotion, TwoThirds);
+  const double d1     = 0.75 * J2 * (3.0 * cosio2 - 1.0) / (rteosq * omeosq);
+  double del          = d1 / (ak * ak);
+  const double adel   = ak * (1.0 - del * del - del * (1.0 / 3.0 + 134.0 * del * del / 81.0));
+  del                 = d1 / (adel * adel);
+  m_meanMotion        = elements.meanMotion / (1.0 + del);
+  const double ao     = qPow(xke / m_meanMotion, TwoThirds);
+  const double sinio  = qSin(inclo);
+  const double po     = ao * omeosq;
+  const double con42  = 1.0 - 5.0 * cosio2;
+  m_con41             = -con42 - cosio2 - cosio2;
+  const double posq   = po * po;
+  const double rp     = ao * (1.0 - ecco);
+
+  if (TwoPi / m_meanMotion >= 225.0) {
+    m_error = DeepSpaceError;
+    return m_error;
+  }
+
+  // Satellites with a perigee below 220 km use a truncated drag model.
+  m_isSimple = rp < (220.0 / EarthRadiusKm + 1.0);
+
+  // For perigees below 156 km, the atmospheric density parameters
+  // are adjusted.
+  double sfour = ss;
+  double qzms24 = qzms2t;
+  const double perige = (rp - 1.0) * EarthRadiusKm;
+  if (perige < 156.0) {
+    sfour = perige - 78.0;
+    if (perige < 98.0)
+      sfour = 20.0;
+    qzms24 = qPow((120.0 - sfour) / EarthRadiusKm, 4);
+    sfour = sfour / EarthRadiusKm + 1.0;
+  }
+
+  const double pinvsq = 1.0 / posq;
+  const double tsi    = 1.0 / (ao - sfour);
+  m_eta               = ao * ecco * tsi;
+  const double etasq  = m_eta * m_eta;
+  const double eeta   = ecco * m_eta;
+  const double psisq  = qFabs(1.0 - etasq);
+  const double coef   = qzms24 * qPow(tsi, 4);
+  const double coef1  = coef / qPow(psisq, 3.5);
+  const double cc2    = coef1 * m_meanMotion *
+    (ao * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) +
+     0.375 * J2 * tsi / psisq * m_con41 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+  m_cc1               = bstar * cc2;
+  double cc3          = 0.0;
+  if (ecco > 1.0e-4)
+    cc3 = -2.0 * coef * tsi * J3oJ2 * m_meanMotion * sinio / ecco;
+  m_x1mth2            = 1.0 - cosio2;
+  m_cc4               = 2.0 * m_meanMotion * coef1 * ao * omeosq *
+    (m_eta * (2.0 + 0.5 * etasq) + ecco * (0.5 + 2.0 * etasq) -
+     J2 * tsi / (ao * psisq) *
+     (-3.0 * m_con41 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) +
+      0.75 * m_x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * qCos(2.0 * argpo)));
+  m_cc5               = 2.0 * coef1 * ao * omeosq * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+  const double cosio4 = cosio2 * cosio2;
+  const double temp1  = 1.5 * J2 * pinvsq * m_meanMotion;
+  const double temp2  = 0.5 * temp1 * J2 * pinvsq;
+  const double temp3  = -0.46875 * J4 * pinvsq * pinvsq * m_meanMotion;
+  m_mdot              = m_meanMotion + 0.5 * temp1 * rteosq * m_con41 +
+    0.0625 * temp2 * rteosq * (13.0 - 78.0 * cosio2 + 137.0 * cosio4);
+  m_argpdot           = -0.5 * temp1 * con42 + 0.0625 * temp2 * (7.0 - 114.0 * cosio2 + 395.0 * cosio4) +
+    temp3 * (3.0 - 36.0 * cosio2 + 49.0 * cosio4);
+  const double xhdot1 = -temp1 * cosio;
+  m_nodedot           = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * cosio2) + 2.0 * temp3 * (3.0 - 7.0 * cosio2)) * cosio;
+  m_omgcof            = bstar * cc3 * qCos(argpo);
+  m_xmcof             = 0.0;
+  if (ecco > 1.0e-4)
+    m_xmcof = -TwoThirds * coef * bstar / eeta;
+  m_nodecf            = 3.5 * omeosq * xhdot1 * m_cc1;
+  m_t2cof             = 1.5 * m_cc1;
+
+  // Avoid a division by zero for an inclination of 180 degrees.
+  if (qFabs(cosio + 1.0) > 1.5e-12)
+    m_xlcof = -0.25 * J3oJ2 * sinio * (3.0 + 5.0 * cosio) / (1.0 + cosio);
+  else
+    m_xlcof = -0.25 * J3oJ2 * sinio * (3.0 + 5.0 * cosio) / 1.5e-12;
+  m_aycof             = -0.5 * J3oJ2 * sinio;
+  const double delmotemp = 1.0 + m_eta * qCos(mo);
+  m_delmo             = delmotemp * delmotemp * delmotemp;
+  m_sinmao            = qSin(mo);
+  m_x7thm1            = 7.0 * cosio2 - 1.0;
+
+  m_d2 = m_d3 = m_d4 = m_t3cof = m_t4cof = m_t5cof = 0.0;
+  if (!m_isSimple) {
+    const double cc1sq = m_cc1 * m_cc1;
+    m_d2               = 4.0 * ao * tsi * cc1sq;
+    const double temp  = m_d2 * tsi * m_cc1 / 3.0;
+    m_d3               = (17.0 * ao + sfour) * temp;
+    m_d4               = 0.5 * temp * ao * tsi * (221.0 * ao + 31.0 * sfour) * m_cc1;
+    m_t3cof            = m_d2 + 2.0 * cc1sq;
+    m_t4cof            = 0.25 * (3.0 * m_d3 + m_cc1 * (12.0 * m_d2 + 10.0 * cc1sq));
+    m_t5cof            = 0.2 * (3.0 * m_d4 + 12.0 * m_cc1 * m_d3 + 6.0 * m_d2 * m_d2 +
+                                15.0 * cc1sq * (2.0 * m_d2 + cc1sq));
+  }
+
+  return m_error;
+}
+
+Sgp4::Error Sgp4::propagate(double t, double r[3], double v[3]) const
+{
+  if (m_error != NoError)
+    return m_error;
+
+  const double xke = Xke();
+  const double bstar = m_elements.bstar;
+
+  // Update for secular gravity and atmospheric drag.
+  const double xmdf   = m_elements.meanAnomaly + m_mdot * t;
+  const double argpdf = m_elements.argumentOfPerigee + m_argpdot * t;
+  const double nodedf = m_elements.rightAscension + m_nodedot * t;
+  double argpm        = argpdf;
+  double mm           = xmdf;
+  const double t2     = t * t;
+  double nodem        = nodedf + m_nodecf * t2;
+  double tempa        = 1.0 - m_cc1 * t;
+  double tempe        = bstar * m_cc4 * t;
+  double templ        = m_t2cof * t2;
+
+  if (!m_isSimple) {
+    const double delomg   = m_omgcof * t;
+    const double delmtemp = 1.0 + m_eta * qCos(xmdf);
+    const double delm     = m_xmcof * (delmtemp * delmtemp * delmtemp - m_delmo);
+    const double temp     = delomg + delm;
+    mm                    = xmdf + temp;
+    argpm                 = argpdf - temp;
+    const double t3       = t2 * t;
+    const double t4       = t3 * t;
+    tempa                 = tempa - m_d2 * t2 - m_d3 * t3 - m_d4 * t4;
+    tempe                 = tempe + bstar * m_cc5 * (qSin(mm) - m_sinmao);
+    templ                 = templ + m_t3cof * t3 + t4 * (m_t4cof + t * m_t5cof);
+  }
+
+  double nm   = m_meanMotion;
+  double em   = m_elements.eccentricity;
+  const double inclm = m_elements.inclination;
+  if (nm <= 0.0)
+    return MeanMotionError;
+
+  const double am = qPow(xke / nm, TwoThirds) * tempa * tempa;
+  nm = xke / qPow(am, 1.5);
+  em = em - tempe;
+  if (em >= 1.0 || em < -0.001)
+    return EccentricityError;
+  if (em < 1.0e-6)
+    em = 1.0e-6;
+  mm = mm + m_meanMotion * templ;
+  double xlm = mm + argpm + nodem;
+
+  nodem = fmod(nodem, TwoPi);
+  argpm = fmod(argpm, TwoPi);
+  xlm   = fmod(xlm, TwoPi);
+  mm    = fmod(xlm - argpm - nodem, TwoPi);
+
+  const double sinip = qSin(inclm);
+  const double cosip = qCos(inclm);
+
+  // Long period periodics
+  const double axnl = em * qCos(argpm);
+  double temp       = 1.0 / (am * (1.0 - em * em));
+  const double aynl = em * qSin(argpm) + temp * m_aycof;
+  const double xl   = mm + argpm + nodem + temp * m_xlcof * axnl;
+
+  // Solve Kepler's equation
+  const double u = fmod(xl - nodem, TwoPi);
+  double eo1 = u;
+  double tem5 = 9999.9;
+  double sineo1 = 0.0, coseo1 = 0.0;
+  for (int ktr = 1; qFabs(tem5) >= 1.0e-12 && ktr <= 10; ++ktr) {
+    sineo1 = qSin(eo1);
+    coseo1 = qCos(eo1);
+    tem5   = 1.0 - coseo1 * axnl - sineo1 * aynl;
+    tem5   = (u - aynl * coseo1 + axnl * sineo1 - eo1) / tem5;
+    if (qFabs(tem5) >= 0.95)
+      tem5 = tem5 > 0.0 ? 0.95 : -0.95;
+    eo1 = eo1 + tem5;
+  }
+
+  // Short period preliminary quantities
+  const double ecose = axnl * coseo1 + aynl * sineo1;
+  const double esine = axnl * sineo1 - aynl * coseo1;
+  const double el2   = axnl * axnl + aynl * aynl;
+  const double pl    = am * (1.0 - el2);
+  if (pl < 0.0)
+    return SemiLatusRectumError;
+
+  const double rl     = am * (1.0 - ecose);
+  const double rdotl  = qSqrt(am) * esine / rl;
+  const double rvdotl = qSqrt(pl) / rl;
+  const double betal  = qSqrt(1.0 - el2);
+  temp                = esine / (1.0 + betal);
+  const double sinu   = am / rl * (sineo1 - aynl - axnl * temp);
+  const double cosu   = am / rl * (coseo1 - axnl + aynl * temp);
+  double su           = qAtan2(sinu, cosu);
+  const double sin2u  = (cosu + cosu) * sinu;
+  const double cos2u  = 1.0 - 2.0 * sinu * sinu;
+  temp                = 1.0 / pl;
+  const double temp1  = 0.5 * J2 * temp;
+  const double temp2  = temp1 * temp;
+
+  // Update for short period periodics
+  const double mrt   = rl * (1.0 - 1.5 * temp2 * betal * m_con41) + 0.5 * temp1 * m_x1mth2 * cos2u;
+  su                 = su - 0.25 * temp2 * m_x7thm1 * sin2u;
+  const double xnode = nodem + 1.5 * temp2 * cosip * sin2u;
+  const double xinc  = inclm + 1.5 * temp2 * cosip * sinip * cos2u;
+  const double mvt   = rdotl - nm * temp1 * m_x1mth2 * sin2u / xke;
+  const double rvdot = rvdotl + nm * temp1 * (m_x1mth2 * cos2u + 1.5 * m_con41) / xke;
+
+  // Orientation vectors
+  const double sinsu = qSin(su);
+  const double cossu = qCos(su);
+  const double snod  = qSin(xnode);
+  const double cnod  = qCos(xnode);
+  const double sini  = qSin(xinc);
+  const double cosi  = qCos(xinc);
+  const double xmx   = -snod * cosi;
+  const double xmy   = cnod * cosi;
+  const double ux    = xmx * sinsu + cnod * cossu;
+  const double uy    = xmy * sinsu + snod * cossu;
+  const double uz    = sini * sinsu;
+  const double vx    = xmx * cossu - cnod * sinsu;
+  const double vy    = xmy * cossu - snod * sinsu;
+  const double vz    = sini * cossu;
+
+  // Position and velocity in km and km/s
+  const double vkmpersec = EarthRadiusKm * xke / 60.0;
+  r[0] = mrt * ux * EarthRadiusKm;
+  r[1] = mrt * uy * EarthRadiusKm;
+  r[2] = mrt * uz * EarthRadiusKm;
+  v[0] = (mvt * ux + rvdot * vx) * vkmpersec;
+  v[1] = (mvt * uy + rvdot * vy) * vkmpersec;
+  v[2] = (mvt * uz + rvdot * vz) * vkmpersec;
+
+  if (mrt < 1.0)
+    return DecayedError;
+  return NoError;
+}
+
+double Sgp4::greenwichSiderealTime(double msecsSinceEpoch)
+{
+  const double jdut1 = msecsSinceEpoch / MsecsPerDay + JulianDayOfUnixEpoch;
+  const double tut1 = (jdut1 - 2451545.0) / 36525.0;
+  double seconds = -6.2e-6 * tut1 * tut1 * tut1 + 0.093104 * tut1 * tut1 +
+    (876600.0 * 3600.0 + 8640184.812866) * tut1 + 67310.54841;
+  double gmst = fmod(qDegreesToRadians(seconds / 240.0), TwoPi);
+  if (gmst < 0.0)
+    gmst += TwoPi;
+  return gmst;
+}
+
+Sgp4::Error Sgp4::positionAt(double msecsSinceEpoch, GeoPoint *ecef) const
+{
+  double r[3], v[3];
+  const Error error = propagate((msecsSinceEpoch - m_elements.epoch) / 60000.0, r, v);
+  if (error != NoError)
+    return error;
+
+  // Rotate from TEME to the pseudo earth fixed frame about the z axis
+  // by the sidereal angle.
+  const double gmst = greenwichSiderealTime(msecsSinceEpoch);
+  const double c = qCos(gmst);
+  const double s = qSin(gmst);
+  if (ecef)
+    ecef->set(1000.0 * ( c * r[0] + s * r[1]),
+              1000.0 * (-s * r[0] + c * r[1]),
+              1000.0 * r[2]);
+  return NoError;
+}
+
+Sgp4::Error Sgp4::positionAt(QDateTime const &time, GeoPoint *ecef) const
+{
+  return positionAt(double(time.toMSecsSinceEpoch()), ecef);
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include "GeoPoint.hpp"
+
+// A TwoLineElements object holds the mean orbital elements of a
+// satellite as published by NORAD in the two line element (TLE)
+// format.  Here is an example, with an optional name line:
+//
+// ISS (ZARYA)
+// 1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927
+// 2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537
+//
+// The elements are only meaningful to the SGP4 propagator, which was
+// used to fit them.
+
+struct TwoLineElements
+{
+  QString name;            // satellite name, or empty
+  int     catalogNumber;   // NORAD catalog number
+  double  epoch;           // milliseconds since 1970-01-01T00:00:00 UTC
+  double  bstar;           // drag term, 1/earth radii
+  double  inclination;     // radians
+  double  rightAscension;  // right ascension of the ascending node, radians
+  double  eccentricity;
+  double  argumentOfPerigee; // radians
+  double  meanAnomaly;     // radians
+  double  meanMotion;      // radians per minute
+
+  // Parse the two element lines.  Returns false if either line is
+  // malformed or fails its checksum.
+  bool parse(QByteArray const &line1, QByteArray const &line2);
+};
+
+// The Sgp4 class propagates a satellite's two line elements to its
+// position and velocity at a given time.  This is the SGP4 model of
+// Spacetrack Report #3 as revised by Vallado, Crawford, Hujsak and
+// Kelso in "Revisiting Spacetrack Report #3" (AIAA 2006-6753), using
+// the WGS72 constants with which the elements are generated.
+//
+// Only the near earth model (orbital periods of less than 225
+// minutes) is implemented.  The deep space (SDP4) lunar and solar
+// perturbations are not, and the elements of deep space satellites
+// are rejected with the DeepSpaceError.
+//
+// The propagator produces positions in the True Equator, Mean
+// Equinox (TEME) frame, which are then rotated by the Greenwich mean
+// sidereal time into the Earth centered, Earth fixed frame used by
+// GeoPoint.  Polar motion is neglected; it amounts to a few meters.
+
+class Sgp4
+{
+public:
+  enum Error {
+    NoError = 0,
+    EccentricityError,   // mean eccentricity out of range
+    MeanMotionError,     // mean motion less than zero
+    SemiLatusRectumError,// semi-latus rectum less than zero
+    DecayedError,        // the satellite has decayed
+    DeepSpaceError,      // deep space elements are not supported
+    ElementsError        // the elements are invalid
+  };
+
+  Sgp4();
+  Sgp4(TwoLineElements const &elements);
+
+  // (Re)initialize the propagator from the elements.
+  Error setElements(TwoLineElements const &elements);
+  TwoLineElements const &elements() const;
+  Error error() const;
+
+  // Propagate to the given number of minutes since the element
+  // epoch.  The position (km) and velocity (km/s) are in the TEME
+  // frame.
+  Error propagate(double minutes, double position[3], double velocity[3]) const;
+
+  // Propagate to the given time, in milliseconds since 1970, and
+  // return the position in the Earth centered, Earth fixed frame in
+  // meters.
+  Error positionAt(double msecsSinceEpoch, GeoPoint *ecef) const;
+  Error positionAt(QDateTime const &time, GeoPoint *ecef) const;
+
+  // The Greenwich mean sidereal time in radians (IAU 1982) at the
+  // given time in milliseconds since 1970.
+  static double greenwichSiderealTime(double msecsSinceEpoch);
+
+private:
+  TwoLineElements m_elements;
+  Error           m_error;
+  bool            m_isSimple;  // perigee below 220 km: truncated drag terms
+
+  // Quantities derived from the elements by the initialization
+  double m_meanMotion;         // un-Kozai'd mean motion, radians per minute
+  double m_aycof, m_con41, m_cc1, m_cc4, m_cc5, m_d2, m_d3, m_d4;
+  double m_delmo, m_eta, m_argpdot, m_omgcof, m_sinmao, m_t2cof;
+  double m_t3cof, m_t4cof, m_t5cof, m_x1mth2, m_x7thm1, m_mdot;
+  double m_nodedot, m_xlcof, m_xmcof, m_nodecf;
+};
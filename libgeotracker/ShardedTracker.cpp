@@ -0,0 +1,378 @@
+#include <QThread>
+#include <QHash>
+#include <QGeoCoordinate>
+#include "ShardedTracker.hpp"
+#include "EntityPool.hpp"
+#include "GeoEntity.hpp"
+#include "GeoEntityDispatcher.hpp"
+#include "LookAngle.hpp"
+#include "Metrics.hpp"
+
+// The look angles gathered from an outbox at once
+static const int GatherBatchSize = 4096;
+
+// The metrics of all the sharded trackers
+static
+MetricCounter &LookAngleCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_shard_look_angles_total",
+                                                            "Look angles computed by the shards of the sharded trackers.");
+  return *counter;
+}
+
+static
+MetricCounter &DroppedCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_shard_dropped_look_angles_total",
+                                                            "Look angles dropped by the shards, their outbox being full.");
+  return *counter;
+}
+
+EntityLookAngleSink::~EntityLookAngleSink()
+{
+}
+
+LookAngleOutbox::LookAngleOutbox(int capacity) :
+  m_head(0),
+  m_tail(0)
+{
+  int size = 1;
+  while (size < capacity)
+    size <<= 1;
+  m_ring.resize(size);
+  m_data = m_ring.data();
+  m_mask = quint64(size - 1);
+}
+
+int LookAngleOutbox::capacity() const
+{
+  return m_ring.size();
+}
+
+int LookAngleOutbox::push(EntityLookAngle const *lookAngles, int count)
+{
+  const quint64 head = m_head.loadRelaxed();
+  const quint64 free = quint64(m_ring.size()) - (head - m_tail.loadAcquire());
+  const int n = int(qMin(quint64(qMax(0, count)), free));
+  for (int i = 0; i < n; ++i)
+    m_data[(head + quint64(i)) & m_mask] = lookAngles[i];
+  m_head.storeRelease(head + quint64(n));
+  return n;
+}
+
+int LookAngleOutbox::pop(EntityLookAngle *lookAngles, int count)
+{
+  const quint64 tail = m_tail.loadRelaxed();
+  const quint64 waiting = m_head.loadAcquire() - tail;
+  const int n = int(qMin(quint64(qMax(0, count)), waiting));
+  for (int i = 0; i < n; ++i)
+    lookAngles[i] = m_data[(tail + quint64(i)) & m_mask];
+  m_tail.storeRelease(tail + quint64(n));
+  return n;
+}
+
+// A shard of a ShardedTracker, which lives in a thread of its own.
+// Only the outbox and the counters are used from other threads.
+
+class TrackerShard : public QObject
+{
+public:
+  TrackerShard(ShardedTracker *tracker) :
+    m_delivered(0),
+    m_tracker(tracker),
+    dispatcher(new GeoEntityDispatcher(this)),
+    m_hasObserver(false),
+    m_samples(0),
+    m_lookAngles(0),
+    m_dropped(0)
+  {
+    dispatcher->setPool(&m_pool);
+  }
+
+  void process(QVector<PositionSample> const &samples)
+  {
+    m_samples.fetchAndAddRelaxed(quint64(samples.size()));
+    dispatcher->consume(samples.constData(), samples.size());
+    if (!m_hasObserver)
+      return;
+
+    // The valid samples, by component, for the batch of LookAngleFrame
+    const int size = samples.size();
+    m_results.resize(size);
+    m_latitude.resize(size);
+    m_longitude.resize(size);
+    m_altitude.resize(size);
+    int count = 0;
+    for (PositionSample const &sample : samples) {
+      if (!sample.isValid())
+        continue;
+      EntityLookAngle &result = m_results[count];
+      result.id = sample.id;
+      result.timestamp = sample.timestamp;
+      m_latitude[count] = sample.latitude;
+      m_longitude[count] = sample.longitude;
+      m_altitude[count] = sample.altitude;
+      ++count;
+    }
+    if (count == 0)
+      return;
+    m_azimuth.fill(0.0f, count);
+    m_elevation.resize(count);
+    m_range.resize(count);
+    m_frame.lookAngles(count, m_latitude.constData(), m_longitude.constData(), m_altitude.constData(),
+                       m_azimuth.data(), m_elevation.data(), m_range.data());
+    m_refraction.apply(m_elevation.data(), m_range.constData(), count);
+    for (int i = 0; i < count; ++i) {
+      m_results[i].azimuth = m_azimuth.at(i);
+      m_results[i].elevation = m_elevation.at(i);
+    }
+    const int pushed = outbox.push(m_results.constData(), count);
+    m_lookAngles.fetchAndAddRelaxed(quint64(count));
+    LookAngleCount().add(quint64(count));
+    if (pushed < count) {
+      m_dropped.fetchAndAddRelaxed(quint64(count - pushed));
+      DroppedCount().add(quint64(count - pushed));
+    }
+    if (pushed > 0)
+      m_tracker->requestGather();
+  }
+
+  void setObserver(QGeoCoordinate const &observer)
+  {
+    m_observer = observer;
+    m_hasObserver = observer.isValid();
+    if (m_hasObserver)
+      m_frame = LookAngleFrame::at(observer);
+  }
+
+  void setRefraction(Refraction const &refraction)
+  {
+    m_refraction = refraction;
+  }
+
+  // Route an id to an entity, which has been moved to this thread,
+  // or to none, moving the previous one back home.
+  void setEntity(quint64 id, GeoEntity *entity, QThread *home)
+  {
+    GeoEntity *previous = m_entities.value(id);
+    if (previous == entity)
+      return;
+    if (previous) {
+      dispatcher->setEntity(id, nullptr);
+      m_entities.remove(id);
+      previous->moveToThread(home);
+    }
+    if (entity) {
+      m_entities.insert(id, entity);
+      dispatcher->setEntity(id, entity);
+    }
+  }
+
+  void releaseEntities(QThread *home)
+  {
+    for (auto i = m_entities.constBegin(); i != m_entities.constEnd(); ++i) {
+      dispatcher->setEntity(i.key(), nullptr);
+      i.value()->moveToThread(home);
+    }
+    m_entities.clear();
+  }
+
+  ShardedTrackerStatistics statistics() const
+  {
+    ShardedTrackerStatistics statistics;
+    statistics.samples = m_samples.loadRelaxed();
+    statistics.lookAngles = m_lookAngles.loadRelaxed();
+    statistics.dropped = m_dropped.loadRelaxed();
+    statistics.delivered = m_delivered.loadRelaxed();
+    return statistics;
+  }
+
+  LookAngleOutbox outbox;
+  QAtomicInteger<quint64> m_delivered;    // by the thread of the tracker
+
+private:
+  ShardedTracker *m_tracker;
+  GeoEntityDispatcher *dispatcher;
+  EntityPool m_pool;
+  QHash<quint64, GeoEntity *> m_entities;
+  QGeoCoordinate m_observer;
+  LookAngleFrame m_frame;
+  bool m_hasObserver;
+  Refraction m_refraction;
+  QVector<EntityLookAngle> m_results;
+  QVector<double> m_latitude, m_longitude, m_altitude;
+  QVector<float> m_azimuth, m_elevation;
+  QVector<double> m_range;
+  QAtomicInteger<quint64> m_samples;
+  QAtomicInteger<quint64> m_lookAngles;
+  QAtomicInteger<quint64> m_dropped;
+};
+
+ShardedTracker::ShardedTracker(int shardCount, QObject *parent) :
+  QObject(parent),
+  m_sink(nullptr),
+  m_isGatherPending(0)
+{
+  const int count = shardCount > 0 ? shardCount : qMax(1, QThread::idealThreadCount());
+  for (int i = 0; i < count; ++i) {
+    QThread *thread = new QThread;
+    thread->setObjectName(QString("TrackerShard%1").arg(i));
+    TrackerShard *shard = new TrackerShard(this);
+    shard->moveToThread(thread);
+    thread->start();
+    threads.append(thread);
+    m_shards.append(shard);
+  }
+  m_gathered.resize(GatherBatchSize);
+}
+
+ShardedTracker::~ShardedTracker()
+{
+  QThread *home = thread();
+  for (int i = 0; i < m_shards.size(); ++i) {
+    TrackerShard *shard = m_shards.at(i);
+    // Delete the shard in its own thread, where its dispatcher lives,
+    // once its entities are moved back.
+    QMetaObject::invokeMethod(shard, [shard, home]() {
+        shard->releaseEntities(home);
+        delete shard;
+      }, Qt::BlockingQueuedConnection);
+    threads.at(i)->quit();
+    threads.at(i)->wait();
+    delete threads.at(i);
+  }
+}
+
+int ShardedTracker::shardCount() const
+{
+  return m_shards.size();
+}
+
+int ShardedTracker::shardOf(quint64 id) const
+{
+  // Fibonacci hashing, so that runs of ids are spread evenly
+  return int(((id * Q_UINT64_C(0x9e3779b97f4a7c15)) >> 32) % quint64(m_shards.size()));
+}
+
+QGeoPositionInfo ShardedTracker::observerPosition() const
+{
+  return m_observerPosition;
+}
+
+Refraction ShardedTracker::refraction() const
+{
+  return m_refraction;
+}
+
+void ShardedTracker::setRefraction(Refraction const &refraction)
+{
+  m_refraction = refraction;
+  for (TrackerShard *shard : m_shards) {
+    QMetaObject::invokeMethod(shard, [shard, refraction]() {
+        shard->setRefraction(refraction);
+      }, Qt::QueuedConnection);
+  }
+}
+
+void ShardedTracker::setEntity(quint64 id, GeoEntity *entity)
+{
+  TrackerShard *shard = m_shards.at(shardOf(id));
+  QThread *home = thread();
+  if (entity)
+    entity->moveToThread(shard->thread());
+  QMetaObject::invokeMethod(shard, [shard, id, entity, home]() {
+      shard->setEntity(id, entity, home);
+    }, Qt::BlockingQueuedConnection);
+}
+
+EntityLookAngleSink *ShardedTracker::lookAngleSink() const
+{
+  return m_sink;
+}
+
+void ShardedTracker::setLookAngleSink(EntityLookAngleSink *sink)
+{
+  m_sink = sink;
+}
+
+ShardedTrackerStatistics ShardedTracker::statistics() const
+{
+  ShardedTrackerStatistics total = { 0, 0, 0, 0 };
+  for (TrackerShard const *shard : m_shards) {
+    const ShardedTrackerStatistics statistics = shard->statistics();
+    total.samples += statistics.samples;
+    total.lookAngles += statistics.lookAngles;
+    total.dropped += statistics.dropped;
+    total.delivered += statistics.delivered;
+  }
+  return total;
+}
+
+ShardedTrackerStatistics ShardedTracker::statistics(int shard) const
+{
+  return m_shards.at(shard)->statistics();
+}
+
+void ShardedTracker::consume(PositionSample const *samples, int count)
+{
+  if (count <= 0)
+    return;
+
+  // Split the batch by shard, in order, and queue the parts
+  QVector<QVector<PositionSample>> parts(m_shards.size());
+  for (QVector<PositionSample> &part : parts)
+    part.reserve(count / m_shards.size() + 16);
+  for (int i = 0; i < count; ++i)
+    parts[shardOf(samples[i].id)].append(samples[i]);
+  for (int i = 0; i < m_shards.size(); ++i) {
+    if (parts.at(i).isEmpty())
+      continue;
+    TrackerShard *shard = m_shards.at(i);
+    const QVector<PositionSample> part = parts.at(i);
+    QMetaObject::invokeMethod(shard, [shard, part]() {
+        shard->process(part);
+      }, Qt::QueuedConnection);
+  }
+}
+
+void ShardedTracker::setObserverPosition(QGeoPositionInfo const &position)
+{
+  m_observerPosition = position;
+  const QGeoCoordinate coordinate = position.coordinate();
+  for (TrackerShard *shard : m_shards) {
+    QMetaObject::invokeMethod(shard, [shard, coordinate]() {
+        shard->setObserver(coordinate);
+      }, Qt::QueuedConnection);
+  }
+}
+
+void ShardedTracker::requestGather()
+{
+  // In a shard.  One request at a time: the outboxes are all gathered
+  // from anyway.
+  if (m_isGatherPending.testAndSetOrdered(0, 1))
+    QMetaObject::invokeMethod(this, [this]() { gather(); }, Qt::QueuedConnection);
+}
+
+void ShardedTracker::gather()
+{
+  // Cleared before reading, so that look angles pushed from now on
+  // make another request.
+  m_isGatherPending.fetchAndStoreOrdered(0);
+  for (TrackerShard *shard : m_shards) {
+    int count;
+    while ((count = shard->outbox.pop(m_gathered.data(), m_gathered.size())) > 0) {
+      if (!m_sink)
+        continue;
+      m_sink->consume(m_gathered.constData(), count);
+      shard->m_delivered.fetchAndAddRelaxed(quint64(count));
+    }
+  }
+}
+
+void ShardedTracker::flush()
+{
+  for (TrackerShard *shard : m_shards)
+    QMetaObject::invokeMethod(shard, []() {}, Qt::BlockingQueuedConnection);
+  gather();
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <QObject>
+#include <QVector>
+#include <QAtomicInteger>
+#include <QGeoPositionInfo>
+#include "PositionSample.hpp"
+#include "Refraction.hpp"
+
+class QThread;
+class GeoEntity;
+class TrackerShard;
+
+// A look angle from the observer to an entity, at the time of the
+// sample of the entity
+struct EntityLookAngle
+{
+  quint64 id;
+  qint64  timestamp;    // milliseconds since 1970-01-01T00:00:00 UTC
+  float   azimuth;      // degrees from true north
+  float   elevation;    // degrees above the horizon
+};
+
+// A consumer of batches of look angles, as the PositionSampleSink is
+// of samples
+class EntityLookAngleSink
+{
+public:
+  virtual ~EntityLookAngleSink();
+
+  virtual void consume(EntityLookAngle const *lookAngles, int count) = 0;
+};
+
+// A LookAngleOutbox is a ring of look angles with one writer and one
+// reader, in different threads, neither of which ever waits for the
+// other: the writer publishes the look angles it has written by
+// moving the head with a release, and the reader frees the ones it
+// has read by moving the tail with a release.  The head and the tail
+// are on cache lines of their own.  When the ring is full, the look
+// angles that do not fit are refused.
+
+class LookAngleOutbox
+{
+public:
+  // The capacity is rounded up to a power of two.
+  LookAngleOutbox(int capacity = 65536);
+
+  int capacity() const;
+
+  // By the writer: the number of look angles taken, from the first
+  int push(EntityLookAngle const *lookAngles, int count);
+  // By the reader: the number of look angles read, at most count
+  int pop(EntityLookAngle *lookAngles, int count);
+
+private:
+  Q_DISABLE_COPY(LookAngleOutbox)
+
+  QVector<EntityLookAngle> m_ring;
+  EntityLookAngle *m_data;        // of the ring, not to detach it
+  quint64 m_mask;
+  alignas(64) QAtomicInteger<quint64> m_head;   // the next to write
+  alignas(64) QAtomicInteger<quint64> m_tail;   // the next to read
+};
+
+// Counters of a ShardedTracker, or of one of its shards
+struct ShardedTrackerStatistics
+{
+  quint64 samples;          // samples routed to the shards
+  quint64 lookAngles;       // look angles computed
+  quint64 dropped;          // look angles refused by a full outbox
+  quint64 delivered;        // look angles handed to the sink
+};
+
+// A ShardedTracker spreads the work of tracking a feed of many
+// entities over worker threads, so that it is not bound to one core.
+//
+// The entities are sharded by a hash of their id, each shard on a
+// thread with an event loop of its own.  consume() splits each batch
+// of samples by shard and queues the parts to the shards, so any
+// number of position sources, in any threads, may feed the tracker.
+// Each shard updates the records of its entities (an EntityPool) and
+// the GeoEntity objects routed to it (a GeoEntityDispatcher), and
+// computes the look angle to each updated entity from the observer.
+// The look angles are put in the lock-free outbox of the shard (see
+// LookAngleOutbox) and gathered, in the thread of the tracker, into
+// batches for the look angle sink.  A shard tells the tracker to
+// gather only when none is pending, so a busy tracker gathers from
+// all the shards at once.
+//
+// The position of the observer and the refraction are copied to
+// every shard, in order with the samples.  Look angles are only
+// computed once the observer has a position.
+//
+// A GeoEntity routed to the tracker (setEntity()) is moved to the
+// thread of its shard, where its positionChanged() is emitted; its
+// receivers in other threads get queued signals.  It is moved back to
+// the thread of the tracker when it is removed, or when the tracker
+// is destroyed.
+
+class ShardedTracker : public QObject, public PositionSampleSink
+{
+  Q_OBJECT
+public:
+  // By default a shard per core
+  ShardedTracker(int shardCount = 0, QObject *parent = nullptr);
+  ~ShardedTracker();
+
+  int shardCount() const;
+  // The shard of an id
+  int shardOf(quint64 id) const;
+
+  QGeoPositionInfo observerPosition() const;
+  Refraction refraction() const;
+  void setRefraction(Refraction const &refraction);
+
+  // Route the samples of an id to an entity in its shard, or to no
+  // entity if it is null.  The entity must have no parent, and must
+  // not be deleted until it is removed or the tracker is destroyed.
+  void setEntity(quint64 id, GeoEntity *entity);
+
+  // The sink of the look angles, which is not owned, or null.  It
+  // receives them in the thread of the tracker.
+  EntityLookAngleSink *lookAngleSink() const;
+  void setLookAngleSink(EntityLookAngleSink *sink);
+
+  ShardedTrackerStatistics statistics() const;
+  ShardedTrackerStatistics statistics(int shard) const;
+
+  // May be called from any thread.
+  virtual void consume(PositionSample const *samples, int count);
+
+public slots:
+  void setObserverPosition(QGeoPositionInfo const &position);
+
+  // Gather the look angles waiting in the outboxes.  Done when a
+  // shard asks for it; public so that a caller may gather at once.
+  void gather();
+
+  // Wait until the shards have processed the samples queued so far,
+  // then gather.  Not to be called from a position source that runs
+  // on a shard.
+  void flush();
+
+private:
+  friend class TrackerShard;
+  void requestGather();
+
+  QVector<TrackerShard *> m_shards;
+  QVector<QThread *> threads;
+  QGeoPositionInfo m_observerPosition;
+  Refraction m_refraction;
+  EntityLookAngleSink *m_sink;
+  QVector<EntityLookAngle> m_gathered;
+  QAtomicInteger<int> m_isGatherPending;
+};
@@ -0,0 +1,380 @@
+#include <QThread>
+#include <QtMath>
+#include <limits>
+#include <algorithm>
+#include "TrackFusion.hpp"
+#include "Metrics.hpp"
+
+// The metrics of all the fusion stages
+static
+MetricCounter &StaleCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_fusion_dropped_reports_total",
+                                                            "Reports dropped by the track fusion.",
+                                                            "reason=\"stale\"");
+  return *counter;
+}
+
+static
+MetricCounter &OutOfOrderCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_fusion_dropped_reports_total",
+                                                            "Reports dropped by the track fusion.",
+                                                            "reason=\"out_of_order\"");
+  return *counter;
+}
+
+// The mean radius of the earth, for moving reports and measuring
+// distances over the short spans of a window or a gate
+static const double EarthRadius = 6371008.8;
+
+static
+double WrapLongitude(double longitude)
+{
+  while (longitude > 180.0)
+    longitude -= 360.0;
+  while (longitude < -180.0)
+    longitude += 360.0;
+  return longitude;
+}
+
+// The distance in meters between two nearby positions, on a plane
+// tangent to the earth
+static
+double Distance(PositionSample const &a, PositionSample const &b)
+{
+  const double north = qDegreesToRadians(b.latitude - a.latitude);
+  const double east = qDegreesToRadians(WrapLongitude(b.longitude - a.longitude))
+    * qCos(qDegreesToRadians(0.5 * (a.latitude + b.latitude)));
+  return EarthRadius * qSqrt(north * north + east * east);
+}
+
+static
+bool HasVelocity(PositionSample const &sample)
+{
+  return !qIsNaN(sample.groundSpeed) && !qIsNaN(sample.direction);
+}
+
+TrackFusion::TrackFusion(QObject *parent) :
+  QObject(parent),
+  m_window(100),
+  m_gate(0.0),
+  m_maximumAge(5000),
+  m_trackTimeout(60000),
+  m_defaultAccuracy(50.0),
+  m_sink(nullptr),
+  m_newest(std::numeric_limits<qint64>::min()),
+  m_nextExpiry(std::numeric_limits<qint64>::min()),
+  timer(new QTimer(this))
+{
+  m_statistics.reports = 0;
+  m_statistics.outOfOrder = 0;
+  m_statistics.stale = 0;
+  m_statistics.associated = 0;
+  m_statistics.updates = 0;
+  m_statistics.expired = 0;
+  timer->setInterval(m_window);
+  connect(timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+int TrackFusion::window() const
+{
+  return m_window;
+}
+
+void TrackFusion::setWindow(int msecs)
+{
+  m_window = qMax(1, msecs);
+  timer->setInterval(m_window);
+}
+
+double TrackFusion::gate() const
+{
+  return m_gate;
+}
+
+void TrackFusion::setGate(double meters)
+{
+  m_gate = meters;
+}
+
+qint64 TrackFusion::maximumAge() const
+{
+  return m_maximumAge;
+}
+
+void TrackFusion::setMaximumAge(qint64 msecs)
+{
+  m_maximumAge = msecs;
+}
+
+qint64 TrackFusion::trackTimeout() const
+{
+  return m_trackTimeout;
+}
+
+void TrackFusion::setTrackTimeout(qint64 msecs)
+{
+  m_trackTimeout = msecs;
+}
+
+double TrackFusion::defaultAccuracy() const
+{
+  return m_defaultAccuracy;
+}
+
+void TrackFusion::setDefaultAccuracy(double meters)
+{
+  m_defaultAccuracy = meters;
+}
+
+PositionSampleSink *TrackFusion::sampleSink() const
+{
+  return m_sink;
+}
+
+void TrackFusion::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+quint64 TrackFusion::track(quint64 id) const
+{
+  const int index = m_aliases.value(id, -1);
+  return index < 0 ? 0 : m_tracks.at(index).id;
+}
+
+int TrackFusion::trackCount() const
+{
+  return m_tracks.size();
+}
+
+TrackFusionStatistics TrackFusion::statistics() const
+{
+  return m_statistics;
+}
+
+void TrackFusion::consume(PositionSample const *samples, int count)
+{
+  if (count <= 0)
+    return;
+  if (QThread::currentThread() == thread()) {
+    receive(samples, count);
+    return;
+  }
+  QVector<PositionSample> copy(count);
+  std::copy(samples, samples + count, copy.begin());
+  QMetaObject::invokeMethod(this, [this, copy]() {
+      receive(copy.constData(), copy.size());
+    }, Qt::QueuedConnection);
+}
+
+int TrackFusion::associate(PositionSample const &sample)
+{
+  const int alias = m_aliases.value(sample.id, -1);
+  if (alias >= 0)
+    return alias;
+
+  // The nearest live track within the gate
+  int nearest = -1;
+  if (m_gate > 0.0) {
+    double nearestDistance = m_gate;
+    for (int i = 0; i < m_tracks.size(); ++i) {
+      Track const &track = m_tracks.at(i);
+      if (track.last.timestamp < m_newest - m_maximumAge)
+        continue;
+      const double distance = Distance(track.last, sample);
+      if (distance <= nearestDistance) {
+        nearest = i;
+        nearestDistance = distance;
+      }
+    }
+  }
+  if (nearest >= 0) {
+    ++m_statistics.associated;
+  } else {
+    Track track;
+    track.id = sample.id;
+    track.last = sample;
+    track.lastTimestamp = std::numeric_limits<qint64>::min();
+    track.isPending = false;
+    nearest = m_tracks.size();
+    m_tracks.append(track);
+  }
+  m_aliases.insert(sample.id, nearest);
+  return nearest;
+}
+
+void TrackFusion::receive(PositionSample const *samples, int count)
+{
+  for (int i = 0; i < count; ++i) {
+    PositionSample const &sample = samples[i];
+    ++m_statistics.reports;
+    if (!sample.isValid())
+      continue;
+    m_newest = qMax(m_newest, sample.timestamp);
+    if (sample.timestamp < m_newest - m_maximumAge) {
+      ++m_statistics.stale;
+      StaleCount().increment();
+      continue;
+    }
+    const int index = associate(sample);
+    Track &track = m_tracks[index];
+    if (sample.timestamp <= track.lastTimestamp) {
+      ++m_statistics.outOfOrder;
+      OutOfOrderCount().increment();
+      continue;
+    }
+    if (!track.isPending) {
+      track.isPending = true;
+      track.latest = sample.timestamp;
+      m_pending.append(index);
+    } else {
+      track.latest = qMax(track.latest, sample.timestamp);
+    }
+    m_reports.append(sample);
+    m_reportTracks.append(index);
+  }
+  if (!m_pending.isEmpty() && !timer->isActive())
+    timer->start();
+}
+
+void TrackFusion::accumulate(Track &track, PositionSample const &sample)
+{
+  // Move the report to the time of the latest report of the window
+  double latitude = sample.latitude;
+  double longitude = sample.longitude;
+  double altitude = sample.altitude;
+  const double dt = (track.latest - sample.timestamp) / 1000.0;
+  double north = 0.0;
+  double east = 0.0;
+  if (HasVelocity(sample)) {
+    north = sample.groundSpeed * qCos(qDegreesToRadians(sample.direction));
+    east = sample.groundSpeed * qSin(qDegreesToRadians(sample.direction));
+    latitude += qRadiansToDegrees(north * dt / EarthRadius);
+    longitude += qRadiansToDegrees(east * dt / (EarthRadius * qCos(qDegreesToRadians(sample.latitude))));
+  }
+  if (!qIsNaN(sample.verticalSpeed) && !qIsNaN(altitude))
+    altitude += sample.verticalSpeed * dt;
+
+  const double horizontal = qIsNaN(sample.horizontalAccuracy) || sample.horizontalAccuracy <= 0.0
+    ? m_defaultAccuracy : sample.horizontalAccuracy;
+  const double vertical = qIsNaN(sample.verticalAccuracy) || sample.verticalAccuracy <= 0.0
+    ? horizontal : sample.verticalAccuracy;
+  const double weight = 1.0 / (horizontal * horizontal);
+
+  if (track.horizontalWeight == 0.0)
+    track.referenceLongitude = longitude;
+  track.horizontalWeight += weight;
+  track.latitude += weight * latitude;
+  // Relative to the first report, in case the track crosses the
+  // antimeridian
+  track.longitude += weight * WrapLongitude(longitude - track.referenceLongitude);
+  if (!qIsNaN(altitude)) {
+    const double verticalWeight = 1.0 / (vertical * vertical);
+    track.verticalWeight += verticalWeight;
+    track.altitude += verticalWeight * altitude;
+  }
+  if (HasVelocity(sample)) {
+    track.velocityWeight += weight;
+    track.north += weight * north;
+    track.east += weight * east;
+  }
+  if (!qIsNaN(sample.verticalSpeed)) {
+    ++track.verticalSpeedCount;
+    track.verticalSpeed += sample.verticalSpeed;
+  }
+}
+
+void TrackFusion::flush()
+{
+  timer->stop();
+  if (m_pending.isEmpty())
+    return;
+
+  for (int index : m_pending) {
+    Track &track = m_tracks[index];
+    track.horizontalWeight = track.latitude = track.longitude = 0.0;
+    track.verticalWeight = track.altitude = 0.0;
+    track.velocityWeight = track.north = track.east = 0.0;
+    track.verticalSpeedCount = 0;
+    track.verticalSpeed = 0.0;
+  }
+  for (int i = 0; i < m_reports.size(); ++i)
+    accumulate(m_tracks[m_reportTracks.at(i)], m_reports.at(i));
+
+  for (int index : m_pending) {
+    Track &track = m_tracks[index];
+    PositionSample fused = PositionSample::invalid(track.id);
+    fused.timestamp = track.latest;
+    fused.latitude = track.latitude / track.horizontalWeight;
+    fused.longitude = WrapLongitude(track.referenceLongitude + track.longitude / track.horizontalWeight);
+    fused.horizontalAccuracy = qSqrt(1.0 / track.horizontalWeight);
+    if (track.verticalWeight > 0.0) {
+      fused.altitude = track.altitude / track.verticalWeight;
+      fused.verticalAccuracy = qSqrt(1.0 / track.verticalWeight);
+    }
+    if (track.velocityWeight > 0.0) {
+      const double north = track.north / track.velocityWeight;
+      const double east = track.east / track.velocityWeight;
+      fused.groundSpeed = qSqrt(north * north + east * east);
+      fused.direction = qRadiansToDegrees(qAtan2(east, north));
+      if (fused.direction < 0.0)
+        fused.direction += 360.0;
+    }
+    if (track.verticalSpeedCount > 0)
+      fused.verticalSpeed = track.verticalSpeed / track.verticalSpeedCount;
+
+    track.last = fused;
+    track.lastTimestamp = fused.timestamp;
+    track.isPending = false;
+    m_fused.append(fused);
+  }
+
+  m_statistics.updates += quint64(m_fused.size());
+  m_reports.clear();
+  m_reportTracks.clear();
+  m_pending.clear();
+  if (m_sink)
+    m_sink->consume(m_fused.constData(), m_fused.size());
+  m_fused.clear();
+  expireTracks();
+}
+
+void TrackFusion::expireTracks()
+{
+  // A sweep every quarter of the timeout, of the report time
+  const qint64 timeout = qMax(m_trackTimeout, m_maximumAge);
+  if (m_newest < m_nextExpiry)
+    return;
+  m_nextExpiry = m_newest + qMax<qint64>(1, timeout / 4);
+
+  // The tracks are compacted, none being pending between windows,
+  // and the aliases moved with them
+  const qint64 oldest = m_newest - timeout;
+  QVector<int> indexes(m_tracks.size());
+  int count = 0;
+  for (int i = 0; i < m_tracks.size(); ++i) {
+    if (m_tracks.at(i).last.timestamp < oldest) {
+      indexes[i] = -1;
+      continue;
+    }
+    indexes[i] = count;
+    if (count != i)
+      m_tracks[count] = m_tracks.at(i);
+    ++count;
+  }
+  if (count == m_tracks.size())
+    return;
+  m_statistics.expired += quint64(m_tracks.size() - count);
+  m_tracks.resize(count);
+  for (auto i = m_aliases.begin(); i != m_aliases.end(); ) {
+    const int index = indexes.at(i.value());
+    if (index < 0) {
+      i = m_aliases.erase(i);
+    } else {
+      i.value() = index;
+      ++i;
+    }
+  }
+}
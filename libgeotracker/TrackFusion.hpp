@@ -0,0 +1,147 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+#include "PositionSample.hpp"
+
+// Counters of a TrackFusion stage
+struct TrackFusionStatistics
+{
+  quint64 reports;          // samples received
+  quint64 outOfOrder;       // discarded: older than the last update of their track
+  quint64 stale;            // discarded: older than the maximum age
+  quint64 associated;       // new ids associated to an existing track by distance
+  quint64 updates;          // fused samples delivered
+  quint64 expired;          // tracks dropped after the track timeout
+};
+
+// TrackFusion merges the position reports of the same objects from
+// several feeds into one track per object, ahead of the GeoEntity
+// objects (see GeoEntityDispatcher), so that duplicates do not each
+// cost a look angle calculation and a round of signals.
+//
+// Reports are associated to a track by their id.  The first report
+// of an unknown id is associated to the nearest track within the
+// gating distance, if any, and its id becomes an alias of that
+// track; otherwise it starts a track of its own, identified by its
+// id.  The gating distance is zero by default, which associates by id
+// only: a gate is for feeds that identify the same object
+// differently, and it may confuse objects that are closer than it.
+//
+// Reports that are older than the last update of their track arrive
+// out of order, and are discarded.  So are reports older than the
+// maximum age, relative to the newest report received from any feed
+// (not the clock, so that logs may be replayed).
+//
+// The reports of a track are accumulated over a fusion window and
+// delivered as one fused sample when the window closes, so each
+// track is updated at most once per window.  The fused position is
+// the mean of the reports weighted by the inverse of their variance
+// (their horizontal and vertical accuracy, taken as one standard
+// deviation, or the default accuracy if they have none), after
+// moving them to the time of the latest one with their velocity when
+// they have one.  The accuracy of the fused sample is that of the
+// weighted mean.
+//
+// A track that has had no report for the track timeout, relative to
+// the newest report as for the maximum age, is dropped with its
+// aliases, so that a feed whose ids come and go does not grow the
+// stage without bound.  The timeout is at least the maximum age: a
+// report newer than that is never out of order for a dropped track.
+//
+// Reports consumed from another thread are copied and queued to the
+// thread of the fusion stage.
+
+class TrackFusion : public QObject, public PositionSampleSink
+{
+  Q_OBJECT
+public:
+  TrackFusion(QObject *parent = nullptr);
+
+  // The fusion window, in milliseconds (100 by default)
+  int window() const;
+  void setWindow(int msecs);
+
+  // The gating distance, in meters (0 by default)
+  double gate() const;
+  void setGate(double meters);
+
+  // The maximum age of the reports, in milliseconds (5000 by default)
+  qint64 maximumAge() const;
+  void setMaximumAge(qint64 msecs);
+
+  // The idle time of a track in milliseconds, after which it is
+  // dropped (60000 by default)
+  qint64 trackTimeout() const;
+  void setTrackTimeout(qint64 msecs);
+
+  // The accuracy of the reports that have none, in meters (50 by
+  // default)
+  double defaultAccuracy() const;
+  void setDefaultAccuracy(double meters);
+
+  // The fused samples go to the sink, which is not owned.
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+  // The track of a report id, or 0 if the id is unknown
+  quint64 track(quint64 id) const;
+  int trackCount() const;
+
+  TrackFusionStatistics statistics() const;
+
+  virtual void consume(PositionSample const *samples, int count);
+
+public slots:
+  // Close the current window: deliver the fused samples of the
+  // tracks that received reports.
+  void flush();
+
+private:
+  struct Track
+  {
+    quint64 id;
+    PositionSample last;        // the last fused sample, or the first report
+    qint64 lastTimestamp;       // of the last fused sample
+    bool isPending;             // has reports in the window
+
+    // The weighted sums of the reports of the window
+    qint64 latest;
+    double referenceLongitude;
+    double horizontalWeight;
+    double latitude;
+    double longitude;
+    double verticalWeight;
+    double altitude;
+    double velocityWeight;
+    double north;
+    double east;
+    int verticalSpeedCount;
+    double verticalSpeed;
+  };
+
+  void receive(PositionSample const *samples, int count);
+  int associate(PositionSample const &sample);
+  void accumulate(Track &track, PositionSample const &sample);
+  void expireTracks();
+
+  int m_window;
+  double m_gate;
+  qint64 m_maximumAge;
+  qint64 m_trackTimeout;
+  double m_defaultAccuracy;
+  PositionSampleSink *m_sink;
+
+  QVector<Track> m_tracks;
+  QHash<quint64, int> m_aliases;        // report id to track index
+  QVector<PositionSample> m_reports;    // of the window
+  QVector<int> m_reportTracks;
+  QVector<int> m_pending;               // tracks with reports in the window
+  QVector<PositionSample> m_fused;
+  qint64 m_newest;
+  qint64 m_nextExpiry;                  // of the tracks, in report time
+  QTimer *timer;
+  TrackFusionStatistics m_statistics;
+};
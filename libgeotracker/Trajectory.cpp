@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <QFile>
+#include <QDateTime>
+#include "Trajectory.hpp"
+#include "GeoPoint.hpp"
+
+Trajectory::~Trajectory()
+{
+}
+
+SampledTrajectory::SampledTrajectory()
+{
+}
+
+bool SampledTrajectory::load(QString const &fileName)
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  while (!file.atEnd()) {
+    QList<QByteArray> data = file.readLine().trimmed().split(' ');
+    bool hasLatitude = false;
+    bool hasLongitude = false;
+    bool hasAltitude = false;
+    QDateTime timestamp = QDateTime::fromString(QString(data.value(0)), Qt::ISODate);
+    double latitude = data.value(1).toDouble(&hasLatitude);
+    double longitude = data.value(2).toDouble(&hasLongitude);
+    double altitude = data.value(3).toDouble(&hasAltitude);
+    if (hasLatitude && hasLongitude && hasAltitude && timestamp.isValid())
+      append(QGeoPositionInfo(QGeoCoordinate(latitude, longitude, altitude), timestamp));
+  }
+  return true;
+}
+
+void SampledTrajectory::append(QGeoPositionInfo const &info)
+{
+  if (!info.isValid())
+    return;
+  const double time = info.timestamp().toMSecsSinceEpoch();
+  if (!m_times.isEmpty() && time <= m_times.last())
+    return;
+  m_times.append(time);
+  m_coordinates.append(info.coordinate());
+}
+
+int SampledTrajectory::count() const
+{
+  return m_times.size();
+}
+
+QGeoCoordinate SampledTrajectory::positionAt(double time) const
+{
+  if (m_times.isEmpty() || time < m_times.first() || time > m_times.last())
+    return QGeoCoordinate();
+
+  // Find the samples on either side of the time and interpolate
+  // between their Earth centered, Earth fixed positions, which is
+  // well behaved across the poles and the antimeridian.
+  const int i = std::upper_bound(m_times.constBegin(), m_times.constEnd(), time) - m_times.constBegin();
+  if (i >= m_times.size())
+    return m_coordinates.last();
+  const double fraction = (time - m_times.at(i - 1)) / (m_times.at(i) - m_times.at(i - 1));
+  GeoPoint a(m_coordinates.at(i - 1));
+  GeoPoint b(m_coordinates.at(i));
+  return GeoPoint(a.x() + fraction * (b.x() - a.x()),
+                  a.y() + fraction * (b.y() - a.y()),
+                  a.z() + fraction * (b.z() - a.z())).coordinate();
+}
+
+ExtrapolatedTrajectory::ExtrapolatedTrajectory(QGeoPositionInfo const &info, double horizon) :
+  m_coordinate(info.coordinate()),
+  m_time(info.timestamp().toMSecsSinceEpoch()),
+  m_horizon(horizon),
+  m_direction(0.0),
+  m_groundSpeed(0.0),
+  m_verticalSpeed(0.0)
+{
+  if (info.hasAttribute(QGeoPositionInfo::Direction))
+    m_direction = info.attribute(QGeoPositionInfo::Direction);
+  if (info.hasAttribute(QGeoPositionInfo::GroundSpeed))
+    m_groundSpeed = info.attribute(QGeoPositionInfo::GroundSpeed);
+  if (info.hasAttribute(QGeoPositionInfo::VerticalSpeed))
+    m_verticalSpeed = info.attribute(QGeoPositionInfo::VerticalSpeed);
+}
+
+QGeoCoordinate ExtrapolatedTrajectory::positionAt(double time) const
+{
+  const double seconds = (time - m_time) / 1000.0;
+  if (seconds < 0.0 || seconds > m_horizon || !m_coordinate.isValid())
+    return QGeoCoordinate();
+  const double altitude = qIsNaN(m_coordinate.altitude()) ? 0.0 : m_coordinate.altitude();
+  QGeoCoordinate position = m_coordinate.atDistanceAndAzimuth(m_groundSpeed * seconds, m_direction);
+  position.setAltitude(altitude + m_verticalSpeed * seconds);
+  return position;
+}
+
+SatelliteTrajectory::SatelliteTrajectory(Sgp4 const &satellite) :
+  m_satellite(satellite)
+{
+}
+
+QGeoCoordinate SatelliteTrajectory::positionAt(double time) const
+{
+  GeoPoint position;
+  if (m_satellite.positionAt(time, &position) != Sgp4::NoError)
+    return QGeoCoordinate();
+  return position.coordinate();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include "Sgp4.hpp"
+
+// A Trajectory is the path of an entity whose position can be
+// predicted at any time within some interval, as opposed to a
+// position source that only reports the present.  Trajectories are
+// used to look ahead: for instance, to find when a target will be
+// visible from an observer (see VisibilityPredictor).
+//
+// Times are in milliseconds since 1970-01-01T00:00:00 UTC.  A
+// trajectory returns an invalid coordinate for times outside of the
+// interval for which it is defined.
+//
+// Trajectories are immutable once constructed, so they may be
+// evaluated from several threads at once.
+
+class Trajectory
+{
+public:
+  virtual ~Trajectory();
+
+  virtual QGeoCoordinate positionAt(double msecsSinceEpoch) const = 0;
+};
+
+// A SampledTrajectory interpolates between time stamped positions,
+// such as those of a recorded log (see LogFilePositionSource for the
+// format).  It is defined from the first sample to the last.
+
+class SampledTrajectory : public Trajectory
+{
+public:
+  SampledTrajectory();
+
+  // Read the samples from a log file.  Returns false if the file
+  // cannot be read.
+  bool load(QString const &fileName);
+
+  // Append a sample.  Samples must be appended in time order; older
+  // samples are ignored.
+  void append(QGeoPositionInfo const &info);
+
+  int count() const;
+  virtual QGeoCoordinate positionAt(double msecsSinceEpoch) const;
+
+private:
+  QVector<double>         m_times;
+  QVector<QGeoCoordinate> m_coordinates;
+};
+
+// An ExtrapolatedTrajectory dead reckons from the last known
+// position along its direction at its ground and vertical speeds
+// (taken from the QGeoPositionInfo attributes; an entity without them
+// is assumed stationary).  It is defined from the time of the
+// position for a limited horizon, beyond which the extrapolation is
+// no longer trustworthy.
+
+class ExtrapolatedTrajectory : public Trajectory
+{
+public:
+  ExtrapolatedTrajectory(QGeoPositionInfo const &info, double horizon = 600.0);
+
+  virtual QGeoCoordinate positionAt(double msecsSinceEpoch) const;
+
+private:
+  QGeoCoordinate m_coordinate;
+  double         m_time;          // msecs since 1970
+  double         m_horizon;       // seconds
+  double         m_direction;     // degrees from true north
+  double         m_groundSpeed;   // meters per second
+  double         m_verticalSpeed; // meters per second
+};
+
+// A SatelliteTrajectory is the orbit of a satellite propagated by
+// SGP4.
+
+class SatelliteTrajectory : public Trajectory
+{
+public:
+  SatelliteTrajectory(Sgp4 const &satellite);
+
+  virtual QGeoCoordinate positionAt(double msecsSinceEpoch) const;
+
+private:
+  Sgp4 m_satellite;
+};
@@ -0,0 +1,298 @@
+#include <QtConcurrent>
+#include "VisibilityPredictor.hpp"
+#include "GeoObserver.hpp"
+#include "LookAngle.hpp"
+
+// The elevations are functions of the time in seconds since the start
+// of the prediction.  Working relative to the start keeps the full
+// precision of a double for the refinement.
+
+template <typename Function>
+static
+double BrentRoot(Function f, double a, double b, double fa, double fb, double tolerance)
+{
+  // Brent's method for the root of f in [a, b], given that fa and fb
+  // have opposite signs.  It combines inverse quadratic
+  // interpolation, the secant method and bisection, so it converges
+  // superlinearly on smooth functions and never does worse than
+  // bisection on rough ones.
+  double c = a, fc = fa;
+  double d = b - a, e = d;
+  for (int iteration = 0; iteration < 100; ++iteration) {
+    if ((fb >= 0.0) == (fc >= 0.0)) {
+      c = a; fc = fa;
+      d = e = b - a;
+    }
+    if (qAbs(fc) < qAbs(fb)) {
+      a = b; b = c; c = a;
+      fa = fb; fb = fc; fc = fa;
+    }
+    const double tol = 2.0e-16 * qAbs(b) + 0.5 * tolerance;
+    const double xm = 0.5 * (c - b);
+    if (qAbs(xm) <= tol || fb == 0.0)
+      return b;
+    if (qAbs(e) >= tol && qAbs(fa) > qAbs(fb)) {
+      double p, q;
+      const double s = fb / fa;
+      if (a == c) {
+        p = 2.0 * xm * s;
+        q = 1.0 - s;
+      } else {
+        const double r = fb / fc;
+        q = fa / fc;
+        p = s * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+        q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+      }
+      if (p > 0.0)
+        q = -q;
+      p = qAbs(p);
+      if (2.0 * p < qMin(3.0 * xm * q - qAbs(tol * q), qAbs(e * q))) {
+        e = d;
+        d = p / q;
+      } else {
+        d = xm;
+        e = d;
+      }
+    } else {
+      d = xm;
+      e = d;
+    }
+    a = b;
+    fa = fb;
+    b += qAbs(d) > tol ? d : (xm > 0.0 ? tol : -tol);
+    fb = f(b);
+  }
+  return b;
+}
+
+template <typename Function>
+static
+double GoldenSectionMaximum(Function f, double a, double b, double tolerance, double *maximum)
+{
+  // Locate the maximum of a unimodal function on [a, b].
+  const double ratio = 0.5 * (qSqrt(5.0) - 1.0);
+  double c = b - ratio * (b - a);
+  double d = a + ratio * (b - a);
+  double fc = f(c);
+  double fd = f(d);
+  while (b - a > tolerance) {
+    if (fc > fd) {
+      b = d; d = c; fd = fc;
+      c = b - ratio * (b - a);
+      fc = f(c);
+    } else {
+      a = c; c = d; fc = fd;
+      d = a + ratio * (b - a);
+      fd = f(d);
+    }
+  }
+  const double x = 0.5 * (a + b);
+  if (maximum)
+    *maximum = f(x);
+  return x;
+}
+
+VisibilityPredictor::VisibilityPredictor() :
+  m_elevationMask(0.0),
+  m_step(60),
+  m_tolerance(0.01)
+{
+}
+
+VisibilityPredictor::VisibilityPredictor(QGeoCoordinate const &observer, double elevationMask) :
+  m_observer(observer),
+  m_elevationMask(elevationMask),
+  m_step(60),
+  m_tolerance(0.01)
+{
+}
+
+VisibilityPredictor::VisibilityPredictor(GeoObserver const &observer) :
+  m_observer(observer.position().coordinate()),
+  m_elevationMask(observer.elevationMask()),
+  m_refraction(observer.refraction()),
+  m_step(60),
+  m_tolerance(0.01)
+{
+}
+
+QGeoCoordinate VisibilityPredictor::observer() const
+{
+  return m_observer;
+}
+
+void VisibilityPredictor::setObserver(QGeoCoordinate const &observer)
+{
+  m_observer = observer;
+}
+
+double VisibilityPredictor::elevationMask() const
+{
+  return m_elevationMask;
+}
+
+void VisibilityPredictor::setElevationMask(double elevationMask)
+{
+  m_elevationMask = elevationMask;
+}
+
+Refraction VisibilityPredictor::refraction() const
+{
+  return m_refraction;
+}
+
+void VisibilityPredictor::setRefraction(Refraction const &refraction)
+{
+  m_refraction = refraction;
+}
+
+int VisibilityPredictor::step() const
+{
+  return m_step;
+}
+
+void VisibilityPredictor::setStep(int step)
+{
+  m_step = qMax(1, step);
+}
+
+double VisibilityPredictor::tolerance() const
+{
+  return m_tolerance;
+}
+
+void VisibilityPredictor::setTolerance(double tolerance)
+{
+  m_tolerance = tolerance;
+}
+
+double VisibilityPredictor::elevationAt(Trajectory const &trajectory, double msecsSinceEpoch) const
+{
+  QGeoCoordinate target = trajectory.positionAt(msecsSinceEpoch);
+  if (!target.isValid())
+    return -90.0;
+  return LookAngle(m_observer, target, m_refraction).elevation();
+}
+
+QVector<VisibilityWindow> VisibilityPredictor::windows(Trajectory const &trajectory,
+                                                       QDateTime const &start,
+                                                       QDateTime const &end) const
+{
+  QVector<VisibilityWindow> result;
+  const double origin = start.toMSecsSinceEpoch();
+  const double span = (end.toMSecsSinceEpoch() - origin) / 1000.0;
+  if (span <= 0.0 || !m_observer.isValid())
+    return result;
+
+  // The elevation above the mask, and its rate of change by a
+  // forward difference over a short interval.
+  auto f = [&](double t) {
+    return elevationAt(trajectory, origin + 1000.0 * t) - m_elevationMask;
+  };
+  const double delta = qMin(1.0, 0.1 * m_step);
+  auto rate = [&](double t, double ft) {
+    return t + delta <= span ? (f(t + delta) - ft) / delta : (ft - f(t - delta)) / delta;
+  };
+
+  // The coarse samples, kept to seed the search for the culminations.
+  QVector<double> times;
+  QVector<double> values;
+
+  // The times at which the target crosses the mask, alternately
+  // rising and setting.
+  QVector<double> crossings;
+  double t0 = 0.0;
+  double f0 = f(t0);
+  double r0 = rate(t0, f0);
+  const bool isInitiallyVisible = f0 >= 0.0;
+  times.append(t0);
+  values.append(f0);
+  while (t0 < span) {
+    const double t1 = qMin(t0 + m_step, span);
+    const double f1 = f(t1);
+    const double r1 = rate(t1, f1);
+    if ((f0 >= 0.0) != (f1 >= 0.0)) {
+      crossings.append(BrentRoot(f, t0, t1, f0, f1, m_tolerance));
+    } else if (f0 < 0.0 && r0 > 0.0 && r1 < 0.0) {
+      // A peak between the samples may rise above the mask.
+      double peak;
+      const double tp = GoldenSectionMaximum(f, t0, t1, m_tolerance, &peak);
+      if (peak >= 0.0) {
+        crossings.append(BrentRoot(f, t0, tp, f0, peak, m_tolerance));
+        crossings.append(BrentRoot(f, tp, t1, peak, f1, m_tolerance));
+      }
+    } else if (f0 >= 0.0 && r0 < 0.0 && r1 > 0.0) {
+      // A dip between the samples may fall below the mask.
+      double dip;
+      const double td = GoldenSectionMaximum([&](double t) { return -f(t); }, t0, t1, m_tolerance, &dip);
+      dip = -dip;
+      if (dip < 0.0) {
+        crossings.append(BrentRoot(f, t0, td, f0, dip, m_tolerance));
+        crossings.append(BrentRoot(f, td, t1, dip, f1, m_tolerance));
+      }
+    }
+    times.append(t1);
+    values.append(f1);
+    t0 = t1;
+    f0 = f1;
+    r0 = r1;
+  }
+
+  // Pair the crossings into windows, closing the windows that are
+  // open at either end of the interval.
+  if (isInitiallyVisible)
+    crossings.prepend(0.0);
+  if (crossings.size() % 2)
+    crossings.append(span);
+
+  int sample = 0;
+  for (int i = 0; i < crossings.size(); i += 2) {
+    const double rise = crossings.at(i);
+    const double set = crossings.at(i + 1);
+
+    // Search for the culmination around the highest coarse sample in
+    // the window.
+    double best = 0.5 * (rise + set);
+    double bestValue = f(best);
+    while (sample < times.size() && times.at(sample) <= set) {
+      if (times.at(sample) >= rise && values.at(sample) > bestValue) {
+        best = times.at(sample);
+        bestValue = values.at(sample);
+      }
+      ++sample;
+    }
+    double maximum;
+    double culmination = GoldenSectionMaximum(f,
+                                              qMax(rise, best - m_step),
+                                              qMin(set, best + m_step),
+                                              m_tolerance, &maximum);
+    if (bestValue > maximum) {
+      culmination = best;
+      maximum = bestValue;
+    }
+
+    VisibilityWindow window;
+    window.rise = QDateTime::fromMSecsSinceEpoch(qRound64(origin + 1000.0 * rise), Qt::UTC);
+    window.set = QDateTime::fromMSecsSinceEpoch(qRound64(origin + 1000.0 * set), Qt::UTC);
+    window.culmination = QDateTime::fromMSecsSinceEpoch(qRound64(origin + 1000.0 * culmination), Qt::UTC);
+    window.maxElevation = maximum + m_elevationMask;
+    result.append(window);
+  }
+  return result;
+}
+
+QVector<QVector<VisibilityWindow> > VisibilityPredictor::windows(QVector<Trajectory const *> const &trajectories,
+                                                                 QDateTime const &start,
+                                                                 QDateTime const &end) const
+{
+  // Each task writes its own element of the result, so no locking is
+  // needed.
+  QVector<QVector<VisibilityWindow> > result(trajectories.size());
+  QVector<int> indexes(trajectories.size());
+  for (int i = 0; i < indexes.size(); ++i)
+    indexes[i] = i;
+  QtConcurrent::blockingMap(indexes, [&](int i) {
+      result[i] = windows(*trajectories.at(i), start, end);
+    });
+  return result;
+}
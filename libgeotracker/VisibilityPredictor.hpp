@@ -0,0 +1,87 @@
+#pragma once
+
+#include <QVector>
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include "Refraction.hpp"
+#include "Trajectory.hpp"
+
+class GeoObserver;
+
+// A VisibilityWindow is an interval of time during which a target is
+// above an observer's elevation mask.
+
+struct VisibilityWindow
+{
+  QDateTime rise;          // the target rises above the mask
+  QDateTime set;           // the target sets below the mask
+  QDateTime culmination;   // time of the maximum elevation
+  double    maxElevation;  // degrees
+};
+
+// The VisibilityPredictor finds the windows of time during which a
+// target following a predictable Trajectory can be seen by an
+// observer, i.e. is above the observer's elevation mask.
+//
+// Rather than sampling the look angle at the resolution required of
+// the answer, the elevation is sampled at a coarse step together with
+// its rate of change.  A change of sign of the elevation above the
+// mask between two samples brackets a rise or a set.  A change of
+// sign of the rate without a change of sign of the elevation
+// brackets a peak (or a dip) that may briefly cross the mask; the
+// extremum is located and, if it crosses the mask, it splits the
+// interval into two brackets.  Each bracket is then refined with
+// Brent's method to the requested tolerance.  So the coarse step
+// need only be shorter than the time between successive extrema of
+// the elevation, not shorter than the windows themselves.
+//
+// Predictions for many targets are independent and are run in
+// parallel on the global thread pool.
+
+class VisibilityPredictor
+{
+public:
+  VisibilityPredictor();
+  VisibilityPredictor(QGeoCoordinate const &observer, double elevationMask = 0.0);
+  VisibilityPredictor(GeoObserver const &observer);
+
+  QGeoCoordinate observer() const;
+  void setObserver(QGeoCoordinate const &observer);
+
+  double elevationMask() const;               // degrees
+  void setElevationMask(double elevationMask);
+
+  Refraction refraction() const;
+  void setRefraction(Refraction const &refraction);
+
+  int step() const;                           // seconds between coarse samples
+  void setStep(int step);
+
+  double tolerance() const;                   // seconds of accuracy of the crossings
+  void setTolerance(double tolerance);
+
+  // The elevation in degrees of the target at the given time in
+  // milliseconds since 1970, or -90 if the trajectory is not defined
+  // at that time.
+  double elevationAt(Trajectory const &trajectory, double msecsSinceEpoch) const;
+
+  // The visibility windows of one target between two times.  A
+  // window that is open at the start or at the end of the interval
+  // is cut short.
+  QVector<VisibilityWindow> windows(Trajectory const &trajectory,
+                                    QDateTime const &start,
+                                    QDateTime const &end) const;
+
+  // The visibility windows of many targets between two times, in the
+  // order of the trajectories.
+  QVector<QVector<VisibilityWindow> > windows(QVector<Trajectory const *> const &trajectories,
+                                              QDateTime const &start,
+                                              QDateTime const &end) const;
+
+private:
+  QGeoCoordinate m_observer;
+  double         m_elevationMask;
+  Refraction     m_refraction;
+  int            m_step;
+  double         m_tolerance;
+};
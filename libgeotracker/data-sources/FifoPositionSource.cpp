@@ -0,0 +1,76 @@
+#include <QtCore>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include "FifoPositionSource.hpp"
+#include "LatencyTrace.hpp"
+
+static const int ReadBufferSize = 65536;
+
+FifoPositionSource::FifoPositionSource(QString const &fileName, QObject *parent)
+  : StreamPositionSource(parent),
+    m_fileName(fileName),
+    m_fd(-1),
+    notifier(nullptr),
+    m_buffer(ReadBufferSize, Qt::Uninitialized)
+{
+}
+
+FifoPositionSource::~FifoPositionSource()
+{
+  close();
+}
+
+bool FifoPositionSource::open()
+{
+  if (m_fileName == "-") {
+    m_fd = STDIN_FILENO;
+  } else {
+    // Without O_NONBLOCK, opening a FIFO blocks until a writer opens
+    // it too.
+    m_fd = ::open(QFile::encodeName(m_fileName).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+      qWarning() << "Error: cannot open FIFO" << m_fileName << strerror(errno);
+      return false;
+    }
+  }
+  notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+  connect(notifier, SIGNAL(activated(int)), this, SLOT(readData()));
+  return true;
+}
+
+void FifoPositionSource::close()
+{
+  delete notifier;
+  notifier = nullptr;
+  if (m_fd >= 0 && m_fd != STDIN_FILENO)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+void FifoPositionSource::readData()
+{
+  LATENCY_TRACE_SCOPE();
+  // One read per notification: the standard input may be blocking,
+  // and the notifier fires again while there is more to read.
+  ssize_t size;
+  do {
+    size = ::read(m_fd, m_buffer.data(), size_t(m_buffer.size()));
+  } while (size < 0 && errno == EINTR);
+
+  if (size > 0) {
+    consume(m_buffer.constData(), size);
+    flush();
+  } else if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+    return;
+  } else if (size == 0 && m_fd != STDIN_FILENO) {
+    // The last writer closed the FIFO.  Reopen it, or else the
+    // notifier keeps reporting the end of the file.
+    close();
+    if (!open())
+      fail(AccessError);
+  } else {
+    fail(ClosedError);
+  }
+}
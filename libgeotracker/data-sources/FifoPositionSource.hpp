@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QSocketNotifier>
+#include "StreamPositionSource.hpp"
+
+// The FIFO Position Source reads lines in the log format (see
+// LogFilePositionSource) from a named pipe, or from the standard
+// input if the file name is "-".
+//
+// A named pipe outlives its writers: when a writer closes it, the
+// source waits for the next one.  The end of the standard input is
+// reported with the ClosedError.  POSIX only.
+
+class FifoPositionSource : public StreamPositionSource
+{
+  Q_OBJECT
+public:
+  FifoPositionSource(QString const &fileName, QObject *parent = 0);
+  ~FifoPositionSource();
+
+protected:
+  virtual bool open();
+  virtual void close();
+
+private slots:
+  void readData();
+
+private:
+  QString m_fileName;
+  int m_fd;
+  QSocketNotifier *notifier;
+  QByteArray m_buffer;
+};
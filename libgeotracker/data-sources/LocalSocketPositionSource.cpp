@@ -0,0 +1,48 @@
+#include <QtCore>
+#include "LocalSocketPositionSource.hpp"
+#include "LatencyTrace.hpp"
+
+static const int ReadBufferSize = 65536;
+
+LocalSocketPositionSource::LocalSocketPositionSource(QString const &serverName, QObject *parent)
+  : StreamPositionSource(parent),
+    m_serverName(serverName),
+    socket(new QLocalSocket(this)),
+    m_buffer(ReadBufferSize, Qt::Uninitialized)
+{
+  connect(socket, SIGNAL(readyRead()), this, SLOT(readData()));
+  connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+}
+
+bool LocalSocketPositionSource::open()
+{
+  socket->connectToServer(m_serverName, QIODevice::ReadOnly);
+  if (!socket->waitForConnected(1000)) {
+    qWarning() << "Error: cannot connect to" << m_serverName << socket->errorString();
+    return false;
+  }
+  return true;
+}
+
+void LocalSocketPositionSource::close()
+{
+  socket->abort();
+}
+
+void LocalSocketPositionSource::readData()
+{
+  LATENCY_TRACE_SCOPE();
+  while (isActive() && socket->bytesAvailable() > 0) {
+    const qint64 size = socket->read(m_buffer.data(), m_buffer.size());
+    if (size <= 0)
+      break;
+    consume(m_buffer.constData(), size);
+  }
+  flush();
+}
+
+void LocalSocketPositionSource::onDisconnected()
+{
+  if (isActive())
+    fail(ClosedError);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QLocalSocket>
+#include "StreamPositionSource.hpp"
+
+// The Local Socket Position Source connects to a Unix domain stream
+// socket (a named pipe on Windows) and reads lines in the log format
+// (see LogFilePositionSource) from it.  The ClosedError is reported
+// when the server closes the connection.
+
+class LocalSocketPositionSource : public StreamPositionSource
+{
+  Q_OBJECT
+public:
+  LocalSocketPositionSource(QString const &serverName, QObject *parent = 0);
+
+protected:
+  virtual bool open();
+  virtual void close();
+
+private slots:
+  void readData();
+  void onDisconnected();
+
+private:
+  QString m_serverName;
+  QLocalSocket *socket;
+  QByteArray m_buffer;
+};
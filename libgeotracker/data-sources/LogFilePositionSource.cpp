@@ -40,6 +40,7 @@
 // taken from https://doc.qt.io/archives/qt-5.8/qtpositioning-logfilepositionsource-logfilepositionsource-cpp.html
 #include <QtCore>
 #include "LogFilePositionSource.hpp"
+#include "LatencyTrace.hpp"
 
 LogFilePositionSource::LogFilePositionSource(QObject *parent)
   : QGeoPositionInfoSource(parent),
@@ -54,6 +55,37 @@ LogFilePositionSource::LogFilePositionSource(QObject *parent)
     qWarning() << "Error: cannot open source file" << logFile->fileName();
 }
 
+LogFilePositionSource::LogFilePositionSource(QString const &fileName, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    logFile(new QFile(fileName, this)),
+    timer(new QTimer(this))
+{
+  connect(timer, SIGNAL(timeout()), this, SLOT(readNextPosition()));
+
+  if (!logFile->open(QIODevice::ReadOnly))
+    qWarning() << "Error: cannot open source file" << logFile->fileName();
+}
+
+bool LogFilePositionSource::parseLine(QByteArray const &line, QGeoPositionInfo *info)
+{
+  QList<QByteArray> data = line.trimmed().split(' ');
+  double latitude;
+  double longitude;
+  double altitude;
+  bool hasLatitude = false;
+  bool hasLongitude = false;
+  bool hasAltitude = false;
+  QDateTime timestamp = QDateTime::fromString(QString(data.value(0)), Qt::ISODate);
+  latitude = data.value(1).toDouble(&hasLatitude);
+  longitude = data.value(2).toDouble(&hasLongitude);
+  altitude = data.value(3).toDouble(&hasAltitude);
+
+  if (!(hasLatitude && hasLongitude && hasAltitude && timestamp.isValid()))
+    return false;
+  *info = QGeoPositionInfo(QGeoCoordinate(latitude, longitude, altitude), timestamp);
+  return info->isValid();
+}
+
 QGeoPositionInfo LogFilePositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
 {
   return lastPosition;
@@ -93,29 +125,15 @@ void LogFilePositionSource::requestUpdate(int /* timeout */)
 
 void LogFilePositionSource::readNextPosition()
 {
+  LATENCY_TRACE_SCOPE();
   QByteArray line = logFile->readLine().trimmed();
   if (line.isEmpty()) {
     emit error(QGeoPositionInfoSource::ClosedError);
   } else {
-    QList<QByteArray> data = line.split(' ');
-    double latitude;
-    double longitude;
-    double altitude;
-    bool hasLatitude = false;
-    bool hasLongitude = false;
-    bool hasAltitude = false;
-    QDateTime timestamp = QDateTime::fromString(QString(data.value(0)), Qt::ISODate);
-    latitude = data.value(1).toDouble(&hasLatitude);
-    longitude = data.value(2).toDouble(&hasLongitude);
-    altitude = data.value(3).toDouble(&hasAltitude);
-
-    if (hasLatitude && hasLongitude && hasAltitude && timestamp.isValid()) {
-      QGeoCoordinate coordinate(latitude, longitude, altitude);
-      QGeoPositionInfo info(coordinate, timestamp);
-      if (info.isValid()) {
-        lastPosition = info;
-        emit positionUpdated(info);
-      }
+    QGeoPositionInfo info;
+    if (parseLine(line, &info)) {
+      lastPosition = info;
+      emit positionUpdated(info);
     }
   }
 }
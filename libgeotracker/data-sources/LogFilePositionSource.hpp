@@ -68,12 +68,21 @@
 //
 // The class reads this data and distributes it via the
 // positionUpdated() signal.
+//
+// By default the data is read from a short log compiled into the
+// application's resources.  Any other file may be given instead.
 
 class LogFilePositionSource : public QGeoPositionInfoSource
 {
   Q_OBJECT
 public:
   LogFilePositionSource(QObject *parent = 0);
+  LogFilePositionSource(QString const &fileName, QObject *parent = 0);
+
+  // Parse one line of the log format.  Returns false if the line is
+  // malformed.  This is shared with the other sources that carry the
+  // same format over other transports.
+  static bool parseLine(QByteArray const &line, QGeoPositionInfo *info);
   
   QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
   
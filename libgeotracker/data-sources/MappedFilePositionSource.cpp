@@ -0,0 +1,106 @@
+#include <QtCore>
+#include "MappedFilePositionSource.hpp"
+#include "LogFilePositionSource.hpp"
+#include "LatencyTrace.hpp"
+
+// Lines replayed per timer event when there is no update interval
+static const int ReplayBatchSize = 1024;
+
+MappedFilePositionSource::MappedFilePositionSource(QString const &fileName, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    mappedFile(new QFile(fileName, this)),
+    timer(new QTimer(this)),
+    m_data(nullptr),
+    m_size(0),
+    m_offset(0),
+    m_error(NoError)
+{
+  connect(timer, SIGNAL(timeout()), this, SLOT(readNextPositions()));
+
+  if (mappedFile->open(QIODevice::ReadOnly)) {
+    m_size = mappedFile->size();
+    if (m_size > 0)
+      m_data = reinterpret_cast<char const *>(mappedFile->map(0, m_size));
+  }
+  if (!m_data && m_size != 0) {
+    qWarning() << "Error: cannot map source file" << mappedFile->fileName();
+    m_error = AccessError;
+  } else if (!mappedFile->isOpen()) {
+    qWarning() << "Error: cannot open source file" << mappedFile->fileName();
+    m_error = AccessError;
+  }
+}
+
+QGeoPositionInfo MappedFilePositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  return lastPosition;
+}
+
+MappedFilePositionSource::PositioningMethods MappedFilePositionSource::supportedPositioningMethods() const
+{
+  return AllPositioningMethods;
+}
+
+int MappedFilePositionSource::minimumUpdateInterval() const
+{
+  return 0;
+}
+
+QGeoPositionInfoSource::Error MappedFilePositionSource::error() const
+{
+  return m_error;
+}
+
+void MappedFilePositionSource::startUpdates()
+{
+  if (m_error != NoError) {
+    emit error(m_error);
+    return;
+  }
+  timer->start(qMax(updateInterval(), minimumUpdateInterval()));
+}
+
+void MappedFilePositionSource::stopUpdates()
+{
+  timer->stop();
+}
+
+void MappedFilePositionSource::requestUpdate(int /* timeout */)
+{
+  if (!readNextPosition())
+    emit updateTimeout();
+}
+
+void MappedFilePositionSource::readNextPositions()
+{
+  const int count = timer->interval() == 0 ? ReplayBatchSize : 1;
+  for (int i = 0; i < count && timer->isActive(); ++i) {
+    if (!readNextPosition()) {
+      timer->stop();
+      m_error = ClosedError;
+      emit error(QGeoPositionInfoSource::ClosedError);
+      return;
+    }
+  }
+}
+
+bool MappedFilePositionSource::readNextPosition()
+{
+  LATENCY_TRACE_SCOPE();
+  // Skip malformed lines; return false at the end of the file.
+  while (m_offset < m_size) {
+    char const *begin = m_data + m_offset;
+    char const *end = static_cast<char const *>(memchr(begin, '\n', size_t(m_size - m_offset)));
+    if (!end)
+      end = m_data + m_size;
+    m_offset = end - m_data + 1;
+
+    QGeoPositionInfo info;
+    if (LogFilePositionSource::parseLine(QByteArray::fromRawData(begin, int(end - begin)), &info)) {
+      lastPosition = info;
+      emit positionUpdated(info);
+      return true;
+    }
+  }
+  return false;
+}
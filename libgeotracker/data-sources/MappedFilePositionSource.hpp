@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QFile>
+#include <QTimer>
+
+// The Mapped File Position Source replays a log file (see
+// LogFilePositionSource for the format) that is mapped into memory
+// rather than read line by line through a buffered file, which makes
+// it the cheapest way to feed a recorded log.
+//
+// One position is distributed per update interval.  With an update
+// interval of zero the log is replayed as fast as possible, a batch
+// of lines at a time so that the event loop keeps running.  The end
+// of the log is reported with the ClosedError.
+
+class MappedFilePositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  MappedFilePositionSource(QString const &fileName, QObject *parent = 0);
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+private slots:
+  void readNextPositions();
+
+private:
+  bool readNextPosition();
+
+  QFile *mappedFile;
+  QTimer *timer;
+  char const *m_data;
+  qint64 m_size;
+  qint64 m_offset;
+  Error m_error;
+  QGeoPositionInfo lastPosition;
+};
@@ -0,0 +1,251 @@
+#include <string.h>
+#include "MavlinkParser.hpp"
+
+static const quint8 Version1Magic = 0xfe;
+static const quint8 Version2Magic = 0xfd;
+static const int Version1HeaderLength = 6;
+static const int Version2HeaderLength = 10;
+static const int ChecksumLength = 2;
+static const int SignatureLength = 13;
+static const quint8 SignedFlag = 0x01;
+
+static
+bool IsMagic(quint8 byte)
+{
+  return byte == Version1Magic || byte == Version2Magic;
+}
+
+// The definitions of the known messages: the CRC_EXTRA of their
+// checksum and the length of their payload.
+static
+bool MessageDefinition(quint32 messageId, quint8 *crcExtra, int *length)
+{
+  switch (messageId) {
+  case MavlinkParser::Attitude:
+    *crcExtra = 39;
+    *length = 28;
+    return true;
+  case MavlinkParser::GlobalPositionInt:
+    *crcExtra = 104;
+    *length = 28;
+    return true;
+  default:
+    return false;
+  }
+}
+
+quint8 MavlinkFrame::uint8At(int offset) const
+{
+  return offset < length ? payload[offset] : 0;
+}
+
+quint16 MavlinkFrame::uint16At(int offset) const
+{
+  return quint16(uint8At(offset) | uint8At(offset + 1) << 8);
+}
+
+qint16 MavlinkFrame::int16At(int offset) const
+{
+  return qint16(uint16At(offset));
+}
+
+quint32 MavlinkFrame::uint32At(int offset) const
+{
+  return quint32(uint16At(offset)) | quint32(uint16At(offset + 2)) << 16;
+}
+
+qint32 MavlinkFrame::int32At(int offset) const
+{
+  return qint32(uint32At(offset));
+}
+
+float MavlinkFrame::floatAt(int offset) const
+{
+  const quint32 bits = uint32At(offset);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+MavlinkParser::MavlinkParser() :
+  m_data(nullptr),
+  m_end(nullptr),
+  m_pending(0),
+  m_returned(0),
+  m_synchronized(false),
+  m_frames(0),
+  m_errors(0),
+  m_skipped(0)
+{
+}
+
+quint64 MavlinkParser::frames() const
+{
+  return m_frames;
+}
+
+quint64 MavlinkParser::errors() const
+{
+  return m_errors;
+}
+
+quint64 MavlinkParser::skipped() const
+{
+  return m_skipped;
+}
+
+quint16 MavlinkParser::crc(void const *data, int size, quint16 crc)
+{
+  quint8 const *bytes = static_cast<quint8 const *>(data);
+  for (int i = 0; i < size; ++i) {
+    quint8 t = quint8(bytes[i] ^ (crc & 0xff));
+    t ^= quint8(t << 4);
+    crc = quint16((crc >> 8) ^ (t << 8) ^ (t << 3) ^ (t >> 4));
+  }
+  return crc;
+}
+
+void MavlinkParser::setData(char const *data, qint64 size)
+{
+  m_data = reinterpret_cast<quint8 const *>(data);
+  m_end = m_data + size;
+}
+
+MavlinkParser::Check MavlinkParser::check(quint8 const *p, int available, int *length, MavlinkFrame *frame)
+{
+  // The length of the frame, once enough of the header is there
+  const bool isVersion2 = p[0] == Version2Magic;
+  if (available < (isVersion2 ? 3 : 2))
+    return Incomplete;
+  const int payloadLength = p[1];
+  *length = (isVersion2 ? Version2HeaderLength : Version1HeaderLength) + payloadLength + ChecksumLength;
+  if (isVersion2) {
+    if (p[2] & ~SignedFlag)
+      return Invalid;       // incompatible features
+    if (p[2] & SignedFlag)
+      *length += SignatureLength;
+  }
+  if (available < *length)
+    return Incomplete;
+
+  frame->version = isVersion2 ? 2 : 1;
+  if (isVersion2) {
+    frame->sequence = p[4];
+    frame->systemId = p[5];
+    frame->componentId = p[6];
+    frame->messageId = quint32(p[7]) | quint32(p[8]) << 8 | quint32(p[9]) << 16;
+    frame->payload = p + Version2HeaderLength;
+  } else {
+    frame->sequence = p[2];
+    frame->systemId = p[3];
+    frame->componentId = p[4];
+    frame->messageId = p[5];
+    frame->payload = p + Version1HeaderLength;
+  }
+  frame->length = payloadLength;
+
+  quint8 crcExtra;
+  int messageLength;
+  if (!MessageDefinition(frame->messageId, &crcExtra, &messageLength))
+    return Other;
+  // Only MAVLink 2 truncates payloads
+  if (payloadLength > messageLength || (!isVersion2 && payloadLength != messageLength))
+    return Invalid;
+
+  // The checksum covers the frame but its magic, and the CRC_EXTRA
+  quint8 const *checksum = frame->payload + payloadLength;
+  quint16 sum = crc(p + 1, int(checksum - p - 1));
+  sum = crc(&crcExtra, 1, sum);
+  if (sum != quint16(checksum[0] | checksum[1] << 8))
+    return Invalid;
+  return Valid;
+}
+
+void MavlinkParser::discard(int count)
+{
+  m_pending -= count;
+  memmove(m_buffer, m_buffer + count, size_t(m_pending));
+}
+
+bool MavlinkParser::next(MavlinkFrame *frame)
+{
+  // The frame returned from the buffer last time
+  if (m_returned > 0) {
+    discard(m_returned);
+    m_returned = 0;
+  }
+
+  for (;;) {
+    int length = 0;
+    if (m_pending > 0) {
+      // Complete the frame split by the last read, a little at a time
+      // since its length is only known from its header.
+      Check result;
+      while ((result = check(m_buffer, m_pending, &length, frame)) == Incomplete) {
+        const int wanted = length > m_pending ? length - m_pending : 3 - m_pending;
+        const int count = int(qMin<qint64>(wanted, m_end - m_data));
+        if (count <= 0)
+          return false;
+        memcpy(m_buffer + m_pending, m_data, size_t(count));
+        m_pending += count;
+        m_data += count;
+      }
+      // After a resynchronization, the buffer may hold more than the
+      // frame.
+      if (result == Valid) {
+        m_synchronized = true;
+        m_returned = length;
+        ++m_frames;
+        return true;
+      }
+      quint8 const *after = length < m_pending ? m_buffer + length : m_data;
+      if (result == Other && m_synchronized && (after == m_end || IsMagic(*after))) {
+        discard(length);
+        ++m_skipped;
+        continue;
+      }
+      // Look for the next frame in what was buffered
+      if (result == Invalid)
+        ++m_errors;
+      m_synchronized = false;
+      int start = 1;
+      while (start < m_pending && !IsMagic(m_buffer[start]))
+        ++start;
+      discard(start);
+      continue;
+    }
+
+    // Frames within the data are checked in place
+    while (m_data < m_end && !IsMagic(*m_data))
+      ++m_data;
+    if (m_data == m_end)
+      return false;
+    const int available = int(qMin<qint64>(m_end - m_data, sizeof(m_buffer)));
+    switch (check(m_data, available, &length, frame)) {
+    case Valid:
+      m_data += length;
+      m_synchronized = true;
+      ++m_frames;
+      return true;
+    case Other:
+      if (m_synchronized && (m_data + length == m_end || IsMagic(m_data[length]))) {
+        m_data += length;
+        ++m_skipped;
+      } else {
+        m_synchronized = false;
+        ++m_data;
+      }
+      break;
+    case Invalid:
+      ++m_data;
+      m_synchronized = false;
+      ++m_errors;
+      break;
+    case Incomplete:
+      m_pending = available;
+      memcpy(m_buffer, m_data, size_t(available));
+      m_data = m_end;
+      return false;
+    }
+  }
+}
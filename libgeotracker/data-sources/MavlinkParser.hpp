@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QtGlobal>
+
+// A MavlinkFrame is one MAVLink message, version 1 or 2.  The payload
+// points into the data given to the parser (or into the parser's own
+// buffer, for a frame that was split between reads), and is only
+// valid until the next call to the parser.
+//
+// MAVLink 2 drops the trailing zeros of payloads, so the payload may
+// be shorter than the message; the accessors read the missing bytes
+// as zeros.
+
+struct MavlinkFrame
+{
+  int      version;         // 1 or 2
+  quint8   sequence;
+  quint8   systemId;
+  quint8   componentId;
+  quint32  messageId;
+  quint8 const *payload;
+  int      length;          // of the payload
+
+  quint8  uint8At(int offset) const;
+  quint16 uint16At(int offset) const;
+  qint16  int16At(int offset) const;
+  quint32 uint32At(int offset) const;
+  qint32  int32At(int offset) const;
+  float   floatAt(int offset) const;
+};
+
+// The MavlinkParser finds the frames in a stream of bytes from a
+// serial link or a log, and checks them.  It does not allocate, and
+// copies only the frames that are split between two reads.
+//
+// The data is given with setData() and the frames are then taken
+// one by one with next():
+//
+//   parser.setData(buffer, size);
+//   MavlinkFrame frame;
+//   while (parser.next(&frame))
+//     ...
+//
+// The checksum of a MAVLink message covers a constant that depends
+// on the definition of the message (CRC_EXTRA), so it can only be
+// checked for the messages this parser knows: GLOBAL_POSITION_INT
+// and ATTITUDE.  The frames of other messages are passed over by
+// their length, but only while the parser is synchronized with the
+// stream, i.e. has found a valid frame since the start or the last
+// error, and the next frame starts where the passed over one ends.
+// Otherwise what looks like the header of an unknown message is
+// more likely noise.  Signed MAVLink 2 frames are accepted, but their
+// signature is not checked.
+
+class MavlinkParser
+{
+public:
+  enum MessageId {
+    Attitude = 30,
+    GlobalPositionInt = 33
+  };
+
+  MavlinkParser();
+
+  void setData(char const *data, qint64 size);
+  bool next(MavlinkFrame *frame);
+
+  // The number of frames of known messages returned, of those
+  // rejected for their checksum or length, and of frames of other
+  // messages passed over.
+  quint64 frames() const;
+  quint64 errors() const;
+  quint64 skipped() const;
+
+  // The CRC-16/MCRF4XX checksum of MAVLink
+  static quint16 crc(void const *data, int size, quint16 crc = 0xffff);
+
+private:
+  enum Check { Incomplete, Valid, Invalid, Other };
+  Check check(quint8 const *p, int available, int *length, MavlinkFrame *frame);
+  void discard(int count);
+
+  quint8 const *m_data;
+  quint8 const *m_end;
+  quint8 m_buffer[280];     // the largest MAVLink 2 frame
+  int m_pending;            // bytes of a split frame in the buffer
+  int m_returned;           // bytes of the frame last returned from the buffer
+  bool m_synchronized;
+  quint64 m_frames;
+  quint64 m_errors;
+  quint64 m_skipped;
+};
@@ -0,0 +1,278 @@
+#include <QtCore>
+#include <QtMath>
+#include <QMetaMethod>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "MavlinkPositionSource.hpp"
+#include "LatencyTrace.hpp"
+
+static const int ReadBufferSize = 65536;
+static const int InitialBatchSize = 256;
+
+static
+speed_t BaudRate(int baudRate)
+{
+  switch (baudRate) {
+  case 9600:    return B9600;
+  case 19200:   return B19200;
+  case 38400:   return B38400;
+  case 57600:   return B57600;
+  case 115200:  return B115200;
+  case 230400:  return B230400;
+#ifdef B460800
+  case 460800:  return B460800;
+#endif
+#ifdef B921600
+  case 921600:  return B921600;
+#endif
+  default:      return B0;
+  }
+}
+
+MavlinkPositionSource::MavlinkPositionSource(QString const &fileName, int baudRate, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    m_fileName(fileName),
+    m_baudRate(baudRate),
+    m_fd(-1),
+    m_isFile(false),
+    notifier(nullptr),
+    m_error(NoError),
+    m_buffer(ReadBufferSize, Qt::Uninitialized),
+    m_updatedCount(0),
+    m_sink(nullptr),
+    m_reading(new QRotationReading(this)),
+    lastSample(PositionSample::invalid())
+{
+  for (int i = 0; i < 256; ++i) {
+    m_vehicles[i].position = PositionSample::invalid(quint64(i));
+    m_vehicles[i].roll = m_vehicles[i].pitch = m_vehicles[i].yaw = 0.0f;
+    m_vehicles[i].attitudeTime = 0;
+    m_vehicles[i].pending = 0;
+  }
+  m_batch.reserve(InitialBatchSize);
+}
+
+MavlinkPositionSource::~MavlinkPositionSource()
+{
+  close();
+}
+
+QGeoPositionInfo MavlinkPositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  if (!lastSample.isValid())
+    return QGeoPositionInfo();
+  return lastSample.toPositionInfo();
+}
+
+MavlinkPositionSource::PositioningMethods MavlinkPositionSource::supportedPositioningMethods() const
+{
+  return SatellitePositioningMethods;
+}
+
+int MavlinkPositionSource::minimumUpdateInterval() const
+{
+  return 0;
+}
+
+QGeoPositionInfoSource::Error MavlinkPositionSource::error() const
+{
+  return m_error;
+}
+
+GeoEntity *MavlinkPositionSource::entity(quint8 systemId) const
+{
+  return m_entities[systemId];
+}
+
+void MavlinkPositionSource::setEntity(quint8 systemId, GeoEntity *entity)
+{
+  m_entities[systemId] = entity;
+}
+
+PositionSample MavlinkPositionSource::position(quint8 systemId) const
+{
+  return m_vehicles[systemId].position;
+}
+
+PositionSampleSink *MavlinkPositionSource::sampleSink() const
+{
+  return m_sink;
+}
+
+void MavlinkPositionSource::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+MavlinkParser const &MavlinkPositionSource::parser() const
+{
+  return m_parser;
+}
+
+void MavlinkPositionSource::startUpdates()
+{
+  if (m_fd >= 0)
+    return;
+  if (!open())
+    fail(AccessError);
+}
+
+void MavlinkPositionSource::stopUpdates()
+{
+  close();
+}
+
+void MavlinkPositionSource::requestUpdate(int /* timeout */)
+{
+  if (lastSample.isValid())
+    emit positionUpdated(lastSample.toPositionInfo());
+  else
+    emit updateTimeout();
+}
+
+bool MavlinkPositionSource::open()
+{
+  m_fd = ::open(QFile::encodeName(m_fileName).constData(), O_RDONLY | O_NONBLOCK | O_NOCTTY | O_CLOEXEC);
+  if (m_fd < 0) {
+    qWarning() << "Error: cannot open" << m_fileName << strerror(errno);
+    return false;
+  }
+
+  struct stat status;
+  m_isFile = ::fstat(m_fd, &status) == 0 && S_ISREG(status.st_mode);
+  if (::isatty(m_fd)) {
+    // Raw bytes, at the baud rate of the link
+    struct termios options;
+    if (::tcgetattr(m_fd, &options) == 0) {
+      ::cfmakeraw(&options);
+      options.c_cflag |= CLOCAL | CREAD;
+      const speed_t speed = BaudRate(m_baudRate);
+      if (speed != B0) {
+        ::cfsetispeed(&options, speed);
+        ::cfsetospeed(&options, speed);
+      } else {
+        qWarning() << "Warning: unsupported baud rate" << m_baudRate;
+      }
+      ::tcsetattr(m_fd, TCSANOW, &options);
+    }
+  }
+
+  notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+  connect(notifier, SIGNAL(activated(int)), this, SLOT(readData()));
+  return true;
+}
+
+void MavlinkPositionSource::close()
+{
+  delete notifier;
+  notifier = nullptr;
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+void MavlinkPositionSource::fail(Error e)
+{
+  m_error = e;
+  close();
+  emit error(e);
+}
+
+void MavlinkPositionSource::readData()
+{
+  LATENCY_TRACE_SCOPE();
+  ssize_t size;
+  do {
+    size = ::read(m_fd, m_buffer.data(), size_t(m_buffer.size()));
+  } while (size < 0 && errno == EINTR);
+
+  if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    return;
+  if (size <= 0) {
+    // The end of a file, or a pseudo terminal closed by its master
+    // (EIO)
+    fail(ClosedError);
+    return;
+  }
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  MavlinkFrame frame;
+  m_parser.setData(m_buffer.constData(), size);
+  while (m_parser.next(&frame))
+    decode(frame, now);
+  deliver();
+}
+
+void MavlinkPositionSource::decode(MavlinkFrame const &frame, qint64 now)
+{
+  Vehicle &vehicle = m_vehicles[frame.systemId];
+  const int pending = vehicle.pending;
+  if (frame.messageId == MavlinkParser::GlobalPositionInt) {
+    // time_boot_ms, lat, lon (degE7), alt, relative_alt (mm), vx, vy,
+    // vz (cm/s, north, east, down), hdg (cdeg)
+    PositionSample sample = PositionSample::invalid(frame.systemId);
+    sample.timestamp = now;
+    sample.latitude = frame.int32At(4) * 1.0e-7;
+    sample.longitude = frame.int32At(8) * 1.0e-7;
+    sample.altitude = frame.int32At(12) * 1.0e-3;
+    const double north = frame.int16At(20) * 0.01;
+    const double east = frame.int16At(22) * 0.01;
+    sample.groundSpeed = qSqrt(north * north + east * east);
+    sample.verticalSpeed = -frame.int16At(24) * 0.01;
+    const quint16 heading = frame.uint16At(26);
+    if (heading != 0xffff)
+      sample.direction = heading * 0.01;
+    else if (sample.groundSpeed > 0.0)
+      sample.direction = qRadiansToDegrees(qAtan2(east, north)) + (east < 0.0 ? 360.0 : 0.0);
+    if (!sample.isValid())
+      return;
+    vehicle.position = sample;
+    vehicle.pending |= PositionPending;
+    lastSample = sample;
+    m_batch.append(sample);
+  } else if (frame.messageId == MavlinkParser::Attitude) {
+    // time_boot_ms, roll, pitch, yaw (rad), and their rates
+    vehicle.attitudeTime = frame.uint32At(0);
+    vehicle.roll = frame.floatAt(4);
+    vehicle.pitch = frame.floatAt(8);
+    vehicle.yaw = frame.floatAt(12);
+    vehicle.pending |= AttitudePending;
+  }
+  if (!pending && vehicle.pending)
+    m_updated[m_updatedCount++] = frame.systemId;
+}
+
+void MavlinkPositionSource::deliver()
+{
+  if (m_sink && !m_batch.isEmpty())
+    m_sink->consume(m_batch.constData(), m_batch.size());
+  // Since Qt 5.7, clear() keeps the capacity.
+  m_batch.clear();
+
+  static const QMetaMethod positionUpdatedSignal = QMetaMethod::fromSignal(&QGeoPositionInfoSource::positionUpdated);
+  const bool isConnected = isSignalConnected(positionUpdatedSignal);
+  for (int i = 0; i < m_updatedCount; ++i) {
+    Vehicle &vehicle = m_vehicles[m_updated[i]];
+    GeoEntity *entity = m_entities[m_updated[i]];
+    if ((vehicle.pending & PositionPending) && (entity || isConnected)) {
+      const QGeoPositionInfo info = vehicle.position.toPositionInfo();
+      if (entity)
+        entity->setPosition(info);
+      if (isConnected)
+        emit positionUpdated(info);
+    }
+    if ((vehicle.pending & AttitudePending) && entity) {
+      m_reading->setTimestamp(quint64(vehicle.attitudeTime) * 1000);
+      m_reading->setFromEuler(qRadiansToDegrees(vehicle.pitch),
+                              qRadiansToDegrees(vehicle.roll),
+                              qRadiansToDegrees(vehicle.yaw));
+      entity->setRotation(m_reading);
+    }
+    vehicle.pending = 0;
+  }
+  m_updatedCount = 0;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QSocketNotifier>
+#include <QRotationReading>
+#include <QPointer>
+#include <QVector>
+#include "GeoEntity.hpp"
+#include "PositionSample.hpp"
+#include "MavlinkParser.hpp"
+
+// The MAVLink Position Source decodes the telemetry of unmanned
+// vehicles: the GLOBAL_POSITION_INT and ATTITUDE messages of MAVLink
+// version 1 or 2, read from a serial device, a pseudo terminal or a
+// file (a telemetry log, replayed as fast as it can be read).  A
+// serial device or pseudo terminal is put in raw mode at the given
+// baud rate.
+//
+// One link may carry many vehicles, told apart by their MAVLink
+// system id.  Each system id may be given a GeoEntity, which is fed
+// the position and attitude of its vehicle with setPosition() and
+// setRotation().  The positions are also distributed via the
+// positionUpdated() signal, for all the vehicles, and as
+// PositionSamples (with the system id as their id) to the sample
+// sink, if any.
+//
+// The frames of each read are decoded in place (see MavlinkParser)
+// into fixed per-vehicle state, so that bursts are handled without
+// allocating per message.  A burst of messages from a vehicle within
+// one read is coalesced: its entity and positionUpdated() receive
+// only the latest position and attitude, while the sample sink
+// receives every position.
+//
+// MAVLink positions are stamped with the time since the boot of the
+// vehicle, so the positions are stamped with the time they are
+// received instead.  The attitude is given to the entity as a
+// QRotationReading whose x is the pitch, y the roll and z the yaw
+// (clockwise from north), in degrees.  The end of a file or the
+// closing of a pseudo terminal is reported with the ClosedError.
+// POSIX only.
+
+class MavlinkPositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  MavlinkPositionSource(QString const &fileName, int baudRate = 57600, QObject *parent = 0);
+  ~MavlinkPositionSource();
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+  // The entity of a vehicle, or null.  The entity is not owned by the
+  // source.
+  GeoEntity *entity(quint8 systemId) const;
+  void setEntity(quint8 systemId, GeoEntity *entity);
+
+  // The last position of a vehicle, or an invalid sample if none was
+  // received.
+  PositionSample position(quint8 systemId) const;
+
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+  MavlinkParser const &parser() const;
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+private slots:
+  void readData();
+
+private:
+  bool open();
+  void close();
+  void fail(Error e);
+  void decode(MavlinkFrame const &frame, qint64 now);
+  void deliver();
+
+  enum Pending {
+    PositionPending = 1,
+    AttitudePending = 2
+  };
+
+  struct Vehicle
+  {
+    PositionSample position;
+    float roll;               // radians
+    float pitch;
+    float yaw;
+    quint32 attitudeTime;     // milliseconds since boot
+    int pending;
+  };
+
+  QString m_fileName;
+  int m_baudRate;
+  int m_fd;
+  bool m_isFile;
+  QSocketNotifier *notifier;
+  Error m_error;
+  QByteArray m_buffer;
+  MavlinkParser m_parser;
+  Vehicle m_vehicles[256];
+  QPointer<GeoEntity> m_entities[256];
+  quint8 m_updated[256];      // the system ids with pending updates
+  int m_updatedCount;
+  QVector<PositionSample> m_batch;
+  PositionSampleSink *m_sink;
+  QRotationReading *m_reading;
+  PositionSample lastSample;
+};
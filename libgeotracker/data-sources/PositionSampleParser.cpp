@@ -0,0 +1,590 @@
+#include <QtMath>
+#include <QDateTime>
+#include <string.h>
+#include "PositionSampleParser.hpp"
+
+static const qint64 MillisecondsPerDay = 86400000;
+static const double MetersPerSecondPerKnot = 1852.0 / 3600.0;
+
+static const double PowersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// A field of a line: the bytes in [begin, end)
+struct Field
+{
+  char const *begin;
+  char const *end;
+};
+
+static
+bool IsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static
+bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static
+char const *SkipSpace(char const *p, char const *end)
+{
+  while (p < end && IsSpace(*p))
+    ++p;
+  return p;
+}
+
+static
+bool Equals(Field const &field, char const *literal)
+{
+  const size_t size = strlen(literal);
+  return size_t(field.end - field.begin) == size && memcmp(field.begin, literal, size) == 0;
+}
+
+// Decode a decimal number, with an optional sign, fraction and
+// exponent, and advance p past it.  Up to 19 significant digits are
+// used, which is more than a double holds.
+static
+bool ParseNumber(char const *&p, char const *end, double *value)
+{
+  char const *q = p;
+  bool negative = false;
+  if (q < end && (*q == '-' || *q == '+'))
+    negative = *q++ == '-';
+
+  quint64 mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any = false;
+  for (; q < end && IsDigit(*q); ++q) {
+    any = true;
+    if (digits < 19) {
+      mantissa = 10 * mantissa + quint64(*q - '0');
+      if (mantissa)
+        ++digits;
+    } else {
+      ++exponent;
+    }
+  }
+  if (q < end && *q == '.') {
+    for (++q; q < end && IsDigit(*q); ++q) {
+      any = true;
+      if (digits < 19) {
+        mantissa = 10 * mantissa + quint64(*q - '0');
+        if (mantissa)
+          ++digits;
+        --exponent;
+      }
+    }
+  }
+  if (!any)
+    return false;
+  if (q < end && (*q == 'e' || *q == 'E')) {
+    char const *r = q + 1;
+    bool negativeExponent = false;
+    if (r < end && (*r == '-' || *r == '+'))
+      negativeExponent = *r++ == '-';
+    if (r < end && IsDigit(*r)) {
+      int e = 0;
+      for (; r < end && IsDigit(*r); ++r)
+        e = qMin(10 * e + (*r - '0'), 10000);
+      exponent += negativeExponent ? -e : e;
+      q = r;
+    }
+  }
+
+  double v = double(mantissa);
+  if (mantissa) {
+    for (; exponent > 22; exponent -= 22)
+      v *= 1e22;
+    for (; exponent < -22; exponent += 22)
+      v /= 1e22;
+    v = exponent >= 0 ? v * PowersOfTen[exponent] : v / PowersOfTen[-exponent];
+  }
+  *value = negative ? -v : v;
+  p = q;
+  return true;
+}
+
+// A number that fills the whole field
+static
+bool ParseNumber(Field const &field, double *value)
+{
+  char const *p = field.begin;
+  return ParseNumber(p, field.end, value) && p == field.end;
+}
+
+// A fixed number of decimal digits
+static
+bool ParseDigits(char const *p, char const *end, int count, int *value)
+{
+  if (end - p < count)
+    return false;
+  int v = 0;
+  for (int i = 0; i < count; ++i) {
+    if (!IsDigit(p[i]))
+      return false;
+    v = 10 * v + (p[i] - '0');
+  }
+  *value = v;
+  return true;
+}
+
+// The number of days from 1970-01-01 to a date of the proleptic
+// Gregorian calendar (H. Hinnant's days_from_civil).
+static
+qint64 DaysFromCivil(int year, int month, int day)
+{
+  year -= month <= 2;
+  const qint64 era = (year >= 0 ? year : year - 399) / 400;
+  const int yearOfEra = int(year - era * 400);
+  const int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+// Decode an ISO 8601 date and time, YYYY-MM-DDTHH:MM:SS with an
+// optional fraction of a second and time zone (Z or +HH:MM).  The
+// time is returned in milliseconds since 1970 as if it were UTC, and
+// the offset of the time zone separately.
+static
+bool ParseIsoTime(Field const &field, qint64 *msecs, bool *hasZone, int *offset)
+{
+  char const *p = field.begin;
+  char const *end = field.end;
+  int year, month, day, hour, minute, second;
+  if (!(ParseDigits(p, end, 4, &year) && end - p > 4 && p[4] == '-' &&
+        ParseDigits(p + 5, end, 2, &month) && end - p > 7 && p[7] == '-' &&
+        ParseDigits(p + 8, end, 2, &day) && end - p > 10 && (p[10] == 'T' || p[10] == 't') &&
+        ParseDigits(p + 11, end, 2, &hour) && end - p > 13 && p[13] == ':' &&
+        ParseDigits(p + 14, end, 2, &minute) && end - p > 16 && p[16] == ':' &&
+        ParseDigits(p + 17, end, 2, &second)))
+    return false;
+  if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+    return false;
+  p += 19;
+
+  int msec = 0;
+  if (p < end && (*p == '.' || *p == ',')) {
+    int scale = 100;
+    for (++p; p < end && IsDigit(*p); ++p) {
+      msec += scale * (*p - '0');
+      scale /= 10;
+    }
+  }
+
+  *hasZone = false;
+  *offset = 0;
+  if (p < end && (*p == 'Z' || *p == 'z')) {
+    *hasZone = true;
+    ++p;
+  } else if (p < end && (*p == '+' || *p == '-')) {
+    const int sign = *p == '-' ? -1 : 1;
+    int zoneHours, zoneMinutes = 0;
+    if (!ParseDigits(p + 1, end, 2, &zoneHours))
+      return false;
+    p += 3;
+    if (p < end && *p == ':')
+      ++p;
+    if (p < end) {
+      if (!ParseDigits(p, end, 2, &zoneMinutes))
+        return false;
+      p += 2;
+    }
+    *hasZone = true;
+    *offset = sign * (zoneHours * 3600 + zoneMinutes * 60);
+  }
+  if (p != end)
+    return false;
+
+  *msecs = DaysFromCivil(year, month, day) * MillisecondsPerDay
+    + ((hour * 60 + minute) * 60 + second) * 1000 + msec;
+  return true;
+}
+
+static
+qint64 TimeFromIso(Field const &field, bool zoneIsLocal, bool *ok)
+{
+  qint64 msecs;
+  bool hasZone;
+  int offset;
+  *ok = ParseIsoTime(field, &msecs, &hasZone, &offset);
+  if (!*ok)
+    return 0;
+  if (hasZone)
+    return msecs - 1000 * qint64(offset);
+  if (!zoneIsLocal)
+    return msecs;
+  // Rare enough to leave the local time zone rules to Qt
+  QDateTime utc = QDateTime::fromMSecsSinceEpoch(msecs, Qt::UTC);
+  return QDateTime(utc.date(), utc.time(), Qt::LocalTime).toMSecsSinceEpoch();
+}
+
+PositionSampleParser::PositionSampleParser() :
+  m_defaultId(0),
+  m_date(-1),
+  m_timeOfDay(0)
+{
+}
+
+quint64 PositionSampleParser::defaultId() const
+{
+  return m_defaultId;
+}
+
+void PositionSampleParser::setDefaultId(quint64 id)
+{
+  m_defaultId = id;
+}
+
+quint64 PositionSampleParser::hash(void const *data, qint64 size)
+{
+  unsigned char const *bytes = static_cast<unsigned char const *>(data);
+  quint64 h = Q_UINT64_C(14695981039346656037);
+  for (qint64 i = 0; i < size; ++i) {
+    h ^= bytes[i];
+    h *= Q_UINT64_C(1099511628211);
+  }
+  return h;
+}
+
+bool PositionSampleParser::parse(char const *begin, char const *end, PositionSample *sample)
+{
+  begin = SkipSpace(begin, end);
+  while (end > begin && IsSpace(end[-1]))
+    --end;
+  if (begin == end)
+    return false;
+
+  switch (*begin) {
+  case '$':
+  case '!':
+    return parseNmea(begin, end, sample);
+  case '{':
+    return parseGpsd(begin, end, sample);
+  default:
+    return parseLog(begin, end, sample);
+  }
+}
+
+static
+int HexDigit(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// NMEA latitude or longitude: (d)ddmm.mmmm and a hemisphere
+static
+bool ParseNmeaAngle(Field const &value, Field const &hemisphere, char negative, double *angle)
+{
+  double v;
+  if (!ParseNumber(value, &v) || hemisphere.end - hemisphere.begin != 1)
+    return false;
+  const double degrees = qFloor(v / 100.0);
+  v = degrees + (v - 100.0 * degrees) / 60.0;
+  *angle = *hemisphere.begin == negative ? -v : v;
+  return true;
+}
+
+// NMEA time of day, hhmmss.sss, in milliseconds
+static
+bool ParseNmeaTime(Field const &field, qint64 *msecs)
+{
+  int hour, minute;
+  double second;
+  Field seconds = { field.begin + 4, field.end };
+  if (!(ParseDigits(field.begin, field.end, 2, &hour) &&
+        ParseDigits(field.begin + 2, field.end, 2, &minute) &&
+        ParseNumber(seconds, &second)))
+    return false;
+  if (hour > 23 || minute > 59 || second >= 61.0)
+    return false;
+  *msecs = (hour * 60 + minute) * 60000 + qRound64(second * 1000.0);
+  return true;
+}
+
+bool PositionSampleParser::parseNmea(char const *begin, char const *end, PositionSample *sample)
+{
+  // The checksum is the exclusive or of the characters between the $
+  // and the *, in two hexadecimal digits.
+  char const *star = static_cast<char const *>(memchr(begin, '*', size_t(end - begin)));
+  if (star) {
+    if (end - star < 3)
+      return false;
+    unsigned char sum = 0;
+    for (char const *p = begin + 1; p < star; ++p)
+      sum ^= static_cast<unsigned char>(*p);
+    const int high = HexDigit(star[1]);
+    const int low = HexDigit(star[2]);
+    if (high < 0 || low < 0 || sum != ((high << 4) | low))
+      return false;
+    end = star;
+  }
+
+  // Split the fields, which are few, on the stack
+  const int MaximumFields = 24;
+  Field fields[MaximumFields];
+  int count = 0;
+  char const *p = begin + 1;
+  for (;;) {
+    char const *comma = static_cast<char const *>(memchr(p, ',', size_t(end - p)));
+    char const *fieldEnd = comma ? comma : end;
+    if (count == MaximumFields)
+      return false;
+    fields[count].begin = p;
+    fields[count].end = fieldEnd;
+    ++count;
+    if (!comma)
+      break;
+    p = comma + 1;
+  }
+
+  // The talker (GP, GN, GL, ...) does not matter
+  Field const &type = fields[0];
+  if (type.end - type.begin != 5)
+    return false;
+  const bool isGga = memcmp(type.begin + 2, "GGA", 3) == 0;
+  const bool isRmc = memcmp(type.begin + 2, "RMC", 3) == 0;
+
+  PositionSample s = PositionSample::invalid(m_defaultId);
+  qint64 timeOfDay;
+  if (isGga) {
+    // $--GGA,time,lat,N,lon,E,quality,satellites,hdop,altitude,M,...
+    if (count < 10 || !ParseNmeaTime(fields[1], &timeOfDay))
+      return false;
+    if (Equals(fields[6], "0") || fields[6].begin == fields[6].end)
+      return false;
+    if (!ParseNmeaAngle(fields[2], fields[3], 'S', &s.latitude) ||
+        !ParseNmeaAngle(fields[4], fields[5], 'W', &s.longitude))
+      return false;
+    ParseNumber(fields[9], &s.altitude);
+  } else if (isRmc) {
+    // $--RMC,time,status,lat,N,lon,E,knots,course,ddmmyy,...
+    if (count < 10 || !ParseNmeaTime(fields[1], &timeOfDay) || !Equals(fields[2], "A"))
+      return false;
+    if (!ParseNmeaAngle(fields[3], fields[4], 'S', &s.latitude) ||
+        !ParseNmeaAngle(fields[5], fields[6], 'W', &s.longitude))
+      return false;
+    if (ParseNumber(fields[7], &s.groundSpeed))
+      s.groundSpeed *= MetersPerSecondPerKnot;
+    ParseNumber(fields[8], &s.direction);
+    int day, month, year;
+    char const *date = fields[9].begin;
+    if (fields[9].end - date != 6 ||
+        !ParseDigits(date, fields[9].end, 2, &day) ||
+        !ParseDigits(date + 2, fields[9].end, 2, &month) ||
+        !ParseDigits(date + 4, fields[9].end, 2, &year))
+      return false;
+    // Two digit years, in the era of GPS
+    year += year < 80 ? 2000 : 1900;
+    m_date = DaysFromCivil(year, month, day) * MillisecondsPerDay;
+  } else {
+    return false;
+  }
+
+  if (m_date < 0) {
+    // Take the date from the clock, allowing for a clock on the other
+    // side of midnight.
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_date = now - now % MillisecondsPerDay;
+    if (timeOfDay - now % MillisecondsPerDay > MillisecondsPerDay / 2)
+      m_date -= MillisecondsPerDay;
+    else if (now % MillisecondsPerDay - timeOfDay > MillisecondsPerDay / 2)
+      m_date += MillisecondsPerDay;
+  } else if (!isRmc && timeOfDay < m_timeOfDay - MillisecondsPerDay / 2) {
+    // The time of day went back: a new day began.
+    m_date += MillisecondsPerDay;
+  }
+  m_timeOfDay = timeOfDay;
+  s.timestamp = m_date + timeOfDay;
+
+  if (!s.isValid())
+    return false;
+  *sample = s;
+  return true;
+}
+
+// Skip a JSON value: a string, an object or array (with what they
+// contain), or a number or literal.
+static
+bool SkipJsonValue(char const *&p, char const *end)
+{
+  if (p >= end)
+    return false;
+  if (*p == '"') {
+    for (++p; p < end; ++p) {
+      if (*p == '\\')
+        ++p;
+      else if (*p == '"')
+        break;
+    }
+    if (p >= end)
+      return false;
+    ++p;
+    return true;
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    for (; p < end; ++p) {
+      if (*p == '"') {
+        if (!SkipJsonValue(p, end))
+          return false;
+        --p;
+      } else if (*p == '{' || *p == '[') {
+        ++depth;
+      } else if ((*p == '}' || *p == ']') && --depth == 0) {
+        ++p;
+        return true;
+      }
+    }
+    return false;
+  }
+  char const *start = p;
+  while (p < end && *p != ',' && *p != '}' && *p != ']' && !IsSpace(*p))
+    ++p;
+  return p > start;
+}
+
+bool PositionSampleParser::parseGpsd(char const *begin, char const *end, PositionSample *sample)
+{
+  // Only the members of the top level object are of interest; nested
+  // objects and arrays are skipped.
+  PositionSample s = PositionSample::invalid(m_defaultId);
+  bool isTpv = false;
+  bool hasTime = false;
+  double mode = 0.0;
+  double altitude = qQNaN();
+  double ellipsoidalAltitude = qQNaN();
+  double epx = qQNaN();
+  double epy = qQNaN();
+
+  char const *p = begin + 1;
+  for (;;) {
+    p = SkipSpace(p, end);
+    if (p >= end)
+      return false;
+    if (*p == '}')
+      break;
+    if (*p == ',') {
+      ++p;
+      continue;
+    }
+    if (*p != '"')
+      return false;
+    Field key;
+    key.begin = ++p;
+    while (p < end && *p != '"')
+      ++p;
+    if (p >= end)
+      return false;
+    key.end = p++;
+    p = SkipSpace(p, end);
+    if (p >= end || *p != ':')
+      return false;
+    p = SkipSpace(p + 1, end);
+    Field value;
+    value.begin = p;
+    if (!SkipJsonValue(p, end))
+      return false;
+    value.end = p;
+
+    // A string, without its quotes
+    Field string = value;
+    const bool isString = *value.begin == '"';
+    if (isString) {
+      ++string.begin;
+      --string.end;
+    }
+
+    if (Equals(key, "class")) {
+      isTpv = isString && Equals(string, "TPV");
+    } else if (Equals(key, "device")) {
+      if (isString)
+        s.id = hash(string.begin, string.end - string.begin);
+    } else if (Equals(key, "time")) {
+      // gpsd times are UTC
+      if (isString)
+        s.timestamp = TimeFromIso(string, false, &hasTime);
+    } else if (Equals(key, "mode")) {
+      ParseNumber(value, &mode);
+    } else if (Equals(key, "lat")) {
+      ParseNumber(value, &s.latitude);
+    } else if (Equals(key, "lon")) {
+      ParseNumber(value, &s.longitude);
+    } else if (Equals(key, "altMSL") || Equals(key, "alt")) {
+      // "alt" is the older name of "altMSL"
+      ParseNumber(value, &altitude);
+    } else if (Equals(key, "altHAE")) {
+      ParseNumber(value, &ellipsoidalAltitude);
+    } else if (Equals(key, "speed")) {
+      ParseNumber(value, &s.groundSpeed);
+    } else if (Equals(key, "track")) {
+      ParseNumber(value, &s.direction);
+    } else if (Equals(key, "climb")) {
+      ParseNumber(value, &s.verticalSpeed);
+    } else if (Equals(key, "eph")) {
+      ParseNumber(value, &s.horizontalAccuracy);
+    } else if (Equals(key, "epx")) {
+      ParseNumber(value, &epx);
+    } else if (Equals(key, "epy")) {
+      ParseNumber(value, &epy);
+    } else if (Equals(key, "epv")) {
+      ParseNumber(value, &s.verticalAccuracy);
+    }
+  }
+
+  // Mode 2 is a 2D fix, mode 3 a 3D fix.
+  if (!isTpv || mode < 2.0)
+    return false;
+  if (mode >= 3.0)
+    s.altitude = qIsNaN(altitude) ? ellipsoidalAltitude : altitude;
+  else
+    s.verticalAccuracy = qQNaN();
+  if (qIsNaN(s.horizontalAccuracy) && !qIsNaN(epx) && !qIsNaN(epy))
+    s.horizontalAccuracy = qMax(epx, epy);
+  if (!hasTime)
+    s.timestamp = QDateTime::currentMSecsSinceEpoch();
+
+  if (!s.isValid())
+    return false;
+  *sample = s;
+  return true;
+}
+
+bool PositionSampleParser::parseLog(char const *begin, char const *end, PositionSample *sample)
+{
+  // time latitude longitude altitude
+  Field fields[4];
+  char const *p = begin;
+  for (int i = 0; i < 4; ++i) {
+    p = SkipSpace(p, end);
+    fields[i].begin = p;
+    while (p < end && !IsSpace(*p))
+      ++p;
+    fields[i].end = p;
+    if (fields[i].begin == fields[i].end)
+      return false;
+  }
+
+  PositionSample s = PositionSample::invalid(m_defaultId);
+  bool ok;
+  s.timestamp = TimeFromIso(fields[0], true, &ok);
+  if (!ok ||
+      !ParseNumber(fields[1], &s.latitude) ||
+      !ParseNumber(fields[2], &s.longitude) ||
+      !ParseNumber(fields[3], &s.altitude) ||
+      !s.isValid())
+    return false;
+  *sample = s;
+  return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QtGlobal>
+#include "PositionSample.hpp"
+
+// The PositionSampleParser decodes one line of text into a
+// PositionSample.  Three formats are understood, and recognized by
+// the first character of the line:
+//
+// - NMEA 0183 GGA and RMC sentences ("$GPGGA,..." from any talker),
+//   whose checksum is verified when present.  GGA has no date, so
+//   the date of the last RMC sentence is used, or today's (UTC) if
+//   there has been none yet.  Sentences flagged as invalid (fix
+//   quality 0, status V) are rejected.
+//
+// - gpsd TPV reports ('{"class":"TPV",...}'), as written by gpsd's
+//   JSON protocol.  Reports without a 2D or 3D fix are rejected.  The
+//   id of the sample is a hash of the "device" member.
+//
+// - The log format of the LogFilePositionSource: an ISO 8601 time
+//   stamp, latitude, longitude and altitude separated by spaces.
+//   Like LogFilePositionSource::parseLine(), a time stamp with no
+//   time zone is local time.
+//
+// Lines of other NMEA sentences, gpsd classes or formats are
+// rejected.  The parser does not allocate: the numbers and times are
+// decoded in place.  It keeps a little state (the date of NMEA
+// sentences), so each stream should have its own parser.
+//
+// Samples that do not carry an id of their own (NMEA and log lines)
+// are given the default id, for instance a hash of the address of
+// the sender.
+
+class PositionSampleParser
+{
+public:
+  PositionSampleParser();
+
+  quint64 defaultId() const;
+  void setDefaultId(quint64 id);
+
+  // Parse a line, without its terminator.  Returns false if the line
+  // is not a position in one of the known formats.
+  bool parse(char const *begin, char const *end, PositionSample *sample);
+
+  // The 64 bit FNV-1a hash of some bytes
+  static quint64 hash(void const *data, qint64 size);
+
+private:
+  bool parseNmea(char const *begin, char const *end, PositionSample *sample);
+  bool parseGpsd(char const *begin, char const *end, PositionSample *sample);
+  bool parseLog(char const *begin, char const *end, PositionSample *sample);
+
+  quint64 m_defaultId;
+  qint64  m_date;           // NMEA: midnight UTC of the current day, in ms since 1970, or -1
+  qint64  m_timeOfDay;      // NMEA: time of day of the last sentence, in ms
+};
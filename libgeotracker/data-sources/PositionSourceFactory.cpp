@@ -0,0 +1,136 @@
+#include <QtCore>
+#include <QHostAddress>
+#include <QUrlQuery>
+#include "PositionSourceFactory.hpp"
+#include "LogFilePositionSource.hpp"
+#include "MappedFilePositionSource.hpp"
+#include "UdpPositionSource.hpp"
+#include "LocalSocketPositionSource.hpp"
+#include "FifoPositionSource.hpp"
+#include "MavlinkPositionSource.hpp"
+#include "SimulatedPositionSource.hpp"
+#include "ThreadedPositionSource.hpp"
+
+static
+double QueryDouble(QUrlQuery const &query, QString const &key, double defaultValue)
+{
+  bool ok = false;
+  const double value = query.queryItemValue(key).toDouble(&ok);
+  return ok ? value : defaultValue;
+}
+
+static
+QHash<QString, PositionSourceFactory::Creator> &Registry()
+{
+  static QHash<QString, PositionSourceFactory::Creator> registry;
+  if (registry.isEmpty()) {
+    registry.insert("default", [](QUrl const &, QObject *parent) {
+        return QGeoPositionInfoSource::createDefaultSource(parent);
+      });
+    registry.insert("file", [](QUrl const &uri, QObject *parent) {
+        return new LogFilePositionSource(uri.toLocalFile(), parent);
+      });
+    registry.insert("qrc", [](QUrl const &uri, QObject *parent) {
+        return new LogFilePositionSource(":" + uri.path(), parent);
+      });
+    registry.insert("mmap", [](QUrl const &uri, QObject *parent) {
+        return new MappedFilePositionSource(uri.path(), parent);
+      });
+    registry.insert("udp", [](QUrl const &uri, QObject *parent) -> QGeoPositionInfoSource * {
+        if (uri.port() <= 0)
+          return nullptr;
+        QHostAddress address(uri.host().isEmpty() ? QString("0.0.0.0") : uri.host());
+        if (address.isNull())
+          return nullptr;
+        return new UdpPositionSource(address, quint16(uri.port()), parent);
+      });
+    registry.insert("unix", [](QUrl const &uri, QObject *parent) {
+        return new LocalSocketPositionSource(uri.path(), parent);
+      });
+    registry.insert("fifo", [](QUrl const &uri, QObject *parent) {
+        return new FifoPositionSource(uri.path(), parent);
+      });
+    registry.insert("stdin", [](QUrl const &, QObject *parent) {
+        return new FifoPositionSource("-", parent);
+      });
+    registry.insert("mavlink", [](QUrl const &uri, QObject *parent) {
+        QUrlQuery query(uri);
+        return new MavlinkPositionSource(uri.path(), int(QueryDouble(query, "baud", 57600.0)), parent);
+      });
+    registry.insert("sim", [](QUrl const &uri, QObject *parent) -> QGeoPositionInfoSource * {
+        QUrlQuery query(uri);
+        SimulatedPositionSource::Trajectory trajectory = SimulatedPositionSource::Circle;
+        if (query.hasQueryItem("model")
+            && !SimulatedPositionSource::trajectoryFromName(query.queryItemValue("model"), &trajectory))
+          return nullptr;
+        QGeoCoordinate center(QueryDouble(query, "lat", 0.0),
+                              QueryDouble(query, "lon", 0.0),
+                              QueryDouble(query, "alt", 1000.0));
+        SimulatedPositionSource *source = new SimulatedPositionSource(center,
+                                                                      QueryDouble(query, "radius", 5000.0),
+                                                                      QueryDouble(query, "speed", 100.0),
+                                                                      parent);
+        source->setTrajectory(trajectory);
+        source->setCount(int(QueryDouble(query, "n", 1.0)));
+        if (query.hasQueryItem("seed"))
+          source->setSeed(query.queryItemValue("seed").toULongLong());
+        source->setSpread(QueryDouble(query, "spread", source->spread()));
+        source->setBatchSize(int(QueryDouble(query, "batch", source->batchSize())));
+        source->setEpoch(qint64(QueryDouble(query, "epoch", 0.0) * 1000.0));
+        return source;
+      });
+  }
+  return registry;
+}
+
+void PositionSourceFactory::registerScheme(QString const &scheme, Creator const &creator)
+{
+  Registry().insert(scheme.toLower(), creator);
+}
+
+QStringList PositionSourceFactory::schemes()
+{
+  QStringList schemes = Registry().keys();
+  schemes.sort();
+  return schemes;
+}
+
+QGeoPositionInfoSource *PositionSourceFactory::create(QString const &uri, QObject *parent, QString *errorString)
+{
+  QUrl url(uri, QUrl::StrictMode);
+  if (!url.isValid() || url.scheme().isEmpty()) {
+    if (errorString)
+      *errorString = QString("malformed position source URI: %1").arg(uri);
+    return nullptr;
+  }
+
+  const QString scheme = url.scheme().toLower();
+  QHash<QString, Creator> const &registry = Registry();
+  if (!registry.contains(scheme)) {
+    if (errorString)
+      *errorString = QString("unknown position source scheme: %1 (expected one of %2)").arg(scheme, schemes().join(", "));
+    return nullptr;
+  }
+
+  // A source that is to run on its own thread is created without a
+  // parent, then handed to the ThreadedPositionSource.
+  QUrlQuery query(url);
+  const bool isThreaded = query.queryItemValue("thread") == "1";
+  QGeoPositionInfoSource *source = registry.value(scheme)(url, isThreaded ? nullptr : parent);
+  if (!source) {
+    if (errorString)
+      *errorString = QString("cannot create a position source for %1").arg(uri);
+    return nullptr;
+  }
+  if (source->objectName().isEmpty())
+    source->setObjectName(uri);
+
+  bool ok = false;
+  const int interval = query.queryItemValue("interval").toInt(&ok);
+  if (ok)
+    source->setUpdateInterval(interval);
+
+  if (isThreaded)
+    source = new ThreadedPositionSource(source, parent);
+  return source;
+}
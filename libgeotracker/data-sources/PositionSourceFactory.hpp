@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QGeoPositionInfoSource>
+
+// The PositionSourceFactory creates position sources from URIs, so
+// that the transport can be chosen at run time.  The scheme of the
+// URI selects the source:
+//
+//   default:               the platform's default source
+//   file:/path/to/log      a log file, read line by line (LogFilePositionSource)
+//   qrc:/sim-data/log      a log compiled into the resources
+//   mmap:/path/to/log      a log file, memory mapped (MappedFilePositionSource)
+//   udp://address:port     datagrams to a local address (UdpPositionSource)
+//   unix:/path/to/socket   a Unix domain socket (LocalSocketPositionSource)
+//   fifo:/path/to/fifo     a named pipe (FifoPositionSource)
+//   stdin:                 the standard input
+//   mavlink:/dev/ttyUSB0   MAVLink telemetry from a serial device, pseudo
+//                          terminal or file (MavlinkPositionSource), with
+//                          the optional baud rate (baud=57600)
+//   sim:?lat=..&lon=..     simulated targets (SimulatedPositionSource)
+//                          with the optional alt, radius (m) and speed (m/s),
+//                          the number of entities (n=1), the trajectory
+//                          (model=circle, great-circle, orbit, loiter or
+//                          walk), the seed (seed=1), the spread (m) and
+//                          the epoch (seconds since 1970)
+//
+// The log files carry the format of LogFilePositionSource, and the
+// streams that format, NMEA or gpsd JSON (see PositionSampleParser).
+//
+// Any source runs on an I/O thread of its own if the URI has the
+// query item "thread=1" (see ThreadedPositionSource), and the update
+// interval may be set with "interval=<msecs>".
+//
+// Other schemes may be registered, typically before any source is
+// created.
+
+class PositionSourceFactory
+{
+public:
+  typedef std::function<QGeoPositionInfoSource *(QUrl const &uri, QObject *parent)> Creator;
+
+  // Register (or replace) the creator of the sources of a scheme.
+  static void registerScheme(QString const &scheme, Creator const &creator);
+  static QStringList schemes();
+
+  // Create a source.  Returns null, with the reason in errorString,
+  // if the URI is malformed, its scheme is unknown or the source
+  // cannot be created.
+  static QGeoPositionInfoSource *create(QString const &uri,
+                                        QObject *parent = 0,
+                                        QString *errorString = nullptr);
+};
@@ -0,0 +1,89 @@
+#include <QtCore>
+#include <limits>
+#include "PositionSourceMonitor.hpp"
+#include "Metrics.hpp"
+
+PositionSourceMonitor::PositionSourceMonitor(QGeoPositionInfoSource *source, QObject *parent)
+  : QObject(parent ? parent : source),
+    m_source(source),
+    m_updateCount(nullptr),
+    m_errorCount(nullptr),
+    m_latency(nullptr)
+{
+  m_clock.start();
+  reset();
+
+  // Count in the thread of the source, as the positions are emitted.
+  connect(source, SIGNAL(positionUpdated(QGeoPositionInfo)),
+          this, SLOT(onPositionUpdated(QGeoPositionInfo)), Qt::DirectConnection);
+  connect(source, SIGNAL(error(QGeoPositionInfoSource::Error)),
+          this, SLOT(onError(QGeoPositionInfoSource::Error)), Qt::DirectConnection);
+}
+
+QGeoPositionInfoSource *PositionSourceMonitor::source() const
+{
+  return m_source;
+}
+
+void PositionSourceMonitor::reset()
+{
+  m_start.storeRelaxed(m_clock.elapsed());
+  m_updates.storeRelaxed(0);
+  m_errors.storeRelaxed(0);
+  m_latencySum.storeRelaxed(0);
+  m_minLatency.storeRelaxed(std::numeric_limits<qint64>::max());
+  m_maxLatency.storeRelaxed(std::numeric_limits<qint64>::min());
+}
+
+void PositionSourceMonitor::exportMetrics(Metrics &metrics, QString const &name)
+{
+  const QString labels = QString("source=\"%1\"").arg(name);
+  m_updateCount = metrics.counter("geotracker_source_positions_total",
+                                  "Positions reported by the position sources.", labels);
+  m_errorCount = metrics.counter("geotracker_source_errors_total",
+                                 "Errors reported by the position sources.", labels);
+  m_latency = metrics.histogram("geotracker_source_latency_seconds",
+                                "Time of arrival less the time stamp of the positions.", labels);
+}
+
+PositionSourceStatistics PositionSourceMonitor::statistics() const
+{
+  PositionSourceStatistics s;
+  s.updates = m_updates.loadRelaxed();
+  s.errors = m_errors.loadRelaxed();
+  s.elapsed = (m_clock.elapsed() - m_start.loadRelaxed()) / 1000.0;
+  s.rate = s.elapsed > 0.0 ? s.updates / s.elapsed : 0.0;
+  if (s.updates > 0) {
+    s.minLatency = m_minLatency.loadRelaxed();
+    s.meanLatency = double(m_latencySum.loadRelaxed()) / s.updates;
+    s.maxLatency = m_maxLatency.loadRelaxed();
+  } else {
+    s.minLatency = s.meanLatency = s.maxLatency = 0.0;
+  }
+  return s;
+}
+
+void PositionSourceMonitor::onPositionUpdated(QGeoPositionInfo const &info)
+{
+  const qint64 latency = QDateTime::currentMSecsSinceEpoch() - info.timestamp().toMSecsSinceEpoch();
+  m_updates.fetchAndAddRelaxed(1);
+  m_latencySum.fetchAndAddRelaxed(latency);
+  if (m_updateCount) {
+    m_updateCount->increment();
+    m_latency->record(qMax(Q_INT64_C(0), latency) * 1000000);
+  }
+
+  qint64 current = m_minLatency.loadRelaxed();
+  while (latency < current && !m_minLatency.testAndSetRelaxed(current, latency, current))
+    ;
+  current = m_maxLatency.loadRelaxed();
+  while (latency > current && !m_maxLatency.testAndSetRelaxed(current, latency, current))
+    ;
+}
+
+void PositionSourceMonitor::onError(QGeoPositionInfoSource::Error)
+{
+  m_errors.fetchAndAddRelaxed(1);
+  if (m_errorCount)
+    m_errorCount->increment();
+}
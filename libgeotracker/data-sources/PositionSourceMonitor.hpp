@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QGeoPositionInfo>
+#include <QGeoPositionInfoSource>
+
+class Metrics;
+class MetricCounter;
+class MetricHistogram;
+
+// A snapshot of the counters of a PositionSourceMonitor.
+
+struct PositionSourceStatistics
+{
+  quint64 updates;       // positions received
+  quint64 errors;        // errors reported
+  double  elapsed;       // seconds since the counters were reset
+  double  rate;          // positions per second
+  double  minLatency;    // milliseconds
+  double  meanLatency;   // milliseconds
+  double  maxLatency;    // milliseconds
+};
+
+// A PositionSourceMonitor counts the positions and errors reported
+// by a position source, for a measure of its throughput, and the
+// latency of the positions: the time of arrival less the time stamp
+// of the position.  The latency only makes sense for live sources
+// whose clocks are synchronized with this one; a replayed log has
+// the age of the log as its latency.
+//
+// The counters are updated in the thread of the source and may be
+// read from any thread.  They may also be exported as metrics,
+// labeled with the name of the source, so that the rates of the
+// sources can be scraped while they run.
+
+class PositionSourceMonitor : public QObject
+{
+  Q_OBJECT
+public:
+  // The monitor is a child of the source unless a parent is given.
+  PositionSourceMonitor(QGeoPositionInfoSource *source, QObject *parent = 0);
+
+  QGeoPositionInfoSource *source() const;
+
+  PositionSourceStatistics statistics() const;
+  void reset();
+
+  // Count the positions, errors and latencies in metrics of the set
+  // too, labeled source="<name>".  Call before the source starts.
+  void exportMetrics(Metrics &metrics, QString const &name);
+
+private slots:
+  void onPositionUpdated(QGeoPositionInfo const &info);
+  void onError(QGeoPositionInfoSource::Error e);
+
+private:
+  QGeoPositionInfoSource *m_source;
+  QElapsedTimer m_clock;
+  QAtomicInteger<qint64> m_start;       // msecs of m_clock at the reset
+  QAtomicInteger<quint64> m_updates;
+  QAtomicInteger<quint64> m_errors;
+  QAtomicInteger<qint64> m_latencySum;  // milliseconds
+  QAtomicInteger<qint64> m_minLatency;
+  QAtomicInteger<qint64> m_maxLatency;
+
+  MetricCounter *m_updateCount;
+  MetricCounter *m_errorCount;
+  MetricHistogram *m_latency;
+};
@@ -0,0 +1,427 @@
+#include <QtCore>
+#include <QtMath>
+#include <QtConcurrent>
+#include "SimulatedPositionSource.hpp"
+
+// The radius of the sphere of QGeoCoordinate, in meters
+static const double EarthRadius = 6371007.2;
+static const double EarthRotationRate = 7.2921159e-5;     // radians per second
+static const double GravitationalParameter = 3.986004418e14;  // m^3/s^2
+
+// The entities are simulated in blocks of this many per thread pool
+// task, which amortizes the cost of the task over enough work.
+static const int SimulationBlockSize = 4096;
+
+// A random generator (splitmix64) with a stream of its own for each
+// entity, so that the parameters of an entity do not depend on those
+// drawn for the others.
+class EntityRandom
+{
+public:
+  EntityRandom(quint64 seed, int index) :
+    m_state(seed ^ (quint64(index) * Q_UINT64_C(0x9e3779b97f4a7c15)))
+  {
+  }
+
+  // Uniform in [0, 1)
+  double uniform()
+  {
+    quint64 z = (m_state += Q_UINT64_C(0x9e3779b97f4a7c15));
+    z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+    return (z ^ (z >> 31)) * (1.0 / 18446744073709551616.0);
+  }
+
+  // Uniform in [low, high)
+  double uniform(double low, double high)
+  {
+    return low + (high - low) * uniform();
+  }
+
+private:
+  quint64 m_state;
+};
+
+// The point at a distance and initial bearing from another on the
+// sphere, as QGeoCoordinate::atDistanceAndAzimuth() computes it, and
+// optionally the bearing of the path on arrival.  Angles in radians.
+static
+void Destination(double latitude, double longitude, double distance, double bearing,
+                 double *latitude2, double *longitude2, double *bearing2 = nullptr)
+{
+  const double ratio = distance / EarthRadius;
+  const double sinLatitude = qSin(latitude);
+  const double cosLatitude = qCos(latitude);
+  const double sinRatio = qSin(ratio);
+  const double cosRatio = qCos(ratio);
+  const double sinBearing = qSin(bearing);
+  const double cosBearing = qCos(bearing);
+  *latitude2 = qAsin(qBound(-1.0, sinLatitude * cosRatio + cosLatitude * sinRatio * cosBearing, 1.0));
+  *longitude2 = longitude + qAtan2(sinBearing * sinRatio * cosLatitude,
+                                   cosRatio - sinLatitude * qSin(*latitude2));
+  if (bearing2)
+    *bearing2 = qAtan2(sinBearing * cosLatitude,
+                       cosLatitude * cosRatio * cosBearing - sinLatitude * sinRatio);
+}
+
+// Degrees in [-180, 180) and [0, 360)
+static
+double Longitude(double radians)
+{
+  const double degrees = std::fmod(qRadiansToDegrees(radians) + 540.0, 360.0);
+  return (degrees < 0.0 ? degrees + 360.0 : degrees) - 180.0;
+}
+
+static
+double Bearing(double radians)
+{
+  const double degrees = std::fmod(qRadiansToDegrees(radians), 360.0);
+  return degrees < 0.0 ? degrees + 360.0 : degrees;
+}
+
+SimulatedPositionSource::SimulatedPositionSource(QGeoCoordinate const &center,
+                                                 double radius,
+                                                 double speed,
+                                                 QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    m_center(center),
+    m_radius(qMax(1.0, radius)),
+    m_speed(speed),
+    m_count(1),
+    m_trajectory(Circle),
+    m_seed(1),
+    m_spread(50000.0),
+    m_batchSize(4096),
+    m_epoch(0),
+    m_sink(nullptr),
+    m_start(0),
+    m_step(0),
+    timer(new QTimer(this))
+{
+  connect(timer, SIGNAL(timeout()), this, SLOT(simulate()));
+}
+
+QGeoPositionInfo SimulatedPositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  return lastPosition;
+}
+
+SimulatedPositionSource::PositioningMethods SimulatedPositionSource::supportedPositioningMethods() const
+{
+  return AllPositioningMethods;
+}
+
+int SimulatedPositionSource::minimumUpdateInterval() const
+{
+  return 1;
+}
+
+QGeoPositionInfoSource::Error SimulatedPositionSource::error() const
+{
+  return NoError;
+}
+
+int SimulatedPositionSource::count() const
+{
+  return m_count;
+}
+
+void SimulatedPositionSource::setCount(int count)
+{
+  m_count = qMax(1, count);
+}
+
+SimulatedPositionSource::Trajectory SimulatedPositionSource::trajectory() const
+{
+  return m_trajectory;
+}
+
+void SimulatedPositionSource::setTrajectory(Trajectory trajectory)
+{
+  m_trajectory = trajectory;
+}
+
+quint64 SimulatedPositionSource::seed() const
+{
+  return m_seed;
+}
+
+void SimulatedPositionSource::setSeed(quint64 seed)
+{
+  m_seed = seed;
+}
+
+double SimulatedPositionSource::spread() const
+{
+  return m_spread;
+}
+
+void SimulatedPositionSource::setSpread(double spread)
+{
+  m_spread = qMax(0.0, spread);
+}
+
+int SimulatedPositionSource::batchSize() const
+{
+  return m_batchSize;
+}
+
+void SimulatedPositionSource::setBatchSize(int size)
+{
+  m_batchSize = qMax(1, size);
+}
+
+qint64 SimulatedPositionSource::epoch() const
+{
+  return m_epoch;
+}
+
+void SimulatedPositionSource::setEpoch(qint64 msecsSinceEpoch)
+{
+  m_epoch = msecsSinceEpoch;
+}
+
+PositionSampleSink *SimulatedPositionSource::sampleSink() const
+{
+  return m_sink;
+}
+
+void SimulatedPositionSource::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+bool SimulatedPositionSource::trajectoryFromName(QString const &name, Trajectory *trajectory)
+{
+  static const char *names[] = { "circle", "great-circle", "orbit", "loiter", "walk" };
+  for (int i = 0; i < 5; ++i) {
+    if (name == names[i]) {
+      *trajectory = Trajectory(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+QGeoPositionInfo SimulatedPositionSource::positionAt(double seconds) const
+{
+  return sampleAt(0, seconds).toPositionInfo();
+}
+
+PositionSample SimulatedPositionSource::sampleAt(int index, double seconds) const
+{
+  PositionSample sample = PositionSample::invalid(quint64(index) + 1);
+  const qint64 start = m_start ? m_start : m_epoch ? m_epoch : QDateTime::currentMSecsSinceEpoch();
+  sample.timestamp = start + qRound64(1000.0 * seconds);
+
+  // The parameters of the entity.  The first has those given.
+  EntityRandom random(m_seed, index);
+  const bool isFirst = index == 0;
+  const double offset = isFirst ? 0.0 : m_spread * qSqrt(random.uniform());
+  const double offsetBearing = random.uniform(0.0, 2.0 * M_PI);
+  const double radius = isFirst ? m_radius : m_radius * random.uniform(0.5, 1.5);
+  const double speed = isFirst ? m_speed : m_speed * random.uniform(0.5, 1.5);
+  const double altitude = isFirst ? m_center.altitude() : m_center.altitude() * random.uniform(0.5, 1.5);
+  const double phase = isFirst ? 0.0 : random.uniform(0.0, 2.0 * M_PI);
+
+  double latitude, longitude;
+  Destination(qDegreesToRadians(m_center.latitude()), qDegreesToRadians(m_center.longitude()),
+              offset, offsetBearing, &latitude, &longitude);
+
+  switch (m_trajectory) {
+  case Circle: {
+    // Clockwise, as seen from above, so the direction of travel is the
+    // bearing from the center plus a quarter turn.
+    const double bearing = phase + speed * seconds / radius;
+    double lat, lon;
+    Destination(latitude, longitude, radius, bearing, &lat, &lon);
+    sample.latitude = qRadiansToDegrees(lat);
+    sample.longitude = Longitude(lon);
+    sample.altitude = altitude;
+    sample.direction = Bearing(bearing + 0.5 * M_PI);
+    sample.groundSpeed = speed;
+    break;
+  }
+  case GreatCircle: {
+    // From the point of the circle, on the tangent of the circle
+    double startLatitude, startLongitude;
+    Destination(latitude, longitude, radius, phase, &startLatitude, &startLongitude);
+    double lat, lon, direction;
+    Destination(startLatitude, startLongitude, speed * seconds, phase + 0.5 * M_PI, &lat, &lon, &direction);
+    sample.latitude = qRadiansToDegrees(lat);
+    sample.longitude = Longitude(lon);
+    sample.altitude = altitude;
+    sample.direction = Bearing(direction);
+    sample.groundSpeed = speed;
+    break;
+  }
+  case Orbit: {
+    // Over the start at the start, heading on the tangent of the
+    // circle.  The orbit is fixed in inertial space while the earth
+    // turns beneath it.
+    const double height = isFirst ? 800000.0 : random.uniform(400000.0, 1400000.0);
+    const double r = EarthRadius + height;
+    const double motion = qSqrt(GravitationalParameter / (r * r * r));   // radians per second
+    const double heading = phase + 0.5 * M_PI;
+    const double sinLat = qSin(latitude), cosLat = qCos(latitude);
+    const double sinLon = qSin(longitude), cosLon = qCos(longitude);
+    const double p[3] = { cosLat * cosLon, cosLat * sinLon, sinLat };
+    const double north[3] = { -sinLat * cosLon, -sinLat * sinLon, cosLat };
+    const double east[3] = { -sinLon, cosLon, 0.0 };
+    double v[3];
+    for (int i = 0; i < 3; ++i)
+      v[i] = north[i] * qCos(heading) + east[i] * qSin(heading);
+
+    const double w = motion * seconds;
+    const double a = -EarthRotationRate * seconds;
+    double q[3], dq[3];
+    for (int i = 0; i < 3; ++i) {
+      q[i] = p[i] * qCos(w) + v[i] * qSin(w);
+      dq[i] = (-p[i] * qSin(w) + v[i] * qCos(w)) * motion * r;
+    }
+    // Into the frame of the earth, whose turning adds a westward speed
+    const double e[3] = { q[0] * qCos(a) - q[1] * qSin(a), q[0] * qSin(a) + q[1] * qCos(a), q[2] };
+    const double de[3] = { dq[0] * qCos(a) - dq[1] * qSin(a) + EarthRotationRate * r * e[1],
+                           dq[0] * qSin(a) + dq[1] * qCos(a) - EarthRotationRate * r * e[0],
+                           dq[2] };
+    const double lat = qAsin(qBound(-1.0, e[2], 1.0));
+    const double lon = qAtan2(e[1], e[0]);
+    const double localNorth[3] = { -qSin(lat) * qCos(lon), -qSin(lat) * qSin(lon), qCos(lat) };
+    const double localEast[3] = { -qSin(lon), qCos(lon), 0.0 };
+    const double vn = de[0] * localNorth[0] + de[1] * localNorth[1] + de[2] * localNorth[2];
+    const double ve = de[0] * localEast[0] + de[1] * localEast[1];
+    sample.latitude = qRadiansToDegrees(lat);
+    sample.longitude = Longitude(lon);
+    sample.altitude = height;
+    sample.direction = Bearing(qAtan2(ve, vn));
+    sample.groundSpeed = qSqrt(vn * vn + ve * ve) * EarthRadius / r;
+    break;
+  }
+  case Loiter: {
+    // Legs of twice the radius, joined by half circles of half the
+    // radius, flown clockwise; the legs lie along the orientation.
+    const double orientation = isFirst ? 0.0 : random.uniform(0.0, 2.0 * M_PI);
+    const double leg = 2.0 * radius;
+    const double turn = 0.5 * radius;
+    const double perimeter = 2.0 * leg + 2.0 * M_PI * turn;
+    double s = std::fmod(phase * turn + speed * seconds, perimeter);
+    if (s < 0.0)
+      s += perimeter;
+    double forward, right, heading;
+    if (s < leg) {
+      forward = -0.5 * leg + s;
+      right = -turn;
+      heading = 0.0;
+    } else if (s < leg + M_PI * turn) {
+      const double angle = (s - leg) / turn;
+      forward = 0.5 * leg + turn * qSin(angle);
+      right = -turn * qCos(angle);
+      heading = angle;
+    } else if (s < 2.0 * leg + M_PI * turn) {
+      forward = 0.5 * leg - (s - leg - M_PI * turn);
+      right = turn;
+      heading = M_PI;
+    } else {
+      const double angle = (s - 2.0 * leg - M_PI * turn) / turn;
+      forward = -0.5 * leg - turn * qSin(angle);
+      right = turn * qCos(angle);
+      heading = M_PI + angle;
+    }
+    const double north = forward * qCos(orientation) - right * qSin(orientation);
+    const double east = forward * qSin(orientation) + right * qCos(orientation);
+    double lat, lon;
+    Destination(latitude, longitude, qSqrt(north * north + east * east), qAtan2(east, north), &lat, &lon);
+    sample.latitude = qRadiansToDegrees(lat);
+    sample.longitude = Longitude(lon);
+    sample.altitude = altitude;
+    sample.direction = Bearing(orientation + heading);
+    sample.groundSpeed = speed;
+    break;
+  }
+  case RandomWalk: {
+    // Three random sinusoids in each direction, whose speeds add up
+    // to about the speed given
+    double north = 0.0, east = 0.0, vn = 0.0, ve = 0.0;
+    for (int k = 0; k < 3; ++k) {
+      const double amplitude = radius * random.uniform(0.2, 0.6);
+      const double frequency = speed / radius * random.uniform(0.3, 1.0);
+      const double northPhase = random.uniform(0.0, 2.0 * M_PI);
+      const double eastPhase = random.uniform(0.0, 2.0 * M_PI);
+      north += amplitude * qSin(frequency * seconds + northPhase);
+      east += amplitude * qSin(frequency * seconds + eastPhase);
+      vn += amplitude * frequency * qCos(frequency * seconds + northPhase);
+      ve += amplitude * frequency * qCos(frequency * seconds + eastPhase);
+    }
+    double lat, lon;
+    Destination(latitude, longitude, qSqrt(north * north + east * east), qAtan2(east, north), &lat, &lon);
+    sample.latitude = qRadiansToDegrees(lat);
+    sample.longitude = Longitude(lon);
+    sample.altitude = altitude;
+    sample.direction = Bearing(qAtan2(ve, vn));
+    sample.groundSpeed = qSqrt(vn * vn + ve * ve);
+    break;
+  }
+  }
+  return sample;
+}
+
+void SimulatedPositionSource::simulate(double seconds, QVector<PositionSample> *samples) const
+{
+  const int n = m_count;
+  samples->resize(n);
+  PositionSample *data = samples->data();
+  if (n <= SimulationBlockSize) {
+    for (int i = 0; i < n; ++i)
+      data[i] = sampleAt(i, seconds);
+    return;
+  }
+
+  // Each task writes a disjoint block of the samples, so no locking
+  // is needed.
+  QVector<int> blocks;
+  for (int begin = 0; begin < n; begin += SimulationBlockSize)
+    blocks.append(begin);
+  QtConcurrent::blockingMap(blocks, [this, n, seconds, data](int begin) {
+      const int end = qMin(begin + SimulationBlockSize, n);
+      for (int i = begin; i < end; ++i)
+        data[i] = sampleAt(i, seconds);
+    });
+}
+
+void SimulatedPositionSource::startUpdates()
+{
+  if (m_start == 0)
+    m_start = m_epoch ? m_epoch : QDateTime::currentMSecsSinceEpoch();
+  timer->start(qMax(updateInterval(), minimumUpdateInterval()));
+}
+
+void SimulatedPositionSource::stopUpdates()
+{
+  timer->stop();
+}
+
+void SimulatedPositionSource::requestUpdate(int /* timeout */)
+{
+  simulate();
+}
+
+void SimulatedPositionSource::simulate()
+{
+  // Step by the update interval, so that a run is reproducible.
+  if (m_start == 0)
+    m_start = m_epoch ? m_epoch : QDateTime::currentMSecsSinceEpoch();
+  const double seconds = m_step * qMax(updateInterval(), minimumUpdateInterval()) / 1000.0;
+  ++m_step;
+  simulate(seconds, &m_samples);
+
+  if (m_sink) {
+    for (int begin = 0; begin < m_samples.size(); begin += m_batchSize)
+      m_sink->consume(m_samples.constData() + begin, qMin(m_batchSize, m_samples.size() - begin));
+  }
+
+  QGeoPositionInfo info = m_samples.first().toPositionInfo();
+  if (info.isValid()) {
+    lastPosition = info;
+    emit positionUpdated(info);
+  }
+}
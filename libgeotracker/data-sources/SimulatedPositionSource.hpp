@@ -0,0 +1,132 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QGeoCoordinate>
+#include <QTimer>
+#include <QVector>
+#include "PositionSample.hpp"
+
+// The Simulated Position Source synthesizes the positions of any
+// number of entities (up to millions) moving on parametric
+// trajectories around a center point.  It needs no data and no
+// network, so it is handy for demonstrations, for exercising the
+// rest of the pipeline and for measuring how it scales.
+//
+// The trajectories are:
+//
+// - Circle: flying circles at a constant altitude and speed,
+//   clockwise as seen from above.
+// - GreatCircle: flying straight on, along a great circle.
+// - Orbit: a circular orbit of the earth at 400 to 1400 km, with a
+//   random inclination, over the rotating earth.
+// - Loiter: flying a racetrack, two straight legs joined by half
+//   circles.
+// - RandomWalk: wandering about the start, smoothly (a sum of random
+//   sinusoids, so the walk is band limited and may be evaluated at
+//   any time).
+//
+// The first entity has the radius, speed and altitude given, about
+// the center itself; on a circle it starts due north of the center,
+// the single target this source has always simulated.  The others
+// are scattered within the spread of the center, with radii, speeds
+// and altitudes from half to one and a half times those given.  The parameters of
+// each entity are drawn from a random generator seeded with the seed
+// and the index of the entity, so a simulation is reproducible, and
+// an entity moves the same whatever the number of entities.
+//
+// The simulation steps by the update interval, whatever the actual
+// time between updates, so the positions of a run depend only on the
+// parameters.  The positions are time stamped from the time of the
+// start (or a given epoch) plus the simulated time.  They are
+// computed in parallel on the global thread pool and handed to the
+// sample sink, if any, in batches, with the index of the entity plus
+// one as their id.  Only the first entity is distributed via the
+// positionUpdated() signal.  The earth is a sphere of the mean radius
+// here, as for QGeoCoordinate::atDistanceAndAzimuth().
+
+class SimulatedPositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  enum Trajectory { Circle, GreatCircle, Orbit, Loiter, RandomWalk };
+
+  SimulatedPositionSource(QGeoCoordinate const &center,
+                          double radius = 5000.0,
+                          double speed = 100.0,
+                          QObject *parent = 0);
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+  int count() const;
+  void setCount(int count);
+
+  Trajectory trajectory() const;
+  void setTrajectory(Trajectory trajectory);
+
+  quint64 seed() const;
+  void setSeed(quint64 seed);
+
+  // Meters from the center within which the entities start
+  double spread() const;
+  void setSpread(double spread);
+
+  // The samples handed to the sink at once
+  int batchSize() const;
+  void setBatchSize(int size);
+
+  // The time stamp of the start of the simulation, in milliseconds
+  // since 1970, or 0 for the time of startUpdates()
+  qint64 epoch() const;
+  void setEpoch(qint64 msecsSinceEpoch);
+
+  // The sink receives the samples in the thread of the source.  It is
+  // not owned by the source.
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+  // The simulated position of the first entity at a time in seconds
+  // since the start
+  QGeoPositionInfo positionAt(double seconds) const;
+  // And of any, stamped with the epoch plus the time
+  PositionSample sampleAt(int index, double seconds) const;
+
+  // The positions of all the entities at a time, in parallel
+  void simulate(double seconds, QVector<PositionSample> *samples) const;
+
+  static bool trajectoryFromName(QString const &name, Trajectory *trajectory);
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+private slots:
+  void simulate();
+
+private:
+  QGeoCoordinate m_center;
+  double m_radius;                // meters
+  double m_speed;                 // meters per second
+  int m_count;
+  Trajectory m_trajectory;
+  quint64 m_seed;
+  double m_spread;                // meters
+  int m_batchSize;
+  qint64 m_epoch;                 // milliseconds since 1970
+  PositionSampleSink *m_sink;
+
+  qint64 m_start;                 // milliseconds since 1970
+  qint64 m_step;                  // updates since the start
+  QTimer *timer;
+  QVector<PositionSample> m_samples;
+  QGeoPositionInfo lastPosition;
+};
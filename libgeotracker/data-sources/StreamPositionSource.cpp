@@ -0,0 +1,152 @@
+#include <QMetaMethod>
+#include "StreamPositionSource.hpp"
+
+// The batch is reserved for this many samples, enough for a read of
+// a few kilobytes of NMEA or log lines, and grows beyond if needed.
+static const int InitialBatchSize = 256;
+static const int InitialLineSize = 1024;
+
+StreamPositionSource::StreamPositionSource(QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    m_active(false),
+    m_error(NoError),
+    m_sink(nullptr),
+    lastSample(PositionSample::invalid())
+{
+  // Reserved, the buffers keep their capacity when emptied.
+  m_partial.reserve(InitialLineSize);
+  m_batch.reserve(InitialBatchSize);
+}
+
+QGeoPositionInfo StreamPositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  if (!lastSample.isValid())
+    return QGeoPositionInfo();
+  return lastSample.toPositionInfo();
+}
+
+StreamPositionSource::PositioningMethods StreamPositionSource::supportedPositioningMethods() const
+{
+  return AllPositioningMethods;
+}
+
+int StreamPositionSource::minimumUpdateInterval() const
+{
+  return 0;
+}
+
+QGeoPositionInfoSource::Error StreamPositionSource::error() const
+{
+  return m_error;
+}
+
+PositionSampleSink *StreamPositionSource::sampleSink() const
+{
+  return m_sink;
+}
+
+void StreamPositionSource::setSampleSink(PositionSampleSink *sink)
+{
+  m_sink = sink;
+}
+
+void StreamPositionSource::startUpdates()
+{
+  if (m_active)
+    return;
+  m_partial.resize(0);
+  if (!open()) {
+    fail(AccessError);
+    return;
+  }
+  m_active = true;
+}
+
+void StreamPositionSource::stopUpdates()
+{
+  if (!m_active)
+    return;
+  m_active = false;
+  close();
+}
+
+void StreamPositionSource::requestUpdate(int /* timeout */)
+{
+  // The positions arrive at the sender's pace; the best that can be
+  // done is to repeat the last one.
+  if (lastSample.isValid())
+    emit positionUpdated(lastSample.toPositionInfo());
+  else
+    emit updateTimeout();
+}
+
+bool StreamPositionSource::isActive() const
+{
+  return m_active;
+}
+
+void StreamPositionSource::setSenderId(quint64 id)
+{
+  m_parser.setDefaultId(id);
+}
+
+void StreamPositionSource::fail(Error e)
+{
+  m_error = e;
+  stopUpdates();
+  emit error(e);
+}
+
+void StreamPositionSource::consume(char const *data, qint64 size, bool isMessage)
+{
+  char const *end = data + size;
+  char const *begin = data;
+  for (char const *p = begin; p < end; ++p) {
+    if (*p != '\n')
+      continue;
+    if (!m_partial.isEmpty()) {
+      m_partial.append(begin, int(p - begin));
+      consumeLine(m_partial.constData(), m_partial.constData() + m_partial.size());
+      m_partial.resize(0);
+    } else {
+      consumeLine(begin, p);
+    }
+    begin = p + 1;
+  }
+  if (begin < end) {
+    if (isMessage && m_partial.isEmpty()) {
+      consumeLine(begin, end);
+      return;
+    }
+    m_partial.append(begin, int(end - begin));
+  }
+  if (isMessage && !m_partial.isEmpty()) {
+    consumeLine(m_partial.constData(), m_partial.constData() + m_partial.size());
+    m_partial.resize(0);
+  }
+}
+
+void StreamPositionSource::consumeLine(char const *begin, char const *end)
+{
+  PositionSample sample;
+  if (m_parser.parse(begin, end, &sample))
+    m_batch.append(sample);
+}
+
+void StreamPositionSource::flush()
+{
+  if (m_batch.isEmpty())
+    return;
+  lastSample = m_batch.last();
+  if (m_sink)
+    m_sink->consume(m_batch.constData(), m_batch.size());
+
+  static const QMetaMethod positionUpdatedSignal = QMetaMethod::fromSignal(&QGeoPositionInfoSource::positionUpdated);
+  if (isSignalConnected(positionUpdatedSignal)) {
+    for (PositionSample const &sample : m_batch)
+      emit positionUpdated(sample.toPositionInfo());
+  }
+
+  // Since Qt 5.7, clear() keeps the capacity.
+  m_batch.clear();
+}
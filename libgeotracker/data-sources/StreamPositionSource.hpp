@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QByteArray>
+#include <QVector>
+#include "PositionSample.hpp"
+#include "PositionSampleParser.hpp"
+
+// A Stream Position Source receives positions pushed to it over a
+// transport, as opposed to reading them at its own pace like the
+// LogFilePositionSource.  The data is a stream of lines in any of
+// the formats of the PositionSampleParser (the log format, NMEA or
+// gpsd JSON), so the update interval is not used.
+//
+// The positions of each read from the transport are parsed into a
+// batch of PositionSamples without allocating, and the batch is
+// handed to the sample sink, if any, in one call.  A sink is the
+// fast path for feeds of many entities (see GeoEntityDispatcher).
+// Each position is also distributed via the positionUpdated()
+// signal, but only while the signal is connected, since that costs
+// a QGeoPositionInfo per position.
+//
+// The transport is opened by startUpdates() and closed by
+// stopUpdates().  A transport that cannot be opened is reported with
+// the AccessError, and one that is closed by the other end with the
+// ClosedError.
+//
+// Subclasses implement the transport and hand the bytes they receive
+// to consume().
+
+class StreamPositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  StreamPositionSource(QObject *parent = 0);
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+  // The sink receives the samples in the thread of the source.  It is
+  // not owned by the source.
+  PositionSampleSink *sampleSink() const;
+  void setSampleSink(PositionSampleSink *sink);
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+protected:
+  // Open and close the transport
+  virtual bool open() = 0;
+  virtual void close() = 0;
+
+  bool isActive() const;
+
+  // Parse the complete lines in the data into the batch.  An
+  // incomplete last line is kept until the rest of it arrives, unless
+  // the data is a whole message (a datagram, for instance).
+  void consume(char const *data, qint64 size, bool isMessage = false);
+
+  // Distribute the batch.  Subclasses call this after each read.
+  void flush();
+
+  // The id of the samples that do not carry one, e.g. a hash of the
+  // address of the sender of a datagram.
+  void setSenderId(quint64 id);
+
+  // Report an error and stop the updates
+  void fail(Error e);
+
+private:
+  void consumeLine(char const *begin, char const *end);
+
+  bool m_active;
+  Error m_error;
+  QByteArray m_partial;
+  PositionSampleParser m_parser;
+  QVector<PositionSample> m_batch;
+  PositionSampleSink *m_sink;
+  PositionSample lastSample;
+};
@@ -0,0 +1,115 @@
+#include <QtCore>
+#include "ThreadedPositionSource.hpp"
+#include "LatencyTrace.hpp"
+
+ThreadedPositionSource::ThreadedPositionSource(QGeoPositionInfoSource *source, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    m_source(source),
+    thread(new QThread(this)),
+    m_supportedMethods(source->supportedPositioningMethods()),
+    m_minimumUpdateInterval(source->minimumUpdateInterval()),
+    m_error(NoError)
+{
+  qRegisterMetaType<QGeoPositionInfo>();
+  qRegisterMetaType<QGeoPositionInfoSource::Error>();
+
+  setObjectName(source->objectName());
+  thread->setObjectName(QStringLiteral("I/O ") + source->metaObject()->className());
+
+  // The subclasses of QGeoPositionInfoSource redeclare the error
+  // signal, so it is connected by name.
+#ifdef LATENCY_TRACE
+  // The origin of the trace goes along with the position.
+  connect(m_source, &QGeoPositionInfoSource::positionUpdated, m_source, [this](QGeoPositionInfo const &info) {
+      const qint64 origin = LatencyTrace::origin();
+      QMetaObject::invokeMethod(this, [this, info, origin]() {
+          LatencyTrace::Scope scope(origin);
+          LATENCY_TRACE_MARK(Handover);
+          onPositionUpdated(info);
+        }, Qt::QueuedConnection);
+    });
+#else
+  connect(m_source, SIGNAL(positionUpdated(QGeoPositionInfo)), this, SLOT(onPositionUpdated(QGeoPositionInfo)));
+#endif
+  connect(m_source, SIGNAL(error(QGeoPositionInfoSource::Error)), this, SLOT(onError(QGeoPositionInfoSource::Error)));
+  connect(m_source, SIGNAL(updateTimeout()), this, SIGNAL(updateTimeout()));
+
+  m_source->moveToThread(thread);
+  thread->start();
+}
+
+ThreadedPositionSource::~ThreadedPositionSource()
+{
+  // Delete the source in its own thread, where its timers and
+  // sockets live.
+  QGeoPositionInfoSource *source = m_source;
+  QMetaObject::invokeMethod(source, [source]() { delete source; }, Qt::BlockingQueuedConnection);
+  thread->quit();
+  thread->wait();
+}
+
+QGeoPositionInfoSource *ThreadedPositionSource::source() const
+{
+  return m_source;
+}
+
+void ThreadedPositionSource::setUpdateInterval(int msec)
+{
+  QGeoPositionInfoSource::setUpdateInterval(msec);
+  QGeoPositionInfoSource *source = m_source;
+  QMetaObject::invokeMethod(source, [source, msec]() { source->setUpdateInterval(msec); }, Qt::QueuedConnection);
+}
+
+void ThreadedPositionSource::setPreferredPositioningMethods(PositioningMethods methods)
+{
+  QGeoPositionInfoSource::setPreferredPositioningMethods(methods);
+  QGeoPositionInfoSource *source = m_source;
+  QMetaObject::invokeMethod(source, [source, methods]() { source->setPreferredPositioningMethods(methods); }, Qt::QueuedConnection);
+}
+
+QGeoPositionInfo ThreadedPositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  return lastPosition;
+}
+
+ThreadedPositionSource::PositioningMethods ThreadedPositionSource::supportedPositioningMethods() const
+{
+  return m_supportedMethods;
+}
+
+int ThreadedPositionSource::minimumUpdateInterval() const
+{
+  return m_minimumUpdateInterval;
+}
+
+QGeoPositionInfoSource::Error ThreadedPositionSource::error() const
+{
+  return m_error;
+}
+
+void ThreadedPositionSource::startUpdates()
+{
+  QMetaObject::invokeMethod(m_source, "startUpdates", Qt::QueuedConnection);
+}
+
+void ThreadedPositionSource::stopUpdates()
+{
+  QMetaObject::invokeMethod(m_source, "stopUpdates", Qt::QueuedConnection);
+}
+
+void ThreadedPositionSource::requestUpdate(int timeout)
+{
+  QMetaObject::invokeMethod(m_source, "requestUpdate", Qt::QueuedConnection, Q_ARG(int, timeout));
+}
+
+void ThreadedPositionSource::onPositionUpdated(QGeoPositionInfo const &info)
+{
+  lastPosition = info;
+  emit positionUpdated(info);
+}
+
+void ThreadedPositionSource::onError(QGeoPositionInfoSource::Error e)
+{
+  m_error = e;
+  emit error(e);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QThread>
+
+// A Threaded Position Source runs another position source on an I/O
+// thread of its own, so that parsing the input of a busy source does
+// not hold up the thread that consumes the positions (and a slow
+// consumer does not make a socket overflow).
+//
+// It is itself a position source that lives in the caller's thread:
+// the calls made on it are forwarded to the wrapped source, and the
+// signals of the wrapped source are forwarded back through queued
+// connections.  The wrapped source must not have a parent; it is
+// owned by the Threaded Position Source and deleted, in its own
+// thread, when the Threaded Position Source is.
+
+class ThreadedPositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  ThreadedPositionSource(QGeoPositionInfoSource *source, QObject *parent = 0);
+  ~ThreadedPositionSource();
+
+  // The wrapped source.  It lives in the I/O thread, so only its
+  // thread safe members may be called from elsewhere.
+  QGeoPositionInfoSource *source() const;
+
+  virtual void setUpdateInterval(int msec);
+  virtual void setPreferredPositioningMethods(PositioningMethods methods);
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+private slots:
+  void onPositionUpdated(QGeoPositionInfo const &info);
+  void onError(QGeoPositionInfoSource::Error e);
+
+private:
+  QGeoPositionInfoSource *m_source;
+  QThread *thread;
+  PositioningMethods m_supportedMethods;
+  int m_minimumUpdateInterval;
+  Error m_error;
+  QGeoPositionInfo lastPosition;
+};
@@ -0,0 +1,108 @@
+#include <QtCore>
+#include "TlePositionSource.hpp"
+#include "SatelliteCatalog.hpp"
+
+TlePositionSource::TlePositionSource(QString const &fileName, int catalogNumber, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    timer(new QTimer(this)),
+    m_error(NoError)
+{
+  initialize(fileName, catalogNumber, QString());
+}
+
+TlePositionSource::TlePositionSource(QString const &fileName, QString const &name, QObject *parent)
+  : QGeoPositionInfoSource(parent),
+    timer(new QTimer(this)),
+    m_error(NoError)
+{
+  initialize(fileName, -1, name);
+}
+
+void TlePositionSource::initialize(QString const &fileName, int catalogNumber, QString const &name)
+{
+  connect(timer, SIGNAL(timeout()), this, SLOT(propagate()));
+
+  SatelliteCatalog catalog;
+  if (!catalog.load(fileName)) {
+    qWarning() << "Error: cannot open element file" << fileName;
+    m_error = AccessError;
+    return;
+  }
+
+  const int index = name.isEmpty() ? catalog.indexOf(catalogNumber) : catalog.indexOf(name);
+  if (index < 0) {
+    qWarning() << "Error: satellite not found in" << fileName;
+    m_error = UnknownSourceError;
+    return;
+  }
+
+  m_satellite = catalog.propagator(index);
+  if (m_satellite.error() != Sgp4::NoError) {
+    qWarning() << "Error: cannot propagate satellite" << m_satellite.elements().catalogNumber;
+    m_error = UnknownSourceError;
+  }
+}
+
+QGeoPositionInfo TlePositionSource::lastKnownPosition(bool /*fromSatellitePositioningMethodsOnly*/) const
+{
+  return lastPosition;
+}
+
+TlePositionSource::PositioningMethods TlePositionSource::supportedPositioningMethods() const
+{
+  return AllPositioningMethods;
+}
+
+int TlePositionSource::minimumUpdateInterval() const
+{
+  return 10;
+}
+
+Sgp4 const &TlePositionSource::propagator() const
+{
+  return m_satellite;
+}
+
+void TlePositionSource::startUpdates()
+{
+  int interval = updateInterval();
+  if (interval < minimumUpdateInterval())
+    interval = minimumUpdateInterval();
+
+  timer->start(interval);
+}
+
+void TlePositionSource::stopUpdates()
+{
+  timer->stop();
+}
+
+void TlePositionSource::requestUpdate(int /* timeout */)
+{
+  if (m_satellite.error() == Sgp4::NoError)
+    propagate();
+  else
+    emit updateTimeout();
+}
+
+void TlePositionSource::propagate()
+{
+  const QDateTime now = QDateTime::currentDateTimeUtc();
+  GeoPoint position;
+  if (m_satellite.positionAt(now, &position) != Sgp4::NoError) {
+    timer->stop();
+    emit error(QGeoPositionInfoSource::UnknownSourceError);
+    return;
+  }
+
+  QGeoPositionInfo info(position.coordinate(), now);
+  if (info.isValid()) {
+    lastPosition = info;
+    emit positionUpdated(info);
+  }
+}
+
+QGeoPositionInfoSource::Error TlePositionSource::error() const
+{
+  return m_error;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QGeoPositionInfoSource>
+#include <QGeoPositionInfo>
+#include <QTimer>
+#include "Sgp4.hpp"
+
+// The TLE Position Source reports the position of a satellite by
+// propagating its two line elements with the SGP4 model.  The
+// elements are read from a local file (see SatelliteCatalog for the
+// format), so no network access is needed.  The satellite is
+// selected by its NORAD catalog number or by its name.
+//
+// On each update the satellite is propagated to the current time and
+// its position is distributed via the positionUpdated() signal, so
+// that it may be connected to GeoEntity::setPosition() like any
+// other position source.
+
+class TlePositionSource : public QGeoPositionInfoSource
+{
+  Q_OBJECT
+public:
+  TlePositionSource(QString const &fileName, int catalogNumber, QObject *parent = 0);
+  TlePositionSource(QString const &fileName, QString const &name, QObject *parent = 0);
+
+  QGeoPositionInfo lastKnownPosition(bool fromSatellitePositioningMethodsOnly = false) const;
+
+  PositioningMethods supportedPositioningMethods() const;
+  int minimumUpdateInterval() const;
+  Error error() const;
+
+  // The elements of the tracked satellite
+  Sgp4 const &propagator() const;
+
+signals:
+  void error(QGeoPositionInfoSource::Error e);
+
+public slots:
+  virtual void startUpdates();
+  virtual void stopUpdates();
+
+  virtual void requestUpdate(int timeout = 5000);
+
+private slots:
+  void propagate();
+
+private:
+  void initialize(QString const &fileName, int catalogNumber, QString const &name);
+
+  Sgp4 m_satellite;
+  QTimer *timer;
+  QGeoPositionInfo lastPosition;
+  Error m_error;
+};
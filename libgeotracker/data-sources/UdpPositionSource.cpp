@@ -0,0 +1,220 @@
+#include <QtCore>
+#include "UdpPositionSource.hpp"
+#include "LatencyTrace.hpp"
+#include "Metrics.hpp"
+
+#ifdef Q_OS_LINUX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+// The datagrams are received in batches of this many, each in a slot
+// of the buffer large enough for a jumbo frame.  Feeds of positions
+// send far smaller datagrams.
+static const int DatagramBatchSize = 64;
+static const int DatagramSlotSize = 9000;
+
+// Large enough for any UDP datagram
+static const int MaximumDatagramSize = 65536;
+
+#ifdef Q_OS_LINUX
+// The metrics of all the UDP sources
+static
+MetricCounter &TruncatedCount()
+{
+  static MetricCounter *counter = Metrics::global().counter("geotracker_udp_truncated_datagrams_total",
+                                                            "Datagrams dropped for being larger than a slot of the receive buffer.");
+  return *counter;
+}
+#endif
+
+UdpPositionSource::UdpPositionSource(QHostAddress const &address, quint16 port, QObject *parent)
+  : StreamPositionSource(parent),
+    m_address(address),
+    m_port(port),
+    m_datagrams(0),
+    m_truncated(0),
+#ifdef Q_OS_LINUX
+    m_fd(-1),
+    notifier(nullptr),
+    m_buffer(DatagramBatchSize * DatagramSlotSize, Qt::Uninitialized)
+#else
+    socket(new QUdpSocket(this)),
+    m_buffer(MaximumDatagramSize, Qt::Uninitialized)
+#endif
+{
+#ifdef Q_OS_LINUX
+  m_messages.resize(DatagramBatchSize * int(sizeof(mmsghdr) + sizeof(iovec) + sizeof(sockaddr_storage)));
+#else
+  connect(socket, SIGNAL(readyRead()), this, SLOT(readDatagrams()));
+#endif
+}
+
+UdpPositionSource::~UdpPositionSource()
+{
+  close();
+}
+
+quint64 UdpPositionSource::datagrams() const
+{
+  return m_datagrams;
+}
+
+quint64 UdpPositionSource::truncatedDatagrams() const
+{
+  return m_truncated;
+}
+
+#ifdef Q_OS_LINUX
+
+// QUdpSocket is bypassed: it expects to be the one reading from its
+// socket, and recvmmsg() would leave it waiting for a read that never
+// comes.  The socket is bound here and watched like the FIFO of the
+// FifoPositionSource.
+
+bool UdpPositionSource::open()
+{
+  sockaddr_storage storage;
+  memset(&storage, 0, sizeof(storage));
+  socklen_t length;
+  bool dualStack = false;
+  if (m_address.protocol() == QAbstractSocket::IPv4Protocol) {
+    sockaddr_in *address = reinterpret_cast<sockaddr_in *>(&storage);
+    address->sin_family = AF_INET;
+    address->sin_port = htons(m_port);
+    address->sin_addr.s_addr = htonl(m_address.toIPv4Address());
+    length = sizeof(sockaddr_in);
+  } else {
+    // IPv6, or any address of either protocol
+    sockaddr_in6 *address = reinterpret_cast<sockaddr_in6 *>(&storage);
+    address->sin6_family = AF_INET6;
+    address->sin6_port = htons(m_port);
+    if (m_address != QHostAddress::Any) {
+      Q_IPV6ADDR ip = m_address.toIPv6Address();
+      memcpy(&address->sin6_addr, &ip, sizeof(ip));
+      address->sin6_scope_id = m_address.scopeId().toUInt();
+    } else {
+      dualStack = true;
+    }
+    length = sizeof(sockaddr_in6);
+  }
+
+  m_fd = ::socket(storage.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_fd < 0) {
+    qWarning() << "Error: cannot create a UDP socket" << strerror(errno);
+    return false;
+  }
+  // As QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint
+  int on = 1;
+  int off = 0;
+  ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  ::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+  if (dualStack)
+    ::setsockopt(m_fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off));
+  if (::bind(m_fd, reinterpret_cast<sockaddr *>(&storage), length) < 0) {
+    qWarning() << "Error: cannot bind to" << m_address.toString() << m_port << strerror(errno);
+    ::close(m_fd);
+    m_fd = -1;
+    return false;
+  }
+
+  notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+  connect(notifier, SIGNAL(activated(int)), this, SLOT(readDatagrams()));
+  return true;
+}
+
+void UdpPositionSource::close()
+{
+  delete notifier;
+  notifier = nullptr;
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+void UdpPositionSource::readDatagrams()
+{
+  LATENCY_TRACE_SCOPE();
+  mmsghdr *messages = reinterpret_cast<mmsghdr *>(m_messages.data());
+  iovec *vectors = reinterpret_cast<iovec *>(messages + DatagramBatchSize);
+  sockaddr_storage *senders = reinterpret_cast<sockaddr_storage *>(vectors + DatagramBatchSize);
+  char *buffer = m_buffer.data();
+
+  while (isActive()) {
+    // The kernel overwrites the lengths, so they are reset before each
+    // call.
+    for (int i = 0; i < DatagramBatchSize; ++i) {
+      vectors[i].iov_base = buffer + i * DatagramSlotSize;
+      vectors[i].iov_len = DatagramSlotSize;
+      memset(&messages[i].msg_hdr, 0, sizeof(msghdr));
+      messages[i].msg_hdr.msg_iov = &vectors[i];
+      messages[i].msg_hdr.msg_iovlen = 1;
+      messages[i].msg_hdr.msg_name = &senders[i];
+      messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    }
+
+    const int count = ::recvmmsg(m_fd, messages, DatagramBatchSize, MSG_DONTWAIT, nullptr);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        qWarning() << "Error: cannot receive from" << m_address.toString() << m_port << strerror(errno);
+      break;
+    }
+
+    for (int i = 0; i < count; ++i) {
+      ++m_datagrams;
+      if (messages[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        ++m_truncated;
+        TruncatedCount().increment();
+        continue;
+      }
+      setSenderId(PositionSampleParser::hash(&senders[i], messages[i].msg_hdr.msg_namelen));
+      consume(buffer + i * DatagramSlotSize, messages[i].msg_len, true);
+    }
+    flush();
+    if (count < DatagramBatchSize)
+      break;
+  }
+}
+
+#else
+
+bool UdpPositionSource::open()
+{
+  if (!socket->bind(m_address, m_port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+    qWarning() << "Error: cannot bind to" << m_address.toString() << m_port << socket->errorString();
+    return false;
+  }
+  return true;
+}
+
+void UdpPositionSource::close()
+{
+  socket->close();
+}
+
+void UdpPositionSource::readDatagrams()
+{
+  LATENCY_TRACE_SCOPE();
+  // The datagrams are read into the same buffer, one at a time.
+  QHostAddress sender;
+  quint16 port;
+  while (isActive() && socket->hasPendingDatagrams()) {
+    const qint64 size = socket->readDatagram(m_buffer.data(), m_buffer.size(), &sender, &port);
+    if (size < 0)
+      break;
+    ++m_datagrams;
+    Q_IPV6ADDR ip = sender.toIPv6Address();
+    setSenderId(PositionSampleParser::hash(&ip, sizeof(ip)) ^ port);
+    consume(m_buffer.constData(), size, true);
+  }
+  flush();
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QUdpSocket>
+#include <QSocketNotifier>
+#include <QVector>
+#include "StreamPositionSource.hpp"
+
+// The UDP Position Source receives positions in datagrams sent to a
+// local address and port.  Each datagram holds one or more lines in
+// any of the formats of the PositionSampleParser: the log format,
+// NMEA GGA and RMC sentences, or gpsd TPV reports.  Samples without
+// an id of their own are identified by the address and port of their
+// sender, so that one port can receive the feeds of many entities.
+//
+// On Linux, the datagrams are received in batches of up to
+// DatagramBatchSize with one recvmmsg() system call, and the samples
+// of a whole batch are handed on at once (see StreamPositionSource).
+// Elsewhere, the datagrams are read one at a time with QUdpSocket.
+
+class UdpPositionSource : public StreamPositionSource
+{
+  Q_OBJECT
+public:
+  UdpPositionSource(QHostAddress const &address, quint16 port, QObject *parent = 0);
+  virtual ~UdpPositionSource();
+
+  // The number of datagrams received, and of those that were too
+  // large for the receive buffers and were dropped.
+  quint64 datagrams() const;
+  quint64 truncatedDatagrams() const;
+
+protected:
+  virtual bool open();
+  virtual void close();
+
+private slots:
+  void readDatagrams();
+
+private:
+  QHostAddress m_address;
+  quint16 m_port;
+  quint64 m_datagrams;
+  quint64 m_truncated;
+#ifdef Q_OS_LINUX
+  int m_fd;
+  QSocketNotifier *notifier;
+#else
+  QUdpSocket *socket;
+#endif
+  QByteArray m_buffer;
+  QVector<char> m_messages;     // struct mmsghdr[], iovec[] and sockaddr_storage[]
+};
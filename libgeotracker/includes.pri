@@ -1,13 +1,90 @@
 HEADERS   += $$PWD/GeoPoint.hpp \
+             $$PWD/FastMath.hpp \
              $$PWD/LookAngle.hpp \
+             $$PWD/LookAngleKernel.hpp \
+             $$PWD/LookAngleCache.hpp \
+             $$PWD/LocalTangentPlane.hpp \
+             $$PWD/Refraction.hpp \
+             $$PWD/Geodesic.hpp \
+             $$PWD/PositionSample.hpp \
+             $$PWD/EntityPool.hpp \
+             $$PWD/EntityRegistry.hpp \
+             $$PWD/Listener.hpp \
              $$PWD/GeoEntity.hpp \
+             $$PWD/LatencyTrace.hpp \
+             $$PWD/Metrics.hpp \
+             $$PWD/MetricsServer.hpp \
+             $$PWD/GeoEntityDispatcher.hpp \
+             $$PWD/TrackFusion.hpp \
+             $$PWD/ReorderBuffer.hpp \
              $$PWD/GeoObserver.hpp \
+             $$PWD/ObserverNetwork.hpp \
+             $$PWD/ShardedTracker.hpp \
+             $$PWD/OutputFormat.hpp \
+             $$PWD/OutputSink.hpp \
+             $$PWD/GimbalDriver.hpp \
              $$PWD/RotationReadingSource.hpp \
-             $$PWD/data-sources/LogFilePositionSource.hpp
+             $$PWD/Sgp4.hpp \
+             $$PWD/SatelliteCatalog.hpp \
+             $$PWD/Trajectory.hpp \
+             $$PWD/VisibilityPredictor.hpp \
+             $$PWD/CoverageRaster.hpp \
+             $$PWD/data-sources/LogFilePositionSource.hpp \
+             $$PWD/data-sources/TlePositionSource.hpp \
+             $$PWD/data-sources/MappedFilePositionSource.hpp \
+             $$PWD/data-sources/PositionSampleParser.hpp \
+             $$PWD/data-sources/StreamPositionSource.hpp \
+             $$PWD/data-sources/UdpPositionSource.hpp \
+             $$PWD/data-sources/LocalSocketPositionSource.hpp \
+             $$PWD/data-sources/FifoPositionSource.hpp \
+             $$PWD/data-sources/MavlinkParser.hpp \
+             $$PWD/data-sources/MavlinkPositionSource.hpp \
+             $$PWD/data-sources/SimulatedPositionSource.hpp \
+             $$PWD/data-sources/ThreadedPositionSource.hpp \
+             $$PWD/data-sources/PositionSourceMonitor.hpp \
+             $$PWD/data-sources/PositionSourceFactory.hpp
 
 SOURCES   += $$PWD/GeoPoint.cpp \
+             $$PWD/FastMath.cpp \
              $$PWD/LookAngle.cpp \
+             $$PWD/LookAngleKernel.cpp \
+             $$PWD/LookAngleCache.cpp \
+             $$PWD/LocalTangentPlane.cpp \
+             $$PWD/Refraction.cpp \
+             $$PWD/Geodesic.cpp \
+             $$PWD/PositionSample.cpp \
+             $$PWD/EntityPool.cpp \
+             $$PWD/EntityRegistry.cpp \
              $$PWD/GeoEntity.cpp \
+             $$PWD/LatencyTrace.cpp \
+             $$PWD/Metrics.cpp \
+             $$PWD/MetricsServer.cpp \
+             $$PWD/GeoEntityDispatcher.cpp \
+             $$PWD/TrackFusion.cpp \
+             $$PWD/ReorderBuffer.cpp \
              $$PWD/GeoObserver.cpp \
+             $$PWD/ObserverNetwork.cpp \
+             $$PWD/ShardedTracker.cpp \
+             $$PWD/OutputFormat.cpp \
+             $$PWD/OutputSink.cpp \
+             $$PWD/GimbalDriver.cpp \
              $$PWD/RotationReadingSource.cpp \
-             $$PWD/data-sources/LogFilePositionSource.cpp
+             $$PWD/Sgp4.cpp \
+             $$PWD/SatelliteCatalog.cpp \
+             $$PWD/Trajectory.cpp \
+             $$PWD/VisibilityPredictor.cpp \
+             $$PWD/CoverageRaster.cpp \
+             $$PWD/data-sources/LogFilePositionSource.cpp \
+             $$PWD/data-sources/TlePositionSource.cpp \
+             $$PWD/data-sources/MappedFilePositionSource.cpp \
+             $$PWD/data-sources/PositionSampleParser.cpp \
+             $$PWD/data-sources/StreamPositionSource.cpp \
+             $$PWD/data-sources/UdpPositionSource.cpp \
+             $$PWD/data-sources/LocalSocketPositionSource.cpp \
+             $$PWD/data-sources/FifoPositionSource.cpp \
+             $$PWD/data-sources/MavlinkParser.cpp \
+             $$PWD/data-sources/MavlinkPositionSource.cpp \
+             $$PWD/data-sources/SimulatedPositionSource.cpp \
+             $$PWD/data-sources/ThreadedPositionSource.cpp \
+             $$PWD/data-sources/PositionSourceMonitor.cpp \
+             $$PWD/data-sources/PositionSourceFactory.cpp
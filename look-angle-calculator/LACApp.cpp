@@ -5,6 +5,7 @@
 #include "LACApp.hpp"
 #include "LookAngle.hpp"
 #include "GeoPoint.hpp"
+#include "Geodesic.hpp"
 
 void LACApp::help(){
   QTextStream out(stdout);
@@ -12,12 +13,18 @@ void LACApp::help(){
       << "target.  Coordinates are defined by latitude in decimal degrees," << Qt::endl
       << "longitude in decimal degrees, and optionally, altitude in meters above" << Qt::endl
       << "sea level.  The coordinate values should be specified using the WGS84" << Qt::endl
-      << "datum. The look angle is a line of sight calculation, not the geodetic" << Qt::endl
-      << "problem.  Azimuth in this context is represented in degrees from true" << Qt::endl
-      << "north to the target while elevation is the angle in degrees from the" << Qt::endl
-      << "horizon to the target. To be valid, the latitude must be between -90" << Qt::endl
-      << "to 90 inclusive. To be valid, the longitude must be between -180 to" << Qt::endl
-      << "180 inclusive." << Qt::endl;  
+      << "datum. The look angle is a line of sight calculation.  Azimuth in" << Qt::endl
+      << "this context is represented in degrees from true north to the target" << Qt::endl
+      << "while elevation is the angle in degrees from the horizon to the" << Qt::endl
+      << "target. To be valid, the latitude must be between -90 to 90" << Qt::endl
+      << "inclusive. To be valid, the longitude must be between -180 to 180" << Qt::endl
+      << "inclusive." << Qt::endl
+      << Qt::endl
+      << "The geodetic problem is also solved: the distance over the surface" << Qt::endl
+      << "of the WGS84 ellipsoid along the geodesic (the shortest path) and" << Qt::endl
+      << "along the great ellipse, each with the initial bearing from the" << Qt::endl
+      << "observer and the final bearing on arrival at the target.  Altitudes" << Qt::endl
+      << "are ignored for these." << Qt::endl;
   out << Qt::endl;
 }
 
@@ -39,6 +46,23 @@ LACApp::LACApp(QCoreApplication *app, int argc, char *argv[]) :
                                        QCoreApplication::translate("main", "Interactive mode to query coordinates."));
   parser.addOption(interactiveOption);
 
+  // Atmospheric refraction correction of the elevation
+  QCommandLineOption refractionOption(QStringList() << "r" << "refraction",
+                                      QCoreApplication::translate("main", "Correct the elevation for atmospheric refraction using <model>: none, radio (4/3 earth), bennett or saemundsson."),
+                                      QCoreApplication::translate("main", "model"),
+                                      "none");
+  parser.addOption(refractionOption);
+  QCommandLineOption temperatureOption(QStringList() << "t" << "temperature",
+                                       QCoreApplication::translate("main", "Air temperature at the observer in degrees Celsius (default 10)."),
+                                       QCoreApplication::translate("main", "celsius"),
+                                       "10");
+  parser.addOption(temperatureOption);
+  QCommandLineOption pressureOption(QStringList() << "p" << "pressure",
+                                    QCoreApplication::translate("main", "Air pressure at the observer in millibars (default 1010)."),
+                                    QCoreApplication::translate("main", "millibars"),
+                                    "1010");
+  parser.addOption(pressureOption);
+
   // Process the actual command line arguments given by the user
   parser.process(*m_app);
 
@@ -48,6 +72,19 @@ LACApp::LACApp(QCoreApplication *app, int argc, char *argv[]) :
   bool isInteractive = parser.isSet(interactiveOption);
   double lat, lon, alt;
   QTextStream err(stderr);
+
+  QString model = parser.value(refractionOption).toLower();
+  double temperature = parser.value(temperatureOption).toDouble();
+  double pressure = parser.value(pressureOption).toDouble();
+  if (model == "radio")
+    m_refraction = Refraction(Refraction::FourThirdsEarth, temperature, pressure);
+  else if (model == "bennett")
+    m_refraction = Refraction(Refraction::Bennett, temperature, pressure);
+  else if (model == "saemundsson")
+    m_refraction = Refraction(Refraction::Saemundsson, temperature, pressure);
+  else if (model != "none")
+    err << "WARNING: unknown refraction model " << model << ", ignored" << Qt::endl;
+
   QTextStream out(stdout);
   QTextStream in(stdin);
   if (isInteractive) {
@@ -94,7 +131,7 @@ if (!m_target.isValid()) {
 void LACApp::main()
 {
   QTextStream stream(stdout);
-  LookAngle lookAngle(m_observer, m_target);
+  LookAngle lookAngle(m_observer, m_target, m_refraction);
   GeoPoint observer_ecef(m_observer);
   GeoPoint target_ecef(m_target);
   
@@ -104,6 +141,16 @@ void LACApp::main()
   stream << "     azimuth to target: " << lookAngle.azimuth() << Qt::endl;
   stream << "   elevation to target: " << lookAngle.elevation() << Qt::endl;
   stream << "LoS distance to target: " << observer_ecef.distanceTo(target_ecef) << Qt::endl;
+
+  double initialBearing, finalBearing;
+  double distance = Geodesic::wgs84().inverse(m_observer, m_target, &initialBearing, &finalBearing);
+  stream << "     geodesic distance: " << distance << Qt::endl;
+  stream << "       initial bearing: " << initialBearing << Qt::endl;
+  stream << "         final bearing: " << finalBearing << Qt::endl;
+  distance = Geodesic::wgs84().greatEllipse(m_observer, m_target, &initialBearing, &finalBearing);
+  stream << "great ellipse distance: " << distance << Qt::endl;
+  stream << "       initial bearing: " << initialBearing << Qt::endl;
+  stream << "         final bearing: " << finalBearing << Qt::endl;
   
   emit finished();
 }
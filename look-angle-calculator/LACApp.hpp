@@ -3,6 +3,7 @@
 #include <QObject>
 #include <QCoreApplication>
 #include <QGeoCoordinate>
+#include "Refraction.hpp"
 
 class LACApp : public QObject
 {
@@ -23,5 +24,6 @@ private:
   QCoreApplication *m_app;
   QGeoCoordinate m_observer;
   QGeoCoordinate m_target;
+  Refraction m_refraction;
 };
 
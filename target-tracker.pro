@@ -3,12 +3,14 @@ TEMPLATE  = subdirs
 SUBDIRS  += libgeotracker \
             tests \
             target-tracker \
-            look-angle-calculator
+            look-angle-calculator \
+            tracker-bench
 
 # Define the build-time directory dependencies
 tests.depends = libgeotracker
 target-tracker.depends = libgeotracker
 look-angle-calculator.depends = libgeotracker
+tracker-bench.depends = libgeotracker
 
 # Common configurations
 include ("common.pri")
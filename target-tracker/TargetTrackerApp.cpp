@@ -1,92 +1,280 @@
 #include <QTextStream>
 #include <QDateTime>
 #include <QDebug>
+#include <QCommandLineParser>
+#include <QUrlQuery>
 #include "TargetTrackerApp.hpp"
-#include "data-sources/LogFilePositionSource.hpp"
+#include "data-sources/PositionSourceFactory.hpp"
+#include "data-sources/PositionSourceMonitor.hpp"
+#include "data-sources/ThreadedPositionSource.hpp"
+#include "data-sources/StreamPositionSource.hpp"
+#include "data-sources/MavlinkPositionSource.hpp"
+#include "data-sources/SimulatedPositionSource.hpp"
 #include "GeoPoint.hpp"
+#include "LatencyTrace.hpp"
+#include "Metrics.hpp"
+#include "MetricsServer.hpp"
+#include "OutputSink.hpp"
+#include "GimbalDriver.hpp"
 
-void TargetTrackerApp::create_observer()
+// Hand the samples of a source of many entities to a sink, if it
+// has the fast path.
+static
+bool SetSampleSink(QGeoPositionInfoSource *source, PositionSampleSink *sink)
+{
+  if (ThreadedPositionSource *threaded = qobject_cast<ThreadedPositionSource *>(source))
+    source = threaded->source();
+  if (StreamPositionSource *stream = qobject_cast<StreamPositionSource *>(source)) {
+    stream->setSampleSink(sink);
+    return true;
+  }
+  if (MavlinkPositionSource *mavlink = qobject_cast<MavlinkPositionSource *>(source)) {
+    mavlink->setSampleSink(sink);
+    return true;
+  }
+  if (SimulatedPositionSource *simulated = qobject_cast<SimulatedPositionSource *>(source)) {
+    simulated->setSampleSink(sink);
+    return true;
+  }
+  return false;
+}
+
+QGeoPositionInfoSource *TargetTrackerApp::create_source(QString uri, QString const &name)
+{
+  // Run the source on its own I/O thread if asked to.
+  if (m_isThreaded && !uri.contains("thread="))
+    uri += (uri.contains('?') ? "&" : "?") + QString("thread=1");
+
+  QString errorString;
+  QGeoPositionInfoSource *source = PositionSourceFactory::create(uri, this, &errorString);
+  if (!source) {
+    qDebug() << "Failed" << name << "source:" << errorString;
+    return nullptr;
+  }
+  PositionSourceMonitor *monitor = new PositionSourceMonitor(source);
+  monitor->setObjectName(name);
+  monitor->exportMetrics(Metrics::global(), name);
+  monitors.append(monitor);
+  return source;
+}
+
+void TargetTrackerApp::create_observer(QString const &uri)
 {
   // Create the observer object:
   observer = new GeoObserver();
 
-  // Since the observer is, by default, the current platform, then
-  // connect the platform's movements to the observer's position
-  // update method.
-  observer_source = QGeoPositionInfoSource::createDefaultSource(this);
+  // The observer is, by default, the current platform (the "default:"
+  // source), so connect the platform's movements to the observer's
+  // position, which recalculates the look angle.
+  observer_source = create_source(uri, "observer");
   if (observer_source){
     connect(observer_source, &QGeoPositionInfoSource::positionUpdated,
-            observer,        &GeoObserver::onObserverPositionChanged);
-  }else{
-    qDebug()<<"Failed source";
+            observer,        &GeoEntity::setPosition);
   }
 }
 
-void TargetTrackerApp::create_target()
+void TargetTrackerApp::create_target(QString const &uri)
 {
   // Create the target object:
   target = new GeoEntity();
 
-  // Connect the target to a position info source:
-  //
-  // TODO: Provide a command line option to obtain target position
-  // updates from stdin (default), a RESTful interface URL, or a DBUS
-  // object.  for now, obtain target position updates from the logfile
-  // position info source.
-  LogFilePositionSource *target_source_from_log_file = new LogFilePositionSource(this);
-  connect(target_source_from_log_file, &LogFilePositionSource::positionUpdated, target, &GeoEntity::setPosition);
-  target_source = target_source_from_log_file;
+  // Connect the target to its position info source, by default the
+  // log file compiled into the resources.
+  target_source = create_source(uri, "target");
+  if (!target_source)
+    return;
+  connect(target_source, &QGeoPositionInfoSource::positionUpdated, target, &GeoEntity::setPosition);
 
   // Connect the position info source's error signal to terminate the
-  // program:
-  connect(target_source_from_log_file, qOverload<QGeoPositionInfoSource::Error>(&LogFilePositionSource::error), this, &TargetTrackerApp::onError);
+  // program.  The sources redeclare the signal, so connect it by name.
+  connect(target_source, SIGNAL(error(QGeoPositionInfoSource::Error)), this, SLOT(onError(QGeoPositionInfoSource::Error)));
 }
 
 TargetTrackerApp::TargetTrackerApp(QCoreApplication *app, int argc, char *argv[]) :
-  m_app(app)
+  m_app(app),
+  m_isThreaded(false),
+  m_isReportingStatistics(false),
+  observer_source(nullptr),
+  target_source(nullptr),
+  metrics(nullptr),
+  output(nullptr),
+  gimbal(nullptr),
+  sharded(nullptr)
 {
   Q_UNUSED(argc);
   Q_UNUSED(argv);
   QCoreApplication::setApplicationName(QCoreApplication::translate("main", "target-tracker"));
   QCoreApplication::setApplicationVersion(GIT_VERSION);
 
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Target Tracker.\n\n"
+                                   "Position sources are given as URIs: default:, file:<path>, qrc:<path>,\n"
+                                   "mmap:<path>, udp://<address>:<port>, unix:<path>, fifo:<path>, stdin:,\n"
+                                   "mavlink:<device>[?baud=<rate>]\n"
+                                   "or sim:?lat=<deg>&lon=<deg>[&alt=<m>&radius=<m>&speed=<m/s>\n"
+                                   "&n=<entities>&model=<circle|great-circle|orbit|loiter|walk>&seed=<n>].\n"
+                                   "Append ?thread=1 to run a source on its own I/O thread and\n"
+                                   "?interval=<msecs> to set its update interval.\n\n"
+                                   "The metrics are served, for Prometheus to scrape, on\n"
+                                   "unix:<path>, localhost:<port> or <port>.\n\n"
+                                   "The output is written in one of the formats text, csv, ndjson\n"
+                                   "or binary, from a thread of its own.\n\n"
+                                   "A gimbal is pointed at the target with commands written to\n"
+                                   "<device>[?baud=<rate>&rate=<commands per second>].\n\n"
+                                   "The entities of a target source of many (stream, mavlink or sim)\n"
+                                   "are tracked on worker threads with --shards.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  QCommandLineOption observerOption(QStringList() << "o" << "observer",
+                                    QCoreApplication::translate("main", "Position source of the observer (default: the platform's)."),
+                                    QCoreApplication::translate("main", "uri"),
+                                    "default:");
+  parser.addOption(observerOption);
+  QCommandLineOption targetOption(QStringList() << "t" << "target",
+                                  QCoreApplication::translate("main", "Position source of the target (default: the built in log)."),
+                                  QCoreApplication::translate("main", "uri"),
+                                  "qrc:/sim-data/log-short.txt");
+  parser.addOption(targetOption);
+  QCommandLineOption threadsOption(QStringList() << "threads",
+                                   QCoreApplication::translate("main", "Run every position source on its own I/O thread."));
+  parser.addOption(threadsOption);
+  QCommandLineOption statisticsOption(QStringList() << "statistics",
+                                      QCoreApplication::translate("main", "Report the throughput and latency of the position sources on exit."));
+  parser.addOption(statisticsOption);
+  QCommandLineOption metricsOption(QStringList() << "metrics",
+                                   QCoreApplication::translate("main", "Serve the metrics on a local socket or port."),
+                                   QCoreApplication::translate("main", "address"));
+  parser.addOption(metricsOption);
+  QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                  QCoreApplication::translate("main", "Format of the output (default: text)."),
+                                  QCoreApplication::translate("main", "format"),
+                                  "text");
+  parser.addOption(formatOption);
+  QCommandLineOption outputOption(QStringList() << "output",
+                                  QCoreApplication::translate("main", "File to write the output to (default: the standard output)."),
+                                  QCoreApplication::translate("main", "file"),
+                                  "-");
+  parser.addOption(outputOption);
+  QCommandLineOption gimbalOption(QStringList() << "gimbal",
+                                  QCoreApplication::translate("main", "Serial device or pseudo terminal of a gimbal to point at the target."),
+                                  QCoreApplication::translate("main", "device"));
+  parser.addOption(gimbalOption);
+  QCommandLineOption shardsOption(QStringList() << "shards",
+                                  QCoreApplication::translate("main", "Track the entities of the target source on worker threads (0: one per core)."),
+                                  QCoreApplication::translate("main", "count"));
+  parser.addOption(shardsOption);
+
+  // Process the actual command line arguments given by the user
+  parser.process(*m_app);
+  m_isThreaded = parser.isSet(threadsOption);
+  m_isReportingStatistics = parser.isSet(statisticsOption);
+
+  // The output, written off the tracking thread
+  OutputFormat *format = OutputFormat::create(parser.value(formatOption));
+  if (!format) {
+    qDebug() << "Unknown output format:" << parser.value(formatOption);
+    format = new TextOutputFormat;
+  }
+  output = new OutputSink(format);
+  if (!output->open(parser.value(outputOption)))
+    qDebug() << "Failed output:" << output->errorString();
+
+  // Serve the metrics before the sources start counting
+  if (parser.isSet(metricsOption)) {
+    metrics = new MetricsServer(&Metrics::global(), this);
+    if (!metrics->listen(parser.value(metricsOption)))
+      qDebug() << "Failed metrics server:" << metrics->errorString();
+  }
+
   // Create the observer and target
-  create_observer();
-  create_target();
+  create_observer(parser.value(observerOption));
+  create_target(parser.value(targetOption));
   
+#ifdef LATENCY_TRACE
+  // The latencies from ingest to look angle, on SIGUSR1 and on exit
+  LatencyTrace::dumpOnSignal();
+  LatencyTrace::dumpAtExit();
+#endif
+
   // Point the observer at the target
   observer->setTarget(target);
 
-  // Print everyone's movements
-  connect(observer, &GeoEntity::positionChanged,    this, &TargetTrackerApp::onObserverPositionChanged);
-  connect(target,   &GeoEntity::positionChanged,    this, &TargetTrackerApp::onTargetPositionChanged);
-  connect(observer, &GeoObserver::lookAngleChanged, this, &TargetTrackerApp::onLookAngleChanged);
+  // And at the entities of the target source, on the shards
+  if (parser.isSet(shardsOption)) {
+    sharded = new ShardedTracker(parser.value(shardsOption).toInt(), this);
+    sharded->setLookAngleSink(this);
+    if (observer_source)
+      connect(observer_source, &QGeoPositionInfoSource::positionUpdated,
+              sharded,         &ShardedTracker::setObserverPosition);
+    if (!target_source || !SetSampleSink(target_source, sharded))
+      qDebug() << "The target source has no entities to shard";
+  }
+
+  // And the gimbal along the look angles
+  if (parser.isSet(gimbalOption)) {
+    const QString value = parser.value(gimbalOption);
+    const int separator = value.indexOf('?');
+    const QUrlQuery query(separator < 0 ? QString() : value.mid(separator + 1));
+    gimbal = new GimbalDriver(this);
+    if (query.hasQueryItem("rate"))
+      gimbal->setCommandRate(query.queryItemValue("rate").toInt());
+    const int baudRate = query.hasQueryItem("baud") ? query.queryItemValue("baud").toInt() : 115200;
+    if (gimbal->open(value.left(separator < 0 ? value.size() : separator), baudRate)) {
+      gimbalListener.bind<GimbalDriver, &GimbalDriver::setTarget>(gimbal);
+      observer->addLookAngleListener(&gimbalListener);
+      gimbal->start();
+    } else {
+      qDebug() << "Failed gimbal:" << gimbal->errorString();
+    }
+  }
 
-  // Set the update interval and start the updates:
+  // Print everyone's movements, called directly rather than by
+  // signals
+  observerListener.bind<TargetTrackerApp, &TargetTrackerApp::onObserverPositionChanged>(this);
+  observer->addPositionListener(&observerListener);
+  targetListener.bind<TargetTrackerApp, &TargetTrackerApp::onTargetPositionChanged>(this);
+  target->addPositionListener(&targetListener);
+  lookAngleListener.bind<TargetTrackerApp, &TargetTrackerApp::onLookAngleChanged>(this);
+  observer->addLookAngleListener(&lookAngleListener);
+
+  // Set the update interval, unless given in the URI:
   //
   // TODO: update the intrval based upon object speeds and distances
-  // OR upon a command line parameter
-  observer_source->setUpdateInterval(500);
-  target_source->setUpdateInterval(500);
+  if (observer_source && !parser.value(observerOption).contains("interval="))
+    observer_source->setUpdateInterval(500);
+  if (target_source && !parser.value(targetOption).contains("interval="))
+    target_source->setUpdateInterval(500);
 }
 
 void TargetTrackerApp::onObserverPositionChanged(QGeoPositionInfo const &position)
 {
-  QTextStream stream(stdout);
-  stream << "   observer's location: " << position.coordinate().toString() << Qt::endl;
+  QGeoCoordinate const coordinate = position.coordinate();
+  output->write(OutputRecord::position(OutputRecord::ObserverPosition, position.timestamp().toMSecsSinceEpoch(),
+                                       coordinate.latitude(), coordinate.longitude(), coordinate.altitude()));
 }
 
 void TargetTrackerApp::onTargetPositionChanged(QGeoPositionInfo const &position)
 {
-  QTextStream stream(stdout);
-  stream << "     target's location: " << position.coordinate().toString() << Qt::endl;
+  QGeoCoordinate const coordinate = position.coordinate();
+  output->write(OutputRecord::position(OutputRecord::TargetPosition, position.timestamp().toMSecsSinceEpoch(),
+                                       coordinate.latitude(), coordinate.longitude(), coordinate.altitude()));
 }
 
 void TargetTrackerApp::onLookAngleChanged(LookAngle const &lookAngle)
 {
-  QTextStream stream(stdout);
-  stream << "     azimuth to target: " << lookAngle.azimuth() << Qt::endl;
-  stream << "   elevation to target: " << lookAngle.elevation() << Qt::endl;
+  LATENCY_TRACE_MARK(LookAngleDelivered);
+  output->write(OutputRecord::lookAngle(QDateTime::currentMSecsSinceEpoch(),
+                                        lookAngle.azimuth(), lookAngle.elevation()));
+}
+
+void TargetTrackerApp::consume(EntityLookAngle const *lookAngles, int count)
+{
+  if (!output)
+    return;
+  for (int i = 0; i < count; ++i)
+    output->write(OutputRecord::lookAngle(lookAngles[i].timestamp,
+                                          lookAngles[i].azimuth, lookAngles[i].elevation));
 }
 
 void TargetTrackerApp::onPositionChanged(QGeoPositionInfo const &info)
@@ -104,19 +292,69 @@ void TargetTrackerApp::onPositionChanged(QGeoPositionInfo const &info)
 
 void TargetTrackerApp::main()
 {
+  // Without a target there is nothing to do.
+  if (!target_source) {
+    onError(QGeoPositionInfoSource::UnknownSourceError);
+    return;
+  }
+
   // Tell the position sources to start reporting updates:
-  observer_source->startUpdates();
+  if (observer_source)
+    observer_source->startUpdates();
   target_source->startUpdates();
 }
 
+void TargetTrackerApp::reportStatistics()
+{
+  QTextStream stream(stderr);
+  for (PositionSourceMonitor const *monitor : monitors) {
+    PositionSourceStatistics s = monitor->statistics();
+    stream << monitor->objectName() << " (" << monitor->source()->objectName() << "): "
+           << s.updates << " positions in " << s.elapsed << " s, "
+           << s.rate << " per second, "
+           << s.errors << " errors, latency min/mean/max "
+           << s.minLatency << "/" << s.meanLatency << "/" << s.maxLatency << " ms" << Qt::endl;
+  }
+  if (gimbal) {
+    GimbalStatistics s = gimbal->statistics();
+    stream << "gimbal: " << s.commands << " commands, " << s.overruns << " overruns, tracking error "
+           << s.trackingError << " degrees, at most " << s.maxTrackingError << Qt::endl;
+  }
+  if (sharded) {
+    for (int i = 0; i < sharded->shardCount(); ++i) {
+      ShardedTrackerStatistics s = sharded->statistics(i);
+      stream << "shard " << i << ": " << s.samples << " samples, " << s.lookAngles << " look angles, "
+             << s.dropped << " dropped" << Qt::endl;
+    }
+  }
+}
+
 void TargetTrackerApp::onError(QGeoPositionInfoSource::Error error)
 {
   Q_UNUSED(error);
 
   // stop the updates:
-  observer_source->stopUpdates();
-  target_source->stopUpdates();
-  
+  if (observer_source)
+    observer_source->stopUpdates();
+  if (target_source)
+    target_source->stopUpdates();
+
+  if (gimbal)
+    gimbal->stop();
+  if (sharded) {
+    SetSampleSink(target_source, nullptr);
+    sharded->flush();
+  }
+  if (m_isReportingStatistics)
+    reportStatistics();
+  monitors.clear();
+
+  // Write out what is queued
+  delete sharded;
+  sharded = nullptr;
+  delete output;
+  output = nullptr;
+
   // clean up:
   delete observer_source;
   delete observer;
@@ -7,14 +7,23 @@
 #include "GeoEntity.hpp"
 #include "GeoObserver.hpp"
 #include "LookAngle.hpp"
+#include "ShardedTracker.hpp"
 
-class TargetTrackerApp : public QObject
+class PositionSourceMonitor;
+class MetricsServer;
+class OutputSink;
+class GimbalDriver;
+
+class TargetTrackerApp : public QObject, public EntityLookAngleSink
 {
   Q_OBJECT
 
 public:
   TargetTrackerApp(QCoreApplication *app, int argc, char *argv[]);
 
+  // The look angles of the sharded tracker
+  virtual void consume(EntityLookAngle const *lookAngles, int count);
+
 public slots:
   void main();
 
@@ -29,16 +38,31 @@ signals:
   void finished();
 
 private:
-  void create_observer();
-  void create_target();
+  QGeoPositionInfoSource *create_source(QString uri, QString const &name);
+  void create_observer(QString const &uri);
+  void create_target(QString const &uri);
+  void reportStatistics();
   
 private:
   QCoreApplication       *m_app;
+  bool                    m_isThreaded;
+  bool                    m_isReportingStatistics;
   
   GeoObserver            *observer;
   QGeoPositionInfoSource *observer_source;
   
   GeoEntity              *target;
   QGeoPositionInfoSource *target_source;
+
+  QList<PositionSourceMonitor *> monitors;
+  MetricsServer                 *metrics;
+  OutputSink                    *output;
+  GimbalDriver                  *gimbal;
+  ShardedTracker                *sharded;
+
+  PositionListener               observerListener;
+  PositionListener               targetListener;
+  LookAngleListener              lookAngleListener;
+  LookAngleListener              gimbalListener;
 };
 
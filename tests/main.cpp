@@ -0,0 +1,113 @@
+#include <QCoreApplication>
+#include <QTest>
+#include "test_CoverageRaster.hpp"
+#include "test_EntityPool.hpp"
+#include "test_EntityRegistry.hpp"
+#include "test_FastMath.hpp"
+#include "test_Geodesic.hpp"
+#include "test_GimbalDriver.hpp"
+#include "test_LatencyTrace.hpp"
+#include "test_Listener.hpp"
+#include "test_LocalTangentPlane.hpp"
+#include "test_LookAngle.hpp"
+#include "test_LookAngleCache.hpp"
+#include "test_LookAngleKernel.hpp"
+#include "test_MavlinkPositionSource.hpp"
+#include "test_Metrics.hpp"
+#include "test_ObserverNetwork.hpp"
+#include "test_OutputSink.hpp"
+#include "test_PositionSampleParser.hpp"
+#include "test_PositionSourceFactory.hpp"
+#include "test_Refraction.hpp"
+#include "test_ReorderBuffer.hpp"
+#include "test_Sgp4.hpp"
+#include "test_ShardedTracker.hpp"
+#include "test_SimulatedPositionSource.hpp"
+#include "test_TrackFusion.hpp"
+#include "test_VisibilityPredictor.hpp"
+
+// Run each of the test classes in turn.  The exit status is non-zero
+// if any of them failed.  No GUI; the application object provides
+// the event loop for the position sources.
+int main(int argc, char *argv[])
+{
+  QCoreApplication app(argc, argv);
+  int status = 0;
+
+  test_CoverageRaster coverageRaster;
+  status |= QTest::qExec(&coverageRaster, argc, argv);
+
+  test_EntityPool entityPool;
+  status |= QTest::qExec(&entityPool, argc, argv);
+
+  test_EntityRegistry entityRegistry;
+  status |= QTest::qExec(&entityRegistry, argc, argv);
+
+  test_FastMath fastMath;
+  status |= QTest::qExec(&fastMath, argc, argv);
+
+  test_Geodesic geodesic;
+  status |= QTest::qExec(&geodesic, argc, argv);
+
+  test_GimbalDriver gimbalDriver;
+  status |= QTest::qExec(&gimbalDriver, argc, argv);
+
+  test_LatencyTrace latencyTrace;
+  status |= QTest::qExec(&latencyTrace, argc, argv);
+
+  test_Listener listener;
+  status |= QTest::qExec(&listener, argc, argv);
+
+  test_LocalTangentPlane localTangentPlane;
+  status |= QTest::qExec(&localTangentPlane, argc, argv);
+
+  test_LookAngle lookAngle;
+  status |= QTest::qExec(&lookAngle, argc, argv);
+
+  test_LookAngleCache lookAngleCache;
+  status |= QTest::qExec(&lookAngleCache, argc, argv);
+
+  test_LookAngleKernel lookAngleKernel;
+  status |= QTest::qExec(&lookAngleKernel, argc, argv);
+
+  test_MavlinkPositionSource mavlinkPositionSource;
+  status |= QTest::qExec(&mavlinkPositionSource, argc, argv);
+
+  test_Metrics metrics;
+  status |= QTest::qExec(&metrics, argc, argv);
+
+  test_ObserverNetwork observerNetwork;
+  status |= QTest::qExec(&observerNetwork, argc, argv);
+
+  test_OutputSink outputSink;
+  status |= QTest::qExec(&outputSink, argc, argv);
+
+  test_PositionSampleParser positionSampleParser;
+  status |= QTest::qExec(&positionSampleParser, argc, argv);
+
+  test_PositionSourceFactory positionSourceFactory;
+  status |= QTest::qExec(&positionSourceFactory, argc, argv);
+
+  test_Refraction refraction;
+  status |= QTest::qExec(&refraction, argc, argv);
+
+  test_ReorderBuffer reorderBuffer;
+  status |= QTest::qExec(&reorderBuffer, argc, argv);
+
+  test_Sgp4 sgp4;
+  status |= QTest::qExec(&sgp4, argc, argv);
+
+  test_ShardedTracker shardedTracker;
+  status |= QTest::qExec(&shardedTracker, argc, argv);
+
+  test_SimulatedPositionSource simulatedPositionSource;
+  status |= QTest::qExec(&simulatedPositionSource, argc, argv);
+
+  test_TrackFusion trackFusion;
+  status |= QTest::qExec(&trackFusion, argc, argv);
+
+  test_VisibilityPredictor visibilityPredictor;
+  status |= QTest::qExec(&visibilityPredictor, argc, argv);
+
+  return status;
+}
@@ -0,0 +1,285 @@
+#include <QDataStream>
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QtMath>
+#include "CoverageRaster.hpp"
+#include "LookAngle.hpp"
+#include "test_CoverageRaster.hpp"
+
+// Sites around Monterey Bay, with their masks, with and without
+// refraction
+static
+QVector<QGeoCoordinate> Sites()
+{
+  return QVector<QGeoCoordinate>() << QGeoCoordinate(36.60, -121.90, 40.0)
+                                   << QGeoCoordinate(36.95, -122.05, 400.0)
+                                   << QGeoCoordinate(36.40, -121.60, 1200.0);
+}
+
+static
+QVector<double> Masks()
+{
+  return QVector<double>() << 0.0 << 2.0 << -0.5;
+}
+
+static
+QVector<Refraction> Refractions()
+{
+  return QVector<Refraction>() << Refraction() << Refraction(Refraction::Bennett)
+                               << Refraction(Refraction::FourThirdsEarth);
+}
+
+static
+void AddSites(CoverageRaster *raster)
+{
+  const QVector<QGeoCoordinate> sites = Sites();
+  const QVector<double> masks = Masks();
+  const QVector<Refraction> refractions = Refractions();
+  for (int site = 0; site < sites.size(); ++site)
+    raster->addSite(sites.at(site), masks.at(site), refractions.at(site));
+}
+
+void test_CoverageRaster::test_agreesWithLookAngle() {
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 60, 40);
+  raster.setAltitude(3000.0);
+  raster.setValue(CoverageRaster::SiteMask);
+  AddSites(&raster);
+  QVERIFY2(raster.siteCount() == 3, "sites");
+  raster.compute();
+  QVERIFY2(raster.values().size() == 60 * 40, "cells");
+
+  const QVector<QGeoCoordinate> sites = Sites();
+  const QVector<double> masks = Masks();
+  const QVector<Refraction> refractions = Refractions();
+  int seen = 0, unseen = 0;
+  for (int row = 0; row < raster.rows(); ++row) {
+    for (int column = 0; column < raster.columns(); ++column) {
+      const QGeoCoordinate cell = raster.cellCenter(column, row);
+      const quint32 mask = quint32(raster.value(column, row));
+      for (int site = 0; site < sites.size(); ++site) {
+        const LookAngle lookAngle(sites.at(site), cell, refractions.at(site));
+        // Not on the edge of the mask
+        if (qAbs(lookAngle.elevation() - masks.at(site)) < 1.0e-3)
+          continue;
+        const bool isSeen = lookAngle.elevation() >= masks.at(site);
+        QVERIFY2(bool(mask & (1u << site)) == isSeen, "visibility");
+        ++(isSeen ? seen : unseen);
+      }
+    }
+  }
+  QVERIFY2(seen > 0 && unseen > 0, "some cells seen, some not");
+}
+
+void test_CoverageRaster::test_values() {
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 30, 20);
+  raster.setAltitude(1000.0);
+  AddSites(&raster);
+
+  raster.setValue(CoverageRaster::SiteMask);
+  raster.compute();
+  const QVector<float> masks = raster.values();
+  raster.setValue(CoverageRaster::SiteCount);
+  raster.compute();
+  const QVector<float> counts = raster.values();
+  raster.setValue(CoverageRaster::MaximumElevation);
+  raster.compute();
+  const QVector<float> elevations = raster.values();
+
+  const QVector<QGeoCoordinate> sites = Sites();
+  const QVector<Refraction> refractions = Refractions();
+  for (int row = 0; row < raster.rows(); ++row) {
+    for (int column = 0; column < raster.columns(); ++column) {
+      const int i = row * raster.columns() + column;
+      const quint32 mask = quint32(masks.at(i));
+      int count = 0;
+      float elevation = -90.0f;
+      for (int site = 0; site < sites.size(); ++site) {
+        if (mask & (1u << site)) {
+          ++count;
+          const LookAngle lookAngle(sites.at(site), raster.cellCenter(column, row), refractions.at(site));
+          elevation = qMax(elevation, lookAngle.elevation());
+        }
+      }
+      QVERIFY2(counts.at(i) == float(count), "count of the mask");
+      QVERIFY2(qAbs(elevations.at(i) - elevation) <= 1.0e-3, "maximum elevation");
+    }
+  }
+}
+
+void test_CoverageRaster::test_maskSiteCount() {
+  // More sites than the mask holds, all at one place
+  CoverageRaster raster;
+  raster.setGrid(36.5, -122.0, 36.7, -121.8, 4, 4);
+  raster.setAltitude(3000.0);
+  for (int site = 0; site < 26; ++site)
+    raster.addSite(QGeoCoordinate(36.6, -121.9, 40.0));
+
+  raster.setValue(CoverageRaster::SiteMask);
+  QTest::ignoreMessage(QtWarningMsg, QRegularExpression("leaves out 2 sites"));
+  raster.compute();
+  for (float value : raster.values())
+    QVERIFY2(value == float((1u << 24) - 1), "first 24 sites");
+
+  raster.setValue(CoverageRaster::SiteCount);
+  raster.compute();
+  for (float value : raster.values())
+    QVERIFY2(value == 26.0f, "all the sites counted");
+}
+
+void test_CoverageRaster::test_tiles() {
+  // The tiles, whatever their size, cover the grid once
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 101, 67);
+  raster.setAltitude(2000.0);
+  AddSites(&raster);
+  raster.compute();
+  const QVector<float> whole = raster.values();
+  raster.setTileSize(7);
+  raster.compute();
+  QVERIFY2(raster.values() == whole, "small tiles");
+}
+
+void test_CoverageRaster::test_antimeridian() {
+  CoverageRaster raster;
+  raster.setGrid(-18.0, 179.0, -16.0, 181.0, 40, 40);
+  raster.setAltitude(10000.0);
+  raster.setValue(CoverageRaster::MaximumElevation);
+  const QGeoCoordinate site(-17.0, 179.9, 100.0);
+  raster.addSite(site, 1.0);
+  raster.compute();
+
+  for (int row = 0; row < raster.rows(); ++row) {
+    for (int column = 0; column < raster.columns(); ++column) {
+      const LookAngle lookAngle(site, raster.cellCenter(column, row));
+      const float expected = lookAngle.elevation() >= 1.0f ? lookAngle.elevation() : -90.0f;
+      if (qAbs(lookAngle.elevation() - 1.0f) < 1.0e-3)
+        continue;
+      QVERIFY2(qAbs(raster.value(column, row) - expected) <= 1.0e-3, "across the antimeridian");
+    }
+  }
+}
+
+void test_CoverageRaster::test_writeRaw() {
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 13, 11);
+  AddSites(&raster);
+  raster.compute();
+
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath("coverage.raw");
+  QVERIFY2(raster.write(fileName, CoverageRaster::RawFormat), "written");
+  QFile file(fileName);
+  QVERIFY2(file.open(QIODevice::ReadOnly), "open");
+  QVERIFY2(file.size() == 13 * 11 * 4, "size");
+  QDataStream stream(&file);
+  stream.setByteOrder(QDataStream::LittleEndian);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  for (float value : raster.values()) {
+    float read;
+    stream >> read;
+    QVERIFY2(read == value, "value");
+  }
+
+  QVERIFY2(!raster.write(dir.filePath("missing/coverage.raw"), CoverageRaster::RawFormat), "missing directory");
+  QVERIFY2(!raster.errorString().isEmpty(), "error string");
+}
+
+void test_CoverageRaster::test_writeGeoTiff() {
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 13, 11);
+  AddSites(&raster);
+  raster.compute();
+
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath("coverage.tif");
+  QVERIFY2(raster.write(fileName, CoverageRaster::GeoTiffFormat), "written");
+  QFile file(fileName);
+  QVERIFY2(file.open(QIODevice::ReadOnly), "open");
+  QDataStream stream(&file);
+  stream.setByteOrder(QDataStream::LittleEndian);
+
+  quint16 byteOrder, magic;
+  quint32 directory;
+  stream >> byteOrder >> magic >> directory;
+  QVERIFY2(byteOrder == 0x4949 && magic == 42, "header");
+
+  // The entries needed to read the image back and place it
+  file.seek(directory);
+  quint16 count;
+  stream >> count;
+  quint32 width = 0, length = 0, offset = 0, pixelScale = 0, tiepoint = 0;
+  quint16 sampleFormat = 0, previous = 0;
+  for (int i = 0; i < count; ++i) {
+    quint16 tag, type;
+    quint32 valueCount, value;
+    stream >> tag >> type >> valueCount >> value;
+    QVERIFY2(tag > previous, "entries in order");
+    previous = tag;
+    switch (tag) {
+    case 256: width = value; break;
+    case 257: length = value; break;
+    case 273: offset = value; break;
+    case 339: sampleFormat = quint16(value); break;
+    case 33550: pixelScale = value; break;
+    case 33922: tiepoint = value; break;
+    }
+  }
+  QVERIFY2(width == 13 && length == 11 && sampleFormat == 3, "image");
+
+  stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+  double scale[3], tie[6];
+  file.seek(pixelScale);
+  stream >> scale[0] >> scale[1] >> scale[2];
+  QVERIFY2(qAbs(scale[0] - 3.0 / 13) < 1.0e-12 && qAbs(scale[1] - 2.0 / 11) < 1.0e-12, "pixel scale");
+  file.seek(tiepoint);
+  for (double &value : tie)
+    stream >> value;
+  QVERIFY2(tie[3] == -123.5 && tie[4] == 37.5, "tie point");
+
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  file.seek(offset);
+  for (float value : raster.values()) {
+    float read;
+    stream >> read;
+    QVERIFY2(read == value, "value");
+  }
+}
+
+void test_CoverageRaster::test_benchmarkCoverage() {
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 300, 200);
+  raster.setAltitude(3000.0);
+  AddSites(&raster);
+
+  QBENCHMARK {
+    raster.compute();
+  }
+}
+
+void test_CoverageRaster::test_benchmarkLookAngle() {
+  // The same, a LookAngle per site and cell
+  CoverageRaster raster;
+  raster.setGrid(35.5, -123.5, 37.5, -120.5, 300, 200);
+  raster.setAltitude(3000.0);
+  QVector<float> values(300 * 200);
+  const QVector<QGeoCoordinate> sites = Sites();
+  const QVector<double> masks = Masks();
+  const QVector<Refraction> refractions = Refractions();
+
+  QBENCHMARK {
+    for (int row = 0; row < 200; ++row) {
+      for (int column = 0; column < 300; ++column) {
+        int count = 0;
+        for (int site = 0; site < sites.size(); ++site) {
+          const LookAngle lookAngle(sites.at(site), raster.cellCenter(column, row), refractions.at(site));
+          if (lookAngle.elevation() >= masks.at(site))
+            ++count;
+        }
+        values[row * 300 + column] = float(count);
+      }
+    }
+  }
+}
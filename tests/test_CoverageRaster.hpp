@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QTest>
+
+class test_CoverageRaster : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_agreesWithLookAngle();
+  void test_values();
+  void test_maskSiteCount();
+  void test_tiles();
+  void test_antimeridian();
+  void test_writeRaw();
+  void test_writeGeoTiff();
+  void test_benchmarkCoverage();
+  void test_benchmarkLookAngle();
+};
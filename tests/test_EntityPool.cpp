@@ -0,0 +1,113 @@
+#include "EntityPool.hpp"
+#include "GeoEntityDispatcher.hpp"
+#include "test_EntityPool.hpp"
+
+static PositionSample Sample(quint64 id, qint64 timestamp)
+{
+  PositionSample sample = PositionSample::invalid(id);
+  sample.timestamp = timestamp;
+  sample.latitude = 40.0;
+  sample.longitude = -75.0;
+  sample.altitude = 1000.0;
+  return sample;
+}
+
+void test_EntityPool::test_handles() {
+  EntityPool pool(4);
+  EntityHandle a = pool.acquire(100);
+  EntityHandle b = pool.acquire(200);
+  QVERIFY2(!a.isNull() && a != b, "handles");
+  QVERIFY2(pool.acquire(100) == a && pool.find(200) == b, "by id");
+  QVERIFY2(pool.find(300).isNull(), "unknown id");
+  QVERIFY2(pool.record(a)->id == 100 && !pool.record(a)->position.isValid(), "new record");
+  QVERIFY2(pool.count() == 2 && pool.capacity() == 4, "counts");
+
+  // A released slot is reused, but its old handles are not.
+  pool.release(a);
+  QVERIFY2(!pool.contains(a) && pool.record(a) == nullptr, "released");
+  QVERIFY2(pool.find(100).isNull(), "id forgotten");
+  EntityHandle c = pool.acquire(300);
+  QVERIFY2(c.index == a.index && c != a, "slot reused");
+  QVERIFY2(pool.record(a) == nullptr && pool.record(c)->id == 300, "stale handle");
+  pool.release(a);
+  QVERIFY2(pool.contains(c) && pool.count() == 2, "stale release ignored");
+  QVERIFY2(pool.record(EntityHandle()) == nullptr && pool.record(EntityHandle(1000, 1)) == nullptr, "invalid handles");
+}
+
+void test_EntityPool::test_slabs() {
+  // Records do not move as the pool grows.
+  EntityPool pool(16);
+  EntityHandle first = pool.update(Sample(1, 1000));
+  EntityRecord *record = pool.record(first);
+  for (quint64 id = 2; id <= 1000; ++id)
+    pool.update(Sample(id, 1000));
+  QVERIFY2(pool.count() == 1000 && pool.capacity() == 1008, "grown by slabs");
+  QVERIFY2(pool.record(first) == record && record->position.timestamp == 1000, "stable");
+
+  int visited = 0;
+  quint64 sum = 0;
+  pool.forEach([&](EntityHandle handle, EntityRecord const &record) {
+      ++visited;
+      sum += record.id;
+      Q_UNUSED(handle);
+    });
+  QVERIFY2(visited == 1000 && sum == 500500, "every record");
+}
+
+void test_EntityPool::test_expire() {
+  // Aircraft leaving coverage, and others taking their slots
+  EntityPool pool(64);
+  for (quint64 id = 0; id < 100; ++id)
+    pool.update(Sample(id, id < 50 ? 1000 : 2000));
+  pool.acquire(1000);
+  QVERIFY2(pool.expire(1500) == 51, "old and empty records");
+  QVERIFY2(pool.count() == 50 && pool.find(10).isNull() && !pool.find(60).isNull(), "kept");
+  for (quint64 id = 100; id < 151; ++id)
+    pool.update(Sample(id, 3000));
+  QVERIFY2(pool.capacity() == 128 && pool.count() == 101, "slots reused");
+}
+
+void test_EntityPool::test_dispatcher() {
+  // Every id to the pool, one of them also to a GeoEntity
+  EntityPool pool;
+  GeoEntityDispatcher dispatcher;
+  dispatcher.setPool(&pool);
+  GeoEntity entity;
+  dispatcher.setEntity(2, &entity);
+  PositionSample samples[] = { Sample(1, 1000), Sample(2, 1000), Sample(3, 1000), Sample(2, 1100), Sample(1, 900) };
+  dispatcher.consume(samples, 5);
+
+  QVERIFY2(pool.count() == 3 && dispatcher.count() == 1, "records and wrappers");
+  QVERIFY2(pool.record(pool.find(1))->position.timestamp == 1000, "latest");
+  QVERIFY2(pool.record(pool.find(2))->position.timestamp == 1100, "latest");
+  QVERIFY2(entity.position().timestamp().toMSecsSinceEpoch() == 1100, "wrapper");
+  QVERIFY2(dispatcher.updates() == 3, "one update per id");
+}
+
+void test_EntityPool::benchmark_churn() {
+  // A thousand entities in, a thousand out
+  EntityPool pool;
+  quint64 id = 0;
+  QBENCHMARK {
+    EntityHandle handles[1000];
+    for (EntityHandle &handle : handles)
+      handle = pool.update(Sample(++id, 1000));
+    for (EntityHandle const &handle : handles)
+      pool.release(handle);
+  }
+  QVERIFY2(pool.count() == 0 && pool.capacity() == 1024, "no growth");
+}
+
+void test_EntityPool::benchmark_churnGeoEntity() {
+  // The same with a QObject per entity
+  PositionSample sample = Sample(1, 1000);
+  QBENCHMARK {
+    GeoEntity *entities[1000];
+    for (GeoEntity *&entity : entities) {
+      entity = new GeoEntity;
+      entity->setPosition(sample.toPositionInfo());
+    }
+    for (GeoEntity *entity : entities)
+      delete entity;
+  }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_EntityPool : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_handles();
+  void test_slabs();
+  void test_expire();
+  void test_dispatcher();
+  void benchmark_churn();
+  void benchmark_churnGeoEntity();
+};
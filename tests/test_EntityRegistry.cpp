@@ -0,0 +1,162 @@
+#include "EntityRegistry.hpp"
+#include "GeoEntityDispatcher.hpp"
+#include "test_EntityRegistry.hpp"
+
+// Keeps the batches of appearances and losses
+class Lifecycle
+{
+public:
+  Lifecycle(EntityRegistry *registry)
+  {
+    QObject::connect(registry, &EntityRegistry::appeared, [this](QVector<QUuid> const &uuids) {
+        appeared.append(uuids);
+      });
+    QObject::connect(registry, &EntityRegistry::lost, [this](QVector<QUuid> const &uuids) {
+        lost.append(uuids);
+      });
+  }
+
+  QVector<QVector<QUuid> > appeared;
+  QVector<QVector<QUuid> > lost;
+};
+
+static PositionSample Sample(quint64 id)
+{
+  PositionSample sample = PositionSample::invalid(id);
+  sample.timestamp = 1000;
+  sample.latitude = 40.0;
+  sample.longitude = -75.0;
+  return sample;
+}
+
+void test_EntityRegistry::test_table() {
+  // Random QUuids, and QUuids of consecutive sample ids
+  EntityRegistry registry;
+  QVector<QUuid> uuids;
+  for (int i = 0; i < 5000; ++i) {
+    uuids.append(QUuid::createUuid());
+    uuids.append(EntityRegistry::uuidOf(quint64(i)));
+  }
+  for (QUuid const &uuid : uuids)
+    registry.touch(uuid, 0);
+  QVERIFY2(registry.count() == 10000 && registry.capacity() == 10000, "all in");
+  QVERIFY2(EntityRegistry::uuidOf(1) != EntityRegistry::uuidOf(2)
+           && EntityRegistry::uuidOf(1) == EntityRegistry::uuidOf(1), "sample ids");
+
+  bool found = true;
+  for (QUuid const &uuid : uuids)
+    found = found && registry.contains(uuid);
+  QVERIFY2(found, "all found");
+
+  // Remove every third one: the others must still be found.
+  for (int i = 0; i < uuids.size(); i += 3)
+    QVERIFY(registry.remove(uuids.at(i)));
+  QVERIFY2(!registry.remove(uuids.at(0)), "removed");
+  bool consistent = true;
+  for (int i = 0; i < uuids.size(); ++i)
+    consistent = consistent && registry.contains(uuids.at(i)) == (i % 3 != 0);
+  QVERIFY2(consistent, "found after removals");
+
+  // The slots are reused.
+  const int removed = 10000 - registry.count();
+  for (int i = 0; i < removed; ++i)
+    registry.touch(QUuid::createUuid(), 0);
+  QVERIFY2(registry.count() == 10000 && registry.capacity() == 10000, "slots reused");
+}
+
+void test_EntityRegistry::test_expiry() {
+  EntityRegistry registry(1000);
+  Lifecycle lifecycle(&registry);
+  const int resolution = registry.resolution();
+  QVERIFY2(resolution == 8, "a 128th of the timeout");
+
+  const QUuid a = QUuid::createUuid();
+  const QUuid b = QUuid::createUuid();
+  registry.touch(a, 0);
+  registry.touch(b, 0);
+  registry.expire(500);
+  QVERIFY2(lifecycle.appeared.size() == 1 && lifecycle.appeared.at(0).size() == 2, "one batch");
+
+  // b is lost no earlier than its timeout, and no later than a tick
+  // after; a was seen since.
+  registry.touch(a, 800);
+  QVERIFY2(registry.lastSeen(a) == 800, "last seen");
+  registry.expire(999);
+  QVERIFY2(lifecycle.lost.isEmpty(), "not yet");
+  registry.expire(1000 + resolution);
+  QVERIFY2(lifecycle.lost.size() == 1 && lifecycle.lost.at(0) == QVector<QUuid>({ b }), "b lost");
+  QVERIFY2(registry.contains(a) && !registry.contains(b) && registry.lastSeen(b) == -1, "a alive");
+
+  registry.expire(1799);
+  QVERIFY2(lifecycle.lost.size() == 1, "a not yet");
+  registry.expire(1800 + resolution);
+  QVERIFY2(lifecycle.lost.size() == 2 && lifecycle.lost.at(1) == QVector<QUuid>({ a }), "a lost");
+  QVERIFY2(registry.count() == 0, "empty");
+  QVERIFY2(lifecycle.appeared.size() == 1, "no more appearances");
+}
+
+void test_EntityRegistry::test_batches() {
+  // Entities seen at different times, then a long silence: one
+  // batch, even though the wheel turned many times over.
+  EntityRegistry registry(100);
+  Lifecycle lifecycle(&registry);
+  for (int i = 0; i < 1000; ++i)
+    registry.touch(QUuid::createUuid(), i);
+  registry.expire(1000);
+  QVERIFY2(lifecycle.appeared.size() == 1 && lifecycle.appeared.at(0).size() == 1000, "appeared");
+  QVERIFY2(lifecycle.lost.size() == 1 && registry.count() == 99, "older ones lost");
+  registry.expire(1000000);
+  QVERIFY2(lifecycle.lost.size() == 2 && lifecycle.lost.at(1).size() == 99 && registry.count() == 0, "all lost");
+
+  // A shorter timeout applies to the entities already there.
+  registry.touch(QUuid::createUuid(), 2000000);
+  registry.setTimeout(10);
+  registry.expire(2000000 + 10 + registry.resolution());
+  QVERIFY2(registry.count() == 0, "new timeout");
+}
+
+void test_EntityRegistry::test_pool() {
+  // The records of the lost entities are released from the pool.
+  EntityPool pool;
+  GeoEntityDispatcher dispatcher;
+  dispatcher.setPool(&pool);
+  EntityRegistry registry(1000);
+  registry.setSampleSink(&dispatcher);
+  registry.setPool(&pool);
+  Lifecycle lifecycle(&registry);
+
+  PositionSample samples[] = { Sample(1), Sample(2), Sample(1) };
+  registry.consume(samples, 3);
+  QVERIFY2(registry.count() == 2 && pool.count() == 2, "passed on");
+  QVERIFY2(registry.contains(EntityRegistry::uuidOf(2)), "by sample id");
+
+  registry.expire(registry.elapsed() + 1000 + registry.resolution());
+  QVERIFY2(lifecycle.lost.size() == 1 && lifecycle.lost.at(0).size() == 2, "lost");
+  QVERIFY2(pool.count() == 0 && registry.count() == 0, "released");
+
+  registry.consume(samples, 3);
+  QVERIFY2(pool.count() == 2 && pool.capacity() == 1024 && registry.capacity() == 2, "recycled");
+}
+
+void test_EntityRegistry::test_timer() {
+  EntityRegistry registry(50);
+  Lifecycle lifecycle(&registry);
+  PositionSample sample = Sample(7);
+  registry.consume(&sample, 1);
+  QTRY_VERIFY2_WITH_TIMEOUT(lifecycle.lost.size() == 1, "lost by the clock", 1000);
+  QVERIFY2(lifecycle.appeared.size() == 1, "appeared");
+  QVERIFY2(lifecycle.lost.at(0) == QVector<QUuid>({ EntityRegistry::uuidOf(7) }), "the entity");
+}
+
+void test_EntityRegistry::benchmark_touch() {
+  // 100000 entities reporting, and a tick of the expiry
+  EntityRegistry registry(10000);
+  qint64 time = 0;
+  QBENCHMARK {
+    for (quint64 id = 0; id < 100000; ++id)
+      registry.touch(id, time);
+    registry.expire(time);
+    time += 100;
+  }
+  QVERIFY2(registry.count() == 100000, "all alive");
+}
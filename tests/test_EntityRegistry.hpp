@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_EntityRegistry : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_table();
+  void test_expiry();
+  void test_batches();
+  void test_pool();
+  void test_timer();
+  void benchmark_touch();
+};
@@ -0,0 +1,201 @@
+#include <cmath>
+#include <QVector>
+#include <QtMath>
+#include "FastMath.hpp"
+#include "LookAngle.hpp"
+#include "test_FastMath.hpp"
+
+// The arguments of the batches
+static const int ArgumentCount = 4096;
+
+// A pseudo random number in [0, 1), the same on every run
+static
+double Random(quint64 *state)
+{
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return double(*state >> 11) / 9007199254740992.0;
+}
+
+void test_FastMath::test_sinCos() {
+  for (FastMath::Accuracy accuracy : { FastMath::Precise, FastMath::Approximate }) {
+    const double bound = FastMath::maximumError(accuracy);
+    quint64 state = 1;
+    for (int i = 0; i < 100000; ++i) {
+      // Mostly angles, some up to the limit of the reduction
+      const double x = (2.0 * Random(&state) - 1.0) * (i % 10 ? 10.0 : 1.0e6);
+      double s, c;
+      FastMath::sinCos(x, &s, &c, accuracy);
+      QVERIFY2(std::fabs(s - std::sin((long double)x)) <= bound, "sine");
+      QVERIFY2(std::fabs(c - std::cos((long double)x)) <= bound, "cosine");
+    }
+  }
+}
+
+void test_FastMath::test_atan2() {
+  for (FastMath::Accuracy accuracy : { FastMath::Precise, FastMath::Approximate }) {
+    const double bound = FastMath::maximumError(accuracy);
+    quint64 state = 2;
+    for (int i = 0; i < 100000; ++i) {
+      // Over every quadrant and many magnitudes
+      const double scale = std::pow(10.0, 12.0 * Random(&state) - 6.0);
+      const double y = (2.0 * Random(&state) - 1.0) * scale;
+      const double x = (2.0 * Random(&state) - 1.0);
+      QVERIFY2(std::fabs(FastMath::atan2(y, x, accuracy) - std::atan2((long double)y, (long double)x)) <= bound, "atan2");
+      QVERIFY2(std::fabs(FastMath::atan2(x, y, accuracy) - std::atan2((long double)x, (long double)y)) <= bound, "atan2 swapped");
+    }
+  }
+}
+
+void test_FastMath::test_acos() {
+  for (FastMath::Accuracy accuracy : { FastMath::Precise, FastMath::Approximate }) {
+    const double bound = FastMath::maximumError(accuracy);
+    quint64 state = 3;
+    for (int i = 0; i < 100000; ++i) {
+      const double x = 2.0 * Random(&state) - 1.0;
+      QVERIFY2(std::fabs(FastMath::acos(x, accuracy) - std::acos((long double)x)) <= bound, "acos");
+    }
+  }
+}
+
+void test_FastMath::test_edges() {
+  for (FastMath::Accuracy accuracy : { FastMath::Exact, FastMath::Precise, FastMath::Approximate }) {
+    double s, c;
+    FastMath::sinCos(0.0, &s, &c, accuracy);
+    QVERIFY2(s == 0.0 && c == 1.0, "sinCos zero");
+    FastMath::sinCos(M_PI_2, &s, &c, accuracy);
+    QVERIFY2(std::fabs(s - 1.0) <= 1.0e-15 && std::fabs(c) <= 1.0e-15, "sinCos pi/2");
+
+    // Beyond the reduction, the C library
+    FastMath::sinCos(1.0e9, &s, &c, accuracy);
+    QVERIFY2(s == std::sin(1.0e9) && c == std::cos(1.0e9), "sinCos large");
+
+    QVERIFY2(FastMath::atan2(0.0, 0.0, accuracy) == 0.0, "atan2 origin");
+    QVERIFY2(FastMath::atan2(0.0, 1.0, accuracy) == 0.0, "atan2 positive x axis");
+    QVERIFY2(std::fabs(FastMath::atan2(0.0, -1.0, accuracy) - M_PI) <= 1.0e-15, "atan2 negative x axis");
+    QVERIFY2(std::fabs(FastMath::atan2(1.0, 0.0, accuracy) - M_PI_2) <= 1.0e-15, "atan2 positive y axis");
+    QVERIFY2(std::fabs(FastMath::atan2(-1.0, 0.0, accuracy) + M_PI_2) <= 1.0e-15, "atan2 negative y axis");
+    QVERIFY2(std::fabs(FastMath::atan2(1.0, 1.0, accuracy) - M_PI_4) <= 1.0e-15, "atan2 diagonal");
+
+    QVERIFY2(FastMath::acos(1.0, accuracy) == 0.0, "acos 1");
+    QVERIFY2(std::fabs(FastMath::acos(-1.0, accuracy) - M_PI) <= 1.0e-15, "acos -1");
+    QVERIFY2(std::fabs(FastMath::acos(0.0, accuracy) - M_PI_2) <= 1.0e-15, "acos 0");
+  }
+}
+
+void test_FastMath::test_batch() {
+  // The batches give the results of the scalar functions, SIMD pairs,
+  // odd elements and large arguments alike.
+  const int count = 1001;
+  QVector<double> x(count), y(count), sine(count), cosine(count), angle(count);
+  QVector<float> yf(count), xf(count), anglef(count);
+  quint64 state = 4;
+  for (int i = 0; i < count; ++i) {
+    x[i] = (2.0 * Random(&state) - 1.0) * (i == 501 ? 1.0e9 : 100.0);
+    y[i] = 2.0 * Random(&state) - 1.0;
+    yf[i] = float(y.at(i));
+    xf[i] = float(x.at(i) / 100.0);
+  }
+
+  for (FastMath::Accuracy accuracy : { FastMath::Exact, FastMath::Precise, FastMath::Approximate }) {
+    FastMath::sinCos(count, x.constData(), sine.data(), cosine.data(), accuracy);
+    for (int i = 0; i < count; ++i) {
+      double s, c;
+      FastMath::sinCos(x.at(i), &s, &c, accuracy);
+      QVERIFY2(sine.at(i) == s && cosine.at(i) == c, "sinCos batch");
+    }
+
+    FastMath::atan2(count, y.constData(), x.constData(), angle.data(), accuracy);
+    for (int i = 0; i < count; ++i)
+      QVERIFY2(angle.at(i) == FastMath::atan2(y.at(i), x.at(i), accuracy), "atan2 batch");
+
+    FastMath::atan2(count, yf.constData(), xf.constData(), anglef.data(), accuracy);
+    for (int i = 0; i < count; ++i)
+      QVERIFY2(anglef.at(i) == float(FastMath::atan2(double(yf.at(i)), double(xf.at(i)), accuracy)), "float atan2 batch");
+
+    FastMath::acos(count, y.constData(), angle.data(), accuracy);
+    for (int i = 0; i < count; ++i)
+      QVERIFY2(angle.at(i) == FastMath::acos(y.at(i), accuracy), "acos batch");
+
+    // In place
+    QVector<double> inPlace = x;
+    FastMath::sinCos(count, inPlace.constData(), inPlace.data(), cosine.data(), accuracy);
+    QVERIFY2(inPlace == sine, "sinCos in place");
+  }
+}
+
+void test_FastMath::test_lookAngles() {
+  // The look angles of a frame to many targets agree with LookAngle.
+  const QGeoCoordinate observer(35.0, -120.0, 100.0);
+  const LookAngleFrame frame = LookAngleFrame::at(observer);
+  const int count = 1000;
+  QVector<double> latitude(count), longitude(count), altitude(count), range(count);
+  QVector<float> azimuth(count), elevation(count);
+  quint64 state = 5;
+  for (int i = 0; i < count; ++i) {
+    latitude[i] = observer.latitude() + 20.0 * Random(&state) - 10.0;
+    longitude[i] = observer.longitude() + 20.0 * Random(&state) - 10.0;
+    altitude[i] = 40000.0 * Random(&state);
+  }
+
+  for (FastMath::Accuracy accuracy : { FastMath::Exact, FastMath::Precise, FastMath::Approximate }) {
+    // The error of the trigonometry, at the radius of the Earth
+    const double rangeBound = 1.0e-3 + FastMath::maximumError(accuracy) * 1.0e7;
+    frame.lookAngles(count, latitude.constData(), longitude.constData(), altitude.constData(),
+                     azimuth.data(), elevation.data(), range.data(), accuracy);
+    for (int i = 0; i < count; ++i) {
+      const QGeoCoordinate target(latitude.at(i), longitude.at(i), altitude.at(i));
+      const LookAngle lookAngle(observer, target);
+      QVERIFY2(std::fabs(azimuth.at(i) - lookAngle.azimuth()) <= 1.0e-4, "azimuth");
+      QVERIFY2(std::fabs(elevation.at(i) - lookAngle.elevation()) <= 1.0e-4, "elevation");
+      QVERIFY2(std::fabs(range.at(i) - frame.point.distanceTo(LookAngle::point(target))) <= rangeBound, "range");
+    }
+  }
+}
+
+void test_FastMath::test_benchmarkSinCos() {
+  QVector<double> x(ArgumentCount), sine(ArgumentCount), cosine(ArgumentCount);
+  for (int i = 0; i < ArgumentCount; ++i)
+    x[i] = (i - ArgumentCount / 2) * 0.001;
+
+  QBENCHMARK {
+    FastMath::sinCos(ArgumentCount, x.constData(), sine.data(), cosine.data(), FastMath::Precise);
+  }
+}
+
+void test_FastMath::test_benchmarkStdSinCos() {
+  QVector<double> x(ArgumentCount), sine(ArgumentCount), cosine(ArgumentCount);
+  for (int i = 0; i < ArgumentCount; ++i)
+    x[i] = (i - ArgumentCount / 2) * 0.001;
+
+  QBENCHMARK {
+    for (int i = 0; i < ArgumentCount; ++i) {
+      sine[i] = std::sin(x.at(i));
+      cosine[i] = std::cos(x.at(i));
+    }
+  }
+}
+
+void test_FastMath::test_benchmarkAtan2() {
+  QVector<double> y(ArgumentCount), x(ArgumentCount), angle(ArgumentCount);
+  for (int i = 0; i < ArgumentCount; ++i) {
+    y[i] = std::sin(i * 0.01);
+    x[i] = std::cos(i * 0.013);
+  }
+
+  QBENCHMARK {
+    FastMath::atan2(ArgumentCount, y.constData(), x.constData(), angle.data(), FastMath::Precise);
+  }
+}
+
+void test_FastMath::test_benchmarkStdAtan2() {
+  QVector<double> y(ArgumentCount), x(ArgumentCount), angle(ArgumentCount);
+  for (int i = 0; i < ArgumentCount; ++i) {
+    y[i] = std::sin(i * 0.01);
+    x[i] = std::cos(i * 0.013);
+  }
+
+  QBENCHMARK {
+    for (int i = 0; i < ArgumentCount; ++i)
+      angle[i] = std::atan2(y.at(i), x.at(i));
+  }
+}
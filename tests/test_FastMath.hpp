@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QTest>
+
+class test_FastMath : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_sinCos();
+  void test_atan2();
+  void test_acos();
+  void test_edges();
+  void test_batch();
+  void test_lookAngles();
+  void test_benchmarkSinCos();
+  void test_benchmarkStdSinCos();
+  void test_benchmarkAtan2();
+  void test_benchmarkStdAtan2();
+};
@@ -0,0 +1,153 @@
+#include <cmath>
+#include <QtMath>
+#include <QGeoCoordinate>
+#include <QRandomGenerator>
+#include "Geodesic.hpp"
+#include "test_Geodesic.hpp"
+
+static const int PairCount = 100000;
+
+// Reference solutions from GeographicLib: latitude and longitude of
+// both points, distance and azimuths.
+static const double Reference[][7] = {
+  {  40.6,     -73.8,   51.6,     -0.5,     5551759.400319,  51.198882846, 107.821776736 },
+  { -30.12345,   0.0,  -30.12344,  0.00005,       4.944208,  77.043533541,  77.043508448 },
+  {   0.0,       0.0,    0.5,    179.5,    19936288.578965,  25.671872868, 154.327085470 },
+  {  89.9,       0.0,  -89.9,    180.0,    20003931.458625,   0.0,        180.0         },
+  {   0.0,       0.0,    0.0,     90.0,    10018754.171395,  90.0,         90.0         },
+  { -41.32,    174.81,  40.96,    -5.50,   19959679.267354, 161.067669986,  18.825195123 },
+};
+
+static double AngleDifference(double a, double b)
+{
+  return qAbs(std::remainder(a - b, 360.0));
+}
+
+void test_Geodesic::initTestCase() {
+  QRandomGenerator random(29);
+  m_lat1.resize(PairCount);
+  m_lon1.resize(PairCount);
+  m_lat2.resize(PairCount);
+  m_lon2.resize(PairCount);
+  for (int i = 0; i < PairCount; ++i) {
+    m_lat1[i] = random.bounded(180.0) - 90.0;
+    m_lon1[i] = random.bounded(360.0) - 180.0;
+    m_lat2[i] = random.bounded(180.0) - 90.0;
+    m_lon2[i] = random.bounded(360.0) - 180.0;
+  }
+}
+
+void test_Geodesic::test_inverse() {
+  Geodesic const &geodesic = Geodesic::wgs84();
+  for (auto const &r : Reference) {
+    double azimuth1, azimuth2;
+    const double distance = geodesic.inverse(r[0], r[1], r[2], r[3], &azimuth1, &azimuth2);
+    QVERIFY2(qAbs(distance - r[4]) <= 1.0e-6, "distance");
+    QVERIFY2(AngleDifference(azimuth1, r[5]) <= 1.0e-8, "initial azimuth");
+    QVERIFY2(AngleDifference(azimuth2, r[6]) <= 1.0e-8, "final azimuth");
+  }
+
+  // Coincident points and the distances between the poles
+  QVERIFY2(geodesic.inverse(12.0, 34.0, 12.0, 34.0) == 0.0, "coincident");
+  QVERIFY2(qAbs(geodesic.inverse(90.0, 0.0, -90.0, 0.0) - 20003931.458625) <= 1.0e-6, "pole to pole");
+
+  // QGeoCoordinate arguments, with the altitudes ignored
+  QGeoCoordinate from(40.6, -73.8, 1000.0);
+  QGeoCoordinate to(51.6, -0.5, 25.0);
+  QVERIFY2(qAbs(geodesic.inverse(from, to) - Reference[0][4]) <= 1.0e-6, "coordinates");
+}
+
+void test_Geodesic::test_symmetry() {
+  // Reversing the path swaps the azimuths and turns them around.
+  Geodesic const &geodesic = Geodesic::wgs84();
+  for (int i = 0; i < 1000; ++i) {
+    double forward1, forward2, reverse1, reverse2;
+    const double forward = geodesic.inverse(m_lat1[i], m_lon1[i], m_lat2[i], m_lon2[i], &forward1, &forward2);
+    const double reverse = geodesic.inverse(m_lat2[i], m_lon2[i], m_lat1[i], m_lon1[i], &reverse1, &reverse2);
+    QVERIFY2(qAbs(forward - reverse) <= 1.0e-6, "distance");
+    if (forward < 1.9e7) {
+      // Away from the antipodes, where the shortest path is unique
+      QVERIFY2(AngleDifference(forward1, reverse2 + 180.0) <= 1.0e-8, "initial azimuth");
+      QVERIFY2(AngleDifference(forward2, reverse1 + 180.0) <= 1.0e-8, "final azimuth");
+    }
+  }
+}
+
+void test_Geodesic::test_greatEllipse() {
+  Geodesic const &geodesic = Geodesic::wgs84();
+
+  // The equator and the meridians are both great ellipses and
+  // geodesics.
+  double azimuth1, azimuth2;
+  double distance = geodesic.greatEllipse(0.0, 0.0, 0.0, 90.0, &azimuth1, &azimuth2);
+  QVERIFY2(qAbs(distance - 10018754.171395) <= 1.0e-6, "equator");
+  QVERIFY2(qAbs(azimuth1 - 90.0) <= 1.0e-8 && qAbs(azimuth2 - 90.0) <= 1.0e-8, "equator azimuths");
+  distance = geodesic.greatEllipse(-30.0, 10.0, 60.0, 10.0, &azimuth1, &azimuth2);
+  QVERIFY2(qAbs(distance - geodesic.inverse(-30.0, 10.0, 60.0, 10.0)) <= 1.0e-6, "meridian");
+  QVERIFY2(AngleDifference(azimuth1, 0.0) <= 1.0e-8 && AngleDifference(azimuth2, 0.0) <= 1.0e-8, "meridian azimuths");
+  QVERIFY2(geodesic.greatEllipse(12.0, 34.0, 12.0, 34.0) == 0.0, "coincident");
+
+  // The great ellipse is never shorter than the geodesic, and is
+  // close to it when the points are not too far apart.
+  for (int i = 0; i < 10000; ++i) {
+    const double s = geodesic.inverse(m_lat1[i], m_lon1[i], m_lat2[i], m_lon2[i], &azimuth1, &azimuth2);
+    double ellipse1, ellipse2;
+    const double e = geodesic.greatEllipse(m_lat1[i], m_lon1[i], m_lat2[i], m_lon2[i], &ellipse1, &ellipse2);
+    QVERIFY2(e >= s - 1.0e-6, "longer than the geodesic");
+    if (s < 1.0e7) {
+      QVERIFY2(e - s <= 15.0, "close to the geodesic");
+      QVERIFY2(AngleDifference(azimuth1, ellipse1) <= 0.25, "initial azimuth");
+      QVERIFY2(AngleDifference(azimuth2, ellipse2) <= 0.25, "final azimuth");
+    }
+  }
+}
+
+void test_Geodesic::test_batch() {
+  Geodesic const &geodesic = Geodesic::wgs84();
+  QVector<double> distance(PairCount), azimuth1(PairCount), azimuth2(PairCount);
+  geodesic.inverse(PairCount, m_lat1.constData(), m_lon1.constData(), m_lat2.constData(), m_lon2.constData(),
+                   distance.data(), azimuth1.data(), azimuth2.data());
+  for (int i = 0; i < PairCount; i += 97) {
+    double a1, a2;
+    QVERIFY2(distance[i] == geodesic.inverse(m_lat1[i], m_lon1[i], m_lat2[i], m_lon2[i], &a1, &a2), "geodesic distance");
+    QVERIFY2(azimuth1[i] == a1 && azimuth2[i] == a2, "geodesic azimuths");
+  }
+
+  // Only the distances are wanted
+  geodesic.greatEllipse(PairCount, m_lat1.constData(), m_lon1.constData(), m_lat2.constData(), m_lon2.constData(),
+                        distance.data(), nullptr, nullptr);
+  for (int i = 0; i < PairCount; i += 97)
+    QVERIFY2(distance[i] == geodesic.greatEllipse(m_lat1[i], m_lon1[i], m_lat2[i], m_lon2[i]), "great ellipse distance");
+}
+
+void test_Geodesic::benchmark_inverse() {
+  Geodesic const &geodesic = Geodesic::wgs84();
+  QVector<double> distance(PairCount), azimuth1(PairCount), azimuth2(PairCount);
+  QBENCHMARK {
+    geodesic.inverse(PairCount, m_lat1.constData(), m_lon1.constData(), m_lat2.constData(), m_lon2.constData(),
+                     distance.data(), azimuth1.data(), azimuth2.data());
+  }
+}
+
+void test_Geodesic::benchmark_greatEllipse() {
+  Geodesic const &geodesic = Geodesic::wgs84();
+  QVector<double> distance(PairCount), azimuth1(PairCount), azimuth2(PairCount);
+  QBENCHMARK {
+    geodesic.greatEllipse(PairCount, m_lat1.constData(), m_lon1.constData(), m_lat2.constData(), m_lon2.constData(),
+                          distance.data(), azimuth1.data(), azimuth2.data());
+  }
+}
+
+void test_Geodesic::benchmark_qGeoCoordinate() {
+  // The spherical approximation, one pair at a time
+  QVector<double> distance(PairCount), azimuth1(PairCount), azimuth2(PairCount);
+  QBENCHMARK {
+    for (int i = 0; i < PairCount; ++i) {
+      QGeoCoordinate from(m_lat1[i], m_lon1[i]);
+      QGeoCoordinate to(m_lat2[i], m_lon2[i]);
+      distance[i] = from.distanceTo(to);
+      azimuth1[i] = from.azimuthTo(to);
+      azimuth2[i] = to.azimuthTo(from) + 180.0;
+    }
+  }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QTest>
+#include <QVector>
+
+class test_Geodesic : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void test_inverse();
+  void test_symmetry();
+  void test_greatEllipse();
+  void test_batch();
+  void benchmark_inverse();
+  void benchmark_greatEllipse();
+  void benchmark_qGeoCoordinate();
+
+private:
+  // Random pairs of points for the batch tests and the benchmarks
+  QVector<double> m_lat1;
+  QVector<double> m_lon1;
+  QVector<double> m_lat2;
+  QVector<double> m_lon2;
+};
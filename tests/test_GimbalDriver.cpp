@@ -0,0 +1,154 @@
+#include <QtMath>
+#include <QSignalSpy>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "GimbalDriver.hpp"
+#include "test_GimbalDriver.hpp"
+
+static const double Interval = 0.02;
+
+void test_GimbalDriver::test_slew() {
+  // From rest to rest, within the limits of the axes
+  GimbalDriver gimbal;
+  GimbalLimits limits = gimbal.limits();
+  gimbal.setPosition(0.0, 0.0);
+  gimbal.setTarget(LookAngle(90.0f, 30.0f));
+
+  double rate = 0.0;
+  bool isWithinRate = true;
+  bool isWithinAcceleration = true;
+  for (int i = 0; i < 250; ++i) {
+    const GimbalCommand command = gimbal.step(Interval);
+    isWithinRate = isWithinRate && qAbs(command.azimuthRate) <= limits.azimuthRate + 1e-9
+      && qAbs(command.elevationRate) <= limits.elevationRate + 1e-9;
+    isWithinAcceleration = isWithinAcceleration
+      && qAbs(command.azimuthRate - rate) <= limits.azimuthAcceleration * Interval + 1e-9;
+    rate = command.azimuthRate;
+  }
+  QVERIFY2(isWithinRate, "rate");
+  QVERIFY2(isWithinAcceleration, "acceleration");
+  const GimbalCommand command = gimbal.position();
+  QVERIFY2(qAbs(command.azimuth - 90.0) < 1e-3 && qAbs(command.elevation - 30.0) < 1e-3, "arrived");
+  QVERIFY2(qAbs(command.azimuthRate) < 1e-2 && qAbs(command.elevationRate) < 1e-2, "at rest");
+  QVERIFY2(gimbal.statistics().trackingError < 1e-3, "on target");
+  QVERIFY2(gimbal.statistics().commands == 250, "commands");
+
+  // 90 degrees at 60 degrees per second, accelerating at 120, takes
+  // two seconds at least.
+  GimbalDriver fast;
+  fast.setTarget(LookAngle(90.0f, 0.0f));
+  for (int i = 0; i < 90; ++i)
+    fast.step(Interval);
+  QVERIFY2(fast.position().azimuth < 89.0, "not sooner");
+}
+
+void test_GimbalDriver::test_wrap() {
+  // From 350 to 10 degrees through north, not the long way around
+  GimbalDriver gimbal;
+  gimbal.setPosition(350.0, 10.0);
+  gimbal.setTarget(LookAngle(10.0f, 10.0f));
+  bool isShortWay = true;
+  for (int i = 0; i < 100; ++i) {
+    const GimbalCommand command = gimbal.step(Interval);
+    isShortWay = isShortWay && (command.azimuth >= 349.99 || command.azimuth <= 10.01);
+    QVERIFY(command.azimuth >= 0.0 && command.azimuth < 360.0);
+  }
+  QVERIFY2(isShortWay, "short way");
+  QVERIFY2(qAbs(gimbal.position().azimuth - 10.0) < 1e-2, "arrived");
+
+  // And back
+  gimbal.setTarget(LookAngle(359.0f, 10.0f));
+  for (int i = 0; i < 100; ++i)
+    gimbal.step(Interval);
+  QVERIFY2(qAbs(gimbal.position().azimuth - 359.0) < 1e-2, "back");
+}
+
+void test_GimbalDriver::test_elevationLimits() {
+  GimbalDriver gimbal;
+  GimbalLimits limits = gimbal.limits();
+  limits.minimumElevation = 0.0;
+  limits.maximumElevation = 80.0;
+  gimbal.setLimits(limits);
+  gimbal.setTarget(LookAngle(0.0f, 89.0f));
+  for (int i = 0; i < 200; ++i)
+    QVERIFY(gimbal.step(Interval).elevation <= 80.0);
+  QVERIFY2(qAbs(gimbal.position().elevation - 80.0) < 1e-6, "top");
+  gimbal.setTarget(LookAngle(0.0f, -5.0f));
+  for (int i = 0; i < 200; ++i)
+    QVERIFY(gimbal.step(Interval).elevation >= 0.0);
+  QVERIFY2(gimbal.position().elevation < 1e-6, "bottom");
+}
+
+void test_GimbalDriver::test_moving() {
+  // A target crossing north at 10 degrees per second, seen twice a
+  // second, is followed between its look angles.
+  GimbalDriver gimbal;
+  gimbal.setPosition(340.0, 20.0);
+  double azimuth = 340.0;
+  double worst = 0.0;
+  for (int i = 0; i < 1000; ++i) {
+    if (i % 25 == 0)
+      gimbal.setTarget(LookAngle(float(azimuth), 20.0f));
+    azimuth = std::fmod(azimuth + 10.0 * Interval, 360.0);
+    gimbal.step(Interval);
+    if (i > 100)
+      worst = qMax(worst, gimbal.statistics().trackingError);
+  }
+  QVERIFY2(worst < 0.25, qPrintable(QString::number(worst)));
+  QVERIFY2(qAbs(gimbal.position().azimuthRate - 10.0) < 0.1, "rate");
+
+  // Without look angles, the target stops a second after the last.
+  for (int i = 0; i < 200; ++i)
+    gimbal.step(Interval);
+  QVERIFY2(qAbs(gimbal.position().azimuthRate) < 0.05, "stopped");
+}
+
+void test_GimbalDriver::test_format() {
+  GimbalCommand command;
+  command.azimuth = 123.4567;
+  command.elevation = -1.5;
+  command.azimuthRate = 2.0;
+  command.elevationRate = -0.25;
+  const QByteArray line = GimbalDriver::format(command);
+  QVERIFY2(line.startsWith("$GMBL,123.457,-1.500,2.000,-0.250*"), line.constData());
+  QVERIFY2(line.endsWith("\r\n") && line.size() == 38, line.constData());
+
+  quint8 checksum = 0;
+  for (int i = 1; i < line.indexOf('*'); ++i)
+    checksum ^= quint8(line.at(i));
+  QVERIFY2(line.mid(line.indexOf('*') + 1, 2).toUInt(nullptr, 16) == checksum, "checksum");
+}
+
+void test_GimbalDriver::test_pty() {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  QVERIFY(master >= 0);
+  QVERIFY(grantpt(master) == 0 && unlockpt(master) == 0);
+  const QString slave = QFile::decodeName(ptsname(master));
+
+  GimbalDriver gimbal;
+  QVERIFY2(!gimbal.open("/nonexistent/gimbal") && !gimbal.errorString().isEmpty(), "no device");
+  QVERIFY2(gimbal.open(slave, 115200), qPrintable(gimbal.errorString()));
+  QSignalSpy commands(&gimbal, SIGNAL(commanded(GimbalCommand)));
+  gimbal.setTarget(LookAngle(45.0f, 10.0f));
+  gimbal.start();
+  QVERIFY2(commands.wait(1000), "commanded");
+  QTest::qWait(100);
+  gimbal.stop();
+
+  char buffer[4096];
+  const ssize_t size = ::read(master, buffer, sizeof(buffer));
+  QVERIFY2(size > 0, "written");
+  const QByteArray lines(buffer, int(size));
+  QVERIFY2(lines.startsWith("$GMBL,") && lines.contains("\r\n"), lines.constData());
+  ::close(master);
+}
+
+void test_GimbalDriver::benchmark_step() {
+  GimbalDriver gimbal;
+  gimbal.setTarget(LookAngle(90.0f, 45.0f));
+  QBENCHMARK {
+    for (int i = 0; i < 1000; ++i)
+      gimbal.step(Interval);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_GimbalDriver : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_slew();
+  void test_wrap();
+  void test_elevationLimits();
+  void test_moving();
+  void test_format();
+  void test_pty();
+  void benchmark_step();
+};
@@ -0,0 +1,111 @@
+#include <QThread>
+#include "LatencyTrace.hpp"
+#include "test_LatencyTrace.hpp"
+
+void test_LatencyTrace::test_buckets() {
+  // Every latency falls in a counter that stands for it, within 1%.
+  bool isWithin = true;
+  bool isPrecise = true;
+  for (qint64 value = 0; value < (Q_INT64_C(1) << 40); value = value * 17 / 16 + 1) {
+    const int index = LatencyHistogram::indexOf(value);
+    isWithin = isWithin && index >= 0 && index < LatencyHistogram::CounterCount
+      && LatencyHistogram::lowestAt(index) <= value && value <= LatencyHistogram::highestAt(index);
+    const qint64 width = LatencyHistogram::highestAt(index) - LatencyHistogram::lowestAt(index) + 1;
+    isPrecise = isPrecise && (value < 256 ? width == 1 : width * 100 < value);
+  }
+  QVERIFY2(isWithin, "in its counter");
+  QVERIFY2(isPrecise, "under 1%");
+
+  // The counters follow each other without a gap.
+  bool isContiguous = true;
+  for (int index = 1; index < LatencyHistogram::indexOf(Q_INT64_C(1) << 40); ++index)
+    isContiguous = isContiguous && LatencyHistogram::lowestAt(index) == LatencyHistogram::highestAt(index - 1) + 1;
+  QVERIFY2(isContiguous, "contiguous");
+  QVERIFY2(LatencyHistogram::indexOf(-5) == 0, "negative");
+  QVERIFY2(LatencyHistogram::indexOf(Q_INT64_C(1) << 50) == LatencyHistogram::indexOf((Q_INT64_C(1) << 40) - 1), "longest");
+}
+
+void test_LatencyTrace::test_percentiles() {
+  LatencyHistogram histogram;
+  QVERIFY2(histogram.count() == 0 && histogram.percentile(0.5) == 0 && histogram.minimum() == 0, "empty");
+  for (qint64 value = 1; value <= 100000; ++value)
+    histogram.record(value);
+  QVERIFY2(histogram.count() == 100000, "count");
+  QVERIFY2(histogram.minimum() == 1 && histogram.maximum() == 100000, "extremes");
+  QVERIFY2(qAbs(histogram.percentile(0.5) - 50000) < 500, "p50");
+  QVERIFY2(qAbs(histogram.percentile(0.99) - 99000) < 990, "p99");
+  QVERIFY2(qAbs(histogram.percentile(0.999) - 99900) < 999, "p999");
+  QVERIFY2(histogram.percentile(1.0) == 100000, "p100");
+
+  // A copy, added to another histogram
+  LatencyHistogram other;
+  other.record(1000000);
+  other.add(histogram);
+  QVERIFY2(other.count() == 100001 && other.maximum() == 1000000 && other.minimum() == 1, "added");
+  histogram.reset();
+  QVERIFY2(histogram.count() == 0 && other.count() == 100001, "reset");
+}
+
+void test_LatencyTrace::test_scope() {
+  LatencyTrace::reset();
+
+  // Outside a trace, marks are ignored.
+  QVERIFY2(LatencyTrace::origin() == 0, "no trace");
+  LatencyTrace::mark(LatencyTrace::EntityUpdate);
+  QVERIFY2(LatencyTrace::histogram(LatencyTrace::EntityUpdate).count() == 0, "ignored");
+
+  qint64 before;
+  {
+    LatencyTrace::Scope scope;
+    before = LatencyTrace::origin();
+    QVERIFY2(before > 0, "origin");
+    QThread::msleep(2);
+    LatencyTrace::mark(LatencyTrace::EntityUpdate);
+    {
+      // Carried over from elsewhere, an earlier origin
+      LatencyTrace::Scope resumed(before - 1000000000);
+      LatencyTrace::mark(LatencyTrace::Handover);
+    }
+    QVERIFY2(LatencyTrace::origin() == before, "restored");
+    LatencyTrace::mark(LatencyTrace::LookAngleComputed);
+  }
+  QVERIFY2(LatencyTrace::origin() == 0, "ended");
+
+  LatencyHistogram update = LatencyTrace::histogram(LatencyTrace::EntityUpdate);
+  QVERIFY2(update.count() == 1 && update.minimum() >= 2000000, "since the origin");
+  QVERIFY2(LatencyTrace::histogram(LatencyTrace::Handover).minimum() >= 1000000000, "since the carried origin");
+  QVERIFY2(LatencyTrace::histogram(LatencyTrace::LookAngleComputed).count() == 1, "after the nested scope");
+}
+
+void test_LatencyTrace::test_threads() {
+  LatencyTrace::reset();
+  QVector<QThread *> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.append(QThread::create([]() {
+        for (int j = 0; j < 1000; ++j) {
+          LatencyTrace::Scope scope;
+          LatencyTrace::mark(LatencyTrace::LookAngleDelivered);
+        }
+      }));
+    threads.last()->start();
+  }
+  for (QThread *thread : threads) {
+    thread->wait();
+    delete thread;
+  }
+  QVERIFY2(LatencyTrace::histogram(LatencyTrace::LookAngleDelivered).count() == 4000, "every thread");
+}
+
+void test_LatencyTrace::test_report() {
+  const QString report = LatencyTrace::report();
+  QVERIFY2(report.contains("p999") && report.contains("entity update") && report.contains("look angle delivered"), "table");
+  QVERIFY2(report.count('\n') == 1 + LatencyTrace::StageCount, "a line per stage");
+}
+
+void test_LatencyTrace::benchmark_mark() {
+  LatencyTrace::Scope scope;
+  QBENCHMARK {
+    for (int i = 0; i < 1000; ++i)
+      LatencyTrace::mark(LatencyTrace::EntityUpdate);
+  }
+}
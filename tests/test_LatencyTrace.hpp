@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_LatencyTrace : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_buckets();
+  void test_percentiles();
+  void test_scope();
+  void test_threads();
+  void test_report();
+  void benchmark_mark();
+};
@@ -0,0 +1,249 @@
+#include <QThread>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include "Listener.hpp"
+#include "GeoEntity.hpp"
+#include "GeoObserver.hpp"
+#include "LookAngle.hpp"
+#include "test_Listener.hpp"
+
+// Records the values it is called with, in a log shared with others
+class RecordingListener
+{
+public:
+  RecordingListener(int name, QVector<int> *log) :
+    m_name(name),
+    m_log(log),
+    m_remove(nullptr)
+  {
+    listener.bind<RecordingListener, &RecordingListener::onValue>(this);
+  }
+
+  void onValue(int const &value)
+  {
+    m_log->append(m_name * 100 + value);
+    if (m_remove)
+      m_remove->unlisten();
+  }
+
+  Listener<int> listener;
+  int m_name;
+  QVector<int> *m_log;
+  Listener<int> *m_remove;    // to remove when called
+};
+
+// Counts the look angles it is given
+class LookAngleCounter
+{
+public:
+  LookAngleCounter() :
+    thread(nullptr),
+    count(0)
+  {
+  }
+
+  void onLookAngleChanged(LookAngle const &lookAngle)
+  {
+    last = lookAngle;
+    thread = QThread::currentThread();
+    ++count;
+  }
+
+  LookAngle last;
+  QThread *thread;
+  int count;
+};
+
+// Counts the positions it is given, by listener or by signal
+class PositionCounter : public QObject
+{
+public:
+  PositionCounter() :
+    count(0)
+  {
+  }
+
+  void onPositionChanged(QGeoPositionInfo const &)
+  {
+    ++count;
+  }
+
+  int count;
+};
+
+static
+QGeoPositionInfo Position(double latitude, double longitude, double altitude)
+{
+  return QGeoPositionInfo(QGeoCoordinate(latitude, longitude, altitude), QDateTime::currentDateTimeUtc());
+}
+
+void test_Listener::test_notify()
+{
+  QVector<int> log;
+  RecordingListener a(1, &log), b(2, &log), c(3, &log);
+  ListenerList<int> list;
+  list.add(&a.listener);
+  list.add(&b.listener);
+  list.add(&c.listener);
+  QVERIFY2(list.count() == 3, "three listeners");
+
+  list.notify(7);
+  QVERIFY2(log == QVector<int>({ 107, 207, 307 }), "called in the order added");
+
+  // Adding again moves a listener to the end
+  list.add(&a.listener);
+  log.clear();
+  list.notify(1);
+  QVERIFY2(log == QVector<int>({ 201, 301, 101 }), "added again last");
+
+  list.remove(&b.listener);
+  QVERIFY2(!b.listener.isListening(), "removed");
+  log.clear();
+  list.notify(2);
+  QVERIFY2(log == QVector<int>({ 302, 102 }), "removed not called");
+}
+
+void test_Listener::test_removeWhileNotified()
+{
+  QVector<int> log;
+  RecordingListener a(1, &log), b(2, &log), c(3, &log);
+  ListenerList<int> list;
+  list.add(&a.listener);
+  list.add(&b.listener);
+  list.add(&c.listener);
+
+  // The first removes the next one, the second is never called
+  a.m_remove = &b.listener;
+  list.notify(1);
+  QVERIFY2(log == QVector<int>({ 101, 301 }), "next removed while notified");
+
+  // A listener removes itself
+  log.clear();
+  a.m_remove = &a.listener;
+  list.notify(2);
+  QVERIFY2(log == QVector<int>({ 102, 302 }), "removed itself while notified");
+  QVERIFY2(list.count() == 1, "one left");
+}
+
+void test_Listener::test_lifetime()
+{
+  QVector<int> log;
+  RecordingListener a(1, &log);
+  {
+    ListenerList<int> list;
+    list.add(&a.listener);
+    {
+      RecordingListener b(2, &log);
+      list.add(&b.listener);
+    }
+    QVERIFY2(list.count() == 1, "destroyed listener left the list");
+    list.notify(3);
+  }
+  QVERIFY2(log == QVector<int>({ 103 }), "only the listener alive called");
+  QVERIFY2(!a.listener.isListening(), "destroyed list let go of its listener");
+  a.listener.unlisten();
+}
+
+void test_Listener::test_observer()
+{
+  GeoObserver observer;
+  GeoEntity target;
+  LookAngleCounter counter;
+  LookAngleListener listener;
+  listener.bind<LookAngleCounter, &LookAngleCounter::onLookAngleChanged>(&counter);
+  observer.addLookAngleListener(&listener);
+
+  observer.setPosition(Position(0.0, 0.0, 0.0));
+  observer.setTarget(&target);
+  const int before = counter.count;
+
+  // Moving the target, without any signal connected, reaches the
+  // observer and its listeners
+  target.setPosition(Position(0.0, 0.1, 0.0));
+  QVERIFY2(counter.count == before + 1, "look angle after the target moved");
+  QVERIFY2(qAbs(counter.last.azimuth() - 90.0) < 0.1, "target due east");
+
+  observer.setPosition(Position(0.1, 0.1, 0.0));
+  QVERIFY2(counter.count == before + 2, "look angle after the observer moved");
+  QVERIFY2(qAbs(counter.last.azimuth() - 180.0) < 0.1, "target due south");
+
+  // Another target, the former no longer followed
+  GeoEntity other;
+  observer.setTarget(&other);
+  const int after = counter.count;
+  target.setPosition(Position(0.2, 0.0, 0.0));
+  QVERIFY2(counter.count == after, "former target not followed");
+
+  observer.removeLookAngleListener(&listener);
+  other.setPosition(Position(0.2, 0.0, 0.0));
+  QVERIFY2(counter.count == after, "removed listener not called");
+}
+
+void test_Listener::test_observerAcrossThreads()
+{
+  GeoObserver observer;
+  GeoEntity target;
+  LookAngleCounter counter;
+  LookAngleListener listener;
+  listener.bind<LookAngleCounter, &LookAngleCounter::onLookAngleChanged>(&counter);
+  observer.addLookAngleListener(&listener);
+  observer.setPosition(Position(0.0, 0.0, 0.0));
+
+  // The target is fed in a thread of its own, as a shard would
+  QThread feed;
+  feed.start();
+  target.moveToThread(&feed);
+  observer.setTarget(&target);
+  const int before = counter.count;
+
+  QMetaObject::invokeMethod(&target, [&target]() {
+    target.setPosition(Position(0.0, 0.1, 0.0));
+  }, Qt::BlockingQueuedConnection);
+  QTRY_VERIFY2(counter.count == before + 1, "look angle after the target moved");
+  QVERIFY2(counter.thread == observer.thread(), "look angle in the thread of the observer");
+  QVERIFY2(qAbs(counter.last.azimuth() - 90.0) < 0.1, "target due east");
+
+  // No longer followed once another target is set
+  observer.setTarget(QGeoCoordinate(0.1, 0.0, 0.0));
+  const int after = counter.count;
+  QMetaObject::invokeMethod(&target, [&target]() {
+    target.setPosition(Position(0.0, 0.2, 0.0));
+  }, Qt::BlockingQueuedConnection);
+  QTest::qWait(10);
+  QVERIFY2(counter.count == after, "former target not followed");
+
+  QThread *home = observer.thread();
+  QMetaObject::invokeMethod(&target, [&target, home]() {
+    target.moveToThread(home);
+  }, Qt::BlockingQueuedConnection);
+  feed.quit();
+  feed.wait();
+}
+
+void test_Listener::test_benchmarkListener()
+{
+  GeoEntity entity;
+  PositionCounter counter;
+  PositionListener listener;
+  listener.bind<PositionCounter, &PositionCounter::onPositionChanged>(&counter);
+  entity.addPositionListener(&listener);
+  const QGeoPositionInfo position = Position(0.1, 0.1, 1000.0);
+
+  QBENCHMARK {
+    entity.setPosition(position);
+  }
+  QVERIFY2(counter.count > 0, "listener called");
+}
+
+void test_Listener::test_benchmarkSignal()
+{
+  GeoEntity entity;
+  PositionCounter counter;
+  connect(&entity, &GeoEntity::positionChanged, &counter, &PositionCounter::onPositionChanged);
+  const QGeoPositionInfo position = Position(0.1, 0.1, 1000.0);
+
+  QBENCHMARK {
+    entity.setPosition(position);
+  }
+  QVERIFY2(counter.count > 0, "slot called");
+}
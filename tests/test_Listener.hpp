@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_Listener : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_notify();
+  void test_removeWhileNotified();
+  void test_lifetime();
+  void test_observer();
+  void test_observerAcrossThreads();
+  void test_benchmarkListener();
+  void test_benchmarkSignal();
+};
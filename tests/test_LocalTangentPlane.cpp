@@ -0,0 +1,176 @@
+#include <cmath>
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include <QtMath>
+#include "GeoEntity.hpp"
+#include "GeoObserver.hpp"
+#include "LocalTangentPlane.hpp"
+#include "LookAngle.hpp"
+#include "test_LocalTangentPlane.hpp"
+
+// The positions of a drone circling 2 km from an observer, a step of
+// a few meters at a time
+static
+QGeoCoordinate DronePosition(QGeoCoordinate const &observer, int step)
+{
+  const double angle = step * 0.002;
+  double longitude = observer.longitude() + 0.022 * qSin(angle);
+  if (longitude > 180.0)
+    longitude -= 360.0;
+  return QGeoCoordinate(observer.latitude() + 0.018 * qCos(angle),
+                        longitude,
+                        observer.altitude() + 120.0 + 30.0 * qSin(3.0 * angle));
+}
+
+static
+QGeoPositionInfo PositionAt(QGeoCoordinate const &coordinate)
+{
+  return QGeoPositionInfo(coordinate, QDateTime::currentDateTimeUtc());
+}
+
+// The difference of two azimuths in degrees
+static
+double AzimuthDifference(double a, double b)
+{
+  const double difference = qAbs(a - b);
+  return qMin(difference, 360.0 - difference);
+}
+
+void test_LocalTangentPlane::test_agreesWithLookAngle() {
+  const QGeoCoordinate observers[] = {
+    QGeoCoordinate(35.0, -120.0, 100.0),
+    QGeoCoordinate(-33.9, 151.2, 20.0),
+    QGeoCoordinate(69.6, 18.9, 0.0),
+    QGeoCoordinate(0.0, 179.99, 10.0)     // across the antimeridian
+  };
+  for (QGeoCoordinate const &observer : observers) {
+    LocalTangentPlane plane;
+    plane.setObserver(observer);
+    for (int step = 0; step < 3200; ++step) {
+      const QGeoCoordinate target = DronePosition(observer, step);
+      float azimuth = 0.0f, elevation = 0.0f;
+      double range = 0.0;
+      plane.lookAngle(target, &azimuth, &elevation, &range);
+      QVERIFY2(plane.error() <= plane.tolerance(), "error within the tolerance");
+
+      // The error of the position over the range and its horizontal
+      // part, and the rounding of a float
+      const LookAngle lookAngle(observer, target);
+      const double bound = qRadiansToDegrees(plane.error() + 1.0e-6);
+      QVERIFY2(qAbs(elevation - lookAngle.elevation()) <= bound / range + 1.0e-4, "elevation");
+      QVERIFY2(AzimuthDifference(azimuth, lookAngle.azimuth())
+               <= bound / (range * qCos(qDegreesToRadians(elevation))) + 1.0e-4, "azimuth");
+      QVERIFY2(qAbs(range - LookAngleFrame::at(observer).point.distanceTo(LookAngle::point(target)))
+               <= plane.error() + 1.0e-6, "range");
+    }
+  }
+}
+
+void test_LocalTangentPlane::test_rebase() {
+  const QGeoCoordinate observer(35.0, -120.0, 100.0);
+  LocalTangentPlane plane;
+  plane.setObserver(observer);
+
+  // The first position is converted in full
+  float azimuth = 0.0f, elevation = 0.0f;
+  double range = 0.0;
+  plane.lookAngle(DronePosition(observer, 0), &azimuth, &elevation, &range);
+  QVERIFY2(plane.rebases() == 1 && plane.error() == 0.0, "first position");
+
+  // The next ones are linearized, until the track has moved away
+  plane.lookAngle(DronePosition(observer, 1), &azimuth, &elevation, &range);
+  QVERIFY2(plane.rebases() == 1 && plane.error() > 0.0, "linearized");
+  for (int step = 2; step < 3200; ++step)
+    plane.lookAngle(DronePosition(observer, step), &azimuth, &elevation, &range);
+  QVERIFY2(plane.rebases() > 1 && plane.rebases() < 320, "rebased now and then");
+
+  // A looser tolerance, fewer rebases
+  LocalTangentPlane loose;
+  loose.setTolerance(1.0);
+  loose.setObserver(observer);
+  for (int step = 0; step < 3200; ++step) {
+    loose.lookAngle(DronePosition(observer, step), &azimuth, &elevation, &range);
+    QVERIFY2(loose.error() <= 1.0, "error within the loose tolerance");
+  }
+  QVERIFY2(loose.rebases() < plane.rebases(), "loose tolerance");
+}
+
+void test_LocalTangentPlane::test_observer() {
+  const QGeoCoordinate observer(35.0, -120.0, 100.0);
+  LocalTangentPlane plane;
+  plane.setObserver(observer);
+  float azimuth = 0.0f, elevation = 0.0f;
+  double range = 0.0;
+  plane.lookAngle(DronePosition(observer, 0), &azimuth, &elevation, &range);
+  plane.lookAngle(DronePosition(observer, 1), &azimuth, &elevation, &range);
+
+  // The same observer keeps the plane, another rebases it
+  plane.setObserver(observer);
+  plane.lookAngle(DronePosition(observer, 2), &azimuth, &elevation, &range);
+  QVERIFY2(plane.rebases() == 1, "same observer");
+
+  const QGeoCoordinate moved(35.001, -120.0, 100.0);
+  plane.setObserver(moved);
+  plane.lookAngle(DronePosition(observer, 3), &azimuth, &elevation, &range);
+  QVERIFY2(plane.rebases() == 2 && plane.error() == 0.0, "moved observer");
+  const LookAngle lookAngle(moved, DronePosition(observer, 3));
+  QVERIFY2(AzimuthDifference(azimuth, lookAngle.azimuth()) <= 1.0e-4, "azimuth from the moved observer");
+  QVERIFY2(qAbs(elevation - lookAngle.elevation()) <= 1.0e-4, "elevation from the moved observer");
+}
+
+void test_LocalTangentPlane::test_geoObserver() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const Refraction refraction(Refraction::Bennett);
+  GeoObserver observer;
+  GeoEntity target;
+  observer.setPosition(PositionAt(site));
+  observer.setRefraction(refraction);
+  QVERIFY2(!observer.isLocalTangentPlane(), "off by default");
+  observer.setLocalTangentPlane(true);
+  observer.setTarget(&target);
+
+  for (int step = 0; step < 1000; ++step) {
+    const QGeoCoordinate position = DronePosition(site, step);
+    target.setPosition(PositionAt(position));
+    const LookAngle lookAngle(site, position, refraction);
+    QVERIFY2(observer.localTangentPlaneError() <= observer.localTangentPlaneTolerance(), "error");
+    QVERIFY2(AzimuthDifference(observer.lookAngle().azimuth(), lookAngle.azimuth()) <= 1.0e-3, "azimuth");
+    QVERIFY2(qAbs(observer.lookAngle().elevation() - lookAngle.elevation()) <= 1.0e-3, "elevation");
+  }
+
+  // Back to the full conversion
+  observer.setLocalTangentPlane(false);
+  target.setPosition(PositionAt(DronePosition(site, 1000)));
+  QVERIFY2(observer.localTangentPlaneError() == 0.0, "no error off the plane");
+  QVERIFY2(observer.lookAngle() == LookAngle(site, DronePosition(site, 1000), refraction), "full conversion");
+}
+
+void test_LocalTangentPlane::test_benchmarkLocalTangentPlane() {
+  const QGeoCoordinate observer(35.0, -120.0, 100.0);
+  QVector<QGeoCoordinate> targets;
+  for (int step = 0; step < 1000; ++step)
+    targets.append(DronePosition(observer, step));
+  LocalTangentPlane plane;
+  plane.setObserver(observer);
+  float azimuth = 0.0f, elevation = 0.0f;
+  double range = 0.0;
+
+  QBENCHMARK {
+    for (QGeoCoordinate const &target : targets)
+      plane.lookAngle(target, &azimuth, &elevation, &range);
+  }
+}
+
+void test_LocalTangentPlane::test_benchmarkLookAngle() {
+  const QGeoCoordinate observer(35.0, -120.0, 100.0);
+  QVector<QGeoCoordinate> targets;
+  for (int step = 0; step < 1000; ++step)
+    targets.append(DronePosition(observer, step));
+  LookAngle lookAngle;
+
+  QBENCHMARK {
+    for (QGeoCoordinate const &target : targets)
+      lookAngle.setLookAngle(observer, target);
+  }
+}
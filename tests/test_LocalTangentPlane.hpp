@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_LocalTangentPlane : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_agreesWithLookAngle();
+  void test_rebase();
+  void test_observer();
+  void test_geoObserver();
+  void test_benchmarkLocalTangentPlane();
+  void test_benchmarkLookAngle();
+};
@@ -21,6 +21,3 @@ void test_LookAngle::test_setLookAngle() {
   QVERIFY2(qFabs(a.azimuth() - 270.339)  <= 0.001, "azimuth");
   QVERIFY2(qFabs(a.elevation() - 4.8812) <= 0.001, "elevation");
 }
-
-// generate basic main: no GUI, no events
-QTEST_APPLESS_MAIN(test_LookAngle)
@@ -0,0 +1,186 @@
+#include <QDateTime>
+#include <QGeoCoordinate>
+#include <QGeoPositionInfo>
+#include <QVector>
+#include "GeoObserver.hpp"
+#include "LookAngle.hpp"
+#include "LookAngleCache.hpp"
+#include "test_LookAngleCache.hpp"
+
+// Surveyed points around a fixed installation
+static
+QVector<QGeoCoordinate> SurveyedPoints(QGeoCoordinate const &site, int count)
+{
+  QVector<QGeoCoordinate> points;
+  for (int i = 0; i < count; ++i)
+    points.append(QGeoCoordinate(site.latitude() + 0.01 * ((i * 7) % 23 - 11),
+                                 site.longitude() + 0.013 * ((i * 5) % 19 - 9),
+                                 site.altitude() + 10.0 * (i % 13)));
+  return points;
+}
+
+static
+QGeoPositionInfo PositionAt(QGeoCoordinate const &coordinate)
+{
+  return QGeoPositionInfo(coordinate, QDateTime::currentDateTimeUtc());
+}
+
+void test_LookAngleCache::test_agreesWithLookAngle() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const Refraction refraction(Refraction::FourThirdsEarth);
+  LookAngleCache cache;
+  cache.setObserver(site);
+
+  // Computed, then looked up, bit for bit those of LookAngle
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 40);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (QGeoCoordinate const &point : points) {
+      float azimuth, elevation;
+      double range;
+      cache.lookAngle(point, &azimuth, &elevation, &range);
+      const LookAngle lookAngle(site, point, refraction);
+      QVERIFY2(azimuth == lookAngle.azimuth(), "azimuth");
+      QVERIFY2(refraction.apparentElevation(elevation, range) == lookAngle.elevation(), "elevation");
+    }
+  }
+
+  // On the vertical of the observer, and at the observer
+  float azimuth, elevation;
+  double range;
+  cache.lookAngle(QGeoCoordinate(site.latitude(), site.longitude(), 5000.0), &azimuth, &elevation, &range);
+  QVERIFY2(azimuth == 0.0f && elevation == 90.0f, "vertical");
+  cache.lookAngle(site, &azimuth, &elevation, &range);
+  QVERIFY2(azimuth == 0.0f && elevation == 0.0f && range == 0.0, "observer");
+}
+
+void test_LookAngleCache::test_hits() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 10);
+  LookAngleCache cache;
+  cache.setObserver(site);
+  QVERIFY2(!cache.contains(points.at(0)), "empty");
+
+  float azimuth, elevation;
+  double range;
+  for (QGeoCoordinate const &point : points)
+    cache.lookAngle(point, &azimuth, &elevation, &range);
+  QVERIFY2(cache.misses() == 10 && cache.hits() == 0, "computed");
+  for (QGeoCoordinate const &point : points) {
+    QVERIFY2(cache.contains(point), "kept");
+    cache.lookAngle(point, &azimuth, &elevation, &range);
+  }
+  QVERIFY2(cache.misses() == 10 && cache.hits() == 10, "looked up");
+
+  // A 2D coordinate is a key of its own
+  const QGeoCoordinate flat(site.latitude() + 0.1, site.longitude());
+  cache.lookAngle(flat, &azimuth, &elevation, &range);
+  cache.lookAngle(flat, &azimuth, &elevation, &range);
+  QVERIFY2(cache.misses() == 11 && cache.hits() == 11, "2D coordinate");
+
+  cache.clear();
+  QVERIFY2(!cache.contains(points.at(0)), "cleared");
+}
+
+void test_LookAngleCache::test_tolerance() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const QGeoCoordinate target(35.05, -120.02, 500.0);
+  LookAngleCache cache;
+  cache.setTolerance(0.5);
+  cache.setObserver(site);
+  float azimuth, elevation, before;
+  double range;
+  cache.lookAngle(target, &azimuth, &before, &range);
+
+  // A new fix of the same position, within the tolerance
+  cache.setObserver(QGeoCoordinate(site.latitude(), site.longitude(), site.altitude() + 0.3));
+  QVERIFY2(cache.contains(target), "kept within the tolerance");
+  QVERIFY2(cache.observer() == site, "observer of the look angles");
+  cache.lookAngle(target, &azimuth, &elevation, &range);
+  QVERIFY2(elevation == before && cache.hits() == 1, "looked up");
+
+  // Beyond it, computed again from the new position
+  const QGeoCoordinate moved(site.latitude(), site.longitude(), site.altitude() + 2.0);
+  cache.setObserver(moved);
+  QVERIFY2(!cache.contains(target), "stale beyond the tolerance");
+  cache.lookAngle(target, &azimuth, &elevation, &range);
+  QVERIFY2(cache.misses() == 2, "computed again");
+  QVERIFY2(elevation == LookAngle(moved, target).elevation() && elevation < before, "from the new position");
+}
+
+void test_LookAngleCache::test_collisions() {
+  // More points than entries: the look angles are always right
+  const QGeoCoordinate site(-33.9, 151.2, 20.0);
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 200);
+  LookAngleCache cache(16);
+  QVERIFY2(cache.capacity() == 16, "capacity");
+  cache.setObserver(site);
+  for (int pass = 0; pass < 3; ++pass) {
+    for (QGeoCoordinate const &point : points) {
+      float azimuth, elevation;
+      double range;
+      cache.lookAngle(point, &azimuth, &elevation, &range);
+      const LookAngle lookAngle(site, point);
+      QVERIFY2(azimuth == lookAngle.azimuth() && elevation == lookAngle.elevation(), "look angle");
+    }
+  }
+  QVERIFY2(cache.hits() + cache.misses() == 600, "lookups");
+}
+
+void test_LookAngleCache::test_geoObserver() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 8);
+  const Refraction refraction(Refraction::Bennett);
+  GeoObserver observer;
+  observer.setPosition(PositionAt(site));
+  observer.setRefraction(refraction);
+  QVERIFY2(!observer.isLookAngleCached(), "off by default");
+  observer.setLookAngleCached(true);
+  observer.setLookAngleCacheTolerance(0.5);
+  observer.cacheLookAngles(points);
+
+  // Pointing at the known points, and new fixes within the tolerance
+  for (int i = 0; i < 32; ++i) {
+    QGeoCoordinate const &point = points.at(i % points.size());
+    observer.setTarget(point);
+    QVERIFY2(observer.lookAngle() == LookAngle(site, point, refraction), "known point");
+    observer.setPosition(PositionAt(QGeoCoordinate(site.latitude(), site.longitude(),
+                                                     site.altitude() + 0.1 * (i % 3))));
+    QVERIFY2(observer.lookAngle() == LookAngle(site, point, refraction), "new fix");
+  }
+
+  // Moved away, the look angles are those of the new position
+  const QGeoCoordinate moved(35.001, -120.0, 100.0);
+  observer.setPosition(PositionAt(moved));
+  QVERIFY2(observer.lookAngle() == LookAngle(moved, points.at(31 % points.size()), refraction), "moved");
+
+  // The cache takes precedence over the local tangent plane
+  observer.setLocalTangentPlane(true);
+  observer.setTarget(points.at(0));
+  QVERIFY2(observer.lookAngle() == LookAngle(moved, points.at(0), refraction), "cached with the plane on");
+  QVERIFY2(observer.localTangentPlaneError() == 0.0, "no error of the plane");
+}
+
+void test_LookAngleCache::test_benchmarkCache() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 32);
+  LookAngleCache cache;
+  cache.setObserver(site);
+  float azimuth, elevation;
+  double range;
+
+  QBENCHMARK {
+    for (QGeoCoordinate const &point : points)
+      cache.lookAngle(point, &azimuth, &elevation, &range);
+  }
+}
+
+void test_LookAngleCache::test_benchmarkLookAngle() {
+  const QGeoCoordinate site(35.0, -120.0, 100.0);
+  const QVector<QGeoCoordinate> points = SurveyedPoints(site, 32);
+  LookAngle lookAngle;
+
+  QBENCHMARK {
+    for (QGeoCoordinate const &point : points)
+      lookAngle.setLookAngle(site, point);
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_LookAngleCache : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_agreesWithLookAngle();
+  void test_hits();
+  void test_tolerance();
+  void test_collisions();
+  void test_geoObserver();
+  void test_benchmarkCache();
+  void test_benchmarkLookAngle();
+};
@@ -0,0 +1,135 @@
+#include <QtMath>
+#include "LookAngleKernel.hpp"
+#include "LookAngle.hpp"
+#include "test_LookAngleKernel.hpp"
+
+// The coordinate at a distance (kilometers, along the sphere) and a
+// bearing from another, at an altitude
+static
+QGeoCoordinate Offset(QGeoCoordinate const &from, double bearing, double distance, double altitude)
+{
+  const double d = distance / 6371.0;
+  const double b = qDegreesToRadians(bearing);
+  const double lat = qDegreesToRadians(from.latitude());
+  const double lon = qDegreesToRadians(from.longitude());
+  const double lat2 = qAsin(qSin(lat) * qCos(d) + qCos(lat) * qSin(d) * qCos(b));
+  const double lon2 = lon + qAtan2(qSin(b) * qSin(d) * qCos(lat), qCos(d) - qSin(lat) * qSin(lat2));
+  double longitude = qRadiansToDegrees(lon2);
+  if (longitude > 180.0)
+    longitude -= 360.0;
+  if (longitude < -180.0)
+    longitude += 360.0;
+  return QGeoCoordinate(qRadiansToDegrees(lat2), longitude, altitude);
+}
+
+// The worst errors of a kernel against LookAngle, over a global grid
+// of origins, each with an observer at the origin and one at a
+// distance from it, and targets from 1 km to geostationary altitude
+// around the latter.
+template <class Real>
+static
+void GridErrors(double distance, double *azimuthError, double *elevationError)
+{
+  *azimuthError = 0.0;
+  *elevationError = 0.0;
+  for (double latitude = -85.0; latitude <= 85.0; latitude += 10.0) {
+    for (double longitude = -180.0; longitude < 180.0; longitude += 30.0) {
+      const QGeoCoordinate origin(latitude, longitude, 100.0);
+      const QGeoCoordinate observers[2] = { origin, Offset(origin, 45.0, distance, 500.0) };
+      LookAngleKernel<Real> kernel;
+      kernel.setOrigin(LookAngleFrame::at(origin).point);
+      kernel.resize(2);
+      for (int i = 0; i < 2; ++i)
+        kernel.setFrame(i, LookAngleFrame::at(observers[i]));
+
+      for (double range : { 1.0, 10.0, 100.0, 1000.0 }) {
+        for (double altitude : { 0.0, 1000.0, 10000.0, 400000.0, 35786000.0 }) {
+          for (double bearing = 0.0; bearing < 360.0; bearing += 60.0) {
+            const QGeoCoordinate target = Offset(observers[1], bearing, range, altitude);
+            float azimuth[2] = { 0.0f, 0.0f };
+            float elevation[2];
+            double ranges[2];
+            kernel.calculate(LookAngle::point(target), azimuth, elevation, ranges);
+            for (int i = 0; i < 2; ++i) {
+              const LookAngle expected(observers[i], target);
+              double difference = qAbs(azimuth[i] - expected.azimuth());
+              difference = qMin(difference, 360.0 - difference);
+              // The azimuth of a target overhead means little
+              if (expected.elevation() < 89.0)
+                *azimuthError = qMax(*azimuthError, difference);
+              *elevationError = qMax(*elevationError, double(qAbs(elevation[i] - expected.elevation())));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+void test_LookAngleKernel::test_doubleGrid()
+{
+  for (double distance : { 0.0, 100.0, 1000.0, 5000.0 }) {
+    double azimuthError, elevationError;
+    GridErrors<double>(distance, &azimuthError, &elevationError);
+    QVERIFY2(azimuthError <= 1e-5, "double azimuth within 1e-5 degree");
+    QVERIFY2(elevationError <= 1e-5, "double elevation within 1e-5 degree");
+  }
+}
+
+void test_LookAngleKernel::test_floatGrid()
+{
+  double azimuthError, elevationError;
+  GridErrors<float>(100.0, &azimuthError, &elevationError);
+  QVERIFY2(azimuthError <= 1e-3, "float azimuth within 1e-3 degree at 100 km");
+  QVERIFY2(elevationError <= 1e-3, "float elevation within 1e-3 degree at 100 km");
+
+  GridErrors<float>(1000.0, &azimuthError, &elevationError);
+  QVERIFY2(azimuthError <= 1e-2, "float azimuth within 1e-2 degree at 1000 km");
+  QVERIFY2(elevationError <= 1e-2, "float elevation within 1e-2 degree at 1000 km");
+}
+
+void test_LookAngleKernel::test_coincident()
+{
+  // A target at the observer has no elevation
+  const QGeoCoordinate observer(45.0, 7.0, 300.0);
+  LookAngleKernel<float> kernel;
+  kernel.setOrigin(LookAngleFrame::at(observer).point);
+  kernel.resize(1);
+  kernel.setFrame(0, LookAngleFrame::at(observer));
+  float azimuth = 0.0f;
+  float elevation = 0.0f;
+  double range = -1.0;
+  kernel.calculate(LookAngle::point(observer), &azimuth, &elevation, &range);
+  QVERIFY2(elevation == 90.0f, "straight up");
+  QVERIFY2(range == 0.0, "no range");
+}
+
+template <class Real>
+static
+void Benchmark()
+{
+  const QGeoCoordinate origin(40.0, -75.0, 0.0);
+  const int count = 4096;
+  LookAngleKernel<Real> kernel;
+  kernel.setOrigin(LookAngleFrame::at(origin).point);
+  kernel.resize(count);
+  for (int i = 0; i < count; ++i)
+    kernel.setFrame(i, LookAngleFrame::at(Offset(origin, i * 0.7, i % 300, 0.0)));
+  QVector<float> azimuth(count), elevation(count);
+  QVector<double> range(count);
+  const GeoPoint target = LookAngle::point(QGeoCoordinate(41.0, -74.0, 10000.0));
+
+  QBENCHMARK {
+    kernel.calculate(target, azimuth.data(), elevation.data(), range.data());
+  }
+}
+
+void test_LookAngleKernel::test_benchmarkDouble()
+{
+  Benchmark<double>();
+}
+
+void test_LookAngleKernel::test_benchmarkFloat()
+{
+  Benchmark<float>();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QTest>
+
+class test_LookAngleKernel : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_doubleGrid();
+  void test_floatGrid();
+  void test_coincident();
+  void test_benchmarkDouble();
+  void test_benchmarkFloat();
+};
@@ -0,0 +1,242 @@
+#include <cstring>
+#include <QtMath>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QScopedPointer>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include "GeoEntity.hpp"
+#include "data-sources/MavlinkParser.hpp"
+#include "data-sources/MavlinkPositionSource.hpp"
+#include "data-sources/PositionSourceFactory.hpp"
+#include "test_MavlinkPositionSource.hpp"
+
+static void Append(QByteArray &payload, void const *value, int size)
+{
+  payload.append(static_cast<char const *>(value), size);
+}
+
+// The payloads, in the order of the MAVLink wire format
+static QByteArray GlobalPositionInt(double latitude, double longitude, double altitude,
+                                    double north, double east, double down, double heading)
+{
+  QByteArray payload;
+  const quint32 time = 1000;
+  const qint32 fields[] = { qint32(qRound64(latitude * 1e7)), qint32(qRound64(longitude * 1e7)),
+                            qint32(qRound64(altitude * 1e3)), 0 };
+  const qint16 velocity[] = { qint16(qRound(north * 100)), qint16(qRound(east * 100)), qint16(qRound(down * 100)) };
+  const quint16 hdg = heading < 0.0 ? 0xffff : quint16(qRound(heading * 100));
+  Append(payload, &time, 4);
+  Append(payload, fields, 16);
+  Append(payload, velocity, 6);
+  Append(payload, &hdg, 2);
+  return payload;
+}
+
+static QByteArray Attitude(float roll, float pitch, float yaw)
+{
+  QByteArray payload;
+  const quint32 time = 2000;
+  const float fields[] = { roll, pitch, yaw, 0.0f, 0.0f, 0.0f };
+  Append(payload, &time, 4);
+  Append(payload, fields, 24);
+  return payload;
+}
+
+// A frame of either version, MAVLink 2 frames with their payload
+// truncated
+static QByteArray Frame(int version, quint8 systemId, quint32 messageId, quint8 crcExtra,
+                        QByteArray payload, bool isSigned = false)
+{
+  QByteArray frame;
+  if (version == 2) {
+    while (payload.endsWith('\0'))
+      payload.chop(1);
+    frame.append(char(0xfd)).append(char(payload.size())).append(char(isSigned ? 1 : 0)).append(char(0));
+    frame.append(char(42)).append(char(systemId)).append(char(1));
+    frame.append(char(messageId)).append(char(messageId >> 8)).append(char(messageId >> 16));
+  } else {
+    frame.append(char(0xfe)).append(char(payload.size())).append(char(42));
+    frame.append(char(systemId)).append(char(1)).append(char(messageId));
+  }
+  frame.append(payload);
+  quint16 crc = MavlinkParser::crc(frame.constData() + 1, frame.size() - 1);
+  crc = MavlinkParser::crc(&crcExtra, 1, crc);
+  frame.append(char(crc & 0xff)).append(char(crc >> 8));
+  if (isSigned)
+    frame.append(QByteArray(13, char(0x5a)));
+  return frame;
+}
+
+static QByteArray Position(int version, quint8 systemId, double latitude, double longitude, double altitude = 100.0)
+{
+  return Frame(version, systemId, MavlinkParser::GlobalPositionInt, 104,
+               GlobalPositionInt(latitude, longitude, altitude, 3.0, -4.0, 0.5, -1.0));
+}
+
+static QByteArray Heartbeat(int version, quint8 systemId)
+{
+  return Frame(version, systemId, 0, 50, QByteArray("\x00\x00\x00\x00\x02\x03\x51\x04\x03", 9));
+}
+
+void test_MavlinkPositionSource::initTestCase() {
+  qRegisterMetaType<QGeoPositionInfo>();
+  qRegisterMetaType<QGeoPositionInfoSource::Error>();
+}
+
+void test_MavlinkPositionSource::test_crc() {
+  // The check value of CRC-16/MCRF4XX
+  QVERIFY2(MavlinkParser::crc("123456789", 9) == 0x6f91, "check value");
+}
+
+void test_MavlinkPositionSource::test_parser() {
+  QByteArray stream;
+  stream += Position(1, 1, 47.3977419, 8.5455938, 488.0);
+  stream += Heartbeat(1, 1);
+  stream += Position(2, 2, -35.3632621, 149.1652374, 584.09);
+  stream += Heartbeat(2, 2);
+  stream += Frame(2, 3, MavlinkParser::Attitude, 39, Attitude(0.1f, -0.2f, 3.0f), true);
+  stream += Frame(2, 4, MavlinkParser::GlobalPositionInt, 104, GlobalPositionInt(0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0));
+
+  // Whole, and one byte at a time
+  for (int chunk : { int(stream.size()), 1, 7 }) {
+    MavlinkParser parser;
+    QVector<MavlinkFrame> frames;
+    QVector<QByteArray> payloads;
+    for (int i = 0; i < stream.size(); i += chunk) {
+      parser.setData(stream.constData() + i, qMin(chunk, stream.size() - i));
+      MavlinkFrame frame;
+      while (parser.next(&frame)) {
+        frames.append(frame);
+        payloads.append(QByteArray(reinterpret_cast<char const *>(frame.payload), frame.length));
+      }
+    }
+    QVERIFY2(frames.size() == 4 && parser.frames() == 4, "frames");
+    QVERIFY2(parser.skipped() == 2 && parser.errors() == 0, "heartbeats");
+
+    MavlinkFrame frame = frames.at(0);
+    frame.payload = reinterpret_cast<quint8 const *>(payloads.at(0).constData());
+    QVERIFY2(frame.version == 1 && frame.systemId == 1 && frame.sequence == 42, "header");
+    QVERIFY2(frame.int32At(4) == 473977419 && frame.int32At(8) == 85455938 && frame.int32At(12) == 488000, "position");
+    QVERIFY2(frame.int16At(20) == 300 && frame.int16At(22) == -400 && frame.uint16At(26) == 0xffff, "velocity");
+
+    frame = frames.at(1);
+    frame.payload = reinterpret_cast<quint8 const *>(payloads.at(1).constData());
+    QVERIFY2(frame.version == 2 && frame.systemId == 2 && frame.int32At(4) == -353632621, "version 2");
+
+    frame = frames.at(2);
+    frame.payload = reinterpret_cast<quint8 const *>(payloads.at(2).constData());
+    QVERIFY2(frame.messageId == MavlinkParser::Attitude && frame.length == 16, "truncated, signed");
+    QVERIFY2(frame.floatAt(4) == 0.1f && frame.floatAt(8) == -0.2f && frame.floatAt(12) == 3.0f, "attitude");
+    QVERIFY2(frame.floatAt(16) == 0.0f && frame.floatAt(24) == 0.0f, "truncated fields");
+
+    frame = frames.at(3);
+    QVERIFY2(frame.length == 2 && frame.int32At(4) == 0 && frame.uint16At(26) == 0, "zeros truncated");
+  }
+}
+
+void test_MavlinkPositionSource::test_resynchronization() {
+  QByteArray good = Position(2, 1, 10.0, 20.0);
+  QByteArray bad = good;
+  bad[20] = char(bad[20] ^ 0x10);
+  QByteArray stream = QByteArray("\xfe\x03\xfd\x00", 4) + good + bad + Heartbeat(1, 1) + good + good.left(12);
+
+  MavlinkParser parser;
+  int count = 0;
+  for (int i = 0; i < stream.size(); i += 5) {
+    parser.setData(stream.constData() + i, qMin(5, stream.size() - i));
+    MavlinkFrame frame;
+    while (parser.next(&frame))
+      ++count;
+  }
+  QVERIFY2(count == 2, "good frames");
+  QVERIFY2(parser.errors() >= 1, "bad frame");
+}
+
+void test_MavlinkPositionSource::test_file() {
+  // A burst of a swarm: ten messages from each of three vehicles
+  QByteArray log;
+  for (int i = 0; i < 10; ++i) {
+    for (quint8 vehicle = 1; vehicle <= 3; ++vehicle) {
+      log += Position(1 + i % 2, vehicle, 40.0 + vehicle + i * 0.001, -75.0 - vehicle, 100.0 * vehicle);
+      log += Frame(2, vehicle, MavlinkParser::Attitude, 39, Attitude(0.0f, 0.1f * vehicle, float(M_PI_2)));
+    }
+  }
+  QTemporaryFile file;
+  QVERIFY(file.open());
+  file.write(log);
+  file.close();
+
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create("mavlink:" + file.fileName()));
+  MavlinkPositionSource *mavlink = qobject_cast<MavlinkPositionSource *>(source.data());
+  QVERIFY2(mavlink, "mavlink source");
+  GeoEntity first;
+  GeoEntity third;
+  mavlink->setEntity(1, &first);
+  mavlink->setEntity(3, &third);
+  QSignalSpy firstPositions(&first, SIGNAL(positionChanged(QGeoPositionInfo)));
+  QSignalSpy positions(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+  QSignalSpy errors(source.data(), SIGNAL(error(QGeoPositionInfoSource::Error)));
+
+  source->startUpdates();
+  QVERIFY2(errors.wait(1000), "end of the file");
+  QVERIFY2(errors.at(0).at(0).value<QGeoPositionInfoSource::Error>() == QGeoPositionInfoSource::ClosedError, "closed");
+  QVERIFY2(mavlink->parser().frames() == 60, "frames");
+
+  // The whole file was read at once, so the burst is coalesced.
+  QVERIFY2(firstPositions.count() == 1 && positions.count() == 3, "one update per vehicle");
+  QGeoCoordinate coordinate = first.position().coordinate();
+  QVERIFY2(qAbs(coordinate.latitude() - 41.009) < 1e-7 && qAbs(coordinate.longitude() + 76.0) < 1e-7, "last position");
+  QVERIFY2(qAbs(third.position().coordinate().altitude() - 300.0) < 1e-3, "altitude");
+  QVERIFY2(qAbs(first.position().attribute(QGeoPositionInfo::GroundSpeed) - 5.0) < 1e-9, "ground speed");
+  QVERIFY2(qAbs(first.position().attribute(QGeoPositionInfo::Direction) - (360.0 - qRadiansToDegrees(qAtan2(4.0, 3.0)))) < 1e-9, "direction");
+  QVERIFY2(qAbs(first.position().attribute(QGeoPositionInfo::VerticalSpeed) + 0.5) < 1e-9, "climb");
+  QVERIFY2(qAbs(third.rotation()->y() - qRadiansToDegrees(0.3)) < 1e-4 && qAbs(third.rotation()->z() - 90.0) < 1e-4, "attitude");
+  QVERIFY2(mavlink->position(2).isValid() && mavlink->position(2).id == 2, "vehicle without an entity");
+  QVERIFY2(!mavlink->position(4).isValid(), "unknown vehicle");
+}
+
+void test_MavlinkPositionSource::test_pty() {
+  const int master = posix_openpt(O_RDWR | O_NOCTTY);
+  QVERIFY(master >= 0);
+  QVERIFY(grantpt(master) == 0 && unlockpt(master) == 0);
+  const QString slave = QFile::decodeName(ptsname(master));
+
+  MavlinkPositionSource source(slave, 115200);
+  GeoEntity entity;
+  source.setEntity(7, &entity);
+  QSignalSpy positions(&entity, SIGNAL(positionChanged(QGeoPositionInfo)));
+  source.startUpdates();
+  QVERIFY2(source.error() == QGeoPositionInfoSource::NoError, "open");
+
+  // One frame split across two writes
+  QByteArray frame = Position(2, 7, 51.5, -0.12);
+  QVERIFY(::write(master, frame.constData(), 10) == 10);
+  QTest::qWait(20);
+  QVERIFY(::write(master, frame.constData() + 10, frame.size() - 10) == frame.size() - 10);
+  QVERIFY2(positions.wait(1000), "position");
+  QVERIFY2(qAbs(entity.position().coordinate().latitude() - 51.5) < 1e-7, "latitude");
+
+  ::close(master);
+  QSignalSpy errors(&source, SIGNAL(error(QGeoPositionInfoSource::Error)));
+  QVERIFY2(errors.wait(1000), "closed");
+}
+
+void test_MavlinkPositionSource::benchmark_parse() {
+  // A second of a swarm of 50 vehicles at 50 Hz
+  QByteArray stream;
+  for (int i = 0; i < 50; ++i) {
+    for (quint8 vehicle = 1; vehicle <= 50; ++vehicle) {
+      stream += Position(2, vehicle, 40.0, -75.0);
+      stream += Frame(2, vehicle, MavlinkParser::Attitude, 39, Attitude(0.1f, 0.2f, 0.3f));
+    }
+  }
+  MavlinkParser parser;
+  QBENCHMARK {
+    parser.setData(stream.constData(), stream.size());
+    MavlinkFrame frame;
+    while (parser.next(&frame))
+      ;
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_MavlinkPositionSource : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void test_crc();
+  void test_parser();
+  void test_resynchronization();
+  void test_file();
+  void test_pty();
+  void benchmark_parse();
+};
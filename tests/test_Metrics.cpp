@@ -0,0 +1,170 @@
+#include <QThread>
+#include <QDir>
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include "Metrics.hpp"
+#include "MetricsServer.hpp"
+#include "test_Metrics.hpp"
+
+// Send a request and read the response up to the end of the
+// connection.
+static
+QByteArray Scrape(QIODevice *socket, QByteArray const &request)
+{
+  socket->write(request);
+  QByteArray response;
+  for (int i = 0; i < 50 && socket->isOpen(); ++i) {
+    if (QTcpSocket *tcpSocket = qobject_cast<QTcpSocket *>(socket)) {
+      tcpSocket->waitForReadyRead(100);
+      response += tcpSocket->readAll();
+      if (tcpSocket->state() == QAbstractSocket::UnconnectedState)
+        break;
+    } else if (QLocalSocket *localSocket = qobject_cast<QLocalSocket *>(socket)) {
+      localSocket->waitForReadyRead(100);
+      response += localSocket->readAll();
+      if (localSocket->state() == QLocalSocket::UnconnectedState)
+        break;
+    }
+  }
+  return response;
+}
+
+void test_Metrics::test_counter() {
+  Metrics metrics;
+  MetricCounter *counter = metrics.counter("test_events_total", "Events.");
+  QVERIFY2(counter->value() == 0, "zero");
+  counter->increment();
+  counter->add(41);
+  QVERIFY2(counter->value() == 42, "added");
+  QVERIFY2(metrics.counter("test_events_total", "Events.") == counter, "same metric");
+  QVERIFY2(metrics.counter("test_events_total", "Events.", "source=\"a\"") != counter, "labeled");
+
+  // Counted from several threads at once, nothing is lost.
+  QVector<QThread *> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.append(QThread::create([counter]() {
+          for (int n = 0; n < 100000; ++n)
+            counter->increment();
+        }));
+    threads.last()->start();
+  }
+  for (QThread *thread : threads) {
+    thread->wait();
+    delete thread;
+  }
+  QVERIFY2(counter->value() == 42 + 800000, "threads");
+}
+
+void test_Metrics::test_gauge() {
+  Metrics metrics;
+  MetricGauge *gauge = metrics.gauge("test_depth", "Depth.");
+  QVERIFY2(gauge->value() == 0.0, "zero");
+  gauge->set(2.5);
+  gauge->add(-1.0);
+  gauge->add(10.0);
+  QVERIFY2(gauge->value() == 11.5, "set and added");
+}
+
+void test_Metrics::test_histogram() {
+  Metrics metrics;
+  MetricHistogram *histogram = metrics.histogram("test_seconds", "Time.");
+  QVERIFY2(histogram->histogram().count() == 0, "empty");
+
+  // Each thread records into a histogram of its own; they are added
+  // up when read.
+  QVector<QThread *> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.append(QThread::create([histogram]() {
+          for (qint64 value = 1; value <= 1000; ++value)
+            histogram->record(value * 1000);
+        }));
+    threads.last()->start();
+  }
+  for (QThread *thread : threads) {
+    thread->wait();
+    delete thread;
+  }
+  histogram->record(2000000);
+  const LatencyHistogram h = histogram->histogram();
+  QVERIFY2(h.count() == 4001, "count");
+  QVERIFY2(h.maximum() == 2000000, "maximum");
+  QVERIFY2(qAbs(h.percentile(0.5) - 500000) < 5000, "median");
+}
+
+void test_Metrics::test_exposition() {
+  Metrics metrics;
+  metrics.counter("test_positions_total", "Positions.", "source=\"observer\"")->add(3);
+  metrics.gauge("test_depth", "Depth.")->set(7);
+  metrics.counter("test_positions_total", "Positions.", "source=\"target\"")->add(5);
+  MetricHistogram *histogram = metrics.histogram("test_seconds", "Time.");
+  histogram->record(1000000);
+  histogram->record(3000000);
+
+  // The metrics of one name are together, under one HELP and TYPE.
+  const QByteArray text = metrics.exposition();
+  const QByteArray counters = "# HELP test_positions_total Positions.\n"
+    "# TYPE test_positions_total counter\n"
+    "test_positions_total{source=\"observer\"} 3\n"
+    "test_positions_total{source=\"target\"} 5\n";
+  QVERIFY2(text.startsWith(counters), text.constData());
+  QVERIFY2(text.contains("# TYPE test_depth gauge\ntest_depth 7\n"), "gauge");
+  QVERIFY2(text.contains("# TYPE test_seconds summary\n"), "summary");
+  QVERIFY2(text.contains("test_seconds{quantile=\"0.999\"} 0.003"), "quantile");
+  QVERIFY2(text.contains("test_seconds_sum 0.004\n"), "sum");
+  QVERIFY2(text.contains("test_seconds_count 2\n"), "count");
+  QVERIFY2(text.count("# HELP") == 3, "once per name");
+}
+
+void test_Metrics::test_tcpServer() {
+  Metrics metrics;
+  metrics.counter("test_scrapes_total", "Scrapes.")->add(12);
+  MetricsServer server(&metrics);
+  QVERIFY2(server.listen("localhost:0"), qPrintable(server.errorString()));
+  QVERIFY2(server.address().startsWith("localhost:"), qPrintable(server.address()));
+  const quint16 port = server.address().mid(10).toUShort();
+  QVERIFY2(port != 0, "port");
+
+  QTcpSocket socket;
+  socket.connectToHost(QHostAddress::LocalHost, port);
+  QVERIFY2(socket.waitForConnected(1000), "connected");
+  QByteArray response = Scrape(&socket, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  QVERIFY2(response.startsWith("HTTP/1.0 200 OK\r\n"), response.constData());
+  QVERIFY2(response.contains("text/plain; version=0.0.4"), "content type");
+  QVERIFY2(response.endsWith("test_scrapes_total 12\n"), response.constData());
+
+  // Anything but GET and HEAD is refused.
+  QTcpSocket other;
+  other.connectToHost(QHostAddress::LocalHost, port);
+  QVERIFY2(other.waitForConnected(1000), "connected");
+  response = Scrape(&other, "POST /metrics HTTP/1.1\r\n\r\n");
+  QVERIFY2(response.startsWith("HTTP/1.0 405"), response.constData());
+  QVERIFY2(server.requests() == 2, "requests");
+
+  QVERIFY2(!server.listen("localhost:http-alt"), "bad address");
+  server.close();
+  QVERIFY2(server.address().isEmpty(), "closed");
+}
+
+void test_Metrics::test_localServer() {
+  Metrics metrics;
+  metrics.gauge("test_depth", "Depth.")->set(3);
+  const QString path = QDir::temp().filePath(QString("test_Metrics.%1").arg(QCoreApplication::applicationPid()));
+  MetricsServer server(&metrics);
+  QVERIFY2(server.listen("unix:" + path), qPrintable(server.errorString()));
+
+  QLocalSocket socket;
+  socket.connectToServer(path);
+  QVERIFY2(socket.waitForConnected(1000), "connected");
+  const QByteArray response = Scrape(&socket, "GET / HTTP/1.0\n\n");
+  QVERIFY2(response.startsWith("HTTP/1.0 200 OK\r\n"), response.constData());
+  QVERIFY2(response.endsWith("test_depth 3\n"), response.constData());
+}
+
+void test_Metrics::benchmark_counter() {
+  Metrics metrics;
+  MetricCounter *counter = metrics.counter("test_events_total", "Events.");
+  QBENCHMARK {
+    for (int i = 0; i < 1000; ++i)
+      counter->increment();
+  }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_Metrics : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_counter();
+  void test_gauge();
+  void test_histogram();
+  void test_exposition();
+  void test_tcpServer();
+  void test_localServer();
+  void benchmark_counter();
+};
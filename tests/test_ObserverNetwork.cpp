@@ -0,0 +1,202 @@
+#include <QtMath>
+#include <QDateTime>
+#include "ObserverNetwork.hpp"
+#include "GeoEntity.hpp"
+#include "LookAngle.hpp"
+#include "test_ObserverNetwork.hpp"
+
+// Remembers the last look angles of a network
+class NetworkRecorder
+{
+public:
+  NetworkRecorder() :
+    calls(0)
+  {
+  }
+
+  void onLookAngles(NetworkLookAngles const &lookAngles)
+  {
+    last = lookAngles;
+    ++calls;
+  }
+
+  NetworkLookAngles last;
+  int calls;
+};
+
+// Observers spread over the globe, some high above it
+static
+QVector<QGeoCoordinate> Stations(int count)
+{
+  QVector<QGeoCoordinate> stations;
+  for (int i = 0; i < count; ++i)
+    stations.append(QGeoCoordinate(-80.0 + 160.0 * ((i * 37) % 101) / 100.0,
+                                   -179.0 + 358.0 * ((i * 53) % 97) / 96.0,
+                                   (i % 5) * 1500.0));
+  return stations;
+}
+
+static
+double AngleDifference(double a, double b)
+{
+  const double difference = qAbs(a - b);
+  return qMin(difference, 360.0 - difference);
+}
+
+static
+bool Agrees(ObserverNetwork const &network, QVector<QGeoCoordinate> const &stations,
+            QGeoCoordinate const &target, Refraction const &refraction)
+{
+  for (int i = 0; i < stations.size(); ++i) {
+    const LookAngle expected(stations.at(i), target, refraction);
+    const LookAngle actual = network.lookAngle(i);
+    if (AngleDifference(actual.azimuth(), expected.azimuth()) > 1e-4 ||
+        qAbs(actual.elevation() - expected.elevation()) > 1e-4) {
+      qDebug() << "observer" << i << "azimuth" << actual.azimuth() << expected.azimuth()
+               << "elevation" << actual.elevation() << expected.elevation();
+      return false;
+    }
+  }
+  return true;
+}
+
+void test_ObserverNetwork::test_agreesWithLookAngle()
+{
+  // An odd number, so that the last observer is not in a pair
+  const QVector<QGeoCoordinate> stations = Stations(101);
+  ObserverNetwork network;
+  for (QGeoCoordinate const &station : stations)
+    network.addObserver(station);
+  QVERIFY2(network.count() == stations.size(), "count");
+
+  const QVector<QGeoCoordinate> targets = {
+    QGeoCoordinate(39.0, -76.0, 12000.0),
+    QGeoCoordinate(-33.9, 151.2, 400000.0),
+    QGeoCoordinate(0.0, 0.0, 35786000.0),
+    QGeoCoordinate(89.9, 10.0, 0.0)
+  };
+  for (QGeoCoordinate const &target : targets) {
+    network.calculate(target);
+    QVERIFY2(Agrees(network, stations, target, Refraction()), "agrees with LookAngle");
+  }
+
+  // In float, for observers within 1000 km of the first
+  network.setPrecision(ObserverNetwork::SinglePrecision);
+  network.clear();
+  const QGeoCoordinate centre(45.0, 10.0, 200.0);
+  QVector<QGeoCoordinate> regional;
+  for (int i = 0; i < 33; ++i)
+    regional.append(QGeoCoordinate(centre.latitude() + (i % 7 - 3) * 0.5,
+                                   centre.longitude() + (i % 5 - 2) * 0.5,
+                                   (i % 3) * 300.0));
+  for (QGeoCoordinate const &station : regional)
+    network.addObserver(station);
+  const QGeoCoordinate aircraft(46.0, 11.0, 10000.0);
+  network.calculate(aircraft);
+  for (int i = 0; i < regional.size(); ++i) {
+    const LookAngle expected(regional.at(i), aircraft);
+    // The azimuth of a target overhead means little
+    QVERIFY2(expected.elevation() > 89.0 ||
+             AngleDifference(network.lookAngle(i).azimuth(), expected.azimuth()) < 1e-2, "float azimuth");
+    QVERIFY2(qAbs(network.lookAngle(i).elevation() - expected.elevation()) < 1e-2, "float elevation");
+  }
+
+  const NetworkLookAngles lookAngles = network.lookAngles();
+  QVERIFY2(lookAngles.count == regional.size(), "look angles of every observer");
+  QVERIFY2(lookAngles.range[0] > 0.0, "range");
+}
+
+void test_ObserverNetwork::test_refraction()
+{
+  const QVector<QGeoCoordinate> stations = Stations(40);
+  ObserverNetwork network;
+  for (QGeoCoordinate const &station : stations)
+    network.addObserver(station);
+  const QGeoCoordinate target(10.0, 20.0, 20000.0);
+
+  for (Refraction::Model model : { Refraction::FourThirdsEarth, Refraction::Bennett }) {
+    const Refraction refraction(model);
+    network.setRefraction(refraction);
+    network.calculate(target);
+    QVERIFY2(Agrees(network, stations, target, refraction), "agrees with LookAngle when refracted");
+  }
+}
+
+void test_ObserverNetwork::test_removeObserver()
+{
+  const QVector<QGeoCoordinate> stations = Stations(5);
+  ObserverNetwork network;
+  for (QGeoCoordinate const &station : stations)
+    network.addObserver(station);
+
+  network.removeObserver(1);
+  QVERIFY2(network.count() == 4, "removed");
+  QVERIFY2(network.observerPosition(1) == stations.at(4), "the last took its index");
+
+  // A moved observer is calculated from its new position
+  const QGeoCoordinate moved(51.5, -0.1, 50.0);
+  network.setObserverPosition(0, moved);
+  const QGeoCoordinate target(48.9, 2.3, 10000.0);
+  network.calculate(target);
+  const LookAngle expected(moved, target);
+  QVERIFY2(qAbs(network.lookAngle(0).azimuth() - expected.azimuth()) < 1e-4, "moved observer azimuth");
+  QVERIFY2(qAbs(network.lookAngle(0).elevation() - expected.elevation()) < 1e-4, "moved observer elevation");
+
+  network.clear();
+  QVERIFY2(network.count() == 0, "cleared");
+  network.calculate(target);
+}
+
+void test_ObserverNetwork::test_target()
+{
+  const QVector<QGeoCoordinate> stations = Stations(8);
+  ObserverNetwork network;
+  for (QGeoCoordinate const &station : stations)
+    network.addObserver(station);
+  NetworkRecorder recorder;
+  NetworkLookAnglesListener listener;
+  listener.bind<NetworkRecorder, &NetworkRecorder::onLookAngles>(&recorder);
+  network.addLookAnglesListener(&listener);
+
+  GeoEntity target;
+  network.setTarget(&target);
+  QVERIFY2(recorder.calls == 0, "no position yet");
+
+  const QDateTime time = QDateTime::fromMSecsSinceEpoch(1600000000000, Qt::UTC);
+  const QGeoCoordinate coordinate(20.0, 30.0, 9000.0);
+  target.setPosition(QGeoPositionInfo(coordinate, time));
+  QVERIFY2(recorder.calls == 1, "the target moved");
+  QVERIFY2(recorder.last.count == stations.size(), "every observer");
+  QVERIFY2(recorder.last.timestamp == time.toMSecsSinceEpoch(), "timestamp of the target");
+  QVERIFY2(Agrees(network, stations, coordinate, Refraction()), "look angles to the target");
+
+  network.setTarget(nullptr);
+  target.setPosition(QGeoPositionInfo(coordinate, time));
+  QVERIFY2(recorder.calls == 1, "no longer followed");
+}
+
+void test_ObserverNetwork::test_benchmarkNetwork()
+{
+  const QVector<QGeoCoordinate> stations = Stations(1000);
+  ObserverNetwork network;
+  for (QGeoCoordinate const &station : stations)
+    network.addObserver(station);
+  const QGeoCoordinate target(10.0, 20.0, 400000.0);
+
+  QBENCHMARK {
+    network.calculate(target);
+  }
+}
+
+void test_ObserverNetwork::test_benchmarkLookAngles()
+{
+  // The same, an observer at a time
+  const QVector<QGeoCoordinate> stations = Stations(1000);
+  const QGeoCoordinate target(10.0, 20.0, 400000.0);
+  QVector<LookAngle> lookAngles(stations.size());
+
+  QBENCHMARK {
+    for (int i = 0; i < stations.size(); ++i)
+      lookAngles[i].setLookAngle(stations.at(i), target);
+  }
+}
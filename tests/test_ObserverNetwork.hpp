@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_ObserverNetwork : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_agreesWithLookAngle();
+  void test_refraction();
+  void test_removeObserver();
+  void test_target();
+  void test_benchmarkNetwork();
+  void test_benchmarkLookAngles();
+};
@@ -0,0 +1,138 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QGeoCoordinate>
+#include <cstring>
+#include "OutputSink.hpp"
+#include "test_OutputSink.hpp"
+
+static
+QByteArray Formatted(OutputFormat const &format, OutputRecord const &record)
+{
+  QByteArray out;
+  format.format(record, &out);
+  return out;
+}
+
+static
+QString TemporaryPath(char const *name)
+{
+  return QDir::temp().filePath(QString("test_OutputSink.%1.%2").arg(QCoreApplication::applicationPid()).arg(name));
+}
+
+void test_OutputSink::test_text() {
+  // The lines target-tracker has always printed
+  TextOutputFormat format;
+  QVERIFY2(format.header().isEmpty(), "no header");
+  const OutputRecord observer = OutputRecord::position(OutputRecord::ObserverPosition, 0, 38.5, -77.25, 10.0);
+  QVERIFY2(Formatted(format, observer) == "   observer's location: "
+           + QGeoCoordinate(38.5, -77.25, 10.0).toString().toUtf8() + "\n", "observer");
+  const OutputRecord target = OutputRecord::position(OutputRecord::TargetPosition, 0, 38.5, -77.25, qQNaN());
+  QVERIFY2(Formatted(format, target) == "     target's location: "
+           + QGeoCoordinate(38.5, -77.25).toString().toUtf8() + "\n", "target");
+  QVERIFY2(Formatted(format, OutputRecord::lookAngle(0, 123.5f, -4.25f))
+           == "     azimuth to target: 123.5\n   elevation to target: -4.25\n", "look angle");
+}
+
+void test_OutputSink::test_csv() {
+  CsvOutputFormat format;
+  QVERIFY2(format.header() == "kind,timestamp,latitude,longitude,altitude,azimuth,elevation\n", "header");
+  QVERIFY2(Formatted(format, OutputRecord::position(OutputRecord::TargetPosition, 1500, 38.5, -77.25, qQNaN()))
+           == "target,1500,38.50000000,-77.25000000,,,\n", "position");
+  QVERIFY2(Formatted(format, OutputRecord::lookAngle(1600, 90.0, 45.5))
+           == "look_angle,1600,,,,90.000000,45.500000\n", "look angle");
+}
+
+void test_OutputSink::test_ndjson() {
+  NdjsonOutputFormat format;
+  QVERIFY2(Formatted(format, OutputRecord::position(OutputRecord::ObserverPosition, 1500, 1.0, 2.0, qQNaN()))
+           == "{\"kind\":\"observer\",\"timestamp\":1500,\"latitude\":1.00000000,"
+              "\"longitude\":2.00000000,\"altitude\":null}\n", "position");
+  QVERIFY2(Formatted(format, OutputRecord::lookAngle(1600, 90.0, 45.5))
+           == "{\"kind\":\"look_angle\",\"timestamp\":1600,\"azimuth\":90.000000,\"elevation\":45.500000}\n", "look angle");
+}
+
+void test_OutputSink::test_binary() {
+  BinaryOutputFormat format;
+  const QByteArray header = format.header();
+  QVERIFY2(header.size() == BinaryOutputFormat::HeaderSize && header.startsWith("GTRK") && header.at(4) == 1, "header");
+
+  const QByteArray out = Formatted(format, OutputRecord::lookAngle(Q_INT64_C(1600000000000), 90.0, 45.5));
+  QVERIFY2(out.size() == BinaryOutputFormat::RecordSize, "size");
+  uchar const *data = reinterpret_cast<uchar const *>(out.constData());
+  QVERIFY2(qFromLittleEndian<qint64>(data) == Q_INT64_C(1600000000000), "timestamp");
+  QVERIFY2(qFromLittleEndian<quint32>(data + 8) == OutputRecord::LookAngle, "kind");
+  quint64 bits = qFromLittleEndian<quint64>(data + 16 + 3 * 8);
+  double azimuth;
+  memcpy(&azimuth, &bits, sizeof(azimuth));
+  QVERIFY2(azimuth == 90.0, "azimuth");
+  bits = qFromLittleEndian<quint64>(data + 16);
+  double latitude;
+  memcpy(&latitude, &bits, sizeof(latitude));
+  QVERIFY2(qIsNaN(latitude), "latitude");
+}
+
+void test_OutputSink::test_sink() {
+  const QString path = TemporaryPath("csv");
+  OutputSink sink(new CsvOutputFormat);
+  QVERIFY2(!sink.isOpen(), "closed");
+  QVERIFY2(sink.open(path), qPrintable(sink.errorString()));
+  for (int i = 0; i < 5000; ++i)
+    sink.write(OutputRecord::lookAngle(i, i % 360, 10.0));
+
+  // Flushed, everything queued is in the file.
+  sink.flush();
+  QVERIFY2(sink.written() + sink.dropped() == 5000, "accounted");
+  QFile file(path);
+  QVERIFY2(file.open(QIODevice::ReadOnly), "file");
+  QByteArray contents = file.readAll();
+  QVERIFY2(contents.startsWith(CsvOutputFormat().header()), "header");
+  QVERIFY2(contents.count('\n') == 1 + int(sink.written()), "lines");
+
+  // Unflushed records are written out on close.
+  sink.write(OutputRecord::lookAngle(5000, 0.0, 0.0));
+  sink.close();
+  QVERIFY2(!sink.isOpen(), "closed again");
+  file.seek(0);
+  contents = file.readAll();
+  QVERIFY2(contents.endsWith("look_angle,5000,,,,0.000000,0.000000\n"), "closed");
+
+  // Nothing is written once closed.
+  const quint64 dropped = sink.dropped();
+  sink.write(OutputRecord::lookAngle(5001, 0.0, 0.0));
+  QVERIFY2(sink.dropped() == dropped + 1, "dropped");
+  file.close();
+  QFile::remove(path);
+
+  QVERIFY2(!sink.open(QDir::temp().filePath("no/such/directory/output")), "no file");
+}
+
+void test_OutputSink::test_full() {
+  // A small queue, filled faster than it is written, drops rather
+  // than waits.
+  const QString path = TemporaryPath("bin");
+  OutputSink sink(new BinaryOutputFormat, 16);
+  sink.setFlushInterval(1000);
+  QVERIFY2(sink.open(path), qPrintable(sink.errorString()));
+  for (int i = 0; i < 1000; ++i)
+    sink.write(OutputRecord::lookAngle(i, 0.0, 0.0));
+  sink.close();
+  QVERIFY2(sink.dropped() > 0, "dropped");
+  QVERIFY2(sink.written() + sink.dropped() == 1000, "accounted");
+  QVERIFY2(QFileInfo(path).size() == BinaryOutputFormat::HeaderSize
+           + BinaryOutputFormat::RecordSize * qint64(sink.written()), "size");
+  QFile::remove(path);
+}
+
+void test_OutputSink::benchmark_write() {
+  OutputSink sink(new NdjsonOutputFormat);
+  QVERIFY2(sink.open(TemporaryPath("ndjson")), qPrintable(sink.errorString()));
+  QBENCHMARK {
+    for (int i = 0; i < 1000; ++i)
+      sink.write(OutputRecord::lookAngle(i, 45.0, 10.0));
+    sink.flush();
+  }
+  sink.close();
+  QFile::remove(TemporaryPath("ndjson"));
+}
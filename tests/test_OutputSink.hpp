@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_OutputSink : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_text();
+  void test_csv();
+  void test_ndjson();
+  void test_binary();
+  void test_sink();
+  void test_full();
+  void benchmark_write();
+};
@@ -0,0 +1,204 @@
+#include <cstring>
+#include <QtMath>
+#include <QUdpSocket>
+#include <QScopedPointer>
+#include "GeoEntityDispatcher.hpp"
+#include "data-sources/PositionSampleParser.hpp"
+#include "data-sources/UdpPositionSource.hpp"
+#include "test_PositionSampleParser.hpp"
+
+// Examples from the NMEA and gpsd documentation
+static const char *Rmc = "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A";
+static const char *Gga = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+static const char *Tpv =
+  "{\"class\":\"TPV\",\"device\":\"/dev/pts/1\",\"time\":\"2005-06-08T10:34:48.283Z\","
+  "\"ept\":0.005,\"lat\":46.498293369,\"lon\":7.567411672,\"alt\":1343.127,\"eph\":36.000,"
+  "\"epv\":32.321,\"track\":10.3788,\"speed\":0.091,\"climb\":-0.085,\"mode\":3}";
+
+static bool Parse(PositionSampleParser &parser, char const *line, PositionSample *sample)
+{
+  return parser.parse(line, line + strlen(line), sample);
+}
+
+// An NMEA sentence with its checksum
+static QByteArray Nmea(QByteArray const &body)
+{
+  unsigned char sum = 0;
+  for (char c : body)
+    sum ^= static_cast<unsigned char>(c);
+  return "$" + body + "*" + QByteArray::number(sum, 16).rightJustified(2, '0').toUpper();
+}
+
+void test_PositionSampleParser::initTestCase() {
+  qRegisterMetaType<QGeoPositionInfo>();
+}
+
+void test_PositionSampleParser::test_nmea() {
+  PositionSampleParser parser;
+  parser.setDefaultId(7);
+  PositionSample sample;
+
+  QVERIFY2(Parse(parser, Rmc, &sample), "RMC");
+  QVERIFY2(sample.id == 7, "default id");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(1994, 3, 23), QTime(12, 35, 19), Qt::UTC).toMSecsSinceEpoch(), "RMC time");
+  QVERIFY2(qAbs(sample.latitude - (48.0 + 7.038 / 60.0)) < 1e-12, "RMC latitude");
+  QVERIFY2(qAbs(sample.longitude - (11.0 + 31.0 / 60.0)) < 1e-12, "RMC longitude");
+  QVERIFY2(qAbs(sample.groundSpeed - 22.4 * 1852.0 / 3600.0) < 1e-12, "RMC speed");
+  QVERIFY2(sample.direction == 84.4, "RMC course");
+  QVERIFY2(qIsNaN(sample.altitude), "RMC altitude");
+
+  // The GGA takes its date from the RMC
+  QVERIFY2(Parse(parser, Gga, &sample), "GGA");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(1994, 3, 23), QTime(12, 35, 19), Qt::UTC).toMSecsSinceEpoch(), "GGA time");
+  QVERIFY2(sample.altitude == 545.4, "GGA altitude");
+  QVERIFY2(qIsNaN(sample.groundSpeed), "GGA speed");
+
+  // Other talkers, southern and western hemispheres
+  QVERIFY2(Parse(parser, Nmea("GNGGA,000000.50,3351.000,S,15112.000,W,2,08,0.9,-10.5,M,,M,,"), &sample), "GNGGA");
+  QVERIFY2(qAbs(sample.latitude + 33.85) < 1e-12 && qAbs(sample.longitude + 151.2) < 1e-12, "hemispheres");
+  QVERIFY2(sample.altitude == -10.5, "negative altitude");
+  QVERIFY2(sample.timestamp % 86400000 == 500, "fraction of a second");
+
+  // Invalid fixes and other sentences
+  QVERIFY2(!Parse(parser, Nmea("GPGGA,123519,4807.038,N,01131.000,E,0,00,,,M,,M,,"), &sample), "no fix");
+  QVERIFY2(!Parse(parser, Nmea("GPRMC,123519,V,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W"), &sample), "void");
+  QVERIFY2(!Parse(parser, Nmea("GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00"), &sample), "GSV");
+}
+
+void test_PositionSampleParser::test_nmeaChecksum() {
+  PositionSampleParser parser;
+  PositionSample sample;
+  QVERIFY2(Parse(parser, QByteArray(Rmc).replace("*6A", "*6a"), &sample), "lower case checksum");
+  QVERIFY2(!Parse(parser, QByteArray(Gga).replace("*47", "*48"), &sample), "bad checksum");
+  QVERIFY2(!Parse(parser, QByteArray(Gga).replace("4807.038", "4807.039"), &sample), "corrupt sentence");
+  QVERIFY2(!Parse(parser, QByteArray(Gga).replace("*47", "*4"), &sample), "short checksum");
+  QVERIFY2(Parse(parser, QByteArray(Gga).replace("*47", ""), &sample), "no checksum");
+}
+
+void test_PositionSampleParser::test_nmeaMidnight() {
+  PositionSampleParser parser;
+  PositionSample sample;
+  QVERIFY(Parse(parser, Nmea("GPRMC,235959,A,4807.038,N,01131.000,E,0,0,311299,,"), &sample));
+  QVERIFY(Parse(parser, Nmea("GPGGA,235959.9,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,"), &sample));
+  QVERIFY2(sample.timestamp == QDateTime(QDate(1999, 12, 31), QTime(23, 59, 59, 900), Qt::UTC).toMSecsSinceEpoch(), "before midnight");
+  QVERIFY(Parse(parser, Nmea("GPGGA,000000.1,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,"), &sample));
+  QVERIFY2(sample.timestamp == QDateTime(QDate(2000, 1, 1), QTime(0, 0, 0, 100), Qt::UTC).toMSecsSinceEpoch(), "after midnight");
+
+  // Without a date, today's
+  PositionSampleParser undated;
+  QVERIFY(Parse(undated, Gga, &sample));
+  QVERIFY2(qAbs(sample.timestamp - QDateTime::currentMSecsSinceEpoch()) <= 43200000, "today");
+}
+
+void test_PositionSampleParser::test_gpsd() {
+  PositionSampleParser parser;
+  PositionSample sample;
+  QVERIFY2(Parse(parser, Tpv, &sample), "TPV");
+  QVERIFY2(sample.id == PositionSampleParser::hash("/dev/pts/1", 10), "device id");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(2005, 6, 8), QTime(10, 34, 48, 283), Qt::UTC).toMSecsSinceEpoch(), "time");
+  QVERIFY2(sample.latitude == 46.498293369 && sample.longitude == 7.567411672, "position");
+  QVERIFY2(sample.altitude == 1343.127, "altitude");
+  QVERIFY2(sample.groundSpeed == 0.091 && sample.direction == 10.3788 && sample.verticalSpeed == -0.085, "velocity");
+  QVERIFY2(sample.horizontalAccuracy == 36.0 && sample.verticalAccuracy == 32.321, "accuracy");
+
+  // Nested members are skipped, and the order does not matter.
+  QVERIFY2(Parse(parser,
+                 "{ \"mode\" : 2, \"lat\" : -1.5e1, \"ecef\" : {\"x\":1, \"y\":[2, \"}\"]}, "
+                 "\"lon\" : 2.5E+1, \"alt\" : 100, \"epx\":3.0, \"epy\":4.0, \"class\" : \"TPV\" }",
+                 &sample), "2D fix");
+  QVERIFY2(sample.latitude == -15.0 && sample.longitude == 25.0, "2D position");
+  QVERIFY2(qIsNaN(sample.altitude), "no altitude without a 3D fix");
+  QVERIFY2(sample.horizontalAccuracy == 4.0, "epx, epy");
+
+  QVERIFY2(!Parse(parser, "{\"class\":\"TPV\",\"device\":\"/dev/pts/1\",\"mode\":1}", &sample), "no fix");
+  QVERIFY2(!Parse(parser, "{\"class\":\"SKY\",\"device\":\"/dev/pts/1\",\"lat\":1,\"lon\":2,\"mode\":3}", &sample), "SKY");
+  QVERIFY2(!Parse(parser, "{\"class\":\"TPV\",\"lat\":1,\"lon\":2,\"mode\":3", &sample), "truncated");
+}
+
+void test_PositionSampleParser::test_log() {
+  PositionSampleParser parser;
+  PositionSample sample;
+  QVERIFY2(Parse(parser, "2009-08-24T22:24:37Z -27.572321 153.090718 1180.0", &sample), "UTC");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(2009, 8, 24), QTime(22, 24, 37), Qt::UTC).toMSecsSinceEpoch(), "UTC time");
+  QVERIFY2(sample.latitude == -27.572321 && sample.longitude == 153.090718 && sample.altitude == 1180.0, "position");
+
+  QVERIFY2(Parse(parser, "2009-08-24T22:24:37.250+10:00 -27.572321 153.090718 1180.0", &sample), "time zone");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(2009, 8, 24), QTime(12, 24, 37, 250), Qt::UTC).toMSecsSinceEpoch(), "time zone time");
+
+  // As LogFilePositionSource, local time without a time zone
+  QVERIFY2(Parse(parser, "2009-08-24T22:24:37 -27.572321 153.090718 1180.0\r", &sample), "local");
+  QVERIFY2(sample.timestamp == QDateTime(QDate(2009, 8, 24), QTime(22, 24, 37), Qt::LocalTime).toMSecsSinceEpoch(), "local time");
+
+  QVERIFY2(!Parse(parser, "not a position", &sample), "text");
+  QVERIFY2(!Parse(parser, "2009-08-24T22:24:37 -27.572321 153.090718", &sample), "no altitude");
+  QVERIFY2(!Parse(parser, "2009-13-24T22:24:37 -27.572321 153.090718 1180.0", &sample), "bad date");
+  QVERIFY2(!Parse(parser, "2009-08-24T22:24:37 -97.5 153.090718 1180.0", &sample), "bad latitude");
+  QVERIFY2(!Parse(parser, "", &sample), "empty");
+}
+
+void test_PositionSampleParser::test_udpLoopback() {
+  // Find a free port
+  QUdpSocket probe;
+  QVERIFY(probe.bind(QHostAddress::LocalHost, 0));
+  const quint16 port = probe.localPort();
+  probe.close();
+
+  UdpPositionSource source(QHostAddress::LocalHost, port);
+  GeoEntityDispatcher dispatcher;
+  dispatcher.setCreatesEntities(true);
+  source.setSampleSink(&dispatcher);
+  QList<GeoEntity *> entities;
+  connect(&dispatcher, &GeoEntityDispatcher::entityCreated, [&entities](quint64, GeoEntity *entity) {
+      entities.append(entity);
+    });
+  source.startUpdates();
+  QVERIFY2(source.error() == QGeoPositionInfoSource::NoError, "bound");
+
+  // Two NMEA senders, each flying north one minute of arc per
+  // second, and a gpsd daemon with two devices.
+  const int Count = 50;
+  QUdpSocket first;
+  QUdpSocket second;
+  QVERIFY(first.bind(QHostAddress::LocalHost, 0) && second.bind(QHostAddress::LocalHost, 0));
+  for (int i = 0; i < Count; ++i) {
+    const QByteArray time = QByteArray::number(100000 + i);
+    first.writeDatagram(Nmea("GPGGA," + time + ",10" + QByteArray::number(i).rightJustified(2, '0') + ".000,N,02000.000,E,1,08,0.9,100.0,M,,M,,"),
+                        QHostAddress::LocalHost, port);
+    second.writeDatagram(Nmea("GPGGA," + time + ",30" + QByteArray::number(i).rightJustified(2, '0') + ".000,S,04000.000,W,1,08,0.9,100.0,M,,M,,"),
+                         QHostAddress::LocalHost, port);
+  }
+  first.writeDatagram("{\"class\":\"TPV\",\"device\":\"/dev/ttyUSB0\",\"time\":\"2024-01-01T00:00:01Z\",\"lat\":1,\"lon\":2,\"mode\":2}\n"
+                      "{\"class\":\"TPV\",\"device\":\"/dev/ttyUSB1\",\"time\":\"2024-01-01T00:00:01Z\",\"lat\":3,\"lon\":4,\"mode\":2}\n",
+                      QHostAddress::LocalHost, port);
+
+  QTRY_VERIFY_WITH_TIMEOUT(dispatcher.samples() == quint64(2 * Count + 2), 5000);
+  QVERIFY2(source.datagrams() == quint64(2 * Count + 1), "datagrams");
+  QVERIFY2(dispatcher.count() == 4 && entities.size() == 4, "entities");
+  QVERIFY2(dispatcher.updates() <= dispatcher.samples(), "at most one update per sample");
+  QVERIFY2(dispatcher.entity(PositionSampleParser::hash("/dev/ttyUSB1", 12))->position().coordinate().latitude() == 3.0, "gpsd device");
+
+  // Each entity ends at the last position of its sender
+  int atEnd = 0;
+  for (GeoEntity *entity : entities) {
+    QGeoCoordinate coordinate = entity->position().coordinate();
+    if (qAbs(coordinate.latitude() - (10.0 + (Count - 1) / 60.0)) < 1e-9 && coordinate.longitude() == 20.0)
+      ++atEnd;
+    if (qAbs(coordinate.latitude() + (30.0 + (Count - 1) / 60.0)) < 1e-9 && coordinate.longitude() == -40.0)
+      ++atEnd;
+  }
+  QVERIFY2(atEnd == 2, "last positions");
+  source.stopUpdates();
+}
+
+void test_PositionSampleParser::benchmark_parse() {
+  QByteArray lines[3] = { Nmea("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,"), Tpv,
+                          "2009-08-24T22:24:37Z -27.572321 153.090718 1180.0" };
+  PositionSampleParser parser;
+  PositionSample sample;
+  QBENCHMARK {
+    for (int i = 0; i < 3000; ++i) {
+      QByteArray const &line = lines[i % 3];
+      parser.parse(line.constData(), line.constData() + line.size(), &sample);
+    }
+  }
+}
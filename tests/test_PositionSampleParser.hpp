@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QTest>
+
+class test_PositionSampleParser : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void test_nmea();
+  void test_nmeaChecksum();
+  void test_nmeaMidnight();
+  void test_gpsd();
+  void test_log();
+  void test_udpLoopback();
+  void benchmark_parse();
+};
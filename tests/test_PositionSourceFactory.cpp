@@ -0,0 +1,121 @@
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QUdpSocket>
+#include <QScopedPointer>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "data-sources/PositionSourceFactory.hpp"
+#include "data-sources/PositionSourceMonitor.hpp"
+#include "data-sources/ThreadedPositionSource.hpp"
+#include "test_PositionSourceFactory.hpp"
+
+static const char *Log =
+  "2009-08-24T22:24:37 -27.572321 153.090718 1180.0\n"
+  "2009-08-24T22:24:38 -27.572470 153.090783 1180.0\n"
+  "not a position\n"
+  "2009-08-24T22:24:39 -27.572616 153.090845 1180.0\n";
+
+void test_PositionSourceFactory::initTestCase() {
+  // For the signal spies
+  qRegisterMetaType<QGeoPositionInfo>();
+  qRegisterMetaType<QGeoPositionInfoSource::Error>();
+}
+
+void test_PositionSourceFactory::test_schemes() {
+  QStringList schemes = PositionSourceFactory::schemes();
+  for (char const *scheme : { "file", "mmap", "udp", "unix", "fifo", "mavlink", "sim" })
+    QVERIFY2(schemes.contains(scheme), scheme);
+
+  QString errorString;
+  QVERIFY2(!PositionSourceFactory::create("carrier-pigeon:/loft", nullptr, &errorString), "unknown scheme");
+  QVERIFY2(errorString.contains("carrier-pigeon"), "error string");
+  QVERIFY2(!PositionSourceFactory::create("no scheme", nullptr, &errorString), "malformed");
+  QVERIFY2(!PositionSourceFactory::create("udp://127.0.0.1", nullptr, &errorString), "no port");
+
+  // Registered schemes
+  PositionSourceFactory::registerScheme("test", [](QUrl const &uri, QObject *parent) {
+      return PositionSourceFactory::create("sim:?" + uri.query(), parent);
+    });
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create("test:?lat=10&lon=20&interval=7"));
+  QVERIFY2(source, "registered scheme");
+  QVERIFY2(source->updateInterval() == 7, "interval");
+}
+
+void test_PositionSourceFactory::test_mappedFile() {
+  QTemporaryFile file;
+  QVERIFY(file.open());
+  file.write(Log);
+  file.close();
+
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create("mmap:" + file.fileName() + "?interval=0"));
+  QVERIFY2(source, "mmap source");
+  PositionSourceMonitor monitor(source.data(), nullptr);
+  QSignalSpy positions(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+  QSignalSpy errors(source.data(), SIGNAL(error(QGeoPositionInfoSource::Error)));
+  source->startUpdates();
+  QVERIFY2(errors.wait(1000), "end of the log");
+  QVERIFY2(positions.count() == 3, "positions");
+  QVERIFY2(positions.at(2).at(0).value<QGeoPositionInfo>().coordinate().longitude() == 153.090845, "last position");
+
+  PositionSourceStatistics statistics = monitor.statistics();
+  QVERIFY2(statistics.updates == 3 && statistics.errors == 1, "counters");
+  QVERIFY2(statistics.minLatency <= statistics.meanLatency && statistics.meanLatency <= statistics.maxLatency, "latency");
+}
+
+void test_PositionSourceFactory::test_udp() {
+  // Find a free port
+  QUdpSocket probe;
+  QVERIFY(probe.bind(QHostAddress::LocalHost, 0));
+  const quint16 port = probe.localPort();
+  probe.close();
+
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create(QString("udp://127.0.0.1:%1").arg(port)));
+  QVERIFY2(source, "udp source");
+  QSignalSpy positions(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+  source->startUpdates();
+
+  QUdpSocket sender;
+  sender.writeDatagram(Log, qstrlen(Log), QHostAddress::LocalHost, port);
+  while (positions.count() < 3)
+    QVERIFY2(positions.wait(1000), "datagram");
+  QVERIFY2(positions.count() == 3, "positions");
+}
+
+void test_PositionSourceFactory::test_fifo() {
+  QTemporaryDir directory;
+  QVERIFY(directory.isValid());
+  const QString fileName = directory.filePath("positions");
+  QVERIFY(mkfifo(QFile::encodeName(fileName).constData(), 0600) == 0);
+
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create("fifo:" + fileName));
+  QVERIFY2(source, "fifo source");
+  QSignalSpy positions(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+  source->startUpdates();
+
+  // Write in two parts, splitting a line, then close the writer.
+  const int fd = ::open(QFile::encodeName(fileName).constData(), O_WRONLY);
+  QVERIFY(fd >= 0);
+  QVERIFY(::write(fd, Log, 60) == 60);
+  QVERIFY(::write(fd, Log + 60, qstrlen(Log) - 60) == qint64(qstrlen(Log) - 60));
+  ::close(fd);
+  while (positions.count() < 3)
+    QVERIFY2(positions.wait(1000), "line");
+  QVERIFY2(positions.count() == 3, "positions");
+}
+
+void test_PositionSourceFactory::test_threaded() {
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create("sim:?lat=39&lon=-75&interval=1&thread=1"));
+  QVERIFY2(qobject_cast<ThreadedPositionSource *>(source.data()), "threaded");
+  QThread *thread = qobject_cast<ThreadedPositionSource *>(source.data())->source()->thread();
+  QVERIFY2(thread != QThread::currentThread(), "I/O thread");
+
+  QSignalSpy positions(source.data(), SIGNAL(positionUpdated(QGeoPositionInfo)));
+  source->startUpdates();
+  while (positions.count() < 10)
+    QVERIFY2(positions.wait(1000), "simulated positions");
+  QGeoPositionInfo info = positions.last().at(0).value<QGeoPositionInfo>();
+  QVERIFY2(qAbs(info.coordinate().distanceTo(QGeoCoordinate(39.0, -75.0)) - 5000.0) <= 1.0, "circle");
+  source->stopUpdates();
+}
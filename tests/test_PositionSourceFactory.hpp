@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_PositionSourceFactory : public QObject {
+  Q_OBJECT
+
+private slots:
+  void initTestCase();
+  void test_schemes();
+  void test_mappedFile();
+  void test_udp();
+  void test_fifo();
+  void test_threaded();
+};
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <QtMath>
+#include "LookAngle.hpp"
+#include "Refraction.hpp"
+#include "test_Refraction.hpp"
+
+void test_Refraction::test_none() {
+  Refraction r;
+
+  QVERIFY2(r.model() == Refraction::None, "default model");
+  QVERIFY2(r.correction(0.0f) == 0.0f, "no correction at the horizon");
+  QVERIFY2(r.apparentElevation(10.0f) == 10.0f, "apparent elevation");
+}
+
+void test_Refraction::test_optical() {
+  Refraction bennett(Refraction::Bennett);
+  Refraction saemundsson(Refraction::Saemundsson);
+
+  // about 29 arc minutes at the geometric horizon, 5.4 at 10
+  // degrees, 1 at 45 degrees and none at the zenith.
+  QVERIFY2(qFabs(saemundsson.correction(0.0f) * 60.0 - 29.0) <= 0.5, "saemundsson horizon");
+  QVERIFY2(qFabs(saemundsson.correction(10.0f) * 60.0 - 5.4) <= 0.1, "saemundsson 10 degrees");
+  QVERIFY2(qFabs(saemundsson.correction(45.0f) * 60.0 - 1.0) <= 0.05, "saemundsson 45 degrees");
+  QVERIFY2(saemundsson.correction(90.0f) == 0.0f, "saemundsson zenith");
+
+  // The two formulas agree to a fraction of an arc minute.
+  for (float elevation = -1.0f; elevation <= 90.0f; elevation += 0.25f)
+    QVERIFY2(qFabs(bennett.correction(elevation) - saemundsson.correction(elevation)) * 60.0 <= 0.6, "bennett vs. saemundsson");
+
+  // Cold, dense air refracts more.
+  Refraction cold(Refraction::Saemundsson, -20.0, 1030.0);
+  QVERIFY2(cold.correction(1.0f) > saemundsson.correction(1.0f), "temperature and pressure");
+}
+
+void test_Refraction::test_fourThirdsEarth() {
+  Refraction radio(Refraction::FourThirdsEarth);
+  Refraction optical(Refraction::Saemundsson);
+
+  // range / (8 * R) radians for a nearby target
+  QVERIFY2(qFabs(radio.correction(1.0f, 50000.0) - qRadiansToDegrees(50000.0 / (8.0 * 6371000.0))) <= 1.0e-5, "nearby target");
+
+  // limited by the refraction through the whole atmosphere
+  QVERIFY2(radio.correction(1.0f, 1.0e7) == optical.correction(1.0f), "distant target");
+  QVERIFY2(radio.correction(1.0f) == optical.correction(1.0f), "unknown range");
+}
+
+void test_Refraction::test_apply() {
+  Refraction optical(Refraction::Bennett);
+  Refraction radio(Refraction::FourThirdsEarth);
+  float elevation[] = { -5.0f, 0.0f, 0.3f, 12.5f, 89.99f, 90.0f };
+  double range[] = { 1.0e5, 2.0e5, 3.0e5, 4.0e5, 5.0e5, 6.0e5 };
+  const int count = sizeof(elevation) / sizeof(elevation[0]);
+
+  float batch[count];
+  std::copy(elevation, elevation + count, batch);
+  optical.apply(batch, nullptr, count);
+  for (int i = 0; i < count; ++i)
+    QVERIFY2(qFabs(batch[i] - optical.apparentElevation(elevation[i])) <= 1.0e-4, "optical batch");
+
+  std::copy(elevation, elevation + count, batch);
+  radio.apply(batch, range, count);
+  for (int i = 0; i < count; ++i)
+    QVERIFY2(qFabs(batch[i] - radio.apparentElevation(elevation[i], range[i])) <= 1.0e-4, "radio batch");
+}
+
+void test_Refraction::test_setLookAngle() {
+  QGeoCoordinate observer(39.0, -75.0, 4000.0);
+  QGeoCoordinate target(39.0, -76.0, 12000.0);
+  Refraction refraction(Refraction::Saemundsson);
+  LookAngle geometric(observer, target);
+  LookAngle apparent(observer, target, refraction);
+
+  QVERIFY2(apparent.azimuth() == geometric.azimuth(), "azimuth");
+  QVERIFY2(qFabs(apparent.elevation() - refraction.apparentElevation(geometric.elevation())) <= 1.0e-4, "elevation");
+  QVERIFY2(apparent.elevation() > geometric.elevation(), "refraction raises the target");
+}
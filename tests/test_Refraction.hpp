@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QTest>
+
+class test_Refraction : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_none();
+  void test_optical();
+  void test_fourThirdsEarth();
+  void test_apply();
+  void test_setLookAngle();
+};
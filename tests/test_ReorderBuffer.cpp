@@ -0,0 +1,171 @@
+#include <algorithm>
+#include "ReorderBuffer.hpp"
+#include "test_ReorderBuffer.hpp"
+
+// Keeps the time stamps of what it is given, by id
+class ReleasedSamples : public PositionSampleSink
+{
+public:
+  virtual void consume(PositionSample const *samples, int count)
+  {
+    for (int i = 0; i < count; ++i)
+      timestamps[samples[i].id].append(samples[i].timestamp);
+  }
+
+  bool isSorted(quint64 id) const
+  {
+    QVector<qint64> const &t = timestamps.value(id);
+    return std::is_sorted(t.begin(), t.end());
+  }
+
+  QHash<quint64, QVector<qint64> > timestamps;
+};
+
+static PositionSample Sample(quint64 id, qint64 timestamp)
+{
+  PositionSample sample = PositionSample::invalid(id);
+  sample.timestamp = timestamp;
+  sample.latitude = 40.0;
+  sample.longitude = -75.0;
+  return sample;
+}
+
+static void Consume(ReorderBuffer &buffer, quint64 id, std::initializer_list<qint64> timestamps)
+{
+  for (qint64 timestamp : timestamps) {
+    PositionSample sample = Sample(id, timestamp);
+    buffer.consume(&sample, 1);
+  }
+}
+
+void test_ReorderBuffer::test_inOrder() {
+  // Without a delay, the samples go straight through.
+  ReorderBuffer buffer(0);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+  Consume(buffer, 1, { 100, 200, 200, 300 });
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 100, 200, 200, 300 }), "through");
+  QVERIFY2(buffer.count() == 0, "nothing held");
+
+  // With one, they are held for it.
+  buffer.setDelay(150);
+  Consume(buffer, 1, { 400, 500, 600 });
+  QVERIFY2(released.timestamps.value(1).size() == 5 && released.timestamps.value(1).last() == 400, "held");
+  QVERIFY2(buffer.count() == 2, "two held");
+  buffer.flush();
+  QVERIFY2(released.timestamps.value(1).size() == 7 && buffer.count() == 0, "flushed");
+  QVERIFY2(released.isSorted(1), "in order");
+}
+
+void test_ReorderBuffer::test_reorder() {
+  ReorderBuffer buffer(300);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+
+  // Shuffled by less than the delay
+  Consume(buffer, 1, { 200, 100, 400, 300, 600, 500, 700, 1000, 900, 800 });
+  buffer.flush();
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 100, 200, 300, 400, 500, 600, 700, 800, 900, 1000 }), "sorted");
+  ReorderBufferStatistics statistics = buffer.statistics();
+  QVERIFY2(statistics.received == 10 && statistics.released == 10, "counters");
+  QVERIFY2(statistics.late == 0 && statistics.forced == 0, "nothing dropped");
+}
+
+void test_ReorderBuffer::test_late() {
+  ReorderBuffer buffer(100);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+
+  // 1000 is released when 1100 arrives, so 950 is too late, but 1050
+  // is still in time.
+  Consume(buffer, 1, { 1000, 1100, 950, 1050 });
+  QVERIFY2(buffer.statistics().late == 1, "late");
+  buffer.flush();
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 1000, 1050, 1100 }), "late one dropped");
+
+  // After a flush, anything older than what was released is late.
+  Consume(buffer, 1, { 1099, 1100, 1200 });
+  buffer.flush();
+  QVERIFY2(buffer.statistics().late == 2, "late after a flush");
+  QVERIFY2(released.timestamps.value(1).mid(3) == QVector<qint64>({ 1100, 1200 }), "same time is not late");
+}
+
+void test_ReorderBuffer::test_capacity() {
+  // A long delay and a small ring: the oldest samples are pushed out.
+  ReorderBuffer buffer(1000000, 4);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+  Consume(buffer, 1, { 10, 30, 20, 40, 60, 50 });
+  QVERIFY2(buffer.capacity() == 4 && buffer.count() == 4, "full");
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 10, 20 }), "oldest released");
+  QVERIFY2(buffer.statistics().forced == 2, "forced");
+
+  // Older than a sample pushed out
+  Consume(buffer, 1, { 15 });
+  QVERIFY2(buffer.statistics().late == 1 && buffer.count() == 4, "late");
+  buffer.flush();
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 10, 20, 30, 40, 50, 60 }), "in order");
+}
+
+void test_ReorderBuffer::test_expiry() {
+  // A feed that stops: its last samples are released after the delay.
+  ReorderBuffer buffer(50);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+  Consume(buffer, 1, { 1000, 1010 });
+  QVERIFY2(released.timestamps.value(1).isEmpty(), "held");
+  QTRY_VERIFY2_WITH_TIMEOUT(released.timestamps.value(1).size() == 2, "expired", 1000);
+  QVERIFY2(buffer.count() == 0, "nothing held");
+}
+
+void test_ReorderBuffer::test_entities() {
+  // Each entity has its own time.
+  ReorderBuffer buffer(100);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+  PositionSample samples[] = {
+    Sample(1, 5000), Sample(2, 100), Sample(1, 5200), Sample(2, 50), Sample(2, 300), Sample(1, 5100),
+  };
+  buffer.consume(samples, 6);
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 5000, 5100 }), "first entity");
+  QVERIFY2(released.timestamps.value(2) == QVector<qint64>({ 50, 100 }), "second entity");
+  QVERIFY2(buffer.statistics().late == 0, "none late");
+}
+
+void test_ReorderBuffer::test_idleEntities() {
+  // Entities that come and go: the rings of the quiet ones are dropped.
+  ReorderBuffer buffer(0);
+  ReleasedSamples released;
+  buffer.setSampleSink(&released);
+  buffer.setIdleTimeout(20);
+  Consume(buffer, 1, { 100 });
+  Consume(buffer, 2, { 100 });
+  QVERIFY2(buffer.entityCount() == 2, "rings");
+
+  QTest::qWait(50);
+  Consume(buffer, 3, { 100 });
+  QVERIFY2(buffer.entityCount() == 1 && buffer.statistics().expired == 2, "dropped");
+
+  // A sample of a dropped entity starts a ring again
+  Consume(buffer, 1, { 50 });
+  QVERIFY2(buffer.entityCount() == 2 && buffer.statistics().late == 0, "new ring");
+  QVERIFY2(released.timestamps.value(1) == QVector<qint64>({ 100, 50 }), "released");
+}
+
+void test_ReorderBuffer::benchmark_reorder() {
+  // 100 entities, each with its samples swapped in pairs
+  ReorderBuffer buffer(100);
+  ReleasedSamples released;
+  QVector<PositionSample> samples;
+  for (int i = 0; i < 1000; ++i)
+    for (int id = 0; id < 100; ++id)
+      samples.append(Sample(id, 10 * (i ^ 1)));
+  qint64 offset = 0;
+  QBENCHMARK {
+    for (PositionSample &sample : samples)
+      sample.timestamp += offset;
+    buffer.consume(samples.constData(), samples.size());
+    offset = 10000;
+  }
+  QVERIFY2(buffer.statistics().late == 0, "none late");
+}
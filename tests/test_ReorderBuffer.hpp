@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QTest>
+
+class test_ReorderBuffer : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_inOrder();
+  void test_reorder();
+  void test_late();
+  void test_capacity();
+  void test_expiry();
+  void test_entities();
+  void test_idleEntities();
+  void benchmark_reorder();
+};
@@ -0,0 +1,131 @@
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtMath>
+#include "Sgp4.hpp"
+#include "SatelliteCatalog.hpp"
+#include "GeoPoint.hpp"
+#include "test_Sgp4.hpp"
+
+// Test case 00005 from the verification set of "Revisiting Spacetrack
+// Report #3" (tcppver.out).
+static const char *Vanguard1 = "1 00005U 58002B   00179.78495062  .00000023  00000-0  28098-4 0  4753";
+static const char *Vanguard2 = "2 00005  34.2682 348.7242 1859667 331.7664  19.3264 10.82419157413667";
+
+void test_Sgp4::test_parse() {
+  TwoLineElements elements;
+
+  QVERIFY2(elements.parse(Vanguard1, Vanguard2), "parse");
+  QVERIFY2(elements.catalogNumber == 5, "catalog number");
+  QVERIFY2(qFabs(elements.bstar - 0.28098e-4) <= 1.0e-12, "bstar");
+  QVERIFY2(qFabs(elements.eccentricity - 0.1859667) <= 1.0e-12, "eccentricity");
+  QVERIFY2(qFabs(qRadiansToDegrees(elements.inclination) - 34.2682) <= 1.0e-9, "inclination");
+  QVERIFY2(qFabs(elements.meanMotion * 1440.0 / (2.0 * M_PI) - 10.82419157) <= 1.0e-9, "mean motion");
+
+  // 2000-06-27T18:50:19.733568 UTC
+  QDateTime epoch(QDate(2000, 6, 27), QTime(18, 50, 19, 734), Qt::UTC);
+  QVERIFY2(qFabs(elements.epoch - epoch.toMSecsSinceEpoch()) <= 1.0, "epoch");
+
+  // A corrupted line fails its checksum
+  QByteArray corrupted(Vanguard2);
+  corrupted[10] = '5';
+  QVERIFY2(!elements.parse(Vanguard1, corrupted), "checksum");
+
+  // A truncated line has no checksum
+  QVERIFY2(!elements.parse(QByteArray(Vanguard1).left(68), Vanguard2), "truncated line");
+}
+
+void test_Sgp4::test_propagate() {
+  TwoLineElements elements;
+  elements.parse(Vanguard1, Vanguard2);
+  Sgp4 satellite(elements);
+  QVERIFY2(satellite.error() == Sgp4::NoError, "initialize");
+
+  struct {
+    double minutes;
+    double r[3];
+    double v[3];
+  } expected[] = {
+    {   0.0, {  7022.46529266, -1400.08296755,     0.03995155 }, {  1.893841015,  6.405893759,  4.534807250 } },
+    { 360.0, { -7154.03120202, -3783.17682504, -3536.19412294 }, {  4.741887409, -4.151817765, -2.093935425 } },
+  };
+
+  for (auto const &e : expected) {
+    double r[3], v[3];
+    QVERIFY2(satellite.propagate(e.minutes, r, v) == Sgp4::NoError, "propagate");
+    for (int i = 0; i < 3; ++i) {
+      QVERIFY2(qFabs(r[i] - e.r[i]) <= 1.0e-6, "position");
+      QVERIFY2(qFabs(v[i] - e.v[i]) <= 1.0e-8, "velocity");
+    }
+  }
+}
+
+void test_Sgp4::test_deepSpace() {
+  // A geostationary satellite has a period of a day.
+  TwoLineElements elements;
+  QVERIFY2(elements.parse("1 26038U 99066A   06176.50000000 -.00000270  00000-0  10000-3 0  9998",
+                          "2 26038   0.0350 262.4561 0002290 140.2201 317.4356  1.00271149 25234"), "parse");
+  Sgp4 satellite(elements);
+  QVERIFY2(satellite.error() == Sgp4::DeepSpaceError, "deep space");
+
+  GeoPoint position;
+  QVERIFY2(satellite.positionAt(elements.epoch, &position) == Sgp4::DeepSpaceError, "propagate");
+}
+
+void test_Sgp4::test_earthFixed() {
+  TwoLineElements elements;
+  elements.parse(Vanguard1, Vanguard2);
+  Sgp4 satellite(elements);
+
+  // The earth fixed position has the same radius as the TEME
+  // position and is rotated about the pole.
+  double r[3], v[3];
+  GeoPoint ecef;
+  satellite.propagate(360.0, r, v);
+  QVERIFY2(satellite.positionAt(elements.epoch + 360.0 * 60000.0, &ecef) == Sgp4::NoError, "positionAt");
+  const double radius = 1000.0 * qSqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+  QVERIFY2(qFabs(ecef.distanceTo(GeoPoint(0.0, 0.0, 0.0)) - radius) <= 1.0e-3, "radius");
+  QVERIFY2(qFabs(ecef.z() - 1000.0 * r[2]) <= 1.0e-3, "pole");
+
+  // The geodetic coordinate converts back to the same point
+  QGeoCoordinate coordinate = ecef.coordinate();
+  QVERIFY2(GeoPoint(coordinate).distanceTo(ecef) <= 1.0e-3, "geodetic");
+
+  // The Greenwich mean sidereal time at J2000 is 280.46061837 degrees
+  const double j2000 = QDateTime(QDate(2000, 1, 1), QTime(12, 0), Qt::UTC).toMSecsSinceEpoch();
+  QVERIFY2(qFabs(qRadiansToDegrees(Sgp4::greenwichSiderealTime(j2000)) - 280.46061837) <= 1.0e-6, "sidereal time");
+}
+
+// Write the contents of a catalog file
+static
+bool WriteCatalog(QString const &fileName, QByteArray const &contents)
+{
+  QFile file(fileName);
+  return file.open(QIODevice::WriteOnly | QIODevice::Text) && file.write(contents) == contents.size();
+}
+
+void test_Sgp4::test_catalog() {
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath("catalog.txt");
+  const QByteArray geostationary1 = "1 26038U 99066A   06176.50000000 -.00000270  00000-0  10000-3 0  9998";
+  const QByteArray geostationary2 = "2 26038   0.0350 262.4561 0002290 140.2201 317.4356  1.00271149 25234";
+  QVERIFY2(WriteCatalog(fileName, "GEO\n" + geostationary1 + "\n" + geostationary2 + "\n"
+                        + "VANGUARD 1\n" + Vanguard1 + "\n" + Vanguard2 + "\n"), "written");
+
+  SatelliteCatalog catalog;
+  QVERIFY2(catalog.load(fileName), "loaded");
+  QVERIFY2(catalog.count() == 2 && catalog.indexOf("VANGUARD 1") == 1, "satellites");
+  catalog.propagate(QDateTime(QDate(2006, 6, 25), QTime(12, 0), Qt::UTC));
+  QVERIFY2(catalog.error(0) == Sgp4::DeepSpaceError && catalog.x().size() == 2, "propagated");
+
+  // A truncated element set is skipped, and nothing is kept of the
+  // previous catalog
+  QVERIFY2(WriteCatalog(fileName, "VANGUARD 1\n" + QByteArray(Vanguard1) + "\n" + Vanguard2 + "\n"
+                        + "TRUNCATED\n" + geostationary1.left(68) + "\n" + geostationary2 + "\n"), "rewritten");
+  QVERIFY2(catalog.load(fileName), "reloaded");
+  QVERIFY2(catalog.count() == 1 && catalog.indexOf(26038) == -1 && catalog.indexOf("GEO") == -1, "replaced");
+  QVERIFY2(catalog.x().isEmpty() && catalog.time() == QDateTime::fromMSecsSinceEpoch(0, Qt::UTC), "propagation reset");
+  catalog.propagate(QDateTime(QDate(2000, 6, 28), QTime(0, 0), Qt::UTC));
+  QVERIFY2(catalog.error(0) == Sgp4::NoError, "propagated again");
+
+  QVERIFY2(!catalog.load(dir.filePath("missing.txt")) && catalog.count() == 0, "missing file");
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QTest>
+
+class test_Sgp4 : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_parse();
+  void test_propagate();
+  void test_deepSpace();
+  void test_earthFixed();
+  void test_catalog();
+};
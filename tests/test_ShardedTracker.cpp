@@ -0,0 +1,189 @@
+#include <QThread>
+#include <QSet>
+#include <QHash>
+#include "ShardedTracker.hpp"
+#include "GeoEntity.hpp"
+#include "LookAngle.hpp"
+#include "test_ShardedTracker.hpp"
+
+// Keeps the look angles it is given
+class CollectingLookAngleSink : public EntityLookAngleSink
+{
+public:
+  virtual void consume(EntityLookAngle const *lookAngles, int count)
+  {
+    for (int i = 0; i < count; ++i)
+      received.append(lookAngles[i]);
+  }
+
+  QVector<EntityLookAngle> received;
+};
+
+static
+EntityLookAngle MakeLookAngle(quint64 id)
+{
+  EntityLookAngle lookAngle;
+  lookAngle.id = id;
+  lookAngle.timestamp = qint64(id);
+  lookAngle.azimuth = 0.0f;
+  lookAngle.elevation = 0.0f;
+  return lookAngle;
+}
+
+static
+QVector<PositionSample> Samples(int count, qint64 timestamp)
+{
+  QVector<PositionSample> samples(count);
+  for (int i = 0; i < count; ++i) {
+    PositionSample &sample = samples[i];
+    sample = PositionSample::invalid(quint64(i) + 1);
+    sample.timestamp = timestamp;
+    sample.latitude = -27.0 + 0.001 * (i % 1000);
+    sample.longitude = 153.0 + 0.001 * (i / 1000);
+    sample.altitude = 1000.0 + i % 7;
+  }
+  return samples;
+}
+
+void test_ShardedTracker::test_outbox() {
+  LookAngleOutbox outbox(5);
+  QVERIFY2(outbox.capacity() == 8, "power of two");
+
+  // Around the ring a few times
+  EntityLookAngle in[8], out[8];
+  quint64 next = 0, expected = 0;
+  bool isInOrder = true;
+  for (int round = 0; round < 10; ++round) {
+    for (int i = 0; i < 6; ++i)
+      in[i] = MakeLookAngle(next + quint64(i));
+    QVERIFY2(outbox.push(in, 6) == 6, "pushed");
+    next += 6;
+    const int count = outbox.pop(out, 8);
+    QVERIFY2(count == 6, "popped");
+    for (int i = 0; i < count; ++i)
+      isInOrder = isInOrder && out[i].id == expected++;
+  }
+  QVERIFY2(isInOrder, "in order");
+
+  // Full
+  for (int i = 0; i < 8; ++i)
+    in[i] = MakeLookAngle(quint64(i));
+  QVERIFY2(outbox.push(in, 6) == 6, "some");
+  QVERIFY2(outbox.push(in, 6) == 2, "the rest of the room");
+  QVERIFY2(outbox.pop(out, 3) == 3 && out[0].id == 0, "oldest first");
+  QVERIFY2(outbox.push(in, 8) == 3, "room again");
+  QVERIFY2(outbox.pop(out, 8) == 8 && outbox.pop(out, 8) == 0, "emptied");
+}
+
+void test_ShardedTracker::test_outboxThreads() {
+  // A writer and a reader at full speed: nothing lost, nothing
+  // reordered, nothing seen twice
+  LookAngleOutbox outbox(1024);
+  const quint64 total = 2000000;
+  QThread *writer = QThread::create([&outbox, total]() {
+      EntityLookAngle batch[64];
+      quint64 next = 0;
+      while (next < total) {
+        const int count = int(qMin<quint64>(64, total - next));
+        for (int i = 0; i < count; ++i)
+          batch[i] = MakeLookAngle(next + quint64(i));
+        int pushed = 0;
+        while (pushed < count)
+          pushed += outbox.push(batch + pushed, count - pushed);
+        next += quint64(count);
+      }
+    });
+  writer->start();
+
+  EntityLookAngle batch[100];
+  quint64 expected = 0;
+  bool isInOrder = true;
+  while (expected < total) {
+    const int count = outbox.pop(batch, 100);
+    for (int i = 0; i < count; ++i)
+      isInOrder = isInOrder && batch[i].id == expected++ && batch[i].timestamp == qint64(batch[i].id);
+  }
+  writer->wait();
+  delete writer;
+  QVERIFY2(isInOrder, "in order");
+  QVERIFY2(outbox.pop(batch, 100) == 0, "empty");
+}
+
+void test_ShardedTracker::test_lookAngles() {
+  ShardedTracker tracker(4);
+  CollectingLookAngleSink sink;
+  tracker.setLookAngleSink(&sink);
+  QVERIFY2(tracker.shardCount() == 4, "shards");
+
+  // Without an observer, no look angles
+  const QVector<PositionSample> samples = Samples(10000, 1000);
+  tracker.consume(samples.constData(), samples.size());
+  tracker.flush();
+  QVERIFY2(sink.received.isEmpty(), "no observer");
+  QVERIFY2(tracker.statistics().samples == 10000, "routed");
+
+  const QGeoCoordinate site(-27.5, 152.9, 50.0);
+  tracker.setObserverPosition(QGeoPositionInfo(site, QDateTime::currentDateTimeUtc()));
+  tracker.consume(samples.constData(), samples.size());
+  tracker.flush();
+  QVERIFY2(sink.received.size() == 10000, "look angles");
+
+  // Each once, as computed in one thread
+  QSet<quint64> ids;
+  bool isSame = true;
+  for (EntityLookAngle const &lookAngle : sink.received) {
+    ids.insert(lookAngle.id);
+    PositionSample const &sample = samples.at(int(lookAngle.id) - 1);
+    const LookAngle expected(site, QGeoCoordinate(sample.latitude, sample.longitude, sample.altitude));
+    isSame = isSame && lookAngle.azimuth == expected.azimuth() && lookAngle.elevation == expected.elevation()
+      && lookAngle.timestamp == 1000;
+  }
+  QVERIFY2(ids.size() == 10000, "each once");
+  QVERIFY2(isSame, "same look angles");
+
+  // Spread evenly, and every id in its shard
+  quint64 total = 0;
+  for (int i = 0; i < 4; ++i) {
+    const ShardedTrackerStatistics statistics = tracker.statistics(i);
+    QVERIFY2(statistics.samples > 4000 && statistics.samples < 6000, "spread");
+    QVERIFY2(statistics.lookAngles * 2 == statistics.samples, "look angles of the shard");
+    total += statistics.delivered;
+  }
+  QVERIFY2(total == 10000 && tracker.statistics().dropped == 0, "delivered");
+}
+
+void test_ShardedTracker::test_entities() {
+  ShardedTracker tracker(3);
+  GeoEntity entity;
+  QThread *home = entity.thread();
+  tracker.setEntity(42, &entity);
+  QVERIFY2(entity.thread() != home, "moved to its shard");
+
+  QVector<PositionSample> samples = Samples(100, 2000);
+  tracker.consume(samples.constData(), samples.size());
+  tracker.flush();
+  QVERIFY2(entity.position().coordinate().latitude() == samples.at(41).latitude, "updated");
+
+  tracker.setEntity(42, nullptr);
+  QVERIFY2(entity.thread() == home, "moved back");
+
+  // And when the tracker goes
+  GeoEntity other;
+  {
+    ShardedTracker scoped(2);
+    scoped.setEntity(7, &other);
+    QVERIFY2(other.thread() != home, "moved to its shard");
+  }
+  QVERIFY2(other.thread() == home, "moved back at the end");
+}
+
+void test_ShardedTracker::test_benchmark() {
+  ShardedTracker tracker;
+  CollectingLookAngleSink sink;
+  tracker.setObserverPosition(QGeoPositionInfo(QGeoCoordinate(-27.5, 152.9, 50.0), QDateTime::currentDateTimeUtc()));
+  const QVector<PositionSample> samples = Samples(100000, 1000);
+  QBENCHMARK {
+    tracker.consume(samples.constData(), samples.size());
+    tracker.flush();
+  }
+}
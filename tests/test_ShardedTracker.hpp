@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QTest>
+
+class test_ShardedTracker : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_outbox();
+  void test_outboxThreads();
+  void test_lookAngles();
+  void test_entities();
+  void test_benchmark();
+};
@@ -0,0 +1,167 @@
+#include <QtMath>
+#include <QScopedPointer>
+#include <QSignalSpy>
+#include "data-sources/SimulatedPositionSource.hpp"
+#include "data-sources/PositionSourceFactory.hpp"
+#include "test_SimulatedPositionSource.hpp"
+
+// Counts the samples it is given, by id
+class CountingSampleSink : public PositionSampleSink
+{
+public:
+  CountingSampleSink() : batches(0) {}
+
+  virtual void consume(PositionSample const *samples, int count)
+  {
+    ++batches;
+    for (int i = 0; i < count; ++i)
+      ids.append(samples[i].id);
+  }
+
+  int batches;
+  QVector<quint64> ids;
+};
+
+static
+bool IsValid(PositionSample const &sample)
+{
+  return qIsFinite(sample.latitude) && qAbs(sample.latitude) <= 90.0
+    && qIsFinite(sample.longitude) && sample.longitude >= -180.0 && sample.longitude < 180.0
+    && qIsFinite(sample.altitude)
+    && sample.direction >= 0.0 && sample.direction < 360.0
+    && sample.groundSpeed >= 0.0;
+}
+
+void test_SimulatedPositionSource::test_circle() {
+  // The first entity flies the circle given, clockwise from north
+  const QGeoCoordinate center(-27.5, 153.0, 1200.0);
+  SimulatedPositionSource source(center, 5000.0, 100.0);
+  source.setCount(1000);
+  const double period = 2.0 * M_PI * 5000.0 / 100.0;
+  for (double seconds : { 0.0, 0.25 * period, 0.5 * period, 10.0 }) {
+    const QGeoCoordinate coordinate = source.positionAt(seconds).coordinate();
+    QVERIFY2(qAbs(center.distanceTo(coordinate) - 5000.0) < 1.0, "radius");
+    QVERIFY2(coordinate.altitude() == 1200.0, "altitude");
+  }
+  QVERIFY2(qAbs(center.azimuthTo(source.positionAt(0.0).coordinate())) < 1e-6, "north");
+  QVERIFY2(qAbs(center.azimuthTo(source.positionAt(0.25 * period).coordinate()) - 90.0) < 1e-3, "east");
+
+  const PositionSample sample = source.sampleAt(0, 0.0);
+  QVERIFY2(sample.id == 1, "id");
+  QVERIFY2(qAbs(sample.direction - 90.0) < 1e-6 && sample.groundSpeed == 100.0, "velocity");
+}
+
+void test_SimulatedPositionSource::test_reproducible() {
+  // The same seed, the same positions, whatever the number of entities
+  const QGeoCoordinate center(40.0, -105.0, 2000.0);
+  SimulatedPositionSource a(center), b(center), c(center);
+  a.setCount(10000);
+  b.setCount(20000);
+  c.setCount(10000);
+  c.setSeed(2);
+  QVector<PositionSample> samplesA, samplesB, samplesC;
+  a.simulate(60.0, &samplesA);
+  b.simulate(60.0, &samplesB);
+  c.simulate(60.0, &samplesC);
+  QVERIFY2(samplesA.size() == 10000 && samplesB.size() == 20000, "count");
+
+  bool isSame = true;
+  int differs = 0;
+  for (int i = 0; i < samplesA.size(); ++i) {
+    isSame = isSame && samplesA.at(i).latitude == samplesB.at(i).latitude
+      && samplesA.at(i).longitude == samplesB.at(i).longitude
+      && samplesA.at(i).id == quint64(i) + 1;
+    differs += samplesA.at(i).latitude != samplesC.at(i).latitude;
+  }
+  QVERIFY2(isSame, "reproducible");
+  QVERIFY2(differs == samplesA.size() - 1, "seeded");
+
+  // In parallel as one by one
+  QVERIFY2(samplesA.at(9999).latitude == a.sampleAt(9999, 60.0).latitude, "parallel");
+}
+
+void test_SimulatedPositionSource::test_trajectories() {
+  const QGeoCoordinate center(51.5, -0.1, 500.0);
+  const char *names[] = { "circle", "great-circle", "orbit", "loiter", "walk" };
+  for (char const *name : names) {
+    SimulatedPositionSource::Trajectory trajectory;
+    QVERIFY2(SimulatedPositionSource::trajectoryFromName(name, &trajectory), name);
+    SimulatedPositionSource source(center, 2000.0, 50.0);
+    source.setTrajectory(trajectory);
+    source.setCount(500);
+    source.setSpread(20000.0);
+
+    bool isValid = true;
+    bool isNear = true;
+    double maxStep = 0.0;
+    for (int i = 0; i < 500; ++i) {
+      const PositionSample before = source.sampleAt(i, 100.0);
+      const PositionSample after = source.sampleAt(i, 101.0);
+      isValid = isValid && IsValid(before) && IsValid(after);
+      const QGeoCoordinate start(source.sampleAt(i, 0.0).latitude, source.sampleAt(i, 0.0).longitude);
+      if (trajectory != SimulatedPositionSource::Orbit)
+        isNear = isNear && center.distanceTo(start) < 20000.0 + 3.0 * 3000.0;
+      maxStep = qMax(maxStep, QGeoCoordinate(before.latitude, before.longitude)
+                     .distanceTo(QGeoCoordinate(after.latitude, after.longitude)));
+    }
+    QVERIFY2(isValid, name);
+    QVERIFY2(isNear, name);
+    // No faster than the fastest entity (orbits at about 7.5 km/s)
+    const double maxSpeed = trajectory == SimulatedPositionSource::Orbit ? 8000.0
+      : trajectory == SimulatedPositionSource::RandomWalk ? 3.0 * 75.0 : 75.0;
+    QVERIFY2(maxStep > 0.0 && maxStep <= maxSpeed + 1e-3, name);
+  }
+
+  SimulatedPositionSource::Trajectory trajectory;
+  QVERIFY2(!SimulatedPositionSource::trajectoryFromName("zigzag", &trajectory), "unknown");
+}
+
+void test_SimulatedPositionSource::test_factory() {
+  QScopedPointer<QGeoPositionInfoSource> source(PositionSourceFactory::create(
+      "sim:?lat=10&lon=20&n=250&model=loiter&seed=7&spread=1000&batch=100&epoch=1000000000"));
+  QVERIFY2(source, "sim source");
+  SimulatedPositionSource *simulated = qobject_cast<SimulatedPositionSource *>(source.data());
+  QVERIFY2(simulated, "simulated");
+  QVERIFY2(simulated->count() == 250, "n");
+  QVERIFY2(simulated->trajectory() == SimulatedPositionSource::Loiter, "model");
+  QVERIFY2(simulated->seed() == 7 && simulated->spread() == 1000.0, "seed and spread");
+  QVERIFY2(simulated->batchSize() == 100, "batch");
+  QVERIFY2(simulated->epoch() == Q_INT64_C(1000000000000), "epoch");
+  QVERIFY2(simulated->sampleAt(3, 2.5).timestamp == Q_INT64_C(1000000002500), "timestamp");
+
+  QString errorString;
+  QVERIFY2(!PositionSourceFactory::create("sim:?model=zigzag", nullptr, &errorString), "unknown model");
+}
+
+void test_SimulatedPositionSource::test_sink() {
+  // Every entity each update, in batches; the first by the signal
+  SimulatedPositionSource source(QGeoCoordinate(0.0, 0.0, 100.0));
+  CountingSampleSink sink;
+  source.setCount(10000);
+  source.setBatchSize(4096);
+  source.setSampleSink(&sink);
+  QSignalSpy positions(&source, SIGNAL(positionUpdated(QGeoPositionInfo)));
+  source.requestUpdate();
+  QVERIFY2(sink.batches == 3 && sink.ids.size() == 10000, "batches");
+  QVERIFY2(sink.ids.first() == 1 && sink.ids.last() == 10000, "ids");
+  QVERIFY2(positions.count() == 1, "first entity");
+
+  // Stepped by the update interval
+  source.setUpdateInterval(1000);
+  source.requestUpdate();
+  const QGeoPositionInfo info = positions.at(1).at(0).value<QGeoPositionInfo>();
+  QVERIFY2(info.coordinate().distanceTo(source.positionAt(1.0).coordinate()) < 1e-6, "step");
+}
+
+void test_SimulatedPositionSource::test_benchmark() {
+  // A million entities, as for the throughput of the pipeline
+  SimulatedPositionSource source(QGeoCoordinate(35.0, -120.0, 1000.0));
+  source.setCount(1000000);
+  QVector<PositionSample> samples;
+  double seconds = 0.0;
+  QBENCHMARK {
+    source.simulate(seconds, &samples);
+    seconds += 1.0;
+  }
+  QVERIFY2(samples.size() == 1000000, "count");
+}
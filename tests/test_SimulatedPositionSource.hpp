@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QTest>
+
+class test_SimulatedPositionSource : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_circle();
+  void test_reproducible();
+  void test_trajectories();
+  void test_factory();
+  void test_sink();
+  void test_benchmark();
+};
@@ -0,0 +1,215 @@
+#include <QtMath>
+#include <QElapsedTimer>
+#include "TrackFusion.hpp"
+#include "GeoEntityDispatcher.hpp"
+#include "test_TrackFusion.hpp"
+
+// Keeps what it is given
+class Collector : public PositionSampleSink
+{
+public:
+  virtual void consume(PositionSample const *samples, int count)
+  {
+    ++batches;
+    for (int i = 0; i < count; ++i)
+      this->samples.append(samples[i]);
+  }
+
+  int batches = 0;
+  QVector<PositionSample> samples;
+};
+
+static PositionSample Report(quint64 id, qint64 timestamp, double latitude, double longitude, double accuracy = qQNaN())
+{
+  PositionSample sample = PositionSample::invalid(id);
+  sample.timestamp = timestamp;
+  sample.latitude = latitude;
+  sample.longitude = longitude;
+  sample.altitude = 1000.0;
+  sample.horizontalAccuracy = accuracy;
+  return sample;
+}
+
+// One meter north, in degrees
+static const double Meter = 360.0 / (2.0 * M_PI * 6371008.8);
+
+void test_TrackFusion::test_weightedMean() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+
+  // Three reports of one object, one window
+  PositionSample reports[] = {
+    Report(1, 1000, 40.0, -75.0, 10.0),
+    Report(1, 1000, 40.0 + 30.0 * Meter, -75.0, 20.0),
+    Report(1, 1000, 40.0 + 60.0 * Meter, -75.0),
+  };
+  fusion.consume(reports, 3);
+  QVERIFY2(collector.samples.isEmpty(), "window open");
+  fusion.flush();
+  QVERIFY2(collector.batches == 1 && collector.samples.size() == 1, "one update");
+
+  // The weights are 1/100, 1/400 and 1/2500 (the default accuracy)
+  const double weights = 1.0 / 100.0 + 1.0 / 400.0 + 1.0 / 2500.0;
+  const double north = (30.0 / 400.0 + 60.0 / 2500.0) / weights;
+  PositionSample const &fused = collector.samples.at(0);
+  QVERIFY2(fused.id == 1 && fused.timestamp == 1000, "track");
+  QVERIFY2(qAbs((fused.latitude - 40.0) / Meter - north) < 1e-6, "weighted latitude");
+  QVERIFY2(qAbs(fused.horizontalAccuracy - qSqrt(1.0 / weights)) < 1e-9, "accuracy");
+  QVERIFY2(qAbs(fused.altitude - 1000.0) < 1e-9, "altitude");
+  QVERIFY2(fusion.statistics().reports == 3 && fusion.statistics().updates == 1, "counters");
+
+  fusion.flush();
+  QVERIFY2(collector.batches == 1, "nothing new");
+}
+
+void test_TrackFusion::test_association() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+  fusion.setGate(200.0);
+
+  // The same aircraft from two feeds, and another one far away
+  PositionSample first[] = { Report(10, 1000, 40.0, -75.0, 10.0), Report(30, 1000, 41.0, -75.0, 10.0) };
+  fusion.consume(first, 2);
+  PositionSample second[] = { Report(20, 1000, 40.0 + 50.0 * Meter, -75.0, 10.0) };
+  fusion.consume(second, 1);
+  fusion.flush();
+
+  QVERIFY2(fusion.trackCount() == 2, "tracks");
+  QVERIFY2(fusion.track(20) == 10 && fusion.track(10) == 10 && fusion.track(30) == 30, "aliases");
+  QVERIFY2(fusion.statistics().associated == 1, "associated by distance");
+  QVERIFY2(collector.samples.size() == 2, "one update per track");
+  QVERIFY2(qAbs((collector.samples.at(0).latitude - 40.0) / Meter - 25.0) < 1e-6, "fused");
+
+  // Once associated, by id wherever it is
+  PositionSample later[] = { Report(20, 2000, 40.5, -75.0) };
+  fusion.consume(later, 1);
+  fusion.flush();
+  QVERIFY2(collector.samples.last().id == 10, "alias");
+
+  // Without a gate, by id only
+  TrackFusion byId;
+  byId.consume(first, 2);
+  byId.consume(second, 1);
+  QVERIFY2(byId.trackCount() == 3, "no gate");
+}
+
+void test_TrackFusion::test_outOfOrder() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+  fusion.setMaximumAge(5000);
+
+  PositionSample first[] = { Report(1, 10000, 40.0, -75.0) };
+  fusion.consume(first, 1);
+  fusion.flush();
+
+  // Late, duplicate, stale and good reports
+  PositionSample second[] = {
+    Report(1, 9000, 40.1, -75.0),
+    Report(1, 10000, 40.1, -75.0),
+    Report(2, 4000, 40.1, -75.0),
+    Report(1, 11000, 40.2, -75.0),
+  };
+  fusion.consume(second, 4);
+  fusion.flush();
+
+  TrackFusionStatistics statistics = fusion.statistics();
+  QVERIFY2(statistics.outOfOrder == 2, "out of order");
+  QVERIFY2(statistics.stale == 1, "stale");
+  QVERIFY2(collector.samples.size() == 2 && qAbs(collector.samples.last().latitude - 40.2) < 1e-12, "good report");
+  QVERIFY2(fusion.trackCount() == 1, "no track for stale reports");
+}
+
+void test_TrackFusion::test_propagation() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+
+  // Flying north at 100 m/s: the report of a second ago, moved to
+  // now, agrees with the report of now.
+  PositionSample old = Report(1, 0, 40.0, -75.0, 10.0);
+  old.groundSpeed = 100.0;
+  old.direction = 0.0;
+  old.verticalSpeed = 5.0;
+  PositionSample now = Report(1, 1000, 40.0 + 100.0 * Meter, -75.0, 10.0);
+  now.altitude = 1005.0;
+  PositionSample reports[] = { old, now };
+  fusion.consume(reports, 2);
+  fusion.flush();
+
+  PositionSample const &fused = collector.samples.at(0);
+  QVERIFY2(fused.timestamp == 1000, "latest time");
+  QVERIFY2(qAbs((fused.latitude - 40.0) / Meter - 100.0) < 1e-3, "moved");
+  QVERIFY2(qAbs(fused.altitude - 1005.0) < 1e-9, "climbed");
+  QVERIFY2(qAbs(fused.groundSpeed - 100.0) < 1e-9 && qAbs(fused.direction) < 1e-9, "velocity");
+}
+
+void test_TrackFusion::test_antimeridian() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+  PositionSample reports[] = { Report(1, 0, 10.0, 179.9999), Report(1, 0, 10.0, -179.9999) };
+  fusion.consume(reports, 2);
+  fusion.flush();
+  QVERIFY2(qAbs(qAbs(collector.samples.at(0).longitude) - 180.0) < 1e-9, "across the antimeridian");
+}
+
+void test_TrackFusion::test_window() {
+  // A feed at 1 kHz for two objects, into entities
+  TrackFusion fusion;
+  GeoEntityDispatcher dispatcher;
+  dispatcher.setCreatesEntities(true);
+  fusion.setSampleSink(&dispatcher);
+  fusion.setWindow(50);
+
+  QElapsedTimer elapsed;
+  elapsed.start();
+  qint64 time = 0;
+  while (elapsed.elapsed() < 300) {
+    ++time;
+    PositionSample reports[] = { Report(1, time, 40.0, -75.0), Report(2, time, 41.0, -75.0) };
+    fusion.consume(reports, 2);
+    QTest::qWait(1);
+  }
+  const qint64 windows = elapsed.elapsed() / 50 + 1;
+  fusion.flush();
+
+  QVERIFY2(dispatcher.count() == 2, "entities");
+  QVERIFY2(dispatcher.updates() <= quint64(2 * (windows + 1)), "at most one update per entity per window");
+  QVERIFY2(fusion.statistics().reports == quint64(2 * time), "all reports");
+  QVERIFY2(dispatcher.entity(2)->position().timestamp().toMSecsSinceEpoch() == time, "latest");
+}
+
+void test_TrackFusion::test_trackTimeout() {
+  TrackFusion fusion;
+  Collector collector;
+  fusion.setSampleSink(&collector);
+  fusion.setGate(200.0);
+  fusion.setTrackTimeout(10000);
+
+  // Two aircraft, one of them reported by two feeds
+  PositionSample first[] = {
+    Report(1, 1000, 40.0, -75.0),
+    Report(3, 1000, 40.0 + 50.0 * Meter, -75.0),
+    Report(2, 1000, 41.0, -75.0),
+  };
+  fusion.consume(first, 3);
+  fusion.flush();
+  QVERIFY2(fusion.trackCount() == 2 && fusion.track(3) == 1, "tracks");
+
+  // The first one goes quiet for longer than the timeout
+  PositionSample second[] = { Report(2, 20000, 41.0, -75.0) };
+  fusion.consume(second, 1);
+  fusion.flush();
+  QVERIFY2(fusion.trackCount() == 1 && fusion.statistics().expired == 1, "expired");
+  QVERIFY2(fusion.track(1) == 0 && fusion.track(3) == 0 && fusion.track(2) == 2, "aliases dropped");
+
+  // Back, it starts a track again
+  PositionSample third[] = { Report(1, 20500, 40.0, -75.0), Report(2, 20500, 41.0, -75.0) };
+  fusion.consume(third, 2);
+  fusion.flush();
+  QVERIFY2(fusion.trackCount() == 2 && fusion.track(1) == 1 && fusion.track(2) == 2, "new track");
+  QVERIFY2(collector.samples.size() == 5 && fusion.statistics().outOfOrder == 0, "delivered");
+}
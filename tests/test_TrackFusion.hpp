@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QTest>
+
+class test_TrackFusion : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_weightedMean();
+  void test_association();
+  void test_outOfOrder();
+  void test_propagation();
+  void test_antimeridian();
+  void test_window();
+  void test_trackTimeout();
+};
@@ -0,0 +1,81 @@
+#include <QtMath>
+#include "Sgp4.hpp"
+#include "Trajectory.hpp"
+#include "VisibilityPredictor.hpp"
+#include "test_VisibilityPredictor.hpp"
+
+static const char *Iss1 = "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927";
+static const char *Iss2 = "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537";
+
+// A target 20 km north of the observer that climbs and descends
+// through the mask twice an hour.
+class BobbingTrajectory : public Trajectory
+{
+public:
+  virtual QGeoCoordinate positionAt(double msecsSinceEpoch) const {
+    const double t = msecsSinceEpoch / 1000.0;
+    return QGeoCoordinate(39.18, -75.0, 1000.0 + 3000.0 * qSin(2.0 * M_PI * t / 1800.0));
+  }
+};
+
+void test_VisibilityPredictor::test_crossings() {
+  BobbingTrajectory trajectory;
+  VisibilityPredictor predictor(QGeoCoordinate(39.0, -75.0, 0.0), 5.0);
+  predictor.setStep(120);
+  QDateTime start = QDateTime::fromMSecsSinceEpoch(0, Qt::UTC);
+  QDateTime end = start.addSecs(7200);
+
+  QVector<VisibilityWindow> windows = predictor.windows(trajectory, start, end);
+  QVERIFY2(windows.size() == 4, "windows");
+  for (VisibilityWindow const &window : windows) {
+    QVERIFY2(window.rise < window.culmination && window.culmination < window.set, "order");
+    QVERIFY2(qFabs(predictor.elevationAt(trajectory, window.rise.toMSecsSinceEpoch()) - 5.0) <= 0.01, "rise");
+    QVERIFY2(qFabs(predictor.elevationAt(trajectory, window.set.toMSecsSinceEpoch()) - 5.0) <= 0.01, "set");
+    QVERIFY2(window.maxElevation >= predictor.elevationAt(trajectory, window.culmination.toMSecsSinceEpoch() - 1000), "culmination");
+  }
+}
+
+void test_VisibilityPredictor::test_coarseStep() {
+  // Passes of a few minutes are found even when the elevation is
+  // sampled only every twenty minutes.
+  TwoLineElements elements;
+  elements.parse(Iss1, Iss2);
+  SatelliteTrajectory trajectory((Sgp4(elements)));
+  QDateTime start = QDateTime::fromMSecsSinceEpoch(qint64(elements.epoch), Qt::UTC);
+  QDateTime end = start.addDays(1);
+  VisibilityPredictor predictor(QGeoCoordinate(39.0, -75.0, 0.0));
+
+  predictor.setStep(30);
+  QVector<VisibilityWindow> fine = predictor.windows(trajectory, start, end);
+  predictor.setStep(1200);
+  QVector<VisibilityWindow> coarse = predictor.windows(trajectory, start, end);
+
+  QVERIFY2(fine.size() == 7, "passes");
+  QVERIFY2(coarse.size() == fine.size(), "coarse passes");
+  for (int i = 0; i < fine.size(); ++i) {
+    QVERIFY2(qAbs(fine.at(i).rise.msecsTo(coarse.at(i).rise)) <= 20, "rise");
+    QVERIFY2(qAbs(fine.at(i).set.msecsTo(coarse.at(i).set)) <= 20, "set");
+    QVERIFY2(qFabs(fine.at(i).maxElevation - coarse.at(i).maxElevation) <= 0.01, "maximum elevation");
+  }
+}
+
+void test_VisibilityPredictor::test_batch() {
+  TwoLineElements elements;
+  elements.parse(Iss1, Iss2);
+  SatelliteTrajectory satellite((Sgp4(elements)));
+  BobbingTrajectory bobbing;
+  QDateTime start = QDateTime::fromMSecsSinceEpoch(qint64(elements.epoch), Qt::UTC);
+  QDateTime end = start.addSecs(6 * 3600);
+  VisibilityPredictor predictor(QGeoCoordinate(39.0, -75.0, 0.0), 5.0);
+
+  QVector<Trajectory const *> trajectories;
+  trajectories << &satellite << &bobbing << &satellite;
+  QVector<QVector<VisibilityWindow> > batch = predictor.windows(trajectories, start, end);
+  QVERIFY2(batch.size() == 3, "results");
+  for (int i = 0; i < trajectories.size(); ++i) {
+    QVector<VisibilityWindow> single = predictor.windows(*trajectories.at(i), start, end);
+    QVERIFY2(batch.at(i).size() == single.size(), "same windows");
+    for (int j = 0; j < single.size(); ++j)
+      QVERIFY2(batch.at(i).at(j).rise == single.at(j).rise, "same rise");
+  }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QTest>
+
+class test_VisibilityPredictor : public QObject {
+  Q_OBJECT
+
+private slots:
+  void test_crossings();
+  void test_coarseStep();
+  void test_batch();
+};
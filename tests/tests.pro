@@ -6,9 +6,58 @@ QT        += testlib
 CONFIG    += testcase
 CONFIG    += no_testcase_installs
 
-HEADERS   += test_LookAngle.hpp
+HEADERS   += test_CoverageRaster.hpp \
+             test_EntityPool.hpp \
+             test_EntityRegistry.hpp \
+             test_FastMath.hpp \
+             test_Geodesic.hpp \
+             test_GimbalDriver.hpp \
+             test_LatencyTrace.hpp \
+             test_Listener.hpp \
+             test_LocalTangentPlane.hpp \
+             test_LookAngle.hpp \
+             test_LookAngleCache.hpp \
+             test_LookAngleKernel.hpp \
+             test_MavlinkPositionSource.hpp \
+             test_Metrics.hpp \
+             test_ObserverNetwork.hpp \
+             test_OutputSink.hpp \
+             test_PositionSampleParser.hpp \
+             test_PositionSourceFactory.hpp \
+             test_Refraction.hpp \
+             test_ReorderBuffer.hpp \
+             test_Sgp4.hpp \
+             test_ShardedTracker.hpp \
+             test_SimulatedPositionSource.hpp \
+             test_TrackFusion.hpp \
+             test_VisibilityPredictor.hpp
 
-SOURCES   += test_LookAngle.cpp
+SOURCES   += main.cpp \
+             test_CoverageRaster.cpp \
+             test_EntityPool.cpp \
+             test_EntityRegistry.cpp \
+             test_FastMath.cpp \
+             test_Geodesic.cpp \
+             test_GimbalDriver.cpp \
+             test_LatencyTrace.cpp \
+             test_Listener.cpp \
+             test_LocalTangentPlane.cpp \
+             test_LookAngle.cpp \
+             test_LookAngleCache.cpp \
+             test_LookAngleKernel.cpp \
+             test_MavlinkPositionSource.cpp \
+             test_Metrics.cpp \
+             test_ObserverNetwork.cpp \
+             test_OutputSink.cpp \
+             test_PositionSampleParser.cpp \
+             test_PositionSourceFactory.cpp \
+             test_Refraction.cpp \
+             test_ReorderBuffer.cpp \
+             test_Sgp4.cpp \
+             test_ShardedTracker.cpp \
+             test_SimulatedPositionSource.cpp \
+             test_TrackFusion.cpp \
+             test_VisibilityPredictor.cpp
 
 # Include dependencies if required
 LIBS +=
@@ -0,0 +1,652 @@
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QThread>
+#include <QtConcurrent>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+#include "TrackerBench.hpp"
+#include "GeoEntity.hpp"
+#include "GeoEntityDispatcher.hpp"
+#include "GeoObserver.hpp"
+#include "LookAngle.hpp"
+#include "OutputFormat.hpp"
+#include "OutputSink.hpp"
+#include "data-sources/SimulatedPositionSource.hpp"
+
+// The allocations of the whole process, counted by replacing the
+// global operator new.  The other forms of new and delete go through
+// these.
+static std::atomic<quint64> Allocations(0);
+
+void *operator new(std::size_t size)
+{
+  Allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+// The batches queued to the tracking thread at once by the threaded
+// variant, beyond which the producer waits
+static const int BatchesInFlight = 4;
+
+// The samples of a frame computed by one task of the parallel variant
+static const int ParallelBlockSize = 4096;
+
+// The arguments of each FastMath function measured, and the time
+// each measure lasts at least
+static const int MathArgumentCount = 4096;
+static const qint64 MathMeasureNanoseconds = 50000000;
+
+// A target entity and the observer at the site that watches it, as
+// the tracker has for each entity of a feed.  The listener is for the
+// direct variants, which take the look angles without a signal.
+struct Track
+{
+  GeoEntity target;
+  GeoObserver observer;
+  LookAngleListener listener;
+};
+
+// The tracks of a run, one per entity, entity i + 1 being track i
+class Tracks
+{
+public:
+  Tracks(int count, QGeoCoordinate const &site, Refraction const &refraction) :
+    m_tracks(count)
+  {
+    const QGeoPositionInfo position(site, QDateTime::currentDateTimeUtc());
+    for (Track *&track : m_tracks) {
+      track = new Track;
+      track->observer.setPosition(position);
+      track->observer.setRefraction(refraction);
+      track->observer.setTarget(&track->target);
+    }
+  }
+
+  ~Tracks()
+  {
+    qDeleteAll(m_tracks);
+  }
+
+  int size() const
+  {
+    return m_tracks.size();
+  }
+
+  Track *at(int i) const
+  {
+    return m_tracks.at(i);
+  }
+
+  // The track of a sample, or null
+  Track *of(PositionSample const &sample) const
+  {
+    const quint64 i = sample.id - 1;
+    return i < quint64(m_tracks.size()) ? m_tracks.at(int(i)) : nullptr;
+  }
+
+private:
+  Q_DISABLE_COPY(Tracks)
+  QVector<Track *> m_tracks;
+};
+
+// Writes out the look angles it is given by the observers of the
+// direct variants, with a histogram of its own, a histogram having
+// one writer
+class LookAngleWriter
+{
+public:
+  LookAngleWriter() :
+    output(nullptr),
+    timestamp(nullptr),
+    updates(0)
+  {
+  }
+
+  void onLookAngleChanged(LookAngle const &lookAngle)
+  {
+    // The look angles of the setup are outside any trace
+    const qint64 origin = LatencyTrace::origin();
+    if (origin == 0)
+      return;
+    output->write(OutputRecord::lookAngle(*timestamp, lookAngle.azimuth(), lookAngle.elevation()));
+    latency.record(LatencyTrace::now() - origin);
+    ++updates;
+  }
+
+  OutputSink *output;
+  qint64 const *timestamp;      // of the frame in progress
+  LatencyHistogram latency;
+  quint64 updates;
+};
+
+// The processor time of the process, user and system, in nanoseconds
+static
+qint64 ProcessorTime()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * Q_INT64_C(1000000000)
+    + (qint64(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+}
+
+TrackerBench::TrackerBench(QCoreApplication *app, int argc, char *argv[]) :
+  m_app(app),
+  m_count(10000),
+  m_rate(0.0),
+  m_duration(5.0),
+  m_seed(1),
+  m_accuracy(FastMath::Precise),
+  m_site(35.0, -120.0, 0.0),
+  output(nullptr),
+  m_timestamp(0)
+{
+  Q_UNUSED(argc);
+  Q_UNUSED(argv);
+  QCoreApplication::setApplicationName(QCoreApplication::translate("main", "tracker-bench"));
+  QCoreApplication::setApplicationVersion(GIT_VERSION);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("Target Tracker benchmark.\n\n"
+                                   "Pushes simulated positions through the pipeline of the tracker\n"
+                                   "(entities, look angles and output) and writes the throughput,\n"
+                                   "processor time, allocations and latency of each variant as JSON.\n"
+                                   "The variants are signals-single, signals-threaded, direct-single,\n"
+                                   "direct-parallel and direct-batch.  The errors and speed of the fast\n"
+                                   "trigonometry are reported as well.");
+  parser.addHelpOption();
+  parser.addVersionOption();
+
+  QCommandLineOption entitiesOption(QStringList() << "n" << "entities",
+                                    QCoreApplication::translate("main", "Number of entities (default: 10000)."),
+                                    QCoreApplication::translate("main", "count"),
+                                    "10000");
+  parser.addOption(entitiesOption);
+  QCommandLineOption rateOption(QStringList() << "rate",
+                                QCoreApplication::translate("main", "Updates per second of each entity (default: as fast as possible)."),
+                                QCoreApplication::translate("main", "hz"),
+                                "0");
+  parser.addOption(rateOption);
+  QCommandLineOption durationOption(QStringList() << "duration",
+                                    QCoreApplication::translate("main", "Seconds per run (default: 5)."),
+                                    QCoreApplication::translate("main", "seconds"),
+                                    "5");
+  parser.addOption(durationOption);
+  QCommandLineOption modelOption(QStringList() << "model",
+                                 QCoreApplication::translate("main", "Trajectory of the entities (default: circle)."),
+                                 QCoreApplication::translate("main", "model"),
+                                 "circle");
+  parser.addOption(modelOption);
+  QCommandLineOption seedOption(QStringList() << "seed",
+                                QCoreApplication::translate("main", "Seed of the simulation (default: 1)."),
+                                QCoreApplication::translate("main", "seed"),
+                                "1");
+  parser.addOption(seedOption);
+  QCommandLineOption variantsOption(QStringList() << "variants",
+                                    QCoreApplication::translate("main", "Comma separated variants to run (default: all)."),
+                                    QCoreApplication::translate("main", "variants"),
+                                    variants().join(','));
+  parser.addOption(variantsOption);
+  QCommandLineOption formatOption(QStringList() << "f" << "format",
+                                  QCoreApplication::translate("main", "Format of the output (default: binary)."),
+                                  QCoreApplication::translate("main", "format"),
+                                  "binary");
+  parser.addOption(formatOption);
+  QCommandLineOption outputOption(QStringList() << "output",
+                                  QCoreApplication::translate("main", "File to write the output to (default: /dev/null)."),
+                                  QCoreApplication::translate("main", "file"),
+                                  "/dev/null");
+  parser.addOption(outputOption);
+  QCommandLineOption jsonOption(QStringList() << "json",
+                                QCoreApplication::translate("main", "File to write the results to (default: the standard output)."),
+                                QCoreApplication::translate("main", "file"),
+                                "-");
+  parser.addOption(jsonOption);
+  QCommandLineOption accuracyOption(QStringList() << "accuracy",
+                                    QCoreApplication::translate("main", "Trigonometry of direct-batch: exact, precise or approximate (default: precise)."),
+                                    QCoreApplication::translate("main", "accuracy"),
+                                    "precise");
+  parser.addOption(accuracyOption);
+
+  // Process the actual command line arguments given by the user
+  parser.process(*m_app);
+  m_count = qMax(1, parser.value(entitiesOption).toInt());
+  m_rate = qMax(0.0, parser.value(rateOption).toDouble());
+  m_duration = qMax(0.1, parser.value(durationOption).toDouble());
+  m_model = parser.value(modelOption);
+  m_seed = parser.value(seedOption).toULongLong();
+  m_variants = parser.value(variantsOption).split(',', Qt::SkipEmptyParts);
+  m_format = parser.value(formatOption);
+  m_outputFile = parser.value(outputOption);
+  m_jsonFile = parser.value(jsonOption);
+  const QString accuracy = parser.value(accuracyOption);
+  if (accuracy == "exact")
+    m_accuracy = FastMath::Exact;
+  else if (accuracy == "approximate")
+    m_accuracy = FastMath::Approximate;
+  else
+    m_accuracy = FastMath::Precise;
+}
+
+TrackerBench::~TrackerBench()
+{
+}
+
+QStringList TrackerBench::variants()
+{
+  return QStringList() << "signals-single" << "signals-threaded" << "direct-single" << "direct-parallel" << "direct-batch";
+}
+
+void TrackerBench::main()
+{
+  SimulatedPositionSource::Trajectory trajectory;
+  if (!SimulatedPositionSource::trajectoryFromName(m_model, &trajectory)) {
+    qDebug() << "Unknown model:" << m_model;
+    QCoreApplication::exit(1);
+    return;
+  }
+  QScopedPointer<OutputFormat> format(OutputFormat::create(m_format));
+  if (!format) {
+    qDebug() << "Unknown output format:" << m_format;
+    QCoreApplication::exit(1);
+    return;
+  }
+
+  // The frames replayed by the runs, a second apart, or at the rate
+  SimulatedPositionSource source(QGeoCoordinate(m_site.latitude(), m_site.longitude(), 1000.0));
+  source.setCount(m_count);
+  source.setTrajectory(trajectory);
+  source.setSeed(m_seed);
+  source.setEpoch(QDateTime::currentMSecsSinceEpoch());
+  const int frames = 16;
+  m_frames.resize(frames);
+  for (int i = 0; i < frames; ++i)
+    source.simulate(i / (m_rate > 0.0 ? m_rate : 1.0), &m_frames[i]);
+
+  QJsonArray runs;
+  for (QString const &variant : m_variants) {
+    if (!variants().contains(variant)) {
+      qDebug() << "Unknown variant:" << variant;
+      continue;
+    }
+    const QJsonObject result = run(variant);
+    qInfo().noquote() << QString("%1: %2 updates/s, %3 ns and %4 allocations per update, p99 %5 us")
+      .arg(variant, -16)
+      .arg(result.value("updates_per_second").toDouble(), 0, 'f', 0)
+      .arg(result.value("cpu_ns_per_update").toDouble(), 0, 'f', 0)
+      .arg(result.value("allocations_per_update").toDouble(), 0, 'f', 2)
+      .arg(result.value("latency_us").toObject().value("p99").toDouble(), 0, 'f', 1);
+    runs.append(result);
+  }
+
+  const QJsonObject math = measureMath();
+  for (QString const &function : math.keys()) {
+    QJsonObject const &measures = math.value(function).toObject();
+    QJsonObject const &precise = measures.value("precise").toObject();
+    QJsonObject const &approximate = measures.value("approximate").toObject();
+    qInfo().noquote() << QString("%1: precise %2x (error %3), approximate %4x (error %5)")
+      .arg(function, -16)
+      .arg(precise.value("speedup").toDouble(), 0, 'f', 2)
+      .arg(precise.value("max_error").toDouble(), 0, 'g', 2)
+      .arg(approximate.value("speedup").toDouble(), 0, 'f', 2)
+      .arg(approximate.value("max_error").toDouble(), 0, 'g', 2);
+  }
+
+  QJsonObject results;
+  results.insert("version", GIT_VERSION);
+  results.insert("entities", m_count);
+  results.insert("rate", m_rate);
+  results.insert("duration", m_duration);
+  results.insert("model", m_model);
+  results.insert("seed", QString::number(m_seed));
+  results.insert("format", m_format);
+  results.insert("threads", QThread::idealThreadCount());
+  results.insert("runs", runs);
+  results.insert("math", math);
+
+  QFile file;
+  const bool isOpen = m_jsonFile == "-" ? file.open(stdout, QIODevice::WriteOnly)
+    : (file.setFileName(m_jsonFile), file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+  if (!isOpen || file.write(QJsonDocument(results).toJson()) < 0) {
+    qDebug() << "Failed results:" << file.errorString();
+    QCoreApplication::exit(1);
+    return;
+  }
+  file.close();
+  emit finished();
+}
+
+QJsonObject TrackerBench::run(QString const &variant)
+{
+  output = new OutputSink(OutputFormat::create(m_format));
+  if (!output->open(m_outputFile))
+    qDebug() << "Failed output:" << output->errorString();
+
+  LatencyHistogram latency;
+  const quint64 allocations = Allocations.load(std::memory_order_relaxed);
+  const qint64 processorTime = ProcessorTime();
+  m_clock.start();
+
+  quint64 updates = 0;
+  if (variant.startsWith("signals"))
+    updates = runSignals(variant == "signals-threaded", &latency);
+  else if (variant == "direct-batch")
+    updates = runBatch(&latency);
+  else
+    updates = runDirect(variant == "direct-parallel", &latency);
+
+  const double seconds = m_clock.nsecsElapsed() / 1e9;
+  const double cpu = double(ProcessorTime() - processorTime);
+  const double allocated = double(Allocations.load(std::memory_order_relaxed) - allocations);
+
+  // The records queued are written out before the sink is counted
+  output->close();
+  const quint64 written = output->written();
+  const quint64 dropped = output->dropped();
+  delete output;
+  output = nullptr;
+
+  const double count = double(qMax<quint64>(1, updates));
+  QJsonObject percentiles;
+  percentiles.insert("p50", latency.percentile(0.5) / 1000.0);
+  percentiles.insert("p90", latency.percentile(0.9) / 1000.0);
+  percentiles.insert("p99", latency.percentile(0.99) / 1000.0);
+  percentiles.insert("p999", latency.percentile(0.999) / 1000.0);
+  percentiles.insert("max", latency.maximum() / 1000.0);
+
+  QJsonObject result;
+  result.insert("variant", variant);
+  result.insert("updates", double(updates));
+  result.insert("seconds", seconds);
+  result.insert("updates_per_second", updates / seconds);
+  result.insert("cpu_ns_per_update", cpu / count);
+  result.insert("allocations_per_update", allocated / count);
+  result.insert("latency_us", percentiles);
+  result.insert("output_written", double(written));
+  result.insert("output_dropped", double(dropped));
+  return result;
+}
+
+quint64 TrackerBench::runSignals(bool isThreaded, LatencyHistogram *latency)
+{
+  // The samples are dispatched to the entities, and the look angles
+  // of the observers are written out by a slot
+  GeoEntityDispatcher dispatcher;
+  Tracks tracks(m_count, m_site, m_refraction);
+  quint64 updates = 0;
+  for (int i = 0; i < tracks.size(); ++i) {
+    dispatcher.setEntity(quint64(i) + 1, &tracks.at(i)->target);
+    connect(&tracks.at(i)->observer, &GeoObserver::lookAngleChanged, this, [this, latency, &updates](LookAngle const &lookAngle) {
+        // The look angles of the setup are outside any trace
+        const qint64 origin = LatencyTrace::origin();
+        if (origin == 0)
+          return;
+        output->write(OutputRecord::lookAngle(m_timestamp, lookAngle.azimuth(), lookAngle.elevation()));
+        latency->record(LatencyTrace::now() - origin);
+        ++updates;
+      });
+  }
+  // The setup is not measured
+  m_clock.restart();
+
+  if (!isThreaded) {
+    for (qint64 frame = 0; pace(frame); ++frame) {
+      QVector<PositionSample> const &samples = m_frames.at(frame % m_frames.size());
+      LatencyTrace::Scope scope;
+      m_timestamp = samples.first().timestamp;
+      dispatcher.consume(samples.constData(), samples.size());
+    }
+    return updates;
+  }
+
+  // The batches are made on a thread of their own and queued to this
+  // one, with the time of their ingest.  The frames are implicitly
+  // shared, so they are not copied.
+  QSemaphore inFlight(BatchesInFlight);
+  QThread *producer = QThread::create([this, &dispatcher, &inFlight]() {
+      for (qint64 frame = 0; pace(frame); ++frame) {
+        inFlight.acquire();
+        const QVector<PositionSample> samples = m_frames.at(frame % m_frames.size());
+        const qint64 origin = LatencyTrace::now();
+        QMetaObject::invokeMethod(&dispatcher, [this, &dispatcher, &inFlight, samples, origin]() {
+            LatencyTrace::Scope scope(origin);
+            m_timestamp = samples.first().timestamp;
+            dispatcher.consume(samples.constData(), samples.size());
+            inFlight.release();
+          }, Qt::QueuedConnection);
+      }
+    });
+  QEventLoop loop;
+  connect(producer, &QThread::finished, &loop, &QEventLoop::quit);
+  producer->start();
+  loop.exec();
+  producer->wait();
+  delete producer;
+
+  // The batches still queued
+  while (inFlight.available() < BatchesInFlight)
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+  return updates;
+}
+
+quint64 TrackerBench::runDirect(bool isParallel, LatencyHistogram *latency)
+{
+  // The same tracks as the signals variants, the samples set on the
+  // entities by direct calls, and the look angles taken by listeners.
+  // The parallel variant splits the tracks in blocks, each with a
+  // writer, and the tracks of a block are only touched by its task.
+  Tracks tracks(m_count, m_site, m_refraction);
+  const int blockSize = isParallel ? ParallelBlockSize : qMax(1, m_count);
+  QVector<int> blocks;
+  for (int begin = 0; begin < m_count; begin += blockSize)
+    blocks.append(begin);
+  QVector<LookAngleWriter> writers(blocks.size());
+  for (int i = 0; i < tracks.size(); ++i) {
+    LookAngleWriter &writer = writers[i / blockSize];
+    writer.output = output;
+    writer.timestamp = &m_timestamp;
+    Track *track = tracks.at(i);
+    track->listener.bind<LookAngleWriter, &LookAngleWriter::onLookAngleChanged>(&writer);
+    track->observer.addLookAngleListener(&track->listener);
+  }
+  // The setup is not measured
+  m_clock.restart();
+
+  for (qint64 frame = 0; pace(frame); ++frame) {
+    QVector<PositionSample> const &samples = m_frames.at(frame % m_frames.size());
+    const qint64 origin = LatencyTrace::now();
+    m_timestamp = samples.first().timestamp;
+    const auto update = [&tracks, &samples, blockSize, origin](int begin) {
+      LatencyTrace::Scope scope(origin);
+      const int end = qMin(begin + blockSize, samples.size());
+      for (int i = begin; i < end; ++i) {
+        PositionSample const &sample = samples.at(i);
+        if (Track *track = tracks.of(sample))
+          track->target.setPosition(sample.toPositionInfo());
+      }
+    };
+    if (isParallel)
+      QtConcurrent::blockingMap(blocks, update);
+    else
+      update(0);
+  }
+
+  quint64 updates = 0;
+  for (LookAngleWriter const &writer : writers) {
+    latency->add(writer.latency);
+    updates += writer.updates;
+  }
+  return updates;
+}
+
+quint64 TrackerBench::runBatch(LatencyHistogram *latency)
+{
+  const LookAngleFrame site = LookAngleFrame::at(m_site);
+  QVector<double> latitude, longitude, altitude, range;
+  QVector<float> azimuth, elevation;
+  quint64 updates = 0;
+  for (qint64 frame = 0; pace(frame); ++frame) {
+    QVector<PositionSample> const &samples = m_frames.at(frame % m_frames.size());
+    const qint64 origin = LatencyTrace::now();
+    const int count = samples.size();
+    latitude.resize(count);
+    longitude.resize(count);
+    altitude.resize(count);
+    range.resize(count);
+    elevation.resize(count);
+    azimuth.fill(0.0f, count);
+    for (int i = 0; i < count; ++i) {
+      latitude[i] = samples.at(i).latitude;
+      longitude[i] = samples.at(i).longitude;
+      altitude[i] = samples.at(i).altitude;
+    }
+    site.lookAngles(count, latitude.constData(), longitude.constData(), altitude.constData(),
+                    azimuth.data(), elevation.data(), range.data(), m_accuracy);
+    m_refraction.apply(elevation.data(), range.constData(), count);
+    for (int i = 0; i < count; ++i) {
+      output->write(OutputRecord::lookAngle(samples.at(i).timestamp, azimuth.at(i), elevation.at(i)));
+      latency->record(LatencyTrace::now() - origin);
+    }
+    updates += quint64(count);
+  }
+  return updates;
+}
+
+// The nanoseconds per argument of a batch function, called over and
+// over for a while
+template <class Function>
+static
+double NanosecondsPerCall(Function const &function)
+{
+  QElapsedTimer clock;
+  clock.start();
+  quint64 calls = 0;
+  do {
+    function();
+    calls += MathArgumentCount;
+  } while (clock.nsecsElapsed() < MathMeasureNanoseconds);
+  return double(clock.nsecsElapsed()) / double(calls);
+}
+
+// The measures of a function at an accuracy against its time with
+// the C library
+static
+QJsonObject MathMeasure(double maximumError, double nanoseconds, double exactNanoseconds)
+{
+  QJsonObject measure;
+  measure.insert("max_error", maximumError);
+  measure.insert("ns_per_call", nanoseconds);
+  measure.insert("speedup", exactNanoseconds / nanoseconds);
+  return measure;
+}
+
+QJsonObject TrackerBench::measureMath() const
+{
+  // Arguments over the whole ranges, the errors against long double
+  QVector<double> angle(MathArgumentCount), y(MathArgumentCount), x(MathArgumentCount), cosine(MathArgumentCount);
+  QVector<double> first(MathArgumentCount), second(MathArgumentCount);
+  for (int i = 0; i < MathArgumentCount; ++i) {
+    const double t = (i + 0.5) / MathArgumentCount;
+    angle[i] = (2.0 * t - 1.0) * 4.0 * M_PI;
+    y[i] = std::sin(7.0 * M_PI * t) * (1.0 + 1000.0 * t);
+    x[i] = std::cos(5.0 * M_PI * t) * (1.0 + 1000.0 * t);
+    cosine[i] = 2.0 * t - 1.0;
+  }
+
+  const FastMath::Accuracy accuracies[] = { FastMath::Exact, FastMath::Precise, FastMath::Approximate };
+  const char *names[] = { "exact", "precise", "approximate" };
+  QJsonObject sinCos, atan2, acos;
+  double sinCosExact = 0.0, atan2Exact = 0.0, acosExact = 0.0;
+  for (FastMath::Accuracy accuracy : accuracies) {
+    double error = 0.0;
+    FastMath::sinCos(MathArgumentCount, angle.constData(), first.data(), second.data(), accuracy);
+    for (int i = 0; i < MathArgumentCount; ++i)
+      error = qMax(error, double(qMax(std::fabs(first.at(i) - std::sin((long double)angle.at(i))),
+                                      std::fabs(second.at(i) - std::cos((long double)angle.at(i))))));
+    const double sinCosTime = NanosecondsPerCall([&] {
+        FastMath::sinCos(MathArgumentCount, angle.constData(), first.data(), second.data(), accuracy);
+      });
+
+    double atan2Error = 0.0;
+    FastMath::atan2(MathArgumentCount, y.constData(), x.constData(), first.data(), accuracy);
+    for (int i = 0; i < MathArgumentCount; ++i)
+      atan2Error = qMax(atan2Error, double(std::fabs(first.at(i) - std::atan2((long double)y.at(i), (long double)x.at(i)))));
+    const double atan2Time = NanosecondsPerCall([&] {
+        FastMath::atan2(MathArgumentCount, y.constData(), x.constData(), first.data(), accuracy);
+      });
+
+    double acosError = 0.0;
+    FastMath::acos(MathArgumentCount, cosine.constData(), first.data(), accuracy);
+    for (int i = 0; i < MathArgumentCount; ++i)
+      acosError = qMax(acosError, double(std::fabs(first.at(i) - std::acos((long double)cosine.at(i)))));
+    const double acosTime = NanosecondsPerCall([&] {
+        FastMath::acos(MathArgumentCount, cosine.constData(), first.data(), accuracy);
+      });
+
+    if (accuracy == FastMath::Exact) {
+      sinCosExact = sinCosTime;
+      atan2Exact = atan2Time;
+      acosExact = acosTime;
+    }
+    sinCos.insert(names[accuracy], MathMeasure(error, sinCosTime, sinCosExact));
+    atan2.insert(names[accuracy], MathMeasure(atan2Error, atan2Time, atan2Exact));
+    acos.insert(names[accuracy], MathMeasure(acosError, acosTime, acosExact));
+  }
+
+  QJsonObject math;
+  math.insert("sincos", sinCos);
+  math.insert("atan2", atan2);
+  math.insert("acos", acos);
+  return math;
+}
+
+bool TrackerBench::pace(qint64 frame) const
+{
+  const qint64 elapsed = m_clock.nsecsElapsed();
+  if (elapsed >= qint64(m_duration * 1e9))
+    return false;
+  if (m_rate > 0.0) {
+    const qint64 due = qint64(frame * 1e9 / m_rate);
+    if (due > elapsed)
+      QThread::usleep(quint64((due - elapsed) / 1000));
+  }
+  return true;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QObject>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QGeoCoordinate>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVector>
+#include "PositionSample.hpp"
+#include "LatencyTrace.hpp"
+#include "Refraction.hpp"
+#include "FastMath.hpp"
+
+class OutputSink;
+
+// The TrackerBench measures the capacity of the whole pipeline: the
+// samples of a source, the entities they update, the look angles
+// computed from an observer and the output they are written to.  It
+// pushes the positions of a number of simulated entities (see
+// SimulatedPositionSource) through the pipeline for a while, as fast
+// as it can or at a rate, and reports the sustained updates per
+// second, the processor time and the allocations per update, and the
+// latency from the ingest of a batch to the output of each look
+// angle, as JSON.
+//
+// The variants of the design are run in turn:
+//
+// - signals-single: the samples go through a GeoEntityDispatcher to
+//   a GeoEntity per entity, each watched by a GeoObserver, whose look
+//   angles are written out by a slot connected to lookAngleChanged(),
+//   in one thread.  The observers follow their targets by listener,
+//   as GeoObserver does for an entity in its thread.
+// - signals-threaded: the same, with the batches made on a thread of
+//   their own and queued to the tracking thread, as for a
+//   ThreadedPositionSource.
+// - direct-single: the same entities and observers, the samples set
+//   on the entities by direct calls to GeoEntity::setPosition, and
+//   the look angles written out by look angle listeners, in one
+//   thread.
+// - direct-parallel: the same, with the entities split in blocks
+//   between the threads of the global pool.
+// - direct-batch: the look angles of a frame are computed at once by
+//   LookAngleFrame, with the trigonometry of FastMath, in one thread,
+//   without entities or observers: the bound of the look angle
+//   computation rather than the pipeline.
+//
+// The errors and the speed of FastMath against the C library are
+// measured as well, for each function and accuracy.
+//
+// The positions of a few frames are simulated before the runs and
+// replayed, so that the simulation is not measured.  The processor
+// time is that of the whole process (the writer of the output
+// included), and the allocations are those of operator new.  POSIX
+// only.
+
+class TrackerBench : public QObject
+{
+  Q_OBJECT
+
+public:
+  TrackerBench(QCoreApplication *app, int argc, char *argv[]);
+  ~TrackerBench();
+
+  static QStringList variants();
+
+public slots:
+  void main();
+
+signals:
+  void finished();
+
+private:
+  QJsonObject run(QString const &variant);
+  quint64 runSignals(bool isThreaded, LatencyHistogram *latency);
+  quint64 runDirect(bool isParallel, LatencyHistogram *latency);
+  quint64 runBatch(LatencyHistogram *latency);
+  QJsonObject measureMath() const;
+
+  // Wait for a frame at the rate.  False when the run is over.
+  bool pace(qint64 frame) const;
+
+private:
+  QCoreApplication *m_app;
+
+  int m_count;                    // entities
+  double m_rate;                  // frames per second, or 0 for flat out
+  double m_duration;              // seconds per run
+  QString m_model;
+  quint64 m_seed;
+  QStringList m_variants;
+  QString m_format;
+  QString m_outputFile;
+  QString m_jsonFile;
+  FastMath::Accuracy m_accuracy;  // of direct-batch
+
+  QGeoCoordinate m_site;
+  Refraction m_refraction;
+  QVector<QVector<PositionSample>> m_frames;
+
+  QElapsedTimer m_clock;          // of the run in progress
+  OutputSink *output;             // of the run in progress
+  qint64 m_timestamp;             // of the frame in progress
+};
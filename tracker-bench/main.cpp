@@ -0,0 +1,18 @@
+#include <QCoreApplication>
+#include <QTimer>
+#include "TrackerBench.hpp"
+
+int main(int argc, char * argv[]) {
+  QCoreApplication a(argc, argv);
+  TrackerBench bench(&a, argc, argv);
+
+  // quit application when the runs are complete:
+  QObject::connect(&bench, &TrackerBench::finished, &a, &QCoreApplication::quit);
+
+  // Run the benchmark in the main loop, which the signal variants
+  // need:
+  QTimer::singleShot(0, &bench, &TrackerBench::main);
+
+  // Run the main loop:
+  return a.exec();
+}
@@ -0,0 +1,24 @@
+include ("../common.pri")
+
+# Application Name:
+TARGET     = tracker-bench
+
+CONFIG    += console
+CONFIG    += no_testcase_installs
+CONFIG    -= app_bundle
+
+TEMPLATE   = app
+
+HEADERS   += TrackerBench.hpp
+
+SOURCES   += main.cpp \
+             TrackerBench.cpp
+
+symbian: LIBS += -lgeotracker
+else:unix|win32: LIBS += -L$$OUT_PWD/../libgeotracker -lgeotracker
+
+win32: PRE_TARGETDEPS += $$OUT_PWD/../libgeotracker/geotracker.lib
+else:unix:!symbian: PRE_TARGETDEPS += $$OUT_PWD/../libgeotracker/libgeotracker.a
+
+include (../deployment.pri)
+include (../gitversion.pri)